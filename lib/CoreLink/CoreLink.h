@@ -0,0 +1,161 @@
+/****
+ *
+ * This file is a part of the CoreLink library. The library supplies the two small building
+ * blocks the firmware uses to pass information between the RP2040's two cores without locks:
+ *
+ *      SpscRing    A fixed-size, single-producer, single-consumer ring of items. One core
+ *                  push()es, the other pop()s. Neither ever waits for the other; push()
+ *                  simply fails if the ring is full.
+ *
+ *      SeqLock     A single-writer "sequence lock" around a small struct. The writer publishes
+ *                  a new value whenever it likes, without waiting. A reader gets a consistent
+ *                  copy of the most recently published value. If a publication happens to be
+ *                  underway while it's reading, the reader just reads again, so a read never
+ *                  waits for longer than it takes the writer to copy the struct.
+ *
+ * Both rely on nothing more than 32-bit atomic loads and stores plus memory barriers, which
+ * the Cortex-M0+ does natively, so they're lock-free on the RP2040 as well as on a host.
+ *
+ *****
+ *
+ * CoreLink V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief   A single-producer, single-consumer lock-free ring holding up to N items of type T.
+ *
+ * @details head counts the items ever pushed and tail the items ever popped; only the producer
+ *          writes head and only the consumer writes tail. The item itself is written before
+ *          head is advanced (release) and read after head is seen to have advanced (acquire),
+ *          and likewise for the slot being freed, so neither side ever sees a half-written item.
+ *
+ * @tparam T    The type of the items. Copied by value.
+ * @tparam N    The capacity of the ring. Must be a power of two.
+ */
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    /**
+     * @brief   Producer side: Add an item to the ring
+     *
+     * @param item      The item to add
+     * @return true     Success
+     * @return false    The ring is full; the item was not added
+     */
+    bool push(const T &item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        items[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief   Consumer side: Remove the oldest item from the ring
+     *
+     * @param item      Where to put the item
+     * @return true     Success
+     * @return false    The ring is empty; item is unchanged
+     */
+    bool pop(T &item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) {
+            return false;
+        }
+        item = items[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief   Either side: Return whether the ring is empty. From the producer's side, an
+     *          empty ring means the consumer has taken everything that was pushed.
+     *
+     * @return true     Empty
+     * @return false    Not empty
+     */
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T items[N];                                 // The ring itself
+    std::atomic<uint32_t> head {0};             // Number of items ever pushed
+    std::atomic<uint32_t> tail {0};             // Number of items ever popped
+};
+
+/**
+ * @brief   A single-writer sequence lock around a value of type T
+ *
+ * @details seq is odd while the writer is updating the value and even otherwise; it advances by
+ *          two for each publication. A reader that sees the same even seq before and after
+ *          copying the value knows its copy is consistent.
+ *
+ * @tparam T    The type of the value. Must be trivially copyable and should be small.
+ */
+template <typename T>
+class SeqLock {
+public:
+    /**
+     * @brief   Writer side: Publish a new value. Only one core may ever write.
+     *
+     * @param v     The value to publish
+     */
+    void write(const T &v) {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value = v;
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief   Reader side: Get a consistent copy of the most recently published value
+     *
+     * @return T    The value
+     */
+    T read() const {
+        T v;
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = seq.load(std::memory_order_acquire);
+            v = value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        return v;
+    }
+
+private:
+    T value {};                                 // The protected value
+    std::atomic<uint32_t> seq {0};              // Odd ==> write in progress
+};
@@ -0,0 +1,207 @@
+/****
+ *
+ * This file is a part of the CurveTable library. The library supplies CurveTable, a template for
+ * lookup tables that the compiler fills in, together with a few constexpr math functions to
+ * fill them in with. It's for curves -- brightness response, gamma and the like -- whose input
+ * takes only a small number of values, but which would otherwise have to be calculated in
+ * software floating point each time they're needed. With a CurveTable, the curve is calculated
+ * at compile time, in double precision, and stored in flash. At run time, looking up a value is
+ * an array index. Typically the table holds fixed-point values, so that whatever is done with
+ * them afterwards can be integer math too.
+ *
+ * For example, a 101-entry table of the squares of 0.00 .. 1.00 in Q15 fixed point:
+ *
+ *      static constexpr CurveTable<uint16_t, 101> square {[](uint16_t i) {
+ *          return curveFixed<uint16_t>((i / 100.0) * (i / 100.0), 15);
+ *      }};
+ *
+ *      uint16_t s = square.at(pct);    // pct clamped to 0 .. 100
+ *
+ * The functions in the standard library's <cmath> aren't constexpr (in C++17), so CurveTable.h
+ * has its own constexpr curveLn(), curveLog10() and curvePow() for use in table generators.
+ * They're accurate to within a few units in the last place of a double for the range of
+ * arguments curves are made of, which is far more than a 16-bit table entry can hold.
+ *
+ *****
+ *
+ * CurveTable V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <stdint.h>
+
+#define CURVE_LN2       (0.69314718055994530942)    // ln(2)
+#define CURVE_LN10      (2.30258509299404568402)    // ln(10)
+
+/**
+ * @brief   constexpr natural logarithm
+ *
+ * @details x is scaled by powers of two into [1, 2), where ln(m) = 2 * atanh((m - 1) / (m + 1))
+ *          and the atanh series converges quickly, since its argument is less than 1/3.
+ *
+ * @param x         The argument. Must be > 0.
+ * @return double   ln(x)
+ */
+constexpr double curveLn(double x) {
+    int32_t k = 0;
+    while (x >= 2.0) {
+        x /= 2.0;
+        k++;
+    }
+    while (x < 1.0) {
+        x *= 2.0;
+        k--;
+    }
+    double y = (x - 1.0) / (x + 1.0);
+    double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int32_t n = 1; n < 60; n += 2) {
+        sum += term / n;
+        term *= y2;
+    }
+    return 2.0 * sum + k * CURVE_LN2;
+}
+
+/**
+ * @brief   constexpr base 10 logarithm
+ *
+ * @param x         The argument. Must be > 0.
+ * @return double   log10(x)
+ */
+constexpr double curveLog10(double x) {
+    return curveLn(x) / CURVE_LN10;
+}
+
+/**
+ * @brief   constexpr e to the x
+ *
+ * @details x is split into n * ln(2) + r, with |r| <= ln(2) / 2, and e^r is summed as a Taylor
+ *          series.
+ *
+ * @param x         The exponent
+ * @return double   e^x
+ */
+constexpr double curveExp(double x) {
+    int32_t n = (int32_t)(x / CURVE_LN2 + (x < 0 ? -0.5 : 0.5));
+    double r = x - n * CURVE_LN2;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int32_t i = 1; i < 25; i++) {
+        term *= r / i;
+        sum += term;
+    }
+    for (; n > 0; n--) {
+        sum *= 2.0;
+    }
+    for (; n < 0; n++) {
+        sum /= 2.0;
+    }
+    return sum;
+}
+
+/**
+ * @brief   constexpr x to the power y
+ *
+ * @param x         The base. Must be >= 0.
+ * @param y         The exponent
+ * @return double   x^y (0 if x is 0)
+ */
+constexpr double curvePow(double x, double y) {
+    return x <= 0.0 ? 0.0 : curveExp(y * curveLn(x));
+}
+
+/**
+ * @brief   Convert a value to fixed point, rounding to nearest and clamping to what T can hold
+ *
+ * @tparam T        The (unsigned integer) fixed-point type
+ * @param v         The value to convert. Must be >= 0.
+ * @param fracBits  The number of fraction bits, so that 1.0 becomes 1 << fracBits
+ * @return T        The fixed-point equivalent of v
+ */
+template <typename T>
+constexpr T curveFixed(double v, uint8_t fracBits) {
+    double scaled = v * (double)((uint64_t)1 << fracBits) + 0.5;
+    return scaled >= (double)(T)~(T)0 ? (T)~(T)0 : scaled <= 0.0 ? 0 : (T)scaled;
+}
+
+/**
+ * @brief   A lookup table of N values of type T, filled in at compile time by a generator.
+ *
+ * @details Declare tables static constexpr so that the compiler does the work and the table
+ *          ends up in flash.
+ *
+ * @tparam T    The type of the table's entries
+ * @tparam N    The number of entries; the table's domain is 0 .. N - 1
+ */
+template <typename T, uint16_t N>
+class CurveTable {
+    static_assert(N != 0, "A CurveTable must have at least one entry");
+
+public:
+    /**
+     * @brief   Construct a new CurveTable, calling gen(i) for i = 0 .. N - 1 to produce entry i
+     *
+     * @tparam G    The type of the generator, typically a lambda. Must be usable in a constant
+     *              expression.
+     * @param gen   The generator
+     */
+    template <typename G>
+    constexpr CurveTable(G gen) : entry {} {
+        for (uint16_t i = 0; i < N; i++) {
+            entry[i] = gen(i);
+        }
+    }
+
+    /**
+     * @brief   Get the table entry for i, which must be in 0 .. N - 1
+     *
+     * @param i     The index
+     * @return T    The entry
+     */
+    constexpr T operator[](uint16_t i) const {
+        return entry[i];
+    }
+
+    /**
+     * @brief   Get the table entry for i, clamping i to 0 .. N - 1 first
+     *
+     * @param i     The index
+     * @return T    The entry
+     */
+    constexpr T at(int32_t i) const {
+        return entry[i < 0 ? 0 : i >= N ? N - 1 : i];
+    }
+
+    /**
+     * @brief   Get the number of entries in the table
+     *
+     * @return uint16_t N
+     */
+    static constexpr uint16_t size() {
+        return N;
+    }
+
+private:
+    T entry[N];                                 // The table
+};
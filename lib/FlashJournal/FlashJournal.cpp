@@ -0,0 +1,280 @@
+/****
+ * 
+ * This file is a part of the FlashJournal library. See FlashJournal.h for details
+ *  
+ *****
+ * 
+ * FlashJournal V1.1.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. 
+ * 
+ ****/
+#include <FlashJournal.h>
+
+/**
+ * @brief   How much room a record with a payload of the specified length takes in flash: the 
+ *          header plus the payload, rounded up to a multiple of four bytes.
+ * 
+ */
+#define recSize(len) ((uint16_t)((FJ_REC_HDR_SIZE + (len) + 3) & ~3))
+
+// Public instance member functions
+
+FlashJournal::FlashJournal(uint32_t offset, uint8_t sectors) {
+    base = offset;
+    nSectors = sectors < 2 ? 2 : sectors;
+    active = -1;
+    seq = 0;
+    head = FLASH_SECTOR_SIZE;
+    nextErased = false;
+    memset(latest, FJ_NO_RECORD, sizeof(latest));
+}
+
+bool FlashJournal::begin() {
+    active = -1;
+    head = FLASH_SECTOR_SIZE;
+    memset(latest, FJ_NO_RECORD, sizeof(latest));
+
+    // Find the sector with a valid header and the highest sequence number
+    for (uint8_t s = 0; s < nSectors; s++) {
+        const uint8_t *p = sectorAt(s);
+        uint32_t magic;
+        uint32_t sSeq;
+        memcpy(&magic, p, sizeof(magic));
+        memcpy(&sSeq, p + 4, sizeof(sSeq));
+        if (magic != FJ_MAGIC || crc16(p, 8) != (p[8] | p[9] << 8)) {
+            continue;
+        }
+        if (active < 0 || (int32_t)(sSeq - seq) > 0) {
+            active = s;
+            seq = sSeq;
+        }
+    }
+    nextErased = isErased(nextSector());
+    if (active < 0) {
+        #ifdef FJ_DEBUG
+        Serial.println("FlashJournal::begin - No journal found.");
+        #endif
+        return false;
+    }
+
+    // Read through its records to find the latest for each tag and where to append
+    uint16_t offset = FJ_HDR_SIZE;
+    const uint8_t *p = sectorAt(active);
+    while (offset + FJ_REC_HDR_SIZE <= FLASH_SECTOR_SIZE && !(p[offset] == 0xff && p[offset + 1] == 0xff)) {
+        uint16_t size = checkRecord(active, offset);
+        if (size == 0) {
+            // A record torn by a power failure. Don't append after it; move on next write.
+            #ifdef FJ_DEBUG
+            Serial.printf("FlashJournal::begin - Bad record at sector %d offset %d.\n", active, offset);
+            #endif
+            offset = FLASH_SECTOR_SIZE;
+            break;
+        }
+        latest[p[offset]] = offset;
+        offset += size;
+    }
+    head = offset;
+    #ifdef FJ_DEBUG
+    Serial.printf("FlashJournal::begin - Using sector %d, seq %u, appending at %d.\n", active, seq, head);
+    #endif
+    return true;
+}
+
+bool FlashJournal::read(uint8_t tag, void *data, uint8_t len) {
+    if (active < 0 || tag >= FJ_MAX_TAGS || latest[tag] == FJ_NO_RECORD) {
+        return false;
+    }
+    const uint8_t *p = sectorAt(active) + latest[tag];
+    if (p[1] != len) {
+        return false;
+    }
+    memcpy(data, p + FJ_REC_HDR_SIZE, len);
+    return true;
+}
+
+bool FlashJournal::write(uint8_t tag, const void *data, uint8_t len) {
+    if (tag >= FJ_MAX_TAGS || len > FJ_MAX_LEN) {
+        return false;
+    }
+    if (active >= 0 && latest[tag] != FJ_NO_RECORD) {
+        const uint8_t *p = sectorAt(active) + latest[tag];
+        if (p[1] == len && memcmp(p + FJ_REC_HDR_SIZE, data, len) == 0) {
+            return true;
+        }
+    }
+
+    // Assemble the record
+    uint8_t rec[FJ_REC_HDR_SIZE + FJ_MAX_LEN];
+    rec[0] = tag;
+    rec[1] = len;
+    memcpy(rec + FJ_REC_HDR_SIZE, data, len);
+    uint16_t crc = crc16(rec + FJ_REC_HDR_SIZE, len, crc16(rec, 2));
+    rec[2] = crc & 0xff;
+    rec[3] = crc >> 8;
+    uint16_t size = recSize(len);
+
+    // Append it if there's room. Otherwise move on to the next sector.
+    if (active < 0 || head + size > FLASH_SECTOR_SIZE) {
+        return rotate(tag, rec, size);
+    }
+    bool answer = program(active, head, rec, FJ_REC_HDR_SIZE + len);
+    latest[tag] = head;
+    head += size;
+    return answer;
+}
+
+bool FlashJournal::fits(uint8_t len) {
+    uint16_t size = recSize(len);
+    return (active >= 0 && head + size <= FLASH_SECTOR_SIZE) || nextErased;
+}
+
+void FlashJournal::prepare() {
+    if (!nextErased) {
+        erase(nextSector());
+        nextErased = true;
+    }
+}
+
+// Private instance member functions
+
+uint8_t FlashJournal::nextSector() {
+    return active < 0 ? 0 : (active + 1) % nSectors;
+}
+
+bool FlashJournal::isErased(uint8_t sector) {
+    const uint32_t *p = (const uint32_t *)sectorAt(sector);
+    for (uint16_t i = 0; i < FLASH_SECTOR_SIZE / sizeof(uint32_t); i++) {
+        if (p[i] != 0xffffffff) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const uint8_t *FlashJournal::sectorAt(uint8_t sector) {
+    return (const uint8_t *)(XIP_BASE + base + sector * FLASH_SECTOR_SIZE);
+}
+
+uint16_t FlashJournal::checkRecord(uint8_t sector, uint16_t offset) {
+    const uint8_t *p = sectorAt(sector) + offset;
+    if (offset + FJ_REC_HDR_SIZE > FLASH_SECTOR_SIZE || p[0] >= FJ_MAX_TAGS || p[1] > FJ_MAX_LEN) {
+        return 0;
+    }
+    uint16_t size = recSize(p[1]);
+    if (offset + size > FLASH_SECTOR_SIZE) {
+        return 0;
+    }
+    uint16_t crc = crc16(p + FJ_REC_HDR_SIZE, p[1], crc16(p, 2));
+    return crc == (p[2] | p[3] << 8) ? size : 0;
+}
+
+bool FlashJournal::rotate(uint8_t tag, const uint8_t *rec, uint16_t size) {
+    uint8_t next = nextSector();
+    uint16_t newLatest[FJ_MAX_TAGS];
+    memset(newLatest, FJ_NO_RECORD, sizeof(newLatest));
+    bool answer = true;
+    if (!nextErased) {
+        erase(next);
+    }
+
+    // Carry the latest record for each of the other tags forward
+    uint16_t offset = FJ_HDR_SIZE;
+    for (uint8_t t = 0; t < FJ_MAX_TAGS && active >= 0; t++) {
+        if (t == tag || latest[t] == FJ_NO_RECORD) {
+            continue;
+        }
+        const uint8_t *p = sectorAt(active) + latest[t];
+        answer = program(next, offset, p, FJ_REC_HDR_SIZE + p[1]) && answer;
+        newLatest[t] = offset;
+        offset += recSize(p[1]);
+    }
+
+    // Add the new record
+    answer = program(next, offset, rec, FJ_REC_HDR_SIZE + rec[1]) && answer;
+    newLatest[tag] = offset;
+    offset += size;
+
+    // Last of all, the header that makes the sector the one in use
+    uint8_t hdr[FJ_HDR_SIZE];
+    uint32_t magic = FJ_MAGIC;
+    uint32_t nextSeq = seq + 1;
+    memset(hdr, 0xff, sizeof(hdr));
+    memcpy(hdr, &magic, sizeof(magic));
+    memcpy(hdr + 4, &nextSeq, sizeof(nextSeq));
+    uint16_t crc = crc16(hdr, 8);
+    hdr[8] = crc & 0xff;
+    hdr[9] = crc >> 8;
+    answer = program(next, 0, hdr, FJ_HDR_SIZE) && answer;
+
+    #ifdef FJ_DEBUG
+    Serial.printf("FlashJournal::rotate - Sector %d -> %d, seq %u, %d bytes carried forward.\n", 
+        active, next, nextSeq, offset - size - FJ_HDR_SIZE);
+    #endif
+    active = next;
+    seq = nextSeq;
+    head = offset;
+    memcpy(latest, newLatest, sizeof(latest));
+    nextErased = isErased(nextSector());
+    return answer;
+}
+
+void FlashJournal::erase(uint8_t sector) {
+    rp2040.idleOtherCore();
+    noInterrupts();
+    flash_range_erase(base + sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+    interrupts();
+    rp2040.resumeOtherCore();
+}
+
+bool FlashJournal::program(uint8_t sector, uint16_t offset, const uint8_t *data, uint16_t len) {
+    uint8_t page[FLASH_PAGE_SIZE];
+    uint8_t copy[FJ_REC_HDR_SIZE + FJ_MAX_LEN];
+    memcpy(copy, data, len);
+    uint32_t at = base + sector * FLASH_SECTOR_SIZE + offset;
+    const uint8_t *from = copy;
+    uint16_t togo = len;
+    while (togo > 0) {
+        uint32_t pageAt = at & ~(FLASH_PAGE_SIZE - 1);
+        uint16_t inPage = at - pageAt;
+        uint16_t n = togo < FLASH_PAGE_SIZE - inPage ? togo : FLASH_PAGE_SIZE - inPage;
+        memset(page, 0xff, sizeof(page));
+        memcpy(page + inPage, from, n);
+        rp2040.idleOtherCore();
+        noInterrupts();
+        flash_range_program(pageAt, page, FLASH_PAGE_SIZE);
+        interrupts();
+        rp2040.resumeOtherCore();
+        at += n;
+        from += n;
+        togo -= n;
+    }
+    return memcmp(sectorAt(sector) + offset, copy, len) == 0;
+}
+
+uint16_t FlashJournal::crc16(const uint8_t *data, uint16_t len, uint16_t crc) {
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,221 @@
+/****
+ * 
+ * This file is a part of the FlashJournal library. The library implements a small, 
+ * wear-leveled, log-structured store for the handful of records the firmware needs to keep 
+ * across reboots. It lives in a dedicated region of the RP2040's flash memory made up of a few 
+ * (at least two) 4 KB sectors.
+ * 
+ * Each record has a tag (0 .. FJ_MAX_TAGS - 1) that says what it is, and only the most recently 
+ * written record with a given tag matters. Writing a record appends it to the sector that's in 
+ * use, which costs a flash page program (or two, if the record straddles a page boundary) of 
+ * about a millisecond. Nothing is erased. Flash can be programmed more than once between 
+ * erases as long as each program only changes erased (0xff) bytes, which is what appending 
+ * does.
+ * 
+ * When the sector in use has no room for a record, the journal moves on to the next sector in 
+ * the region, round robin. It erases it, copies the latest record for each tag into it 
+ * (compacting away all the superseded ones), adds the new record and, last of all, writes the 
+ * sector's header, which carries a sequence number one larger than the previous sector's. So 
+ * erases are spread evenly over all the sectors, and there is one erase per sector's worth of 
+ * records rather than one per write.
+ * 
+ * An erase takes tens, sometimes hundreds, of milliseconds, where appending a record takes about 
+ * one, which is more than some callers can afford at some times. The erase needn't happen when 
+ * the journal moves on to the next sector, though; prepare() does it ahead of time, when the 
+ * caller can afford it. After that, fits() says whether a record can be written without 
+ * erasing anything, which it always can until the journal has moved on to the prepared sector.
+ * 
+ * Each record and each sector header carries a CRC. On begin(), the journal picks the sector 
+ * with a valid header and the highest sequence number and reads its records up to the first one 
+ * that's erased or fails its CRC. Because the header of a new sector is written only after 
+ * everything else in it, a power failure while moving to a new sector leaves the old sector in 
+ * charge, and a power failure while appending costs, at most, the record being written.
+ * 
+ * Flash can't be read while it's being erased or programmed, so the journal idles the other 
+ * core and turns interrupts off for the duration of each erase or program, the same way the 
+ * arduino-pico EEPROM library does.
+ * 
+ *****
+ * 
+ * FlashJournal V1.1.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE. 
+ * 
+ ****/
+
+#pragma once
+#ifndef Arduino_h
+    #include <Arduino.h>
+#endif
+#include <hardware/flash.h>
+
+//#define FJ_DEBUG                                // Uncomment to enable debug printing
+
+#define FJ_MAGIC                (0x4c4e524a)    // "JRNL": Marks a sector header
+#define FJ_HDR_SIZE             (16)            // Size of a sector header; records start after it
+#define FJ_REC_HDR_SIZE         (4u)            // Size of a record header
+#define FJ_MAX_TAGS             (8)             // Tags are 0 .. FJ_MAX_TAGS - 1
+#define FJ_MAX_LEN              (248)           // Largest record payload (bytes)
+#define FJ_NO_RECORD            (0)             // latest[] value for a tag with no record
+
+class FlashJournal {
+public:
+    /**
+     * @brief   Construct a new FlashJournal object using the specified region of flash
+     * 
+     * @param offset    The offset from the start of flash of the region. Must be a multiple of 
+     *                  FLASH_SECTOR_SIZE.
+     * @param sectors   The number of sectors in the region. Must be at least 2.
+     */
+    FlashJournal(uint32_t offset, uint8_t sectors);
+
+    /**
+     * @brief   Find the latest records in the journal. Call once before using read() or write().
+     * 
+     * @return true     Found a journal
+     * @return false    The region doesn't hold a journal (yet); there are no records
+     */
+    bool begin();
+
+    /**
+     * @brief   Get the payload of the most recently written record with the specified tag
+     * 
+     * @param tag       The tag
+     * @param data      Where to put the payload
+     * @param len       The length of the payload. Must match the length it was written with.
+     * @return true     Success
+     * @return false    There's no record with that tag and length; data is unchanged
+     */
+    bool read(uint8_t tag, void *data, uint8_t len);
+
+    /**
+     * @brief   Write a record, superseding any earlier one with the same tag. If the payload is 
+     *          the same as that of the latest record with the tag, nothing is written.
+     * 
+     * @param tag       The tag
+     * @param data      The payload
+     * @param len       The length of the payload (0 .. FJ_MAX_LEN)
+     * @return true     Success
+     * @return false    Bad tag or length, or the record didn't read back correctly
+     */
+    bool write(uint8_t tag, const void *data, uint8_t len);
+
+    /**
+     * @brief   Return whether a record with a payload of the specified length can be written 
+     *          without erasing anything
+     * 
+     * @param len       The length of the payload
+     * @return true     It can
+     * @return false    Writing it would mean erasing a sector first
+     */
+    bool fits(uint8_t len);
+
+    /**
+     * @brief   Erase the sector the journal moves on to next, if it isn't erased already, so that 
+     *          moving on to it doesn't need an erase. Call when a possible erase doesn't matter.
+     * 
+     */
+    void prepare();
+
+private:
+    /**
+     * @brief   Return the sector the journal moves on to next
+     * 
+     * @return uint8_t  The sector
+     */
+    uint8_t nextSector();
+
+    /**
+     * @brief   Return whether the specified sector is erased (all 0xff)
+     * 
+     * @param sector    The sector
+     * @return true     It is
+     * @return false    It isn't
+     */
+    bool isErased(uint8_t sector);
+
+    /**
+     * @brief   Return a pointer to where the specified sector can be read
+     * 
+     * @param sector            The sector (0 .. nSectors - 1)
+     * @return const uint8_t*   Its XIP address
+     */
+    const uint8_t *sectorAt(uint8_t sector);
+
+    /**
+     * @brief   Check the record at the specified offset in the specified sector
+     * 
+     * @param sector    The sector
+     * @param offset    The offset in the sector
+     * @return uint16_t The size of the record in flash if it's valid, 0 otherwise
+     */
+    uint16_t checkRecord(uint8_t sector, uint16_t offset);
+
+    /**
+     * @brief   Move to the next sector in the region, carrying along the latest record for each 
+     *          tag other than the specified one, which is replaced by the specified payload.
+     * 
+     * @param tag       The tag of the record being written
+     * @param rec       The record being written (header and payload)
+     * @param size      The size of the record in flash
+     * @return true     Success
+     * @return false    The new sector didn't read back correctly
+     */
+    bool rotate(uint8_t tag, const uint8_t *rec, uint16_t size);
+
+    /**
+     * @brief   Erase the specified sector
+     * 
+     * @param sector    The sector
+     */
+    void erase(uint8_t sector);
+
+    /**
+     * @brief   Program the specified bytes into flash at the specified offset in the specified 
+     *          sector. The bytes are copied to RAM before anything is programmed, so they may 
+     *          come from flash themselves.
+     * 
+     * @param sector    The sector
+     * @param offset    The offset in the sector
+     * @param data      The bytes to program
+     * @param len       The number of bytes
+     * @return true     They read back correctly
+     * @return false    They didn't
+     */
+    bool program(uint8_t sector, uint16_t offset, const uint8_t *data, uint16_t len);
+
+    /**
+     * @brief   Return the CRC-16/CCITT-FALSE of the specified bytes, or continue one
+     * 
+     * @param data      The bytes
+     * @param len       How many of them there are
+     * @param crc       The CRC so far, if continuing one
+     * @return uint16_t The CRC
+     */
+    static uint16_t crc16(const uint8_t *data, uint16_t len, uint16_t crc = 0xffff);
+
+    uint32_t base;                              // Offset in flash of the region
+    uint8_t nSectors;                           // Number of sectors in the region
+    int8_t active;                              // The sector in use or -1 if none
+    uint32_t seq;                               // The sequence number of the active sector
+    uint16_t head;                              // Offset in the active sector to append at
+    bool nextErased;                            // Whether the sector to move on to next is erased
+    uint16_t latest[FJ_MAX_TAGS];               // Offset of each tag's latest record or FJ_NO_RECORD
+};
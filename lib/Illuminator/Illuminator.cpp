@@ -4,8 +4,8 @@
  *  
  *****
  * 
- * Illuminator V1.1.0, June 2024
- * Copyright (C) 2024 D.L. Ehnebuske
+ * Illuminator V1.3.0, October 2026
+ * Copyright (C) 2024, 2026 D.L. Ehnebuske
  * 
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -42,17 +42,30 @@ const uint64_t atWx = 0b00000000000000000000000000000011111111111111111111111111
 const uint64_t atWn = 0b011111111111111111111111111111000000000000000000000000000000;
 
 /**
- * @brief Map a 0..100 sensor reading into its 0.0..1.0 trimmed log-based equivalent
- * 
- * @param ambPct    The 0..100 sensor reading
- * @return float    The mapped equivalent
+ * The mapping of a 0..100 sensor reading into its 0.0..1.0 trimmed log-based equivalent, in 
+ * IL_FACTOR_BITS fixed point, calculated by the compiler.
  */
-static float ambientFactor(int16_t ambPct) {
-    float answer = (ambPct - IL_AMB_LOWEST) * 100.0 / (IL_AMB_HIGHEST - IL_AMB_LOWEST);
+static constexpr CurveTable<uint16_t, 101> ambientFactor {[](uint16_t ambPct) {
+    double answer = (ambPct - IL_AMB_LOWEST) * 100.0 / (IL_AMB_HIGHEST - IL_AMB_LOWEST);
     answer = answer > 100.0 ? 100.0 : answer < 0.0 ? 0.0 : answer;
-    answer = log10(1 + IL_AMB_COEFF * answer) / log10(1 + IL_AMB_COEFF * 100.0);
-    return answer;
-}
+    answer = curveLog10(1 + IL_AMB_COEFF * answer) / curveLog10(1 + IL_AMB_COEFF * 100.0);
+    return curveFixed<uint16_t>(answer, IL_FACTOR_BITS);
+}};
+
+static_assert(ambientFactor[IL_AMB_LOWEST] == 0 && ambientFactor[IL_AMB_HIGHEST] == IL_FACTOR_ONE && 
+    ambientFactor[100] == IL_FACTOR_ONE, "ambientFactor table endpoints are wrong");
+
+/**
+ * The gamma curve: entry i is the fraction of full duty cycle, in IL_FACTOR_BITS fixed point, 
+ * that looks i / 2^IL_GAMMA_BITS as bright as full duty cycle does.
+ */
+static constexpr CurveTable<uint16_t, (1 << IL_GAMMA_BITS) + 1> gammaCurve {[](uint16_t i) {
+    return curveFixed<uint16_t>(curvePow((double)i / (1 << IL_GAMMA_BITS), IL_GAMMA), IL_FACTOR_BITS);
+}};
+
+static_assert(gammaCurve[0] == 0 && gammaCurve[1 << IL_GAMMA_BITS] == IL_FACTOR_ONE, "gammaCurve table endpoints are wrong");
+
+Illuminator *Illuminator::fader = nullptr;
 
 Illuminator::Illuminator(byte pin1, byte pin2, byte pin3) {
     waxingPin = pin1;
@@ -63,16 +76,30 @@ Illuminator::Illuminator(byte pin1, byte pin2, byte pin3) {
 void Illuminator::begin() {
     analogWriteFreq(IL_ANALOG_WRITE_FREQ);
     analogWriteRange(IL_ANALOG_RANGE);
+    if (fadeAlarm >= 0) {
+        hardware_alarm_cancel(fadeAlarm);
+        fadeArmed = false;
+    }
     pinMode(waxingPin, OUTPUT);
-    digitalWrite(waxingPin, LOW);
+    analogWrite(waxingPin, 0);                  // Let the core set up the PWM slice
+    gpio_set_function(waxingPin, GPIO_FUNC_PWM);
+    fade[IL_WAXING] = {.pin = waxingPin, .active = false, .toDuty = 0, .fromLevel = 0, .toLevel = 0, .curLevel = 0, .startMicros = 0};
     waxingIsLit = false;
     pinMode(waningPin, OUTPUT);
-    digitalWrite(waningPin, LOW);
+    analogWrite(waningPin, 0);
+    gpio_set_function(waningPin, GPIO_FUNC_PWM);
+    fade[IL_WANING] = {.pin = waningPin, .active = false, .toDuty = 0, .fromLevel = 0, .toLevel = 0, .curLevel = 0, .startMicros = 0};
     waningIsLit = false;
-    analogReadResolution(IL_ANALOG_READ_RES);
-    pinMode(sensorPin, INPUT);
+    if (fadeAlarm < 0) {
+        fadeAlarm = hardware_alarm_claim_unused(false);
+        if (fadeAlarm >= 0) {
+            fader = this;
+            hardware_alarm_set_callback(fadeAlarm, onFadeAlarm);
+        }
+    }
+    startSampling();
     curAmbient = readAmbient();
-    lastAmbientMillis = millis();
+    lastAmbientMicros = time_us_64();
     curBright = 100;
     waxingMaxDuty = IL_DEFAULT_MAX_DUTY;
     waningMaxDuty = IL_DEFAULT_MAX_DUTY;
@@ -82,32 +109,34 @@ void Illuminator::begin() {
 }
 
 void Illuminator::run() {
-    unsigned long curMillis = millis();
-    if (curMillis - lastAmbientMillis > IL_AMB_UPD_MILLIS) {
+    uint64_t now = time_us_64();
+    if (now - lastAmbientMicros > IL_AMB_UPD_MILLIS * 1000ULL) {
         int16_t newAmbient = (curAmbient * (IL_AMB_SMOOTHING - 1) + readAmbient()) / IL_AMB_SMOOTHING;
         if (newAmbient != curAmbient) {
             curAmbient = newAmbient;
-            float b = ambientFactor(curAmbient) * (curBright / 100.0);
-            int16_t waxingDuty = waxingIsLit ? (int16_t)(b * waxingMaxDuty) : 0;
-            int16_t waningDuty = waningIsLit ? (int16_t)(b * waningMaxDuty) : 0;
-            analogWrite(waxingPin, waxingDuty);
-            analogWrite(waningPin, waningDuty);
+            int16_t waxingDuty = waxingIsLit ? dutyFor(waxingMaxDuty) : 0;
+            int16_t waningDuty = waningIsLit ? dutyFor(waningMaxDuty) : 0;
+            setDuty(IL_WAXING, waxingDuty);
+            setDuty(IL_WANING, waningDuty);
             #ifdef IL_DEBUG
-            Serial.printf("Illuminator::run - curAmbient: %d, ambientFactor: %f, waxingDuty: %d, waningDuty: %d\n", 
-                curAmbient, ambientFactor(curAmbient), waxingDuty, waningDuty);
+            Serial.printf("Illuminator::run - curAmbient: %d, ambientFactor: %d/%d, waxingDuty: %d, waningDuty: %d\n", 
+                curAmbient, ambientFactor.at(curAmbient), IL_FACTOR_ONE, waxingDuty, waningDuty);
             #endif
         }
-        lastAmbientMillis = curMillis;
+        lastAmbientMicros = now;
     }
 }
 
+uint64_t Illuminator::getNextRunMicros() {
+    return lastAmbientMicros + IL_AMB_UPD_MILLIS * 1000ULL + 1;
+}
+
 void Illuminator::toPhase(int16_t phase) {
     phase = phase < 0 ? 0 : phase >= 60 ? 59 : phase;
     waxingIsLit = ((toWx >> phase) & 1) != 0;
     waningIsLit = ((toWn >> phase) & 1) != 0;
-    float b = ambientFactor(curAmbient) * (curBright / 100.0);
-    analogWrite(waxingPin, waxingIsLit ? (int16_t)(b * waxingMaxDuty) : 0);
-    analogWrite(waningPin, waningIsLit & 1 ? (int16_t)(b * waningMaxDuty) : 0);
+    setDuty(IL_WAXING, waxingIsLit ? dutyFor(waxingMaxDuty) : 0);
+    setDuty(IL_WANING, waningIsLit ? dutyFor(waningMaxDuty) : 0);
     #ifdef IL_PHASE_DEBUG
     Serial.printf("Illuminator::toPhase - Illuminator to phase %d. waxing %s waning %s\n", 
         phase, (toWx >> phase) & 1 ? "on" : "off", (toWn >> phase) & 1 ? "on" : "off");
@@ -118,9 +147,8 @@ void Illuminator::atPhase(int16_t phase) {
     phase = phase < 0 ? 0 : phase >= 60 ? 59 : phase;
     waxingIsLit = ((atWx >> phase) & 1) != 0;
     waningIsLit = ((atWn >> phase) & 1) != 0;
-    float b = ambientFactor(curAmbient) * (curBright / 100.0);
-    analogWrite(waxingPin, waxingIsLit ? (int16_t)(b * waxingMaxDuty) : 0);
-    analogWrite(waningPin, waningIsLit ? (int16_t)(b * waningMaxDuty) : 0);
+    setDuty(IL_WAXING, waxingIsLit ? dutyFor(waxingMaxDuty) : 0);
+    setDuty(IL_WANING, waningIsLit ? dutyFor(waningMaxDuty) : 0);
     #ifdef IL_PHASE_DEBUG
     Serial.printf("Illuminator::atPhase - Illuminator at phase %d. waxing %s waning %s\n", 
         phase, (atWx >> phase) & 1 ? "on" : "off", (atWn >> phase) & 1 ? "on" : "off");
@@ -135,9 +163,8 @@ void Illuminator::setBright(int16_t bright) {
     if (bright >= 0 && bright <= 100) {
         curBright = bright;
     #ifdef IL_DEBUG
-    float b = curBright / 100.0;
-    Serial.printf("Illuminator::setBright - Setting brightness to %d%, waxingDutyCycle: %d, waningDutyCycle: %d\n",
-                  curBright, (int16_t)(b * waxingMaxDuty), (int16_t)(b * waningMaxDuty));
+    Serial.printf("Illuminator::setBright - Setting brightness to %d%%, waxingDutyCycle: %d, waningDutyCycle: %d\n",
+                  curBright, curBright * waxingMaxDuty / 100, curBright * waningMaxDuty / 100);
     } else {
         Serial.printf("Illuminator::setBright - Brightness %d out of range; ignored.\n", bright);
     #endif
@@ -176,15 +203,202 @@ void Illuminator::setMaxDuty(bool waxing, int16_t newMaxDuty) {
 }
 
 float Illuminator::getAmbient() {
-    return ambientFactor(curAmbient);
+    return ambientFactor.at(curAmbient) / (float)IL_FACTOR_ONE;
+}
+
+int16_t Illuminator::getAmbientLevel() {
+    return curAmbient;
+}
+
+int16_t Illuminator::getDuty(bool waxing) {
+    return dutyForLevel(fade[waxing ? IL_WAXING : IL_WANING].curLevel);
+}
+
+uint16_t Illuminator::getFadeMillis() {
+    return fadeMicros / 1000;
+}
+
+void Illuminator::setFadeMillis(uint16_t millis) {
+    fadeMicros = millis * 1000u;
+}
+
+uint16_t Illuminator::ambientFactorFor(int16_t ambPct) {
+    return ambientFactor.at(ambPct);
+}
+
+uint16_t Illuminator::gammaFor(uint16_t i) {
+    return gammaCurve.at(i);
+}
+
+int16_t Illuminator::ambientForSum(uint32_t sum) {
+    // 100 less the average as a percentage of full scale, rounded up, as the float version did
+    const uint32_t fullSum = (uint32_t)IL_ADC_RING_LEN * IL_ANALOG_FULLSCALE;
+    return (int16_t)(100 - (sum * 100 + fullSum - 1) / fullSum);
 }
 
 // Private member functions
 
-int16_t Illuminator::readAmbient() {
-    float sensorReading = analogRead(sensorPin);
-    for (uint8_t s = 1; s < IL_SENSOR_SAMPLES; s++) {
-        sensorReading += analogRead(sensorPin);
+int16_t Illuminator::dutyFor(int16_t maxDuty) {
+    // IL_FACTOR_ONE * 100 * IL_ANALOG_RANGE fits comfortably in 32 bits
+    return (int16_t)((uint32_t)ambientFactor.at(curAmbient) * curBright * maxDuty / (IL_FACTOR_ONE * 100u));
+}
+
+void Illuminator::setDuty(uint8_t cob, int16_t duty) {
+    ilFade_t &f = fade[cob];
+    noInterrupts();                             // Keep the fade alarm's handler out while we change things
+    if (duty == f.toDuty) {
+        interrupts();
+        return;
+    }
+    f.toDuty = duty;
+    f.toLevel = levelForDuty(duty);
+    if (fadeAlarm < 0 || fadeMicros == 0) {
+        f.curLevel = f.toLevel;
+        f.active = false;
+        pwm_set_gpio_level(f.pin, duty);
+        interrupts();
+        return;
+    }
+    f.fromLevel = f.curLevel;
+    f.startMicros = time_us_64();
+    f.active = true;
+    if (!fadeArmed) {
+        fadeArmed = true;
+        uint64_t t = f.startMicros;
+        do {
+            t += IL_FADE_TICK_MICROS;
+        } while (hardware_alarm_set_target(fadeAlarm, from_us_since_boot(t)));
+    }
+    interrupts();
+    #ifdef IL_DEBUG
+    Serial.printf("Illuminator::setDuty - %s COB fading to duty cycle %d in %lu ms.\n", 
+        cob == IL_WAXING ? "Waxing" : "Waning", duty, fadeMicros / 1000);
+    #endif
+}
+
+bool Illuminator::stepFades() {
+    uint64_t now = time_us_64();
+    bool answer = false;
+    for (uint8_t cob = 0; cob < 2; cob++) {
+        ilFade_t &f = fade[cob];
+        if (!f.active) {
+            continue;
+        }
+        uint64_t elapsed = now - f.startMicros;
+        if (elapsed >= fadeMicros) {
+            f.curLevel = f.toLevel;
+            f.active = false;
+            pwm_set_gpio_level(f.pin, f.toDuty);
+            continue;
+        }
+        // Linear in perceptual level. |toLevel - fromLevel| * fadeMicros fits in 64 bits easily.
+        int64_t delta = (int64_t)f.toLevel - f.fromLevel;
+        f.curLevel = f.fromLevel + (int32_t)(delta * (int64_t)elapsed / (int64_t)fadeMicros);
+        pwm_set_gpio_level(f.pin, dutyForLevel(f.curLevel));
+        answer = true;
+    }
+    return answer;
+}
+
+void Illuminator::onFadeAlarm(uint alarmNum) {
+    Illuminator *il = fader;
+    if (il == nullptr) {
+        return;
     }
-    return static_cast<int16_t>(100 - ((sensorReading * 100) / (IL_SENSOR_SAMPLES * IL_ANALOG_FULLSCALE)));
+    if (!il->stepFades()) {
+        il->fadeArmed = false;
+        return;
     }
+    uint64_t t = time_us_64();
+    do {
+        t += IL_FADE_TICK_MICROS;
+    } while (hardware_alarm_set_target(alarmNum, from_us_since_boot(t)));
+}
+
+uint32_t Illuminator::levelForDuty(int16_t duty) {
+    uint32_t frac = (uint32_t)duty * IL_FACTOR_ONE / IL_ANALOG_RANGE;
+    if (frac >= IL_FACTOR_ONE) {
+        return IL_LEVEL_MAX;
+    }
+    // The first few gamma table entries all round to 0, and the search would land on the last
+    // of them, so a fade to off would aim a little above it
+    if (frac == 0) {
+        return 0;
+    }
+    // Binary search for the last gamma table entry <= frac, then interpolate
+    uint16_t lo = 0;
+    uint16_t hi = 1 << IL_GAMMA_BITS;
+    while (hi - lo > 1) {
+        uint16_t mid = (lo + hi) / 2;
+        if (gammaCurve[mid] <= frac) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    uint32_t span = gammaCurve[hi] - gammaCurve[lo];
+    uint32_t between = span == 0 ? 0 : ((frac - gammaCurve[lo]) << IL_LEVEL_FRAC_BITS) / span;
+    return ((uint32_t)lo << IL_LEVEL_FRAC_BITS) + between;
+}
+
+int16_t Illuminator::dutyForLevel(uint32_t level) {
+    if (level >= IL_LEVEL_MAX) {
+        return IL_ANALOG_RANGE;
+    }
+    uint16_t i = level >> IL_LEVEL_FRAC_BITS;
+    uint32_t between = level & ((1u << IL_LEVEL_FRAC_BITS) - 1);
+    uint32_t frac = gammaCurve[i] + (((uint32_t)(gammaCurve[i + 1] - gammaCurve[i]) * between) >> IL_LEVEL_FRAC_BITS);
+    return (int16_t)((frac * IL_ANALOG_RANGE + IL_FACTOR_ONE / 2) >> IL_FACTOR_BITS);
+}
+
+void Illuminator::startSampling() {
+    if (adcDma[0] >= 0) {
+        return;
+    }
+    adc_init();
+    adc_gpio_init(sensorPin);
+    adc_select_input(sensorPin - IL_ADC_FIRST_PIN);
+
+    // Prime the ring
+    uint32_t sum = 0;
+    for (uint8_t s = 0; s < IL_SENSOR_SAMPLES; s++) {
+        sum += adc_read();
+    }
+    for (uint16_t s = 0; s < IL_ADC_RING_LEN; s++) {
+        ambRing[s] = sum / IL_SENSOR_SAMPLES;
+    }
+
+    // Set up two DMA channels, each chained to the other, to move samples from the ADC FIFO into 
+    // the ring. Each does a ring's worth of samples and hands off to the other, which, since its 
+    // transfer count is reloaded when it's triggered, does the same. Round and round forever.
+    adcDma[0] = dma_claim_unused_channel(true);
+    adcDma[1] = dma_claim_unused_channel(true);
+    for (uint8_t d = 0; d < 2; d++) {
+        dma_channel_config c = dma_channel_get_default_config(adcDma[d]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+        channel_config_set_read_increment(&c, false);
+        channel_config_set_write_increment(&c, true);
+        channel_config_set_ring(&c, true, IL_ADC_RING_BITS + 1);    // Ring size in bytes is 2^(bits + 1)
+        channel_config_set_dreq(&c, DREQ_ADC);
+        channel_config_set_chain_to(&c, adcDma[1 - d]);
+        dma_channel_configure(adcDma[d], &c, ambRing, &adc_hw->fifo, IL_ADC_RING_LEN, false);
+    }
+
+    // Start the ADC running free
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv(IL_ADC_CLKDIV);
+    dma_channel_start(adcDma[0]);
+    adc_run(true);
+    #ifdef IL_DEBUG
+    Serial.printf("Illuminator::startSampling - ADC input %d at %d samples/s to DMA channels %d and %d.\n", 
+        sensorPin - IL_ADC_FIRST_PIN, IL_ADC_RATE, adcDma[0], adcDma[1]);
+    #endif
+}
+
+int16_t Illuminator::readAmbient() {
+    uint32_t sum = 0;
+    for (uint16_t s = 0; s < IL_ADC_RING_LEN; s++) {
+        sum += ambRing[s];
+    }
+    return ambientForSum(sum);
+}
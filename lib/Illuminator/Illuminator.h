@@ -7,10 +7,32 @@
  * Because there are too many LEDs in each set to drive directly from a GPIO pin, each set is 
  * driven using a channel of a ULN2003 transistor array chip.
  * 
+ * The brightness of the LEDs follows the ambient light, as measured by a phototransistor on one 
+ * of the ADC inputs. The ADC runs free, sampling the phototransistor IL_ADC_RATE times a second, 
+ * and a pair of DMA channels, each chained to the other, moves the samples into a ring buffer 
+ * holding the most recent IL_ADC_RING_LEN of them, all without any help from the CPU. Once a 
+ * second, run() averages the whole ring (a few microseconds of integer adds) and folds the 
+ * result into its smoothed ambient light level. So the light level is heavily oversampled, and 
+ * reading it costs next to nothing.
+ * 
+ * The smoothed ambient light level is mapped to a brightness factor by a log-like curve that 
+ * the compiler works out in advance (see CurveTable.h). So from the sensor samples to the PWM 
+ * duty cycle, everything is integer math.
+ * 
+ * Changes in the duty cycle of a COB -- when it's turned on or off as the phase changes, or 
+ * when the ambient light changes -- aren't made in a single jump. Instead, the COB fades to 
+ * its new duty cycle over a settable time (IL_FADE_MILLIS by default). Fades are spaced evenly 
+ * in perceived brightness rather than in duty cycle: each COB has a perceptual "level" that 
+ * moves linearly from where it is to where it's going, and the duty cycle for a level is given 
+ * by a gamma curve (again worked out by the compiler). The steps are made by a hardware alarm 
+ * whose interrupt handler sets the new PWM levels every IL_FADE_TICK_MICROS and then, if any 
+ * fade is still underway, rearms the alarm. So a fade costs the caller nothing beyond starting 
+ * it, no matter how long it lasts, and when nothing is fading there are no interrupts at all.
+ * 
  *****
  * 
- * Illuminator V1.1.0, June 2024
- * Copyright (C) 2024 D.L. Ehnebuske
+ * Illuminator V1.3.0, October 2026
+ * Copyright (C) 2024, 2026 D.L. Ehnebuske
  * 
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -36,18 +58,39 @@
 #ifndef Arduino_h
     #include <Arduino.h>
 #endif
+#include <hardware/adc.h>
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/pwm.h>
+#include <hardware/timer.h>
+#include <CurveTable.h>
 
 #define IL_ANALOG_WRITE_FREQ    (2000)          // The frequency (Hz) to use for the PWM signal
 #define IL_ANALOG_RANGE         (1000)          // analogWite with this value is 100% duty cycle
-#define IL_ANALOG_READ_RES      (12)            // The analog read resolution (bits)
+#define IL_ANALOG_READ_RES      (12)            // The ADC's resolution (bits)
 #define IL_ANALOG_FULLSCALE     ((1 << IL_ANALOG_READ_RES) - 1) // The max possible reading on the analog sensor
 #define IL_DEFAULT_MAX_DUTY     (500)           // Default duty cycle corresponding to 100% brightness
-#define IL_SENSOR_SAMPLES       (5)             // Number of ambient light sensor samples to average during a reading
+#define IL_SENSOR_SAMPLES       (5)             // Number of samples averaged to prime the sample ring
+#define IL_ADC_FIRST_PIN        (26)            // The GPIO pin of ADC input 0
+#define IL_ADC_RATE             (1000)          // Free-running ADC samples per second
+#define IL_ADC_CLKDIV           (48000000 / IL_ADC_RATE - 1)   // ADC clock (48 MHz) divisor for IL_ADC_RATE
+#define IL_ADC_RING_BITS        (8)             // log2 of the number of samples in the sample ring
+#define IL_ADC_RING_LEN         (1 << IL_ADC_RING_BITS)     // Number of samples in the sample ring
 #define IL_AMB_UPD_MILLIS       (1000)          // How often (millis()) to update curAmbient
 #define IL_AMB_SMOOTHING        (6)             // curAmbient running average smoothing factor
 #define IL_AMB_COEFF            (0.1)           // Coeefficient in log scaling of ambient output
 #define IL_AMB_LOWEST           (4)             // curAmb = this or lower ==> no lights
 #define IL_AMB_HIGHEST          (75)            // curAmb = this or higher ==> fully bright lights
+#define IL_FACTOR_BITS          (15)            // Fraction bits in the fixed-point ambient factor
+#define IL_FACTOR_ONE           (1u << IL_FACTOR_BITS)  // An ambient factor of 1.0 in fixed point
+#define IL_FADE_MILLIS          (750)           // Default time (millis) a COB takes to fade to a new duty cycle
+#define IL_FADE_TICK_MICROS     (10000)         // Time (micros) between fade steps
+#define IL_GAMMA                (2.2)           // Duty cycle = (perceived brightness)^IL_GAMMA
+#define IL_GAMMA_BITS           (8)             // log2 of the number of intervals in the gamma table
+#define IL_LEVEL_FRAC_BITS      (8)             // Bits of perceptual level between gamma table entries
+#define IL_LEVEL_MAX            (1u << (IL_GAMMA_BITS + IL_LEVEL_FRAC_BITS))  // Perceptual level of 100% duty
+#define IL_WAXING               (0)             // Index of the waxing COB's fade
+#define IL_WANING               (1)             // Index of the waning COB's fade
 
 //#define IL_DEBUG                                // Uncomment to enable debugging code
 
@@ -74,6 +117,13 @@ public:
      */
     void run();
 
+    /**
+     * @brief Get the time_us_64() at which run() next has something to do
+     * 
+     * @return uint64_t     The time_us_64() of the next ambient light update
+     */
+    uint64_t getNextRunMicros();
+
     /**
      * @brief Illuminate the display appropriately for moving to the specified phase
      * 
@@ -117,6 +167,21 @@ public:
      */
     float getAmbient();
 
+    /**
+     * @brief Get the current smoothed ambient light level
+     * 
+     * @return int16_t  The ambient light level 0..100, 0 is dark
+     */
+    int16_t getAmbientLevel();
+
+    /**
+     * @brief Get the duty cycle a COB is at right now (partway through a fade if one's underway)
+     * 
+     * @param waxing    true => get the waxing COB's duty cycle, false the waning COB's
+     * @return int16_t  The duty cycle (0..IL_ANALOG_RANGE)
+     */
+    int16_t getDuty(bool waxing);
+
     /**
      * @brief Set the duty cycle corresponding to 100% brightness
      * 
@@ -133,15 +198,125 @@ public:
      */
     void setMaxDuty(bool waxing, int16_t newMaxDuty);
 
+    /**
+     * @brief Get the time a COB takes to fade from one duty cycle to another
+     * 
+     * @return uint16_t The fade time in millis()
+     */
+    uint16_t getFadeMillis();
+
+    /**
+     * @brief Set the time a COB takes to fade from one duty cycle to another
+     * 
+     * @param millis    The fade time in millis(); 0 ==> change duty cycles immediately
+     */
+    void setFadeMillis(uint16_t millis);
+
+    /**
+     * @brief Get the ambient light factor for an ambient light level, as used for the duty cycle
+     * 
+     * @param ambPct    The ambient light level 0..100 (clamped), 0 is dark
+     * @return uint16_t The factor (0..IL_FACTOR_ONE) in IL_FACTOR_BITS fixed point
+     */
+    static uint16_t ambientFactorFor(int16_t ambPct);
+
+    /**
+     * @brief Get entry i of the gamma curve: the fraction of full duty cycle that looks 
+     *        i / 2^IL_GAMMA_BITS as bright as full duty cycle does
+     * 
+     * @param i         The entry (0..2^IL_GAMMA_BITS)
+     * @return uint16_t The fraction (0..IL_FACTOR_ONE) in IL_FACTOR_BITS fixed point
+     */
+    static uint16_t gammaFor(uint16_t i);
+
+    /**
+     * @brief Get the ambient light level given by the sum of a full sample ring's worth of 
+     *        sensor samples
+     * 
+     * @param sum       The sum of IL_ADC_RING_LEN samples (0..IL_ADC_RING_LEN * IL_ANALOG_FULLSCALE)
+     * @return int16_t  The ambient light level 0..100, 0 is dark
+     */
+    static int16_t ambientForSum(uint32_t sum);
+
 private:
 
     /**
-     * @brief   Read the ambient light sensor and return its value, 0..100
+     * @brief   Start the ADC sampling the ambient light sensor into the sample ring, priming the 
+     *          ring with the average of a few one-off samples so that it's meaningful right away.
+     *          Only the first call does anything.
+     * 
+     */
+    void startSampling();
+
+    /**
+     * @brief   Return the ambient light level, 0..100, as given by the average of the samples in 
+     *          the sample ring
      * 
      * @return int16_t The current ambient light level 0..100, 0 is dark
      */
     int16_t readAmbient();
 
+    /**
+     * @brief   Return the duty cycle for a COB given its maxDuty, the current brightness and the 
+     *          current ambient light level
+     * 
+     * @param maxDuty   The COB's duty cycle for 100% brightness
+     * @return int16_t  The duty cycle to use
+     */
+    int16_t dutyFor(int16_t maxDuty);
+
+    /**
+     * @brief   Set the duty cycle of a COB, fading to it if fades are enabled
+     * 
+     * @param cob   IL_WAXING or IL_WANING
+     * @param duty  The duty cycle (0..IL_ANALOG_RANGE)
+     */
+    void setDuty(uint8_t cob, int16_t duty);
+
+    /**
+     * @brief   Take one step of each fade that's underway. Returns whether any still are.
+     * 
+     * @return true     At least one fade is still underway
+     * @return false    Fading is done
+     */
+    bool stepFades();
+
+    /**
+     * @brief   The hardware alarm's interrupt handler. Steps the fades and, if they're not done, 
+     *          rearms the alarm.
+     * 
+     * @param alarmNum  The hardware alarm's number
+     */
+    static void onFadeAlarm(uint alarmNum);
+
+    /**
+     * @brief   Return the perceptual level corresponding to a duty cycle
+     * 
+     * @param duty          The duty cycle (0..IL_ANALOG_RANGE)
+     * @return uint32_t     The level (0..IL_LEVEL_MAX)
+     */
+    static uint32_t levelForDuty(int16_t duty);
+
+    /**
+     * @brief   Return the duty cycle corresponding to a perceptual level
+     * 
+     * @param level     The level (0..IL_LEVEL_MAX)
+     * @return int16_t  The duty cycle (0..IL_ANALOG_RANGE)
+     */
+    static int16_t dutyForLevel(uint32_t level);
+
+    struct ilFade_t {                   // The state of one COB's fade
+        byte pin;                       //   The COB's GPIO pin
+        bool active;                    //   Whether a fade is underway
+        int16_t toDuty;                 //   The duty cycle being faded to
+        uint32_t fromLevel;             //   The perceptual level the fade started from
+        uint32_t toLevel;               //   The perceptual level being faded to
+        uint32_t curLevel;              //   The perceptual level now
+        uint64_t startMicros;           //   time_us_64() when the fade started
+    };
+
+    static Illuminator *fader;          // The Illuminator the fade alarm's handler serves
+
     byte waxingPin;                     // The pin controlling the set of LEDs for the waxing phases
     byte waningPin;                     // The pin controlling the set of LEDs for the waning phases
     byte sensorPin;                     // The pin to which the ambient light sensor is attached
@@ -151,5 +326,12 @@ private:
     bool waningIsLit;                   // True if waning COB is lit (when the ambient light is bright enough)
     int16_t curBright;                  // The current percent of maximum brightness to use when a COB is on
     int16_t curAmbient;                 // The current ambient brightness 0..100. 0 is dark, 100 is bright
-    unsigned long lastAmbientMillis;    // millis() at last update of curAmbeint
+    uint64_t lastAmbientMicros;         // time_us_64() at last update of curAmbient
+    int adcDma[2] = {-1, -1};           // The DMA channels moving samples to ambRing; -1 until started
+    int fadeAlarm = -1;                 // The hardware alarm that steps fades; -1 until claimed
+    bool fadeArmed = false;             // Whether the fade alarm is armed
+    uint32_t fadeMicros = IL_FADE_MILLIS * 1000u;   // The time a fade takes
+    ilFade_t fade[2];                   // The fades of the waxing [IL_WAXING] and waning [IL_WANING] COBs
+    alignas(IL_ADC_RING_LEN * sizeof(uint16_t))
+    volatile uint16_t ambRing[IL_ADC_RING_LEN]; // The most recent ambient light sensor samples (DMA ring)
 };
\ No newline at end of file
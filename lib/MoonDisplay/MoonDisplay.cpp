@@ -4,7 +4,7 @@
  *  
  *****
  * 
- * MoonDisplay V1.1.0, June 2024
+ * MoonDisplay V1.7.0, October 2026
  * Copyright (C) 2024 D.L. Ehnebuske
  * 
  * Permission is hereby granted, free of charge, to any person obtaining a copy
@@ -28,7 +28,7 @@
  ****/
 #include <MoonDisplay.h>
 
-static const float phasePva[60] = {     // Pivot angle (degrees) for each lunation display phase
+static constexpr float phasePva[MD_PHASES] = {    // Pivot angle (degrees) for each lunation display phase
     -78, -78, -75.5, -73.5, -71, -67, -63,  -58,  -53, -47,
     -40, -33, -25,   -18,   -10,  10,  18,   25,   33,  40,
      47,  53,  58,    63,    67,  71,  73.5, 75.5, 78,  78,
@@ -37,168 +37,718 @@ static const float phasePva[60] = {     // Pivot angle (degrees) for each lunati
      47,  53,  58,    63,    67,  71,  73.5, 75.5, 78,  78
 };
 
+struct phaseTargets_t {                 // The {pv, ls} motor targets for each phase, built at compile time
+    mdTarget_t at[MD_PHASES];
+    constexpr phaseTargets_t() : at() {
+        for (int16_t p = 0; p < MD_PHASES; p++) {
+            at[p].pv = MoonDisplay::degToPv(phasePva[p]);
+            at[p].ls = MoonDisplay::pvToLs(at[p].pv);
+        }
+    }
+};
+static constexpr phaseTargets_t phaseTarget {};
+
+static constexpr int32_t homeEdge[ME_AXES] = {MD_HOME_PV, MD_HOME_LS};              // Where each axis's home flag's edge is
+static constexpr int32_t homeSlack[ME_AXES] = {MD_HOME_PV_SLACK, MD_HOME_LS_SLACK}; // How far past it each may search
+
+// The motion profiles. The compiler works out their acceleration tables (see MotionEngine.h).
+static constexpr MotionProfile lsProfile {TOP_SPEED, MD_LS_MAX_SPEED, MD_ACCEL, MD_JERK};       // The leadscrew's usual
+static constexpr MotionProfile pvProfile {TOP_SPEED / 2, MD_PV_MAX_SPEED, MD_ACCEL, MD_JERK};   // The pivot's usual
+static constexpr MotionProfile homeProfile {MD_HOME_SLOW_SPEED, MD_HOME_SLOW_SPEED, MD_ACCEL, 0}; // Creeping up on a home flag
+
+/**
+ * @brief   Return the pivot position (steps) for the specified fractional phase in track mode. 
+ *          It's interpolated between the positions of the phases in the same half of the 
+ *          lunation, placing each phase's position at the middle of the phase. In the first 
+ *          and last half phase of each half, there's nothing to interpolate toward, so it's the 
+ *          position of the first or last phase.
+ * 
+ * @param phaseFrac The phase in 1/MD_PHASE_FRAC phase units: 0 .. MD_PHASES * MD_PHASE_FRAC - 1
+ * @return int32_t  The pivot position
+ */
+static constexpr int32_t fracToPv(int32_t phaseFrac) {
+    int32_t half = phaseFrac >= MD_PHASES / 2 * MD_PHASE_FRAC ? MD_PHASES / 2 : 0;
+    int32_t x = phaseFrac - half * MD_PHASE_FRAC - MD_PHASE_FRAC / 2;
+    x = x < 0 ? 0 : x > (MD_PHASES / 2 - 1) * MD_PHASE_FRAC ? (MD_PHASES / 2 - 1) * MD_PHASE_FRAC : x;
+    int32_t p = half + x / MD_PHASE_FRAC;
+    int32_t r = x % MD_PHASE_FRAC;
+    return r == 0 ? phaseTarget.at[p].pv : 
+        phaseTarget.at[p].pv + (phaseTarget.at[p + 1].pv - phaseTarget.at[p].pv) * r / MD_PHASE_FRAC;
+}
+
+/**
+ * @brief   Return whether fracToPv() puts each phase's position at the middle of the phase and 
+ *          never moves the pivot backward within a half of the lunation, so that tracking only 
+ *          ever makes small forward moves between resets.
+ * 
+ * @return true     It does
+ * @return false    It doesn't
+ */
+static constexpr bool fracToPvTracks() {
+    for (int32_t f = 0; f < MD_PHASES * MD_PHASE_FRAC; f++) {
+        if (f % MD_PHASE_FRAC == MD_PHASE_FRAC / 2 && fracToPv(f) != phaseTarget.at[f / MD_PHASE_FRAC].pv) {
+            return false;
+        }
+        if (f % (MD_PHASES / 2 * MD_PHASE_FRAC) != 0 && fracToPv(f) < fracToPv(f - 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compile-time checks of the integer calibration curve against the floating point one it replaced
+
+/**
+ * @brief   The calibration curve as originally evaluated, in floating point. Only used at 
+ *          compile time, to check pvToLs().
+ * 
+ * @param pv    The position (in steps) of the pivot
+ * @return int32_t 
+ */
+static constexpr int32_t pvToLsFp(int32_t pv) {
+    return pv >= 0 ? (int32_t)(497671.0 + 30.5 * pv - 0.201 * pv * pv) : (int32_t)(497671.0 - 30.5 * pv - 0.201 * pv * pv);
+}
+
+/**
+ * @brief   Return whether pvToLs() agrees with pvToLsFp() over the whole calibrated range. The 
+ *          only disagreements allowed are where the exact value is a whole number of steps and 
+ *          floating point rounding left pvToLsFp() just short of it (at |pv| = 1400 and 1600), 
+ *          so that truncation took it down a step.
+ * 
+ * @return true     They agree
+ * @return false    They don't
+ */
+static constexpr bool pvToLsAgrees() {
+    for (int32_t pv = -MD_CAL_MAX_PV; pv <= MD_CAL_MAX_PV; pv++) {
+        int32_t a = pv >= 0 ? pv : -pv;
+        bool whole = (MD_CAL_LS0 + MD_CAL_LS1 * a - MD_CAL_LS2 * a * a) % 1000 == 0;
+        int32_t diff = MoonDisplay::pvToLs(pv) - pvToLsFp(pv);
+        if (!(diff == 0 || (whole && diff == 1))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief   Return whether the phase target table is bit-for-bit what the floating point 
+ *          functions it replaced computed at run time.
+ * 
+ * @return true     It is
+ * @return false    It isn't
+ */
+static constexpr bool phaseTargetsAgree() {
+    for (int16_t p = 0; p < MD_PHASES; p++) {
+        int32_t pv = (int32_t)(20.48 * phasePva[p]);
+        if (phaseTarget.at[p].pv != pv || phaseTarget.at[p].ls != pvToLsFp(pv)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert((int64_t)MD_CAL_LS0 + (int64_t)MD_CAL_LS1 * MD_CAL_MAX_PV <= INT32_MAX && 
+    (int64_t)MD_CAL_LS2 * MD_CAL_MAX_PV * MD_CAL_MAX_PV <= INT32_MAX, "pvToLs() would overflow int32_t within the calibrated range");
+static_assert(MoonDisplay::pvToLs(INT32_MAX) == MoonDisplay::pvToLs(MD_CAL_MAX_PV) && 
+    MoonDisplay::pvToLs(INT32_MIN) == MoonDisplay::pvToLs(-MD_CAL_MAX_PV), "pvToLs() doesn't hold steady past the calibrated range");
+static_assert(pvToLsAgrees(), "Integer pvToLs() disagrees with the floating point calibration curve");
+static_assert(phaseTargetsAgree(), "Phase target table disagrees with the floating point calculation");
+static_assert(fracToPvTracks(), "Track mode pivot positions don't match the phase targets");
+static_assert(phaseTarget.at[0].pv == phaseTarget.at[MD_PHASES / 2].pv && phaseTarget.at[0].ls == phaseTarget.at[MD_PHASES / 2].ls, 
+    "A reset sweep to phase 0 or 30 needs them to share a position");
+
 // Public instance member functions
 
-MoonDisplay::MoonDisplay(const byte p[4], const byte l[4], const byte i[3]) {
-    pvMotor = new ULN2003();
-    pvPins[0] = p[0]; pvPins[1] = p[1]; pvPins[2] = p[2]; pvPins[3] = p[3]; 
-    lsMotor = new ULN2003();
-    lsPins[0] = l[0]; lsPins[1] = l[1]; lsPins[2] = l[2]; lsPins[3] = l[3]; 
+MoonDisplay::MoonDisplay(const byte p[4], const byte l[4], const byte i[3], const byte h[2]) {
+    motion = new MotionEngine(p, l);
     illum = new Illuminator {i[0], i[1], i[2]};
+    homePin[ME_PV] = h[0];
+    homePin[ME_LS] = h[1];
 }
 
 void MoonDisplay::begin(int32_t phase) {
-    int32_t initPv = degToPv(phasePva[phase]);
-    int32_t initLs = pvToLs(initPv);
-    lsMotor->begin(lsPins[0], lsPins[1], lsPins[2], lsPins[3]);
-    lsMotor->setModulus(0);
-    lsMotor->setSpeed(TOP_SPEED);
-    lsMotor->setLocation(initLs);
-    pvMotor->begin(pvPins[0], pvPins[1], pvPins[2], pvPins[3]);
-    pvMotor->setModulus(0);
-    pvMotor->setSpeed(TOP_SPEED / 2);
-    pvMotor->setLocation(initPv);
-    tgtPhase = curPhase = phase;
-    underway = resetting = false;
-    illum->begin();
-    illum->atPhase(curPhase);
-    #ifdef MD_DEBUG
-    Serial.printf("MoonDisplay::begin - Starting at phase %d.\n", phase); 
-    #endif
+    // Core 1 doesn't publish anything until it has carried out the begin command, so until then 
+    // core 0 is the snapshot's only writer.
+    status.write({
+        phaseTarget.at[phase].pv,               // pv
+        phaseTarget.at[phase].ls,               // ls
+        (int16_t)phase,                         // phase
+        -1,                                     // arrivedPhase
+        0,                                      // arrivals
+        false,                                  // busy
+        (int16_t)phase,                         // tgtPhase
+        false,                                  // resetting
+        false,                                  // underway
+        false,                                  // tracking
+        false,                                  // energized
+        0,                                      // ambient
+        {0, 0},                                 // duty
+        0,                                      // runs
+        0,                                      // runMicros
+        0,                                      // maxRunMicros
+        (int16_t)phase,                         // resetTgt
+        0,                                      // tgtFrac
+        0,                                      // checkpoints
+        false,                                  // homing
+        MD_HOME_NEVER,                          // homeResult
+        0,                                      // homePvOff
+        0                                       // homeLsOff
+    });
+    arrivalsSeen = 0;
+    checkpointsSeen = 0;
+    post(MD_CMD_BEGIN, phase);
+}
+
+bool MoonDisplay::resume(const mdCheckpoint_t &cp) {
+    if (cp.curPhase < 0 || cp.curPhase >= MD_PHASES || cp.tgtPhase < 0 || cp.tgtPhase >= MD_PHASES || 
+        cp.resetTgt < 0 || cp.resetTgt >= MD_PHASES || cp.tgtFrac < 0 || cp.tgtFrac >= MD_PHASES * MD_PHASE_FRAC || 
+        cp.pv < -MD_CAL_MAX_PV || cp.pv > MD_CAL_MAX_PV) {
+        return false;
+    }
+    // As with begin(), core 0 is the snapshot's only writer until core 1 has carried out the 
+    // command
+    bool busy = cp.underway || cp.resetting || cp.curPhase != cp.tgtPhase;
+    status.write({
+        cp.pv,                                  // pv
+        cp.ls,                                  // ls
+        cp.curPhase,                            // phase
+        -1,                                     // arrivedPhase
+        0,                                      // arrivals
+        busy,                                   // busy
+        cp.tgtPhase,                            // tgtPhase
+        cp.resetting,                           // resetting
+        cp.underway,                            // underway
+        cp.tracking,                            // tracking
+        false,                                  // energized
+        0,                                      // ambient
+        {0, 0},                                 // duty
+        0,                                      // runs
+        0,                                      // runMicros
+        0,                                      // maxRunMicros
+        cp.resetTgt,                            // resetTgt
+        cp.tgtFrac,                             // tgtFrac
+        0,                                      // checkpoints
+        false,                                  // homing
+        MD_HOME_NEVER,                          // homeResult
+        0,                                      // homePvOff
+        0                                       // homeLsOff
+    });
+    arrivalsSeen = 0;
+    checkpointsSeen = 0;
+    resumeFrom = cp;
+    return post(MD_CMD_RESUME);
+}
+
+bool MoonDisplay::checkpoint(mdCheckpoint_t &cp) {
+    mdStatus_t s = status.read();
+    if (s.checkpoints == checkpointsSeen) {
+        return false;
+    }
+    checkpointsSeen = s.checkpoints;
+    cp = {s.pv, s.ls, s.tgtFrac, s.phase, s.tgtPhase, s.resetTgt, s.resetting, s.underway, s.tracking};
+    return true;
 }
 
 int16_t MoonDisplay::run() {
+    mdStatus_t s = status.read();
+    if (s.arrivals == arrivalsSeen) {
+        return -1;                              // Let the outside world know nothing exciting happened
+    }
+    arrivalsSeen = s.arrivals;
+    return s.arrivedPhase;                      // Let the outside world know we completed a move
+}
+
+void MoonDisplay::runMotion() {
+    uint64_t start = time_us_64();
+    mdCmd_t cmd;
+    while (cmds.pop(cmd)) {
+        execute(cmd);
+    }
+    if (!begun) {
+        return;
+    }
+
+    bool arrived = false;
     illum->run();   // Let the Illiminator do its thing
+    feedPath();     // Keep the motion engine supplied with waypoints
+    if (homeStep != MD_HOME_IDLE) {
+        runHoming();
+    }
 
     // If no motors are running we might need to do something
-    if (!lsMotor->isMoving() && !pvMotor->isMoving()) {
+    if (!isBusy()) {
         // If the current and target phases don't match, we need to move the display
         if (curPhase != tgtPhase) {
             #ifdef MD_DEBUG
-            Serial.printf("MoonDisplay::run - At phase %d %s phase %d\n", curPhase, (resetting ? "resetting to" : "aiming at"), tgtPhase);
+            Serial.printf("MoonDisplay::runMotion - At phase %d %s phase %d\n", curPhase, (resetting ? "resetting to" : "aiming at"), tgtPhase);
             #endif
             if (!resetting) {
                 illum->toPhase(tgtPhase);
             }
             // Choose the next step on our way
-            curPhase += resetting ? -1 : 1;
-            // If it's a transition from phase 59 to phase 0, we need to begin by resetting to phase 30 
-            if (!resetting && curPhase == 60) {
+            curPhase = (curPhase + 1) % MD_PHASES;
+            // If it's a transition from phase 59 to phase 0 or from phase 29 to phase 30, the 
+            // terminator has to be reset from one extreme to the other. Phases 0 and 30 share a 
+            // position, so the reset is a single, continuous sweep straight to it.
+            if (curPhase == 0 || curPhase == MD_PHASES / 2) {
                 #ifdef MD_DEBUG
-                Serial.println("MoonDisplay::run - Transition 59 -> 0: Need to reset to phase 30");
+                Serial.printf("MoonDisplay::runMotion - Transition %d -> %d: Need to reset\n", (curPhase + MD_PHASES - 1) % MD_PHASES, curPhase);
                 #endif
                 resetTgt = tgtPhase;    // Remember the target while reset is underway
-                tgtPhase = 30;          // The reset target is 30
-                curPhase = 58;          // The next step from 59 toward 30 is 58
+                tgtPhase = curPhase;    // The reset target is the phase the transition is to
                 resetting = true;
             }
-            //if it's a transition from phase 29 to phase 30, need to begin by resetting to phase 0
-            if (!resetting && curPhase == 30) {
-                #ifdef MD_DEBUG
-                Serial.println("MoonDisplay::run - Transition 29 -> 30: Need to reset to phase 0");
-                #endif
-                resetTgt = tgtPhase;    // Remember the target while reset is underway
-                tgtPhase = 0;           // The reset target is 0
-                curPhase = 28;          // The next step from 29 toward 0 is 28
-                resetting = true;
-            }
-            int32_t pv = degToPv(phasePva[curPhase]);
-            int32_t ls = pvToLs(pv);
-            lsMotor->driveTo(ls);
-            pvMotor->driveTo(pv);
+            // In track mode, the last step goes straight to where the terminator should be now
+            startPath(tracking && !resetting && curPhase == tgtPhase ? fracToPv(tgtFrac) : phaseTarget.at[curPhase].pv);
             underway = true;
         // Otherwise we're stationary at the target phase
         } else {
-            // If we're in the middle of a reset we might be done with it
+            // If we're in the middle of a reset, we're done with it
             if (resetting) {
-                // if we're at phase 0, that means the reset needed to get to phase 30 is complete
-                if (curPhase == 0) {
-                    curPhase = 30;
-                    tgtPhase = resetTgt;
-                    resetting = false;
-                    #ifdef MD_DEBUG
-                    Serial.printf("MoonDisplay::run - Reset to 0 complete. Continuing with move to %d.\n", tgtPhase);
-                    #endif
-                // Otherwise, if we're at phase 30, that means the reset needed to get to phase 0 is complete
-                } else if (curPhase == 30) {
-                    curPhase = 0;
-                    tgtPhase = resetTgt;
-                    resetting = false;
-                    #ifdef MD_DEBUG
-                    Serial.printf("MoonDisplay::run - Reset to 30 complete. Continuing with move to %d.\n", tgtPhase);
-                    #endif
-                }
+                tgtPhase = resetTgt;
+                resetting = false;
+                #ifdef MD_DEBUG
+                Serial.printf("MoonDisplay::runMotion - Reset to %d complete. Continuing with move to %d.\n", curPhase, tgtPhase);
+                #endif
             }
             // If we've been underway, we've just come to a stop
             if (underway) {
                 underway = false;
                 #ifdef MD_DEBUG
-                Serial.printf("MoodDisplay::run - Now at phase %d.\n", + curPhase);
+                Serial.printf("MoodDisplay::runMotion - Now at phase %d.\n", + curPhase);
                 #endif
                 illum->atPhase(curPhase);
-                return curPhase;                // Let the outside world know we completed a move to curPhase
+                arrivedPhase = curPhase;        // Let the outside world know we completed a move to curPhase
+                arrivals++;
+                arrived = true;
+            }
+            // In track mode, keep the terminator where the fractional phase says it should be. 
+            // These small moves don't change the phase, so they aren't arrivals.
+            if (tracking && !resetting && curPhase == tgtPhase && fracToPv(tgtFrac) != motion->getPosition(ME_PV)) {
+                startPath(fracToPv(tgtFrac));
+            // Stationary with nowhere to go. The gearing holds the mechanism in place, so stop 
+            // paying to have the coils hold it too.
+            } else if (curPhase == tgtPhase) {
+                motion->release();
             }
         }
     }
-    return -1;                                  // Let the outside world know nothing exciting happened
+    bool checkpointed = requestCheckpoint();
+    uint32_t took = (uint32_t)(time_us_64() - start);
+    runs++;
+    runMicros += took;
+    maxRunMicros = took > maxRunMicros ? took : maxRunMicros;
+    publish();
+    if (arrived || checkpointed) {
+        __sev();                                // Wake core 0 so it hears about the arrival or saves the checkpoint
+    }
+}
+
+uint64_t MoonDisplay::getWakeMicros() {
+    if (!begun) {
+        return time_us_64() + IL_AMB_UPD_MILLIS * 1000ULL;  // Nothing to do until core 0 posts begin
+    }
+    if (!cmds.isEmpty() || resetting || underway || curPhase != tgtPhase || isBusy()) {
+        return time_us_64();
+    }
+    return illum->getNextRunMicros();
+}
+
+boolean MoonDisplay::isMoving() {
+    return status.read().busy;
 }
 
 boolean MoonDisplay::showPhase(int16_t phase) {
-    if (resetting || pvMotor->isMoving() || lsMotor->isMoving()) {
+    if (phase >= MD_PHASES || phase < 0) {
+        #ifdef MD_DEBUG
+        Serial.printf("MoonDisplay::showPhase: Phase (%d) out of bounds; ignored.\n", phase);
+        #endif
+        return false;
+    }
+    mdStatus_t s = status.read();
+    if ((s.busy && !s.homing) || !cmds.isEmpty()) {
         #ifdef MD_DEBUG
         Serial.println("MoonDisplay::showPhase - Tried to move to next phase while display is moving.");
         #endif
         return false;
     }
-    if (phase > sizeof(phasePva)/sizeof(phasePva[0]) || phase < 0) {
+    return post(MD_CMD_SHOW, phase);
+}
+
+boolean MoonDisplay::trackPhase(int32_t phaseFrac) {
+    if (phaseFrac >= MD_PHASES * MD_PHASE_FRAC || phaseFrac < 0) {
         #ifdef MD_DEBUG
-        Serial.printf("MoonDisplay::showPhase: Phase (%d) out of bounds; ignored.\n", phase);
+        Serial.printf("MoonDisplay::trackPhase: Phase (%d) out of bounds; ignored.\n", phaseFrac);
         #endif
         return false;
     }
-    tgtPhase = phase;
-    return true;
+    return post(MD_CMD_TRACK, phaseFrac);
+}
+
+boolean MoonDisplay::home() {
+    if (status.read().busy || !cmds.isEmpty()) {
+        #ifdef MD_DEBUG
+        Serial.println("MoonDisplay::home - Tried to home while display is moving.");
+        #endif
+        return false;
+    }
+    return post(MD_CMD_HOME);
 }
 
 int16_t MoonDisplay::getPhase() {
-    return curPhase;
+    return status.read().phase;
+}
+
+mdStatus_t MoonDisplay::getStatus() {
+    return status.read();
 }
 
 void MoonDisplay::assume(int16_t phase) {
-    int32_t pvLoc = degToPv(phasePva[phase]);
-    int32_t lsLoc = pvToLs(pvLoc);
-    pvMotor->setLocation(pvLoc);
-    lsMotor->setLocation(lsLoc);
-    curPhase = phase;
-    tgtPhase = phase;
-    illum->atPhase(curPhase);
-    #ifdef MD_DEBUG
-    Serial.printf("MoonDisplay::assume - Assuming display shows phase %d; pv: %d, ls: %d.\n", phase, pvLoc, lsLoc);
-    #endif
+    post(MD_CMD_ASSUME, phase);
 }
 
 int32_t MoonDisplay::getLs() {
-    return lsMotor->getLocation();
+    return status.read().ls;
 }
 
 void MoonDisplay::turnLs(int32_t steps) {
-    lsMotor->setLocation(lsMotor->getLocation() - steps);
-    lsMotor->drive(steps);
+    post(MD_CMD_TURN_LS, steps);
 }
 
 int32_t MoonDisplay::getPv() {
-    return pvMotor->getLocation();
+    return status.read().pv;
 }
 
 void MoonDisplay::turnPv(int32_t steps) {
-    pvMotor->setLocation(pvMotor->getLocation() - steps);
-    pvMotor->drive(steps);
+    post(MD_CMD_TURN_PV, steps);
 }
 
-
 void MoonDisplay::stop() {
-    lsMotor->stop();
-    pvMotor->stop();
-    tgtPhase = curPhase;
-    resetting = false;
+    post(MD_CMD_STOP);
+}
+
+// Private instance member functions
+
+bool MoonDisplay::post(mdCmdOp_t op, int32_t arg) {
+    if (!cmds.push({op, arg})) {
+        #ifdef MD_DEBUG
+        Serial.printf("MoonDisplay::post - Command queue full; command %d (%d) dropped.\n", op, arg);
+        #endif
+        return false;
+    }
+    __sev();                                    // Wake core 1 so it sees the command
+    return true;
+}
+
+void MoonDisplay::execute(const mdCmd_t &cmd) {
+    int32_t pvLoc;
+    int32_t lsLoc;
+    switch (cmd.op) {
+        case MD_CMD_BEGIN:
+            beginMotion(phaseTarget.at[cmd.arg].pv, phaseTarget.at[cmd.arg].ls);
+            tgtPhase = curPhase = cmd.arg;
+            underway = resetting = pathPending = tracking = false;
+            illum->atPhase(curPhase);
+            requestCheckpoint();
+            checkpoints = 0;                    // Nothing's changed since the one we started from
+            begun = true;
+            #ifdef MD_DEBUG
+            Serial.printf("MoonDisplay::execute - Starting at phase %d.\n", curPhase); 
+            #endif
+            break;
+        case MD_CMD_RESUME:
+            beginMotion(resumeFrom.pv, resumeFrom.ls);
+            curPhase = resumeFrom.curPhase;
+            tgtPhase = resumeFrom.tgtPhase;
+            resetTgt = resumeFrom.resetTgt;
+            tgtFrac = resumeFrom.tgtFrac;
+            resetting = resumeFrom.resetting;
+            underway = resumeFrom.underway;
+            tracking = resumeFrom.tracking;
+            pathPending = false;
+            // A step or a reset sweep that was underway picks up from wherever it had got to. 
+            // Anything else carries on in runMotion() from where it is.
+            if (underway) {
+                illum->toPhase(resetting ? resetTgt : tgtPhase);
+                startPath(tracking && !resetting && curPhase == tgtPhase ? fracToPv(tgtFrac) : phaseTarget.at[curPhase].pv);
+            } else {
+                illum->atPhase(curPhase);
+            }
+            requestCheckpoint();
+            checkpoints = 0;
+            begun = true;
+            #ifdef MD_DEBUG
+            Serial.printf("MoonDisplay::execute - Resuming at phase %d, headed for %d; pv: %d, ls: %d.\n", 
+                curPhase, resetting ? resetTgt : tgtPhase, resumeFrom.pv, resumeFrom.ls); 
+            #endif
+            break;
+        case MD_CMD_SHOW:
+            // While homing, the new target waits until the display is back where it was
+            if (!begun || resetting || (isBusy() && homeStep == MD_HOME_IDLE)) {
+                #ifdef MD_DEBUG
+                Serial.println("MoonDisplay::execute - Tried to move to next phase while display is moving.");
+                #endif
+                break;
+            }
+            tgtPhase = cmd.arg;
+            tracking = false;
+            break;
+        case MD_CMD_ASSUME:
+            if (!begun) {
+                break;
+            }
+            stopHoming();
+            pvLoc = phaseTarget.at[cmd.arg].pv;
+            lsLoc = phaseTarget.at[cmd.arg].ls;
+            pathPending = tracking = false;
+            motion->setPosition(ME_PV, pvLoc);
+            motion->setPosition(ME_LS, lsLoc);
+            curPhase = cmd.arg;
+            tgtPhase = cmd.arg;
+            illum->atPhase(curPhase);
+            #ifdef MD_DEBUG
+            Serial.printf("MoonDisplay::execute - Assuming display shows phase %d; pv: %d, ls: %d.\n", curPhase, pvLoc, lsLoc);
+            #endif
+            break;
+        case MD_CMD_TURN_LS:
+        case MD_CMD_TURN_PV:
+            if (!begun) {
+                break;
+            }
+            stopHoming();
+            pathPending = false;
+            motion->jog(cmd.op == MD_CMD_TURN_LS ? ME_LS : ME_PV, cmd.arg);
+            break;
+        case MD_CMD_STOP:
+            if (!begun) {
+                break;
+            }
+            stopHoming();
+            pathPending = false;
+            motion->stop();
+            tgtPhase = curPhase;
+            resetting = tracking = false;
+            break;
+        case MD_CMD_TRACK:
+            if (!begun) {
+                break;
+            }
+            // If a reset is underway, the new target has to wait in the stash until it's done
+            tracking = true;
+            tgtFrac = cmd.arg;
+            if (resetting) {
+                resetTgt = cmd.arg / MD_PHASE_FRAC;
+            } else {
+                tgtPhase = cmd.arg / MD_PHASE_FRAC;
+            }
+            break;
+        case MD_CMD_HOME:
+            if (!begun || resetting || isBusy()) {
+                #ifdef MD_DEBUG
+                Serial.println("MoonDisplay::execute - Tried to home while display is moving.");
+                #endif
+                break;
+            }
+            // Underway, so that a checkpoint taken while homing brings the display back to the 
+            // current phase after a reboot
+            underway = true;
+            homeAxis = ME_PV;
+            homeOff[ME_PV] = homeOff[ME_LS] = 0;
+            seekHome();
+            break;
+    }
+}
+
+void MoonDisplay::publish() {
+    status.write({
+        motion->getPosition(ME_PV),
+        motion->getPosition(ME_LS),
+        curPhase,
+        arrivedPhase,
+        arrivals,
+        resetting || isBusy(),
+        tgtPhase,
+        resetting,
+        underway,
+        tracking,
+        motion->isEnergized(),
+        illum->getAmbientLevel(),
+        {illum->getDuty(true), illum->getDuty(false)},
+        runs,
+        runMicros,
+        maxRunMicros,
+        (int16_t)resetTgt,
+        tgtFrac,
+        checkpoints,
+        homeStep != MD_HOME_IDLE,
+        homeResult,
+        homeOff[ME_PV],
+        homeOff[ME_LS]
+    });
+}
+
+void MoonDisplay::beginMotion(int32_t pv, int32_t ls) {
+    motion->begin(pv, ls);
+    setProfiles();
+    for (uint8_t a = 0; a < ME_AXES; a++) {
+        pinMode(homePin[a], INPUT_PULLUP);
+    }
+    homeStep = MD_HOME_IDLE;
+    arrivedPhase = -1;
+    arrivals = 0;
+    illum->begin();
+}
+
+void MoonDisplay::setProfiles() {
+    motion->setProfile(ME_LS, lsProfile);
+    motion->setProfile(ME_PV, pvProfile);
+}
+
+bool MoonDisplay::aboveHome(uint8_t axis) {
+    return digitalRead(homePin[axis]) == MD_HOME_ACTIVE;
+}
+
+void MoonDisplay::seekHome() {
+    int32_t pos = motion->getPosition(homeAxis);
+    int32_t edge = homeEdge[homeAxis];
+    homeAbove = aboveHome(homeAxis);
+    int32_t limit = homeAbove ? (pos < edge ? pos : edge) - homeSlack[homeAxis] : (pos > edge ? pos : edge) + homeSlack[homeAxis];
+    homeStep = MD_HOME_SEEK;
+    #ifdef MD_DEBUG
+    Serial.printf("MoonDisplay::seekHome - Homing %s from %d: %s the edge; searching as far as %d.\n", 
+        homeAxis == ME_PV ? "pv" : "ls", pos, homeAbove ? "above" : "below", limit);
+    #endif
+    if (homeAxis == ME_PV) {
+        startPath(limit < -MD_CAL_MAX_PV ? -MD_CAL_MAX_PV : limit > MD_CAL_MAX_PV ? MD_CAL_MAX_PV : limit);
+    } else {
+        moveAxis(ME_LS, limit);
+    }
+}
+
+void MoonDisplay::runHoming() {
+    bool above = aboveHome(homeAxis);
+    bool moving = pathPending || motion->isMoving();
+    switch (homeStep) {
+        case MD_HOME_SEEK:
+            // Once past the edge, stop and back off to below it
+            if (above != homeAbove) {
+                pathPending = false;
+                motion->stop();
+                homeStep = MD_HOME_BACK_OFF;
+                moveAxis(homeAxis, motion->getPosition(homeAxis) - MD_HOME_BACKOFF);
+            } else if (!moving) {
+                finishHoming(homeAxis == ME_PV ? MD_HOME_NO_PV_FLAG : MD_HOME_NO_LS_FLAG);
+            }
+            break;
+        case MD_HOME_BACK_OFF:
+            if (moving) {
+                break;
+            }
+            if (above) {
+                finishHoming(homeAxis == ME_PV ? MD_HOME_NO_PV_FLAG : MD_HOME_NO_LS_FLAG);
+                break;
+            }
+            // Slowly enough that the sensor is seen to change at the very step that changes it
+            motion->setProfile(homeAxis, homeProfile);
+            homeStep = MD_HOME_RESEEK;
+            moveAxis(homeAxis, motion->getPosition(homeAxis) + 2 * MD_HOME_BACKOFF);
+            break;
+        case MD_HOME_RESEEK:
+            if (above) {
+                motion->stop();
+                homeOff[homeAxis] = motion->getPosition(homeAxis) - homeEdge[homeAxis];
+                motion->setPosition(homeAxis, homeEdge[homeAxis]);
+                setProfiles();
+                #ifdef MD_DEBUG
+                Serial.printf("MoonDisplay::runHoming - Homed %s; it was off by %d steps.\n", 
+                    homeAxis == ME_PV ? "pv" : "ls", homeOff[homeAxis]);
+                #endif
+                if (homeAxis == ME_PV) {
+                    homeAxis = ME_LS;
+                    seekHome();
+                } else {
+                    finishHoming(MD_HOME_OK);
+                }
+            } else if (!moving) {
+                finishHoming(homeAxis == ME_PV ? MD_HOME_NO_PV_FLAG : MD_HOME_NO_LS_FLAG);
+            }
+            break;
+        case MD_HOME_RETURN:
+            if (!moving) {
+                homeStep = MD_HOME_IDLE;        // runMotion() takes it from here, starting with the arrival
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void MoonDisplay::moveAxis(uint8_t axis, int32_t pos) {
+    motion->moveTo(axis == ME_PV ? pos : motion->getPosition(ME_PV), axis == ME_LS ? pos : motion->getPosition(ME_LS));
+}
+
+void MoonDisplay::finishHoming(mdHomeResult_t result) {
+    pathPending = false;
+    motion->stop();
+    setProfiles();
+    homeStep = MD_HOME_RETURN;
+    homeResult = result;
+    #ifdef MD_DEBUG
+    Serial.printf("MoonDisplay::finishHoming - Homing done (%d). Going back to phase %d.\n", result, curPhase);
+    #endif
+    startPath(tracking && !resetting && curPhase == tgtPhase ? fracToPv(tgtFrac) : phaseTarget.at[curPhase].pv);
+}
+
+void MoonDisplay::stopHoming() {
+    if (homeStep == MD_HOME_IDLE) {
+        return;
+    }
+    pathPending = false;
+    motion->stop();
+    setProfiles();
+    homeResult = homeStep == MD_HOME_RETURN ? homeResult : MD_HOME_STOPPED;
+    homeStep = MD_HOME_IDLE;
+}
+
+bool MoonDisplay::requestCheckpoint() {
+    int32_t pv = motion->getPosition(ME_PV);
+    int32_t ls = motion->getPosition(ME_LS);
+    int32_t dPv = pv >= ckpt.pv ? pv - ckpt.pv : ckpt.pv - pv;
+    int32_t dLs = ls >= ckpt.ls ? ls - ckpt.ls : ckpt.ls - ls;
+    bool moved = dPv >= MD_CKPT_PV_STEPS || dLs >= MD_CKPT_LS_STEPS || (!isBusy() && (dPv != 0 || dLs != 0));
+    bool changed = curPhase != ckpt.curPhase || tgtPhase != ckpt.tgtPhase || resetting != ckpt.resetting || 
+        underway != ckpt.underway || tracking != ckpt.tracking || (resetting && resetTgt != ckpt.resetTgt);
+    if (!moved && !changed) {
+        return false;
+    }
+    ckpt = {pv, ls, tgtFrac, curPhase, tgtPhase, (int16_t)resetTgt, (bool)resetting, (bool)underway, (bool)tracking};
+    checkpoints++;
+    return true;
+}
+
+void MoonDisplay::startPath(int32_t pv) {
+    pathPv = motion->getPosition(ME_PV);
+    pathEndPv = pv;
+    // If the leadscrew is off the curve (homing it leaves it well off), bring it back on its own 
+    // first, so the terminator doesn't move with its shape wrong
+    int32_t lsOnCurve = pvToLs(pathPv);
+    if (motion->getPosition(ME_LS) != lsOnCurve) {
+        motion->moveTo(pathPv, lsOnCurve);
+    }
+    pathPending = pathEndPv != pathPv;
+    feedPath();
+}
+
+void MoonDisplay::feedPath() {
+    while (pathPending && motion->queueSpace() > 0) {
+        int32_t togo = pathEndPv - pathPv;
+        pathPv = togo > MD_PATH_PV_STEPS ? pathPv + MD_PATH_PV_STEPS : 
+                 togo < -MD_PATH_PV_STEPS ? pathPv - MD_PATH_PV_STEPS : pathEndPv;
+        motion->moveTo(pathPv, pvToLs(pathPv));
+        pathPending = pathPv != pathEndPv;
+    }
+}
+
+bool MoonDisplay::isBusy() {
+    return pathPending || motion->isMoving() || homeStep != MD_HOME_IDLE;
 }
\ No newline at end of file
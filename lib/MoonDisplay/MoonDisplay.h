@@ -65,9 +65,84 @@
  * lit during the moon's waning phases. During the new-moon transition from phase 59 to phase 0, 
  * while the terminator is reset, neither light source is lit.
  * 
+ * The two steppers are driven together by a MotionEngine. To move the terminator from one 
+ * phase to another, the display feeds the engine a stream of waypoints, MD_PATH_PV_STEPS 
+ * pivot steps apart, each with the leadscrew position pvToLs() calls for. The engine moves 
+ * both motors from waypoint to waypoint in lockstep, so the terminator follows the calibrated 
+ * curve the whole way rather than just at the ends of the move, and both motors arrive at the 
+ * same time.
+ * 
+ * The resets at the 29 -> 30 and 59 -> 0 transitions are done the same way: one continuous 
+ * sweep along the curve from one extreme to the other, without stopping at any of the phases 
+ * in between. While a reset sweep is underway, getPhase() reports the phase the sweep brings the 
+ * display to: 0 at the new moon and 30 at the full moon.
+ * 
+ * The display is split across the RP2040's two cores. Everything that touches the mechanism -- 
+ * the MotionEngine, the Illuminator and the phase-to-phase logic -- runs on core 1, which does 
+ * nothing but call runMotion() from loop1(). That way nothing core 0 does (WiFi, NTP, Serial, 
+ * EEPROM) can hold up the steppers. The public member functions core 0 uses to control the 
+ * display (begin(), showPhase(), assume(), turnLs(), turnPv() and stop()) don't do the work 
+ * themselves; they post a command to core 1 over a lock-free single-producer, single-consumer 
+ * ring and return right away. Going the other way, core 1 publishes a snapshot of the display's 
+ * status (phase, motor positions, whether it's busy and the last phase it arrived at) under a 
+ * sequence lock each time through runMotion(). getPhase(), getLs(), getPv() and run() read that 
+ * snapshot, so they never wait for core 1 either. The flip side is that the snapshot lags 
+ * commands a little: right after, say, assume(), getPhase() reports the old phase until core 1 
+ * has gotten around to the command.
+ * 
+ * Neither core needs to poll the other. Posting a command and arriving at a phase both signal 
+ * an event (__sev()), which wakes the other core if it's asleep in __wfe(). While the display 
+ * is stationary, getWakeMicros() tells core 1 how long it can sleep: until its next ambient 
+ * light update, unless a command or an interrupt wakes it first. And while it's stationary, the 
+ * stepper coils are released: the gearing holds the terminator where it is, and the coils would 
+ * otherwise draw more current than everything else put together.
+ * 
+ * showPhase() jumps the terminator from one phase's position to the next twice a day or so. As an 
+ * alternative, trackPhase() puts the display in track mode. It takes the phase in units of 
+ * 1/MD_PHASE_FRAC of a display phase and sets the pivot to a position interpolated between the 
+ * phases' positions, so that the terminator position for phase p falls at the middle of p's 
+ * span, just as it does, on average, with showPhase(). Called every few minutes, it moves the 
+ * terminator a step or two at a time, which is a good deal less abrupt than moving it a whole 
+ * phase at once. The phase still changes (and run() still reports the arrival) at the same 
+ * moments it does with showPhase(), as do the lights and the resets; the small moves in between 
+ * aren't arrivals. Any other command that moves the display ends track mode.
+ * 
+ * So that losing power in the middle of a move doesn't leave the display mis-registered, core 1 
+ * asks core 0 to checkpoint where the motors are and what the display is in the middle of: 
+ * each time the pivot or the leadscrew has gone MD_CKPT_PV_STEPS or MD_CKPT_LS_STEPS since the 
+ * last checkpoint, each time the motors stop somewhere new, and each time the move changes 
+ * (a new target, the start or end of a step or a reset sweep). It counts the requests in the 
+ * status snapshot and signals an event; core 0 picks the checkpoint up with checkpoint() and 
+ * saves it. At the next boot, resume() starts the display from the saved checkpoint instead of 
+ * from a phase's position, and carries on with whatever move was underway. The motors may have 
+ * gone up to the thresholds past the checkpoint before the power went, which, on the leadscrew, 
+ * is a sixteenth of an inch. The thresholds are a trade between that and the flash wear and 
+ * the time saving the checkpoints costs core 0, which, if it can't save one without erasing 
+ * flash while the display is moving, skips it in favor of a later one. 
+ * 
+ * The steppers run open loop, so a jammed terminator, a belt that jumps a tooth or a hand on the 
+ * pivot leaves the motors somewhere other than where the display thinks they are, and every 
+ * phase after that is off by the same amount. To put that right without jogging the motors by 
+ * hand, each axis has a home flag: a vane that blocks an optical sensor at and above a known 
+ * position, MD_HOME_PV for the pivot (where the terminator is straight) and MD_HOME_LS for the 
+ * leadscrew (a little short of where the straight terminator has it, so the search never pulls 
+ * the terminator taut). home() finds the flags' edges and takes them to be the motors' 
+ * positions, which re-establishes the mapping from phases to motor positions. It homes the 
+ * pivot first, following the calibrated path so the terminator keeps its shape, then, with the 
+ * pivot at its edge, the leadscrew on its own. For each axis, the sensor says which side of the 
+ * edge the axis is on. A fast approach heads for the edge at the usual speed until the sensor 
+ * changes, going no more than MD_HOME_PV_SLACK or MD_HOME_LS_SLACK past where the edge ought to 
+ * be. Then the axis backs off MD_HOME_BACKOFF steps below the edge and creeps back up to it at 
+ * MD_HOME_SLOW_SPEED, so the edge is found to within a step, and always from the same side. 
+ * Whether or not it worked, the display then goes back to the phase it is showing, bringing the 
+ * leadscrew back to the curve on its own before the pivot moves. The sensors pull their inputs 
+ * LOW at and above the edge, so that a sensor that's missing or unplugged, which the pull-up 
+ * leaves HIGH, reads as below it. A display without the flags, or with a sensor that has come 
+ * adrift, fails to find them, having gone no further than the slack. 
+ * 
  *****
  * 
- * MoonDisplay V1.1.0, June 2024
+ * MoonDisplay V1.7.0, October 2026
  * Copyright (C) 2024 D.L. Ehnebuske
  * 
  * Permission is hereby granted, free of charge, to any person obtaining a copy
@@ -95,8 +170,10 @@
     #include <Arduino.h>
 #endif
 
-#include <ULN2003Pico.h>
+#include <MotionEngine.h>
 #include <Illuminator.h>
+#include <CoreLink.h>
+#include <hardware/sync.h>
 
 /**
  * 
@@ -104,7 +181,109 @@
  * 
  **/
 //#define MD_DEBUG                            // Uncomment for debug printing
-#define TOP_SPEED               (600)       // Top speed for steppers
+#define TOP_SPEED               (600)       // Speed steppers can start and stop at without a ramp
+#define MD_LS_MAX_SPEED         (1000)      // Leadscrew top speed (steps/s) once ramped up
+#define MD_PV_MAX_SPEED         (500)       // Pivot top speed (steps/s) once ramped up
+#define MD_ACCEL                (2000)      // Stepper acceleration (steps/s^2)
+#define MD_JERK                 (20000)     // Stepper jerk (steps/s^3)
+#define MD_PATH_PV_STEPS        (8)         // Pivot steps between waypoints on the terminator path
+#define MD_PHASES               (60)        // Number of display phases in a lunation
+#define MD_PHASE_FRAC           (256)       // Units per display phase of the phase trackPhase() takes
+#define MD_CAL_LS0              (497671000) // Calibration curve: ls at pv = 0 (1/1000 steps)
+#define MD_CAL_LS1              (30500)     // Calibration curve: ls per |pv| (1/1000 steps)
+#define MD_CAL_LS2              (201)       // Calibration curve: ls per pv^2 (1/1000 steps, subtracted)
+#define MD_CAL_MAX_PV           (1600)      // Calibration curve: Largest |pv| it's good for
+#define MD_CMD_QUEUE_LEN        (8)         // Commands core 0 can have outstanding (power of 2)
+#define MD_CKPT_PV_STEPS        (64)        // Pivot steps between checkpoints while moving
+#define MD_CKPT_LS_STEPS        (8192)      // Leadscrew steps between checkpoints while moving
+#define MD_HOME_ACTIVE          (LOW)       // What a home sensor reads at and above its flag's edge
+#define MD_HOME_PV              (0)         // Pivot position of the pivot flag's edge
+#define MD_HOME_PV_SLACK        (400)       // How far past where its edge should be the pivot may search
+#define MD_HOME_LS_SLACK        (16384)     // How far past where its edge should be the leadscrew may search
+#define MD_HOME_LS              (MD_CAL_LS0 / 1000 - 2 * MD_HOME_LS_SLACK) // Leadscrew position of its flag's edge
+#define MD_HOME_BACKOFF         (64)        // Steps to back off below an edge before creeping up on it
+#define MD_HOME_SLOW_SPEED      (50)        // Speed (steps/s) to creep up on an edge at
+
+/**
+ * 
+ * Type definitions
+ * 
+ **/
+enum mdCmdOp_t : uint8_t {                  // What a command posted to core 1 asks for
+    MD_CMD_BEGIN,                           // begin(arg)
+    MD_CMD_SHOW,                            // showPhase(arg)
+    MD_CMD_ASSUME,                          // assume(arg)
+    MD_CMD_TURN_LS,                         // turnLs(arg)
+    MD_CMD_TURN_PV,                         // turnPv(arg)
+    MD_CMD_STOP,                            // stop()
+    MD_CMD_TRACK,                           // trackPhase(arg)
+    MD_CMD_RESUME,                          // resume() (the checkpoint is in resumeFrom)
+    MD_CMD_HOME                             // home()
+};
+
+enum mdHomeStep_t : uint8_t {               // Where homing the axis being homed has got to
+    MD_HOME_IDLE,                           // Not homing
+    MD_HOME_SEEK,                           // Heading for the flag's edge until the sensor changes
+    MD_HOME_BACK_OFF,                       // Backing off to below the edge
+    MD_HOME_RESEEK,                         // Creeping back up to the edge
+    MD_HOME_RETURN                          // Done; going back to where the current phase has the terminator
+};
+
+enum mdHomeResult_t : uint8_t {             // How the last homing went
+    MD_HOME_NEVER,                          // There hasn't been one since boot
+    MD_HOME_OK,                             // Both axes homed
+    MD_HOME_NO_PV_FLAG,                     // Couldn't find the pivot flag's edge
+    MD_HOME_NO_LS_FLAG,                     // Couldn't find the leadscrew flag's edge
+    MD_HOME_STOPPED                         // Called off by another command
+};
+
+struct mdCmd_t {                            // A command posted by core 0 for core 1 to carry out
+    mdCmdOp_t op;                           // The operation
+    int32_t arg;                            // Its argument, if any
+};
+
+struct mdTarget_t {                         // Where the motors go for a given phase
+    int32_t pv;                             // Pivot position (steps)
+    int32_t ls;                             // Leadscrew position (steps)
+};
+
+struct mdStatus_t {                         // The status snapshot core 1 publishes for core 0
+    int32_t pv;                             // Pivot position (steps)
+    int32_t ls;                             // Leadscrew position (steps)
+    int16_t phase;                          // The phase showing (or being moved or reset to)
+    int16_t arrivedPhase;                   // The phase most recently arrived at
+    uint32_t arrivals;                      // Count of completed moves; changes on each arrival
+    bool busy;                              // true if moving or with a move still to make
+    int16_t tgtPhase;                       // The phase being worked toward
+    bool resetting;                         // true while a reset sweep is underway
+    bool underway;                          // true while moving to the next phase
+    bool tracking;                          // true in track mode
+    bool energized;                         // true if the stepper coils are energized
+    int16_t ambient;                        // The Illuminator's ambient light level (0..100)
+    int16_t duty[2];                        // The COBs' duty cycles [IL_WAXING], [IL_WANING]
+    uint32_t runs;                          // Number of runMotion() passes (wraps)
+    uint32_t runMicros;                     // Total time (micros) runMotion() has taken (wraps)
+    uint32_t maxRunMicros;                  // Time (micros) the longest runMotion() pass took
+    int16_t resetTgt;                       // While resetting, the phase to go on to afterward
+    int32_t tgtFrac;                        // In track mode, the fractional phase being worked toward
+    uint32_t checkpoints;                   // Count of checkpoint requests; changes on each request
+    bool homing;                            // true while homing (including the trip back)
+    mdHomeResult_t homeResult;              // How the last homing went
+    int32_t homePvOff;                      // How far off the pivot's position was when last homed
+    int32_t homeLsOff;                      // How far off the leadscrew's position was when last homed
+};
+
+struct mdCheckpoint_t {                     // Where the display is and what it's in the middle of
+    int32_t pv;                             // Pivot position (steps)
+    int32_t ls;                             // Leadscrew position (steps)
+    int32_t tgtFrac;                        // In track mode, the fractional phase being worked toward
+    int16_t curPhase;                       // The phase showing (or, while underway, being moved to)
+    int16_t tgtPhase;                       // The phase being worked toward
+    int16_t resetTgt;                       // While resetting, the phase to go on to afterward
+    bool resetting;                         // true while a reset sweep is underway
+    bool underway;                          // true while moving to curPhase
+    bool tracking;                          // true in track mode
+};
 
 class MoonDisplay {
 public:
@@ -114,33 +293,103 @@ public:
      * @param p The GPIO pins for the pv stepper: {pvIn1, pvIn2,pvIn3, pvIn4}
      * @param l The GPIO pins for the ls stepper: {lsIn1, lsIn2, lsIn3, lsIn4}    
      * @param i The GPIO pins for the illuminator: {ilIn1, ilIn2, ilIn3}
+     * @param h The GPIO pins for the home sensors: {pvHome, lsHome}
      */
-    MoonDisplay (const byte p[4], const byte l[4], const byte i[3]);
+    MoonDisplay (const byte p[4], const byte l[4], const byte i[3], const byte h[2]);
 
     /**
      * @brief   Initialize the MoonDisplay assuming it is currently displaying the specified 
-     *          phase. Typically called once in startuo().
+     *          phase. Typically called once in startuo(). The hardware itself is initialized 
+     *          on core 1, the next time through runMotion().
      * 
      * @param   phase   The phase the display should assume it as currently showing.
      */
     void begin(int32_t phase);
 
     /**
-     * @brief Let the MoonDisplay do its thing. Call frequently.
+     * @brief   Initialize the MoonDisplay from a checkpoint saved before a reboot, carrying on 
+     *          with the move, if any, that was underway. Called in setup() instead of begin().
+     * 
+     * @param cp        The checkpoint
+     * @return true     Resuming from it
+     * @return false    The checkpoint makes no sense; nothing done (call begin() instead)
+     */
+    bool resume(const mdCheckpoint_t &cp);
+
+    /**
+     * @brief   Find out whether core 1 has asked for a checkpoint since the last call and, if it 
+     *          has, get it. Call frequently from core 0 and save what it gets.
+     * 
+     * @param cp        Set to the checkpoint, if there's a new one
+     * @return true     There's a new one
+     * @return false    There isn't
+     */
+    bool checkpoint(mdCheckpoint_t &cp);
+
+    /**
+     * @brief   Find out whether the display has finished a move. Call frequently from core 0.
      * 
      * @return int16_t  0 - 59 if just finished moving the that phase. -1 otherwise
      */
     int16_t run();
 
+    /**
+     * @brief   Core 1 side: Carry out the commands posted by core 0, let the MoonDisplay do its 
+     *          thing and publish its status. Call frequently (i.e., from loop1()).
+     * 
+     */
+    void runMotion();
+
+    /**
+     * @brief   Core 1 side: Return the time_us_64() by which runMotion() next needs to be called 
+     *          if nothing else happens. Posting a command signals an event, and motor motion 
+     *          runs on interrupts, so, while the display is stationary, core 1 can sleep until 
+     *          then. While it's moving, the answer is now.
+     * 
+     * @return uint64_t     The time_us_64() runMotion() is next needed
+     */
+    uint64_t getWakeMicros();
+
+    /**
+     * @brief   Return whether the display is moving (or has a reset underway)
+     * 
+     * @return true     Moving
+     * @return false    Stationary
+     */
+    boolean isMoving();
+
     /**
      * @brief   Move cyclcally through the phases to the specified phase
      * 
      * @param phase     The phase to move to
-     * @return boolean  true if success. false if failed because phase was out of bounds or 
-     *                  display was moving
+     * @return boolean  true if success. false if failed because phase was out of bounds, 
+     *                  display was moving or it still had commands to carry out
      */
     boolean showPhase(int16_t phase);
 
+    /**
+     * @brief   Put the display in track mode (if it isn't already) and move the terminator to 
+     *          where it should be for the specified fractional phase, moving cyclically through 
+     *          the phases to get there if need be. Unlike showPhase(), it's fine to call while 
+     *          the display is moving; it goes on from wherever it gets to.
+     * 
+     * @param phaseFrac The phase in 1/MD_PHASE_FRAC phase units: 0 .. MD_PHASES * MD_PHASE_FRAC - 1
+     * @return boolean  true if success. false if phaseFrac was out of bounds or the command 
+     *                  queue was full
+     */
+    boolean trackPhase(int32_t phaseFrac);
+
+    /**
+     * @brief   Find the home flags' edges, take them to be where the motors are and then go back 
+     *          to showing the current phase. Phase changes asked for meanwhile wait until it's 
+     *          done. How it went is in the status snapshot (homing, homeResult, homePvOff and 
+     *          homeLsOff).
+     * 
+     * @return boolean  true if success. false if the display was moving or still had commands 
+     *                  to carry out
+     */
+    boolean home();
+
     /**
      * @brief   Return the current phase showing in the MoonDisplay
      * 
@@ -148,6 +397,15 @@ public:
      */
     int16_t getPhase();
 
+    /**
+     * @brief   Get the whole of the latest status snapshot core 1 has published, for telemetry 
+     *          and the like. The counts of runMotion() passes and the time they took are as of 
+     *          just before the snapshot was published.
+     * 
+     * @return mdStatus_t   The snapshot
+     */
+    mdStatus_t getStatus();
+
     // Low-level and debugging member functions. Use with caution!
 
     /**
@@ -194,53 +452,201 @@ public:
      */
     void stop();
 
+    /**
+     * @brief   Return the position (in steps) the leadscrew should have given the positon (in 
+     *          steps) of the pivot to form a good-looking moon terminator. 
+     * 
+     * @note    A pv past the calibrated range, -MD_CAL_MAX_PV to MD_CAL_MAX_PV, is clamped to
+     *          it, so any pv beyond either end gets the ls for MD_CAL_MAX_PV.
+     *
+     * @details This functon is based on curve fitting calibration data. When pv is 0, the 
+     *          terminator is a straight vertical line with 497,671 steps (each step is 
+     *          1/131072") worth of material to be pushed out. The curve formed when pv = 1600 is 
+     *          all the way to the left rim of the moon photo (approximately), so not on the 
+     *          displayed face. The curve is mirror symmetrical around pv = 0.
+     * 
+     *          The curve is evaluated exactly, in thousandths of a step, using int32_t 
+     *          arithmetic (the largest intermediate value, at |pv| = 1600, is about 5.5e8), and 
+     *          the result is truncated to whole steps. The Pico has no FPU, so this is a good 
+     *          deal quicker than doing it in floating point. The curve means nothing beyond 
+     *          |pv| = MD_CAL_MAX_PV (and int32_t arithmetic would overflow not much more than 
+     *          twice as far out), so, for a pivot that has been jogged past it, it's the value 
+     *          at MD_CAL_MAX_PV.
+     * 
+     * @param pv    The position (in steps) of the pivot
+     * @return int32_t 
+     */
+    static constexpr int32_t pvToLs(int32_t pv) {
+        int32_t a = pv > MD_CAL_MAX_PV || pv < -MD_CAL_MAX_PV ? MD_CAL_MAX_PV : pv >= 0 ? pv : -pv;
+        return (MD_CAL_LS0 + MD_CAL_LS1 * a - MD_CAL_LS2 * a * a) / 1000;
+    }
+
+    /**
+     * @brief   Return the position (in steps) of the pivot given its angle in degrees.
+     * 
+     * @note    The assumtion that -78.125 <= angle <= 78.125 is not checked. Used at compile 
+     *          time to build the table of phase targets.
+     * 
+     * @details The pivot is driven by a 4096 step/turn stepper using a toothed belt drive with a 
+     *          20-tooth pullet on the stepper and a 32-tooth pulley on the pivot.
+     * 
+     * @param angle 
+     * @return int32_t 
+     */
+    static constexpr int32_t degToPv(float angle) {
+        return (int32_t)(20.48 * angle);
+    }
+
 private:
-    ULN2003 *pvMotor;                       // Pointer to the pv stepper motor
-    ULN2003 *lsMotor;                       // Pointer to the ls stepper motor
+    /**
+     * @brief   Post a command for core 1 to carry out
+     * 
+     * @param op        The operation
+     * @param arg       Its argument
+     * @return true     Posted
+     * @return false    The command queue was full; the command was dropped
+     */
+    bool post(mdCmdOp_t op, int32_t arg = 0);
+
+    /**
+     * @brief   Core 1 side: Carry out a command posted by core 0
+     * 
+     * @param cmd   The command
+     */
+    void execute(const mdCmd_t &cmd);
+
+    /**
+     * @brief   Core 1 side: Publish the display's current status for core 0
+     * 
+     */
+    void publish();
+
+    /**
+     * @brief   Core 1 side: Start the motors at the specified position, ready to move
+     * 
+     * @param pv    The pivot position (steps)
+     * @param ls    The leadscrew position (steps)
+     */
+    void beginMotion(int32_t pv, int32_t ls);
+
+    /**
+     * @brief   Core 1 side: Set both motors' usual motion profiles
+     * 
+     */
+    void setProfiles();
+
+    /**
+     * @brief   Core 1 side: Return whether the specified axis's home sensor says it's at or above 
+     *          its flag's edge
+     * 
+     * @param axis      ME_PV or ME_LS
+     * @return true     At or above
+     * @return false    Below
+     */
+    bool aboveHome(uint8_t axis);
+
+    /**
+     * @brief   Core 1 side: Start the fast approach to the home flag's edge of the axis being 
+     *          homed
+     * 
+     */
+    void seekHome();
+
+    /**
+     * @brief   Core 1 side: Move the homing along, watching the home sensor of the axis being 
+     *          homed
+     * 
+     */
+    void runHoming();
+
+    /**
+     * @brief   Core 1 side: Move one motor to the specified position, leaving the other where it 
+     *          is
+     * 
+     * @param axis  ME_PV or ME_LS
+     * @param pos   The position (steps)
+     */
+    void moveAxis(uint8_t axis, int32_t pos);
+
+    /**
+     * @brief   Core 1 side: Finish homing and head back to where the current phase has the 
+     *          terminator
+     * 
+     * @param result    How it went
+     */
+    void finishHoming(mdHomeResult_t result);
+
+    /**
+     * @brief   Core 1 side: If homing, call it off, restoring the usual motion profiles
+     * 
+     */
+    void stopHoming();
+
+    /**
+     * @brief   Core 1 side: Ask for a checkpoint if the motors have gone far enough or stopped 
+     *          somewhere new, or if the move has changed, since the last one
+     * 
+     * @return true     Asked
+     * @return false    There's no need
+     */
+    bool requestCheckpoint();
+
+    /**
+     * @brief   Start moving the terminator along its calibrated path to the specified pivot 
+     *          position. If the leadscrew isn't on the path to begin with, it's brought there 
+     *          first, without moving the pivot. The motors must be stopped.
+     * 
+     * @param pv    The pivot position (steps) to move to
+     */
+    void startPath(int32_t pv);
+
+    /**
+     * @brief   Top up the motion engine's waypoint buffer with the next waypoints along the path 
+     *          we're following, if any.
+     * 
+     */
+    void feedPath();
+
+    /**
+     * @brief   Return whether the display is moving or has more of its path to follow
+     * 
+     * @return true     Moving
+     * @return false    Stationary
+     */
+    bool isBusy();
+
+    MotionEngine *motion;                   // Pointer to the engine driving the pv and ls steppers
     Illuminator *illum;                     // Pointer to the illuminator device
 
-    byte pvPins[4];                         // GPIO pins pvMotor is attached to
-    byte lsPins[4];                         // GPIO pins lsMotor is attached to
+    int32_t pathPv;                         // The pivot position of the last waypoint fed to motion
+    int32_t pathEndPv;                      // The pivot position at the end of the path
+    boolean pathPending;                    // true if there are waypoints left to feed to motion
     unsigned long nextPhaseChangeMillis;    // millis() at next phase change
     int16_t curPhase;                       // The phase we're at currently (or were if we're now moving)
     int16_t tgtPhase;                       // The phase we're working to get to
     boolean resetting = false;              // true when driving the display backwards to go from ph 29 to 30 or 59 to 0
     boolean underway;                       // true when we're moving to the next phase
     int32_t resetTgt;                       // The stash for tgtPhase during reset operations
+    boolean tracking = false;               // true when in track mode
+    int32_t tgtFrac;                        // In track mode, the fractional phase we're working to get to
+    boolean begun = false;                  // Core 1: true once MD_CMD_BEGIN has been carried out
+    int16_t arrivedPhase = -1;              // Core 1: The phase most recently arrived at
+    uint32_t arrivals = 0;                  // Core 1: Count of completed moves
+    uint32_t runs = 0;                      // Core 1: Count of runMotion() passes
+    uint32_t runMicros = 0;                 // Core 1: Total time runMotion() has taken
+    uint32_t maxRunMicros = 0;              // Core 1: Time the longest runMotion() pass took
+    uint32_t arrivalsSeen = 0;              // Core 0: Value of arrivals last time run() looked
+    uint32_t checkpoints = 0;               // Core 1: Count of checkpoint requests
+    mdCheckpoint_t ckpt;                    // Core 1: What the last checkpoint request was for
+    uint32_t checkpointsSeen = 0;           // Core 0: Value of checkpoints last time checkpoint() looked
+    mdCheckpoint_t resumeFrom;              // Core 0 to core 1: The checkpoint for MD_CMD_RESUME
+    byte homePin[ME_AXES];                  // The GPIO pins of the home sensors
+    mdHomeStep_t homeStep = MD_HOME_IDLE;   // Core 1: Where homing the axis being homed has got to
+    uint8_t homeAxis;                       // Core 1: The axis being homed
+    bool homeAbove;                         // Core 1: Whether it was above its flag's edge when the seek began
+    mdHomeResult_t homeResult = MD_HOME_NEVER;  // Core 1: How the last homing went
+    int32_t homeOff[ME_AXES] = {0, 0};      // Core 1: How far off each axis was when last homed
 
-/**
- * @brief   Return the position (in steps) the leadscrew should have given the positon (in steps) 
- *          of the pivot to form a good-looking moon terminator. 
- * 
- * @note    The assumption that -1600 <= pv <= 1600 is not checked.
- * 
- * @details This functon is based on curve fitting calibration data. When pv is 0, the terminator 
- *          is a straight vertical line with 497,671 steps (each step is 1/131072") worth of 
- *          material to be pushed out. The curve formed when pv = 1600 is all the way to the left 
- *          rim of the moon photo (approximately), so not on the displayed face. The curve is 
- *          mirror symmetrical around pv = 0.
- * 
- * @param pv    The position (in steps) of the pivot
- * @return int32_t 
- */
-static int32_t pvToLs(int32_t pv) {
-    return pv >= 0 ? (int32_t)(497671.0 + 30.5 * pv - 0.201 * pv * pv) : (int32_t)(497671.0 - 30.5 * pv - 0.201 * pv * pv);
-}
-
-/**
- * @brief   Return the position (in steps) of the pivot given its angle in degrees.
- * 
- * @note    The assumtion that -78.125 <= angle <= 78.125 is not checked.
- * 
- * @details The pivot is driven by a 4096 step/turn stepper using a toothed belt drive with a 
- *          20-tooth pullet on the stepper and a 32-tooth pulley on the pivot.
- * 
- * @param angle 
- * @return int32_t 
- */
-static int32_t degToPv(float angle) {
-    return (int32_t)(20.48 * angle);
-}
-
-
+    SpscRing<mdCmd_t, MD_CMD_QUEUE_LEN> cmds;   // Commands from core 0 to core 1
+    SeqLock<mdStatus_t> status;             // Status snapshot from core 1 to core 0
 };
\ No newline at end of file
@@ -0,0 +1,191 @@
+/****
+ *
+ * This file is a part of the MoonPhase library. See MoonPhase.h for details.
+ *
+ *****
+ *
+ * MoonPhase V1.2.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <MoonPhase.h>
+#include <NewMoonTable.h>
+#include <math.h>
+#ifdef MP_DEBUG
+    #include <Arduino.h>
+#endif
+
+// Degrees to radians
+static const double d2r = M_PI / 180.0;
+
+/**
+ * @brief   Convert a UTC time_t to a Julian Ephemeris Day (i.e., on Terrestrial Time)
+ *
+ */
+static double jdeOf(time_t t) {
+    return MP_JD_UNIX_EPOCH + (double)(t + MP_DELTA_T) / 86400.0;
+}
+
+MoonPhase::MoonPhase(int16_t phases) {
+    this->phases = phases;
+    k = 0;
+    start = end = 0;
+}
+
+int16_t MoonPhase::phaseAt(time_t t) {
+    return phaseAtMicros((int64_t)t * 1000000);
+}
+
+int16_t MoonPhase::phaseAtMicros(int64_t t, int64_t *nextChange) {
+    cover((time_t)(t / 1000000));
+    int64_t startMicros = (int64_t)start * 1000000;
+    int64_t len = (int64_t)(end - start) * 1000000;
+    int16_t phase = (int16_t)((t - startMicros) * phases / len);
+    if (nextChange != nullptr) {
+        // The first microsecond at which (t - startMicros) * phases >= (phase + 1) * len
+        *nextChange = startMicros + ((phase + 1) * len + phases - 1) / phases;
+    }
+    return phase;
+}
+
+time_t MoonPhase::nextPhaseChange(time_t t) {
+    int64_t next;
+    phaseAtMicros((int64_t)t * 1000000, &next);
+    return (time_t)((next + 999999) / 1000000);
+}
+
+double MoonPhase::lunationFractionAt(time_t t) {
+    cover(t);
+    return (double)(t - start) / (double)(end - start);
+}
+
+double MoonPhase::elongationAt(time_t t) {
+    // Meeus chapter 47: the moon's mean elongation (D), the sun's mean anomaly (M) and the 
+    // moon's mean anomaly (Mp), in degrees
+    double T = (jdeOf(t) - MP_JD_J2000) / 36525.0;
+    double T2 = T * T, T3 = T2 * T, T4 = T3 * T;
+    double D = 297.8501921 + 445267.1114034 * T - 0.0018819 * T2 + T3 / 545868.0 - T4 / 113065000.0;
+    double M = 357.5291092 + 35999.0502909 * T - 0.0001536 * T2 + T3 / 24490000.0;
+    double Mp = 134.9633964 + 477198.8675055 * T + 0.0087414 * T2 + T3 / 69699.0 - T4 / 14712000.0;
+    D = fmod(D, 360.0) * d2r;
+    M = fmod(M, 360.0) * d2r;
+    Mp = fmod(Mp, 360.0) * d2r;
+
+    // Meeus chapter 48: the largest terms of the difference between the true and mean elongation
+    double e = D / d2r + 6.289 * sin(Mp) - 2.100 * sin(M) + 1.274 * sin(2 * D - Mp) + 
+        0.658 * sin(2 * D) + 0.214 * sin(2 * Mp) + 0.110 * sin(D);
+    e = fmod(e, 360.0);
+    return e < 0.0 ? e + 360.0 : e;
+}
+
+double MoonPhase::illuminatedFractionAt(time_t t) {
+    // The phase angle is, near enough, 180 less the elongation
+    return (1.0 - cos(elongationAt(t) * d2r)) / 2.0;
+}
+
+time_t MoonPhase::trueNewMoon(int32_t k) {
+    int32_t i = k - MP_TABLE_FIRST_K;
+    if (i >= 0 && i < MP_TABLE_LEN) {
+        return meanNewMoon(k) + (time_t)mpNewMoonTable[i] * MP_TABLE_UNIT;
+    }
+    return computeNewMoon(k);
+}
+
+time_t MoonPhase::computeNewMoon(int32_t k) {
+    // Meeus chapter 49: the mean new moon and the arguments of the periodic terms
+    double T = k / 1236.85;
+    double T2 = T * T, T3 = T2 * T, T4 = T3 * T;
+    double jde = 2451550.09766 + MP_SYNODIC_MONTH * k + 0.00015437 * T2 - 0.000000150 * T3 + 0.00000000073 * T4;
+    double E = 1.0 - 0.002516 * T - 0.0000074 * T2;
+    double M = (2.5534 + 29.10535670 * k - 0.0000014 * T2 - 0.00000011 * T3) * d2r;
+    double Mp = (201.5643 + 385.81693528 * k + 0.0107582 * T2 + 0.00001238 * T3 - 0.000000058 * T4) * d2r;
+    double F = (160.7108 + 390.67050284 * k - 0.0016118 * T2 - 0.00000227 * T3 + 0.000000011 * T4) * d2r;
+    double Om = (124.7746 - 1.56375588 * k + 0.0020672 * T2 + 0.00000215 * T3) * d2r;
+
+    // The periodic terms
+    jde +=
+        -0.40720 * sin(Mp) + 0.17241 * E * sin(M) + 0.01608 * sin(2 * Mp) + 0.01039 * sin(2 * F) +
+        0.00739 * E * sin(Mp - M) - 0.00514 * E * sin(Mp + M) + 0.00208 * E * E * sin(2 * M) -
+        0.00111 * sin(Mp - 2 * F) - 0.00057 * sin(Mp + 2 * F) + 0.00056 * E * sin(2 * Mp + M) -
+        0.00042 * sin(3 * Mp) + 0.00042 * E * sin(M + 2 * F) + 0.00038 * E * sin(M - 2 * F) -
+        0.00024 * E * sin(2 * Mp - M) - 0.00017 * sin(Om) - 0.00007 * sin(Mp + 2 * M) +
+        0.00004 * sin(2 * Mp - 2 * F) + 0.00004 * sin(3 * M) + 0.00003 * sin(Mp + M - 2 * F) +
+        0.00003 * sin(2 * Mp + 2 * F) - 0.00003 * sin(Mp + M + 2 * F) + 0.00003 * sin(Mp - M + 2 * F) -
+        0.00002 * sin(Mp - M - 2 * F) - 0.00002 * sin(3 * Mp + M) + 0.00002 * sin(4 * Mp);
+
+    // The planetary arguments: {coefficient, A0, A1}
+    static const double a[14][3] = {
+        {0.000325, 299.77, 0.107408}, {0.000165, 251.88, 0.016321}, {0.000164, 251.83, 26.651886},
+        {0.000126, 349.42, 36.412478}, {0.000110, 84.66, 18.206239}, {0.000062, 141.74, 53.303771},
+        {0.000060, 207.14, 2.453732}, {0.000056, 154.84, 7.306860}, {0.000047, 34.52, 27.261239},
+        {0.000042, 207.19, 0.121824}, {0.000040, 291.34, 1.844379}, {0.000037, 161.72, 24.198154},
+        {0.000035, 239.56, 25.513099}, {0.000023, 331.55, 3.592518}
+    };
+    for (uint8_t i = 0; i < 14; i++) {
+        double arg = a[i][1] + a[i][2] * k - (i == 0 ? 0.009173 * T2 : 0.0);
+        jde += a[i][0] * sin(arg * d2r);
+    }
+    return (time_t)llround((jde - MP_JD_UNIX_EPOCH) * 86400.0) - MP_DELTA_T;
+}
+
+time_t MoonPhase::meanNewMoon(int32_t k) {
+    // Rounded toward minus infinity so that it's the same function of k on both sides of 0
+    int64_t ms = (int64_t)k * MP_MEAN_MONTH_MS;
+    return MP_MEAN_NEW_MOON_0 + (time_t)(ms >= 0 ? ms / 1000 : -((-ms + 999) / 1000));
+}
+
+int32_t MoonPhase::lunationAt(time_t t) {
+    // Start from the mean lunation, which is never more than one off
+    int64_t ms = (int64_t)(t - MP_MEAN_NEW_MOON_0) * 1000;
+    int32_t k = (int32_t)(ms >= 0 ? ms / MP_MEAN_MONTH_MS : -((-ms + MP_MEAN_MONTH_MS - 1) / MP_MEAN_MONTH_MS));
+    while (trueNewMoon(k) > t) {
+        k--;
+    }
+    while (trueNewMoon(k + 1) <= t) {
+        k++;
+    }
+    return k;
+}
+
+// Private member functions
+
+void MoonPhase::cover(time_t t) {
+    if (start != end && t >= start && t < end) {
+        return;
+    }
+    // Moving on to the next lunation is the usual case, and needs just one new moon worked out
+    if (start != end && t >= end && t < end + (time_t)(MP_SYNODIC_MONTH * 86400.0 * 0.9)) {
+        time_t next = trueNewMoon(k + 2);
+        if (t < next) {
+            k++;
+            start = end;
+            end = next;
+            return;
+        }
+    }
+    k = lunationAt(t);
+    start = trueNewMoon(k);
+    end = trueNewMoon(k + 1);
+    #ifdef MP_DEBUG
+    Serial.printf("MoonPhase::cover - Lunation %d: %lld to %lld.\n", k, (long long)start, (long long)end);
+    #endif
+}
@@ -0,0 +1,193 @@
+/****
+ *
+ * This file is a part of the MoonPhase library. The library works out the phase of the real moon
+ * at any given time using the algorithms in Jean Meeus, "Astronomical Algorithms", 2nd ed.
+ *
+ * A lunation runs from one true new moon to the next. Because the moon's orbit is eccentric and
+ * is perturbed by the sun, the time between true new moons varies by more than 13 hours either
+ * side of the mean synodic month, so the instant of any particular new moon can be as much as
+ * 14 hours away from where a fixed-length month counted from some starting new moon would put
+ * it. That's more than one of the display's phases. So rather than dividing time up into mean
+ * months, MoonPhase divides each true lunation into equal parts. The display phase at time t is
+ *
+ *      phase = phases * (t - start) / (end - start)
+ *
+ * (rounded down) where start and end are the true new moons that bracket t. The instants of the
+ * true new moons come from Meeus' chapter 49, which is good to well under a minute. It's a sum
+ * of about forty periodic terms, which, on a processor without floating-point hardware, is not
+ * something to do at run time if it can be helped. So the new moons from 2024 to 2100 are
+ * worked out ahead of time, by the host tool in tools/NewMoonTable.cpp, and kept in flash in
+ * NewMoonTable.h. Each entry is how far the true new moon is from the mean one -- the one a
+ * month of exactly MP_MEAN_MONTH_MS counted from lunation 0 would give -- in units of
+ * MP_TABLE_UNIT seconds. That's never more than about 15 hours, so an entry fits in an int16_t
+ * and the whole table in under 2 kB. Finding a new moon is an index, a multiply and an add.
+ * Outside the table's span, the series is evaluated instead. On top of that, MoonPhase keeps
+ * the two new moons bracketing the most recent time it was asked about, so working out the
+ * phase, or when it next changes, for a time in the same lunation is a few integer operations.
+ *
+ * MoonPhase can also give the moon's elongation -- its ecliptic longitude less the sun's -- and
+ * the fraction of its disk that's lit, per the lower precision method in Meeus' chapter 48.
+ * They're good to a few tenths of a degree and a few thousandths, respectively, and are worked
+ * out from scratch each time they're asked for.
+ *
+ * Times are UTC time_t values. Meeus' algorithms run on Terrestrial Time, which is currently
+ * MP_DELTA_T seconds ahead of UTC. (The difference changes by about a second a year; that
+ * matters not at all at the scale of a phase.) phaseAtMicros() takes the time in microseconds
+ * since the Unix epoch and says when the phase next changes to the microsecond.
+ *
+ * To regenerate NewMoonTable.h (say, to extend it past 2100), build and run the tool with
+ *
+ *      pio run -e newmoons && .pio/build/newmoons/program > lib/MoonPhase/NewMoonTable.h
+ *
+ *****
+ *
+ * MoonPhase V1.2.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+#define MP_SYNODIC_MONTH    (29.530588861)      // Mean synodic month in days
+#define MP_JD_UNIX_EPOCH    (2440587.5)         // Julian day of 1970-01-01 00:00 UTC
+#define MP_JD_J2000         (2451545.0)         // Julian day of the J2000.0 epoch
+#define MP_DELTA_T          (69)                // TT - UTC in seconds (approx, for the 2020s)
+#define MP_MEAN_NEW_MOON_0  (947168369LL)       // Mean new moon of lunation 0 (2000-01-06) as a UTC time_t
+#define MP_MEAN_MONTH_MS    (2551442878LL)      // MP_SYNODIC_MONTH in milliseconds
+#define MP_TABLE_UNIT       (2)                 // Seconds per unit of the entries in NewMoonTable.h
+
+//#define MP_DEBUG                                // Uncomment to enable debug printing
+
+class MoonPhase {
+public:
+    /**
+     * @brief   Construct a new MoonPhase object that divides each lunation into the specified
+     *          number of phases
+     *
+     * @param phases    The number of phases per lunation (at most INT16_MAX)
+     */
+    MoonPhase(int16_t phases);
+
+    /**
+     * @brief   Get the phase (0 .. phases - 1) of the moon at the specified time. Phase 0 starts
+     *          at the true new moon.
+     *
+     * @param t         The time
+     * @return int16_t  The phase
+     */
+    int16_t phaseAt(time_t t);
+
+    /**
+     * @brief   Get the phase (0 .. phases - 1) of the moon at the specified time and, optionally,
+     *          when it next changes, to the microsecond
+     *
+     * @param t             The time, in microseconds since the Unix epoch. Must be >= 0.
+     * @param nextChange    If not nullptr, set to the first microsecond after t at which the
+     *                      phase is different from what it is at t
+     * @return int16_t      The phase
+     */
+    int16_t phaseAtMicros(int64_t t, int64_t *nextChange = nullptr);
+
+    /**
+     * @brief   Get the first time after t at which the phase is different from what it is at t
+     *
+     * @param t         The time
+     * @return time_t   When the phase next changes
+     */
+    time_t nextPhaseChange(time_t t);
+
+    /**
+     * @brief   Get how far through its lunation the moon is at the specified time
+     *
+     * @param t         The time
+     * @return double   The fraction (0.0 at the true new moon, approaching 1.0 just before the
+     *                  next one)
+     */
+    double lunationFractionAt(time_t t);
+
+    /**
+     * @brief   Get the moon's elongation, its geocentric ecliptic longitude less the sun's, at
+     *          the specified time
+     *
+     * @param t         The time
+     * @return double   The elongation in degrees (0 .. 360; 0 at new moon, 180 at full)
+     */
+    static double elongationAt(time_t t);
+
+    /**
+     * @brief   Get the fraction of the moon's disk that is lit at the specified time
+     *
+     * @param t         The time
+     * @return double   The illuminated fraction (0.0 .. 1.0)
+     */
+    static double illuminatedFractionAt(time_t t);
+
+    /**
+     * @brief   Get the instant of the true new moon with Meeus' lunation number k (k = 0 is the
+     *          new moon of 2000-01-06), from NewMoonTable.h if it's there and from
+     *          computeNewMoon() otherwise
+     *
+     * @param k         The lunation number
+     * @return time_t   The UTC instant of the new moon
+     */
+    static time_t trueNewMoon(int32_t k);
+
+    /**
+     * @brief   Work out the instant of the true new moon with lunation number k from Meeus'
+     *          series. This is what NewMoonTable.h is made from.
+     *
+     * @param k         The lunation number
+     * @return time_t   The UTC instant of the new moon
+     */
+    static time_t computeNewMoon(int32_t k);
+
+    /**
+     * @brief   Get the instant of the mean new moon with lunation number k, the one the entries
+     *          in NewMoonTable.h are relative to
+     *
+     * @param k         The lunation number
+     * @return time_t   The UTC instant of the mean new moon
+     */
+    static time_t meanNewMoon(int32_t k);
+
+    /**
+     * @brief   Get the lunation number of the true new moon on or before t
+     *
+     * @param t         The time
+     * @return int32_t  The lunation number
+     */
+    static int32_t lunationAt(time_t t);
+
+private:
+    /**
+     * @brief   Make sure the cached lunation is the one that contains t
+     *
+     * @param t     The time
+     */
+    void cover(time_t t);
+
+    int16_t phases;                             // The number of phases per lunation
+    int32_t k;                                  // The lunation number of the cached lunation
+    time_t start;                               // The true new moon starting the cached lunation
+    time_t end;                                 // The one ending it; start == end ==> no cache
+};
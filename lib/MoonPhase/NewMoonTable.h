@@ -0,0 +1,98 @@
+/****
+ *
+ * This file is a part of the MoonPhase library. It was generated by tools/NewMoonTable.cpp
+ * -- don't edit it by hand. See MoonPhase.h for details.
+ *
+ * The true new moons of lunations 296 through 1250 (2024 through 2100), as differences from
+ * MoonPhase::meanNewMoon() in units of MP_TABLE_UNIT seconds. The largest is 50856 s.
+ *
+ ****/
+
+#pragma once
+#include <stdint.h>
+
+#define MP_TABLE_FIRST_K    (296)             // Lunation number of the first entry
+#define MP_TABLE_LEN        (955)             // Number of entries
+
+static const int16_t mpNewMoonTable[MP_TABLE_LEN] = {
+    14230, 13670, 10601,  5718,  -390, -7080,-13329,-17659,-18511,-14956, -7463,  1954,
+    10659, 16697, 19249, 18191, 13660,  6141, -3246,-12691,-20025,-23286,-21381,-14569,
+    -4424,  6738, 16476, 22629, 23775, 19702, 11458,   930, -9709,-18437,-23651,-24279,
+   -19841,-10668,  1590, 13819, 22499, 25428, 22527, 15258,  5588, -4642,-13883,-20754,
+   -23863,-21949,-14630, -3347,  8680, 17979, 22522, 22081, 17498,  9997,   938, -8184,
+   -15713,-19998,-19870,-15245, -7356,  1758, 10064, 16002, 18532, 17225, 12446,  5381,
+    -2238, -8671,-12751,-14152,-13131,-10037, -5125,  1042,  7196, 11666, 13243, 11815,
+     8311,  4058,    22, -3529, -6686, -9270,-10585, -9865, -6983, -2682,  1863,  5706,
+     8424,  9918, 10061,  8623,  5528,  1133, -3776, -8252,-11487,-12917,-12154, -8974,
+    -3542,  3233,  9668, 13982, 15184, 13344,  9132,  3256, -3629,-10642,-16447,-19401,
+   -18107,-12228, -3087,  6715, 14614, 19144, 19880, 16884, 10503,  1584, -8339,-17180,
+   -22767,-23466,-18822, -9833,  1392, 12332, 20579, 24274, 22601, 16063,  6248, -4716,
+   -14663,-21752,-24654,-22618,-15572, -4489,  8178, 18918, 24720, 24489, 19078, 10338,
+      235, -9539,-17571,-22538,-23125,-18444, -8966,  2901, 13647, 20469, 22343, 19700,
+    13624,  5392, -3613,-11862,-17725,-19786,-17413,-11209, -2847,  5669, 12645, 16860,
+    17576, 14700,  8952,  1773, -5092,-10193,-12856,-13151,-11427, -7891, -2756,  3222,
+     8598, 11853, 12229, 10082,  6539,  2731,  -813, -4138, -7282, -9754,-10652, -9340,
+    -6006, -1580,  2848,  6545,  9191, 10573, 10366,  8282,  4414,  -616, -5832,-10246,
+   -13078,-13771,-11932, -7440,  -807,  6544, 12613, 15783, 15534, 12315,  6917,    87,
+    -7370,-14292,-19101,-20141,-16397, -8328,  1910, 11424, 18009, 20721, 19447, 14446,
+     6366, -3541,-13388,-20955,-24238,-22113,-14874, -4210,  7400, 17371, 23484, 24371,
+    19934, 11337,   558,-10181,-18837,-23833,-24165,-19446,-10106,  2143, 14190, 22583,
+    25216, 22090, 14716,  5100, -4898,-13764,-20208,-22970,-20917,-13753, -2906,  8541,
+    17310, 21516, 20985, 16559,  9433,   909, -7608,-14585,-18514,-18369,-14141, -6998,
+     1230,  8776, 14284, 16809, 15891, 11780,  5514, -1314, -7105,-10848,-12345,-11890,
+    -9725, -5885,  -651,  4981,  9482, 11604, 11055,  8551,  5225,  1856, -1439, -4820,
+    -8070,-10362,-10726, -8773, -4991,  -406,  4016,  7687, 10267, 11363, 10523,  7557,
+     2830, -2770, -8145,-12308,-14503,-14174,-10977, -5043,  2617, 10078, 15257, 16937,
+    15118, 10524,  4005, -3619,-11321,-17660,-20907,-19579,-13292, -3439,  7168, 15704,
+    20525, 21168, 17784, 10874,  1436, -8896,-17987,-23631,-24175,-19177, -9725,  1933,
+    13129, 21384, 24860, 22845, 15963,  5893, -5176,-15058,-21928,-24523,-22191,-14960,
+    -3876,  8603, 19034, 24514, 24036, 18504,  9793,  -109, -9523,-17109,-21667,-22021,
+   -17396, -8292,  2979, 13108, 19477, 21156, 18589, 12834,  5118, -3257,-10880,-16264,
+   -18146,-16010,-10459, -3002,  4623, 10973, 14983, 15939, 13662,  8719,  2391, -3723,
+    -8332,-10907,-11594,-10686, -8208, -4110,  1139,  6307,  9919, 11080,  9927,  7373,
+     4353,  1231, -2138, -5784, -9114,-11058,-10750, -8122, -3900,   884,  5391,  9089,
+    11502, 12053, 10293,  6277,   703, -5324,-10650,-14317,-15592,-13941, -9168, -1818,
+     6509, 13522, 17330, 17278, 13828,  7887,   364, -7781,-15269,-20439,-21564,-17567,
+    -8922,  2065, 12256, 19234, 21968, 20399, 14923,  6345, -3968,-14071,-21723,-24905,
+   -22505,-14873, -3813,  8066, 18091, 24044, 24637, 19884, 11043,   147,-10549,-19012,
+   -23715,-23744,-18822, -9459,  2608, 14327, 22362, 24714, 21440, 14073,  4637, -5013,
+   -13415,-19390,-21820,-19711,-12839, -2580,  8166, 16346, 20225, 19671, 15507,  8879,
+     1007, -6820,-13212,-16819,-16754,-13058, -6790,   467,  7225, 12338, 14944, 14534,
+    11211,  5836,  -162, -5339, -8834,-10553,-10778, -9610, -6853, -2510,  2676,  7307,
+    10071, 10477,  9010,  6590,  3815,   671, -3035, -7012,-10289,-11699,-10612, -7276,
+    -2585,  2466,  7117, 10776, 12777, 12453,  9525,  4400, -1915, -8167,-13198,-16076,
+   -16095,-12810, -6334,  2208, 10640, 16583, 18623, 16718, 11685,  4527, -3773,-12058,
+   -18804,-22223,-20777,-14060, -3549,  7739, 16758, 21730, 22199, 18420, 11045,  1199,
+    -9412,-18626,-24232,-24576,-19257, -9449,  2482, 13774, 21926, 25154, 22845, 15717,
+     5514, -5541,-15253,-21836,-24106,-21527,-14230, -3307,  8828, 18849, 23986, 23310,
+    17752,  9193,  -380, -9324,-16395,-20536,-20722,-16283, -7719,  2812, 12242, 18158,
+    19715, 17347, 12057,  4990, -2667, -9639,-14592,-16411,-14665, -9907, -3443,  3274,
+     9050, 12958, 14288, 12739,  8697,  3262, -2127, -6332, -8945,-10148,-10140, -8747,
+    -5660, -1081,  3963,  8023, 10052,  9951,  8398,  6124,  3335,  -184, -4420, -8654,
+   -11638,-12289,-10294, -6191,  -969,  4415,  9194, 12611, 13836, 12279,  8002,  1809,
+    -5041,-11233,-15641,-17380,-15803,-10666, -2564,  6707, 14569, 18888, 18909, 15147,
+     8646,   473, -8268,-16205,-21622,-22744,-18456, -9264,  2377, 13110, 20353, 23027,
+    21142, 15231,  6234, -4385,-14642,-22288,-25308,-22620,-14648, -3308,  8694, 18646,
+    24367, 24661, 19641, 10638,  -272,-10818,-18993,-23341,-23068,-18013, -8763,  2965,
+    14231, 21855, 23950, 20613, 13372,  4240, -4954,-12823,-18319,-20478,-18433,-12005,
+    -2470,  7500, 15097, 18724, 18266, 14497,  8483,  1338, -5783,-11634,-15018,-15162,
+   -12119, -6803,  -537,  5469, 10262, 13046, 13243, 10788,  6347,  1172, -3454, -6805,
+    -8857, -9847, -9714, -8026, -4520,   301,  5158,  8656, 10085,  9676,  8121,  5835,
+     2706, -1446, -6221,-10486,-12881,-12552, -9538, -4624,  1140,  6806, 11510, 14315,
+    14364, 11338,  5727, -1322, -8398,-14189,-17620,-17863,-14402, -7351,  2042, 11349,
+    17922, 20189, 18108, 12605,  4839, -4056,-12813,-19846,-23331,-21697,-14539, -3433,
+     8415, 17770, 22768, 22985, 18795, 10993,   821, -9957,-19171,-24622,-24692,-19047,
+    -8965,  3090, 14316, 22239, 25164, 22581, 15283,  5059, -5854,-15277,-21484,-23405,
+   -20631,-13392, -2791,  8854, 18385, 23181, 22381, 16908,  8625,  -508, -8902,-15426,
+   -19177,-19279,-15148, -7247,  2454, 11154, 16644, 18146, 16065, 11331,  4988, -1905,
+    -8223,-12789,-14627,-13369, -9485, -4058,  1750,  6988, 10860, 12648, 11913,  8836,
+     4315,  -385, -4274, -7041, -8861, -9807, -9497, -7372, -3375,  1644,  6249,  9217,
+    10194,  9607,  7985,  5401,  1617, -3274, -8406,-12364,-13869,-12393, -8314, -2597,
+     3671,  9487, 13812, 15586, 14118,  9509,  2691, -4929,-11887,-16916,-19008,-17425,
+   -11889, -3059,  7072, 15657, 20348, 20332, 16200,  9142,   383, -8850,-17107,-22643,
+   -23661,-19038, -9338,  2838, 13950, 21298, 23804, 21569, 15262,  5948, -4842,-15107,
+   -22616,-25392,-22413,-14194, -2740,  9194, 18923, 24344, 24363, 19171, 10143,  -636,
+   -10903,-18695,-22654,-22117,-17044, -8067,  3162, 13866, 21046, 22925, 19613, 12610,
+     3897, -4741,-12012,-17017,-18952,-17072,-11217, -2527,  6589, 13585, 17000, 16724,
+    13461,  8175,  1846, -4526, -9860,-13105,-13582
+};
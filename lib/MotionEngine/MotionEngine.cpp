@@ -0,0 +1,455 @@
+/****
+ *
+ * This file is a part of the MotionEngine library. See MotionEngine.h for details
+ *
+ *****
+ *
+ * MotionEngine V1.2.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+#include <MotionEngine.h>
+#include <hardware/irq.h>
+#include <hardware/clocks.h>
+#include "StepSequencer.pio.h"
+
+/**
+ * Half-step coil sequence for a 28BYJ-48 driven through a ULN2003. Bit 0 is IN1, bit 3 is IN4.
+ * Taking a step in the positive direction means moving to the next entry.
+ */
+static const uint8_t halfSteps[8] = {0b0001, 0b0011, 0b0010, 0b0110, 0b0100, 0b1100, 0b1000, 0b1001};
+
+static constexpr MotionProfile defaultProfile {ME_DEFAULT_START, ME_DEFAULT_SPEED, ME_DEFAULT_ACCEL, ME_DEFAULT_JERK};
+
+MotionEngine *MotionEngine::engine = nullptr;
+
+// Public instance member functions
+
+MotionEngine::MotionEngine(const byte p[4], const byte l[4]) {
+    for (uint8_t c = 0; c < 4; c++) {
+        pins[ME_PV][c] = p[c];
+        pins[ME_LS][c] = l[c];
+    }
+    running = segActive = false;
+    energized = false;
+    head = tail = 0;
+    dmaChan = -1;
+    seq = 0;
+    blockLen[0] = blockLen[1] = 0;
+    curBlock = 0;
+    pos[ME_PV] = pos[ME_LS] = 0;
+    major = ME_PV;
+    toStop = 0;
+    for (uint8_t a = 0; a < ME_AXES; a++) {
+        profile[a] = &defaultProfile;
+    }
+}
+
+void MotionEngine::begin(int32_t pv, int32_t ls) {
+    stop();
+    pinBase = 0xff;
+    for (uint8_t a = 0; a < ME_AXES; a++) {
+        for (uint8_t c = 0; c < 4; c++) {
+            pinBase = pins[a][c] < pinBase ? pins[a][c] : pinBase;
+        }
+    }
+    for (uint8_t a = 0; a < ME_AXES; a++) {
+        for (uint8_t s = 0; s < 8; s++) {
+            coilBits[a][s] = 0;
+            for (uint8_t c = 0; c < 4; c++) {
+                if (halfSteps[s] & (1 << c)) {
+                    coilBits[a][s] |= 1 << (pins[a][c] - pinBase);
+                }
+            }
+        }
+        phase[a] = 0;
+    }
+
+    // Set up the step sequencer and the DMA channel that feeds it
+    if (dmaChan < 0) {
+        pio = pio_can_add_program(pio0, &stepsequencer_program) ? pio0 : pio1;
+        sm = pio_claim_unused_sm(pio, true);
+        offset = pio_add_program(pio, &stepsequencer_program);
+        stepsequencer_program_init(pio, sm, offset, pinBase, (float)clock_get_hz(clk_sys) / ME_PIO_HZ);
+        dmaChan = dma_claim_unused_channel(true);
+        dma_channel_config c = dma_channel_get_default_config(dmaChan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, pio_get_dreq(pio, sm, true));
+        dma_channel_configure(dmaChan, &c, &pio->txf[sm], block[0], 0, false);
+        engine = this;
+        irq_add_shared_handler(DMA_IRQ_0, onDmaIrq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        dma_channel_set_irq0_enabled(dmaChan, true);
+        irq_set_enabled(DMA_IRQ_0, true);
+    }
+
+    redefine(ME_PV, pv);
+    redefine(ME_LS, ls);
+    writeCoils(0);
+    #ifdef ME_DEBUG
+    Serial.printf("MotionEngine::begin - pv: %d, ls: %d, PIO %d, sm %d, DMA channel %d, pin base %d.\n", 
+        pv, ls, pio_get_index(pio), sm, dmaChan, pinBase);
+    #endif
+}
+
+void MotionEngine::setProfile(uint8_t axis, const MotionProfile &newProfile) {
+    if (axis >= ME_AXES) {
+        return;
+    }
+    profile[axis] = &newProfile;
+    #ifdef ME_DEBUG
+    Serial.printf("MotionEngine::setProfile - axis %d: %d steps from %d to %d sps.\n", axis, newProfile.size(), 
+        1000000 / newProfile[0], 1000000 / newProfile[newProfile.size() - 1]);
+    #endif
+}
+
+bool MotionEngine::moveTo(int32_t pv, int32_t ls) {
+    if (queueSpace() == 0) {
+        return false;
+    }
+    waypoint_t *w = &queue[head];
+    w->tgt[ME_PV] = pv;
+    w->tgt[ME_LS] = ls;
+    w->steps = 0;
+    w->stopBefore = false;
+    for (uint8_t a = 0; a < ME_AXES; a++) {
+        int32_t d = w->tgt[a] - lastQueued[a];
+        uint32_t steps = d < 0 ? -(uint32_t)d : d;
+        int8_t dir = d < 0 ? -1 : d > 0 ? 1 : 0;
+        w->steps = steps > w->steps ? steps : w->steps;
+        // An axis that reverses must come to a stop first
+        if (dir != 0 && dir == -lastDir[a]) {
+            w->stopBefore = true;
+        }
+        if (dir != 0) {
+            lastDir[a] = dir;
+        }
+        lastQueued[a] = w->tgt[a];
+    }
+    head = (head + 1) & (ME_QUEUE_LEN - 1);
+
+    // If the DMA channel isn't running, the interrupt handler isn't around to consume the
+    // buffer, so we can safely get things going from here.
+    if (!running && dmaChan >= 0 && nextSegment()) {
+        fillBlock(0);
+        fillBlock(1);
+        running = true;
+        energized = true;
+        startBlock(0);
+    }
+    return true;
+}
+
+uint8_t MotionEngine::queueSpace() {
+    return ME_QUEUE_LEN - 1 - ((head - tail) & (ME_QUEUE_LEN - 1));
+}
+
+bool MotionEngine::isMoving() {
+    return running || (dmaChan >= 0 && !pio_sm_is_tx_fifo_empty(pio, sm));
+}
+
+void MotionEngine::stop() {
+    bool wasMoving = isMoving();
+    if (wasMoving) {
+        // Stop the step sequencer and the DMA channel in their tracks, and work out where that
+        // leaves the motors.
+        pio_sm_set_enabled(pio, sm, false);
+        dma_channel_set_irq0_enabled(dmaChan, false);
+        dma_channel_abort(dmaChan);
+        dma_channel_acknowledge_irq0(dmaChan);
+        dma_channel_set_irq0_enabled(dmaChan, true);
+        running = false;
+        seq = takenSeq();
+        logEntry_t *taken = &stepLog[(seq - 1) & (ME_LOG_LEN - 1)];
+        for (uint8_t a = 0; a < ME_AXES; a++) {
+            pos[a] = taken->pos[a];
+            phase[a] = taken->phase[a];
+        }
+        pio_sm_clear_fifos(pio, sm);
+        pio_sm_restart(pio, sm);
+        pio_sm_exec(pio, sm, pio_encode_jmp(offset));
+        pio_sm_set_enabled(pio, sm, true);
+    }
+    segActive = false;
+    toStop = 0;
+    tail = head;
+    lastQueued[ME_PV] = pos[ME_PV];
+    lastQueued[ME_LS] = pos[ME_LS];
+    lastDir[ME_PV] = lastDir[ME_LS] = 0;
+    if (wasMoving) {
+        // Hold the coils long enough that whatever comes next starts from a standstill
+        uint16_t pvHold = (*profile[ME_PV])[0];
+        uint16_t lsHold = (*profile[ME_LS])[0];
+        writeCoils(lsHold > pvHold ? lsHold : pvHold);
+    }
+}
+
+void MotionEngine::release() {
+    if (dmaChan < 0 || !energized || isMoving()) {
+        return;
+    }
+    writeCoils(0, false);
+    #ifdef ME_DEBUG
+    Serial.println("MotionEngine::release - Coils released.");
+    #endif
+}
+
+bool MotionEngine::isEnergized() {
+    return energized;
+}
+
+int32_t MotionEngine::getPosition(uint8_t axis) {
+    if (axis >= ME_AXES) {
+        return 0;
+    }
+    if (dmaChan < 0) {
+        return pos[axis];
+    }
+    return stepLog[(takenSeq() - 1) & (ME_LOG_LEN - 1)].pos[axis];
+}
+
+void MotionEngine::setPosition(uint8_t axis, int32_t newPos) {
+    if (axis < ME_AXES) {
+        stop();
+        redefine(axis, newPos);
+    }
+}
+
+void MotionEngine::jog(uint8_t axis, int32_t steps) {
+    if (axis >= ME_AXES) {
+        return;
+    }
+    stop();
+    int32_t target = pos[axis];
+    redefine(axis, target - steps);
+    moveTo(axis == ME_PV ? target : pos[ME_PV], axis == ME_LS ? target : pos[ME_LS]);
+}
+
+// Private member functions
+
+void MotionEngine::onDmaIrq() {
+    MotionEngine *me = engine;
+    if (me == nullptr || !dma_channel_get_irq0_status(me->dmaChan)) {
+        return;
+    }
+    dma_channel_acknowledge_irq0(me->dmaChan);
+    uint8_t done = me->curBlock;
+    uint8_t next = done ^ 1;
+
+    // If the other block came up empty when it was last filled, more waypoints may have arrived
+    // since. If it's still empty, we're done.
+    if (me->blockLen[next] == 0) {
+        me->fillBlock(next);
+        if (me->blockLen[next] == 0) {
+            me->running = false;
+            return;
+        }
+    }
+    me->startBlock(next);
+    me->fillBlock(done);
+}
+
+bool MotionEngine::nextWord(uint32_t *word) {
+    if (!segActive && !nextSegment()) {
+        return false;
+    }
+
+    // Step the major axis and, if Bresenham says so, the minor one
+    uint8_t minor = major ^ 1;
+    pos[major] += dir[major];
+    phase[major] = (phase[major] + dir[major]) & 7;
+    err -= minorSteps;
+    if (err < 0) {
+        pos[minor] += dir[minor];
+        phase[minor] = (phase[minor] + dir[minor]) & 7;
+        err += majorSteps;
+    }
+    toStop--;
+
+    // If that finished the segment, go on to the next one, if there is one, and otherwise hold
+    // the coils long enough to come to a standstill. If it didn't, pace the next step one entry
+    // further along the ramp.
+    uint32_t hold;
+    if (++stepsDone >= majorSteps) {
+        segActive = false;
+        hold = nextSegment() ? interval : (*profile[major])[0];
+    } else {
+        pace(rampPos + 1);
+        hold = interval;
+    }
+    *word = (coilBits[ME_PV][phase[ME_PV]] | coilBits[ME_LS][phase[ME_LS]]) | ((hold - ME_PIO_OVERHEAD) << 8);
+
+    logEntry_t *entry = &stepLog[seq & (ME_LOG_LEN - 1)];
+    for (uint8_t a = 0; a < ME_AXES; a++) {
+        entry->pos[a] = pos[a];
+        entry->phase[a] = phase[a];
+    }
+    seq = seq + 1;
+    return true;
+}
+
+void MotionEngine::fillBlock(uint8_t b) {
+    uint16_t n = 0;
+    blockSeq[b] = seq;
+    while (n < ME_BLOCK_LEN && nextWord(&block[b][n])) {
+        n++;
+    }
+    blockLen[b] = n;
+}
+
+void MotionEngine::startBlock(uint8_t b) {
+    curBlock = b;
+    dma_channel_transfer_from_buffer_now(dmaChan, block[b], blockLen[b]);
+}
+
+uint32_t MotionEngine::takenSeq() {
+    // The words the DMA channel has sent, less the ones waiting in the step sequencer's FIFO.
+    // The interrupt handler may switch blocks while we look, in which case, look again.
+    uint32_t answer;
+    uint8_t b;
+    do {
+        b = curBlock;
+        uint32_t sent = blockLen[b] - dma_channel_hw_addr(dmaChan)->transfer_count;
+        answer = blockSeq[b] + sent - pio_sm_get_tx_fifo_level(pio, sm);
+    } while (b != curBlock);
+    return answer;
+}
+
+bool MotionEngine::nextSegment() {
+    while (tail != head) {
+        waypoint_t *w = &queue[tail];
+        int32_t d[ME_AXES];
+        uint32_t steps[ME_AXES];
+        uint64_t micros[ME_AXES];
+        for (uint8_t a = 0; a < ME_AXES; a++) {
+            d[a] = w->tgt[a] - pos[a];
+            dir[a] = d[a] < 0 ? -1 : 1;
+            steps[a] = d[a] < 0 ? -(uint32_t)d[a] : d[a];
+            micros[a] = (uint64_t)steps[a] * 1000000 / profile[a]->topSpeed();
+        }
+        if (steps[ME_PV] == 0 && steps[ME_LS] == 0) {
+            tail = (tail + 1) & (ME_QUEUE_LEN - 1);
+            continue;
+        }
+        // Coming from a standstill or reversing, start at the bottom of the ramp. Otherwise carry
+        // on at the current speed, on the new major axis's ramp if the major axis changes.
+        uint16_t next;
+        if (toStop == 0 || w->stopBefore) {
+            next = 0;
+        } else if (steps[ME_PV] >= steps[ME_LS] ? major != ME_PV : major != ME_LS) {
+            next = rampIndexFor(major ^ 1, interval) + 1;
+        } else {
+            next = rampPos + 1;
+        }
+        major = steps[ME_PV] >= steps[ME_LS] ? ME_PV : ME_LS;
+        majorSteps = steps[major];
+        minorSteps = steps[major ^ 1];
+        stepsDone = 0;
+        err = majorSteps / 2;
+        // The slower axis sets the top pace for the segment
+        uint64_t segMicros = micros[ME_PV] > micros[ME_LS] ? micros[ME_PV] : micros[ME_LS];
+        cruise = segMicros / majorSteps;
+        tail = (tail + 1) & (ME_QUEUE_LEN - 1);
+        toStop = majorSteps + stepsToStop(tail);
+        pace(next);
+        segActive = true;
+        return true;
+    }
+    return false;
+}
+
+void MotionEngine::pace(uint16_t next) {
+    const MotionProfile &ramp = *profile[major];
+    next = next >= ramp.size() ? ramp.size() - 1 : next;
+    next = next >= toStop ? toStop - 1 : next;
+    interval = ramp[next];
+    if (interval < cruise) {
+        interval = cruise;
+        next = rampIndexFor(major, cruise);
+    }
+    rampPos = next;
+}
+
+uint32_t MotionEngine::stepsToStop(uint8_t from) {
+    uint32_t answer = 0;
+    uint8_t h = head;
+    for (uint8_t i = from; i != h && !queue[i].stopBefore; i = (i + 1) & (ME_QUEUE_LEN - 1)) {
+        answer += queue[i].steps;
+        if (answer >= ME_RAMP_LEN) {
+            break;          // Far enough that it makes no difference
+        }
+    }
+    return answer;
+}
+
+uint16_t MotionEngine::rampIndexFor(uint8_t axis, uint32_t interval) {
+    // The ramp is non-increasing; find the last entry >= interval
+    const MotionProfile &ramp = *profile[axis];
+    uint16_t lo = 0;
+    uint16_t hi = ramp.size() - 1;
+    if (ramp[hi] >= interval) {
+        return hi;
+    }
+    while (lo < hi) {
+        uint16_t mid = (lo + hi + 1) / 2;
+        if (ramp[mid] >= interval) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+void MotionEngine::writeCoils(uint32_t hold, bool energize) {
+    // Sent as a block of one step word, so that it's accounted for like any other
+    uint8_t b = curBlock ^ 1;
+    block[b][0] = energize ? coilBits[ME_PV][phase[ME_PV]] | coilBits[ME_LS][phase[ME_LS]] : 0;
+    energized = energize;
+    if (hold > ME_PIO_OVERHEAD) {
+        block[b][0] |= (hold - ME_PIO_OVERHEAD) << 8;
+    }
+    logEntry_t *entry = &stepLog[seq & (ME_LOG_LEN - 1)];
+    for (uint8_t a = 0; a < ME_AXES; a++) {
+        entry->pos[a] = pos[a];
+        entry->phase[a] = phase[a];
+    }
+    blockSeq[b] = seq;
+    seq = seq + 1;
+    blockLen[b] = 1;
+    blockLen[b ^ 1] = 0;
+    running = true;
+    startBlock(b);
+}
+
+void MotionEngine::redefine(uint8_t axis, int32_t newPos) {
+    pos[axis] = lastQueued[axis] = newPos;
+    lastDir[axis] = 0;
+    if (dmaChan >= 0) {
+        // Any step words still in flight don't move the motors (we've stopped), so they all
+        // leave the motors at the new position.
+        for (uint32_t i = takenSeq() - 1; i != seq; i++) {
+            stepLog[i & (ME_LOG_LEN - 1)].pos[axis] = newPos;
+            stepLog[i & (ME_LOG_LEN - 1)].phase[axis] = phase[axis];
+        }
+    }
+}
@@ -0,0 +1,437 @@
+/****
+ *
+ * This file is a part of the MotionEngine library. The library drives the two 28BYJ-48 stepper
+ * motors of the moon phase display -- the pivot (pv) and the leadscrew (ls) -- as a single,
+ * coordinated two-axis machine. Each motor is attached to the GPIO pins by way of four channels
+ * of a ULN2003 driver chip and is half-stepped (4096 steps per turn).
+ *
+ * Callers give the engine a stream of waypoints, each an absolute {pv, ls} position. The engine
+ * moves from one waypoint to the next along a straight line in {pv, ls} space using Bresenham
+ * interpolation: the axis with more steps to go (the "major" axis) steps on every tick; the
+ * other axis steps on just the ticks that keep it on the line. So both axes start and finish
+ * each segment together, and the time a segment takes is the time its slower axis needs at
+ * that axis's top speed. A path can be followed as closely as needed by making its waypoints
+ * close enough together.
+ *
+ * The coils themselves are driven by an RP2040 PIO state machine running the step sequencer
+ * program in StepSequencer.pio, so the eight coil pins must be eight consecutive GPIOs (in any
+ * order). The state machine is fed by DMA from a pair of blocks of "step words", each of which
+ * holds the coil levels for one step and how long to hold them before taking the next step.
+ * While the DMA channel empties one block, the engine fills the other; it does this in the DMA
+ * completion interrupt handler. So step timing is as accurate as the PIO clock and carries on
+ * no matter what the main loop is doing, and the processor is interrupted once per block of
+ * steps rather than once per step. The waypoints live in a small ring buffer; callers keep it
+ * topped up. When the buffer runs dry the motors stop.
+ *
+ * Since steps are computed a block or two ahead of being taken, the engine keeps a short log
+ * of where each step it computed leaves the motors. getPosition() and stop() use it, together
+ * with how far the DMA channel and the state machine have got, to work out where the motors
+ * actually are.
+ *
+ * Motion is ramped. Each axis has a motion profile: the speed it can start from a standstill
+ * at without missing steps, a top speed, an acceleration limit and, optionally, a jerk limit
+ * (giving an S-curve rather than a trapezoidal profile). From these, a MotionProfile holds a
+ * table of the step interval to use at each step of an acceleration from a standstill. The
+ * compiler works the table out (declare MotionProfiles static constexpr, as with a CurveTable),
+ * so it sits in flash, and setProfile() just points an axis at it. The interrupt handler never
+ * does any arithmetic more complicated than a comparison to pace the steps. It keeps track of
+ * how far along the table it is, moving one entry further along per step while accelerating,
+ * and never being further along than the number of steps left before the motors next have to
+ * stop -- the end of the buffered path, or a waypoint at which an axis reverses direction --
+ * so the motors always have room to decelerate, one entry back per step, to a standstill.
+ *
+ * The coils stay energized when the motors stop, which holds the rotors firmly in place, but
+ * a 28BYJ-48 draws getting on for 100 mA per energized coil to do it. The display's gearing
+ * holds its position perfectly well without help, so a caller that expects the motors to sit
+ * still for a while can release() them. The next move energizes the coils again with its first
+ * step, which, since it's a half step from where the rotor was left, the motor takes without
+ * missing a beat.
+ *
+ *****
+ *
+ * MotionEngine V1.2.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#ifndef Arduino_h
+    #include <Arduino.h>
+#endif
+#include <hardware/pio.h>
+#include <hardware/dma.h>
+
+/**
+ *
+ * Compile-time constants
+ *
+ **/
+//#define ME_DEBUG                          // Uncomment for debug printing
+#define ME_PV                   (0)         // Axis number of the pivot motor
+#define ME_LS                   (1)         // Axis number of the leadscrew motor
+#define ME_AXES                 (2)         // Number of axes
+#define ME_QUEUE_LEN            (32)        // Waypoint ring buffer size (must be a power of 2)
+#define ME_RAMP_LEN             (512)       // Max entries in each axis's acceleration table
+#define ME_DEFAULT_START        (300)       // Default start speed in steps per second
+#define ME_DEFAULT_SPEED        (500)       // Default top speed in steps per second
+#define ME_DEFAULT_ACCEL        (1500)      // Default acceleration in steps per second per second
+#define ME_DEFAULT_JERK         (0)         // Default jerk in steps/s^3; 0 ==> trapezoidal profile
+#define ME_BLOCK_LEN            (32)        // Step words per DMA block
+#define ME_LOG_LEN              (128)       // Step log size (must be a power of 2, > 2 blocks + 8)
+#define ME_PIO_HZ               (1000000)   // Step sequencer clock; one cycle per microsecond
+#define ME_PIO_OVERHEAD         (4)         // Cycles the step sequencer takes per word beyond the hold
+
+/**
+ * @brief   The motion profile of an axis, together with the table of step intervals for
+ *          accelerating from a standstill under it.
+ *
+ * @details The table is worked out by accelerating from the start speed to the top speed in
+ *          small time steps, noting the speed as each step is reached. With a jerk limit,
+ *          acceleration builds up at the jerk rate and tapers off again so as to arrive at top
+ *          speed with no acceleration. That's a few thousand time steps of double precision
+ *          arithmetic, so declare MotionProfiles static constexpr and let the compiler do it.
+ */
+class MotionProfile {
+public:
+    /**
+     * @brief   Construct a new MotionProfile. A start speed of 0 is taken to be 1, a top speed
+     *          below the start speed to be the start speed and an acceleration of 0 to mean no
+     *          ramp at all.
+     *
+     * @param start     The speed, in steps per second, the axis can start and stop at
+     * @param top       The top speed in steps per second
+     * @param accel     The maximum acceleration in steps per second per second
+     * @param jerk      The maximum jerk in steps per second cubed; 0 ==> no limit
+     */
+    constexpr MotionProfile(uint16_t start, uint16_t top, uint32_t accel, uint32_t jerk) : 
+        maxSpeed {0}, len {0}, ramp {} {
+        start = start == 0 ? 1 : start;
+        maxSpeed = top < start ? start : top;
+        const double dt = 0.0001;
+        double v = start;
+        double a = jerk == 0 ? accel : 0;
+        double x = 0;
+        ramp[len++] = 1000000 / start;
+        while (accel != 0 && len < ME_RAMP_LEN && v < maxSpeed) {
+            if (jerk != 0) {
+                if (maxSpeed - v <= a * a / (2.0 * jerk)) {
+                    a -= jerk * dt;
+                    a = a < accel / 100.0 ? accel / 100.0 : a;
+                } else {
+                    a += jerk * dt;
+                    a = a > accel ? accel : a;
+                }
+            }
+            v += a * dt;
+            v = v > maxSpeed ? maxSpeed : v;
+            x += v * dt;
+            while (len < ME_RAMP_LEN && x >= len) {
+                ramp[len++] = (uint16_t)(1000000 / v);
+            }
+        }
+    }
+
+    /**
+     * @brief   Get the step interval to use at step i of an acceleration from a standstill
+     *
+     * @param i         The step, which must be in 0 .. size() - 1
+     * @return uint16_t The interval in microseconds
+     */
+    constexpr uint16_t operator[](uint16_t i) const {
+        return ramp[i];
+    }
+
+    /**
+     * @brief   Get the number of entries in the table: one for each step of the acceleration
+     *          to top speed, up to ME_RAMP_LEN
+     *
+     * @return uint16_t The number of entries
+     */
+    constexpr uint16_t size() const {
+        return len;
+    }
+
+    /**
+     * @brief   Get the top speed
+     *
+     * @return uint16_t The top speed in steps per second
+     */
+    constexpr uint16_t topSpeed() const {
+        return maxSpeed;
+    }
+
+private:
+    uint16_t maxSpeed;                      // Top speed in steps per second
+    uint16_t len;                           // Number of entries used in ramp[]
+    uint16_t ramp[ME_RAMP_LEN];             // Step intervals (us) accelerating from a standstill
+};
+
+class MotionEngine {
+public:
+    /**
+     * @brief Construct a new MotionEngine object attached to the specified GPIO pins.
+     *
+     * @param p The GPIO pins for the pv stepper: {pvIn1, pvIn2, pvIn3, pvIn4}
+     * @param l The GPIO pins for the ls stepper: {lsIn1, lsIn2, lsIn3, lsIn4}
+     */
+    MotionEngine(const byte p[4], const byte l[4]);
+
+    /**
+     * @brief   Initialize the engine, energizing the coils and taking the motors to be at the
+     *          specified positions. The first time, this claims and sets up a PIO state machine
+     *          and a DMA channel, and installs a shared DMA_IRQ_0 handler.
+     *
+     * @param pv    The position (steps) the pivot motor is to be taken to be at
+     * @param ls    The position (steps) the leadscrew motor is to be taken to be at
+     */
+    void begin(int32_t pv, int32_t ls);
+
+    /**
+     * @brief   Set the motion profile of the specified axis. The profile isn't copied, so it
+     *          must last as long as the engine uses it (i.e., be static). Meant to be called
+     *          while the motors are stopped; a move under way goes on under the new profile
+     *          from its next step.
+     *
+     * @param axis      ME_PV or ME_LS
+     * @param profile   The profile
+     */
+    void setProfile(uint8_t axis, const MotionProfile &profile);
+
+    /**
+     * @brief   Append a waypoint to the path the motors follow
+     *
+     * @param pv        The pivot position (steps) of the waypoint
+     * @param ls        The leadscrew position (steps) of the waypoint
+     * @return true     Success
+     * @return false    No room in the waypoint buffer
+     */
+    bool moveTo(int32_t pv, int32_t ls);
+
+    /**
+     * @brief   Return how many more waypoints moveTo() can accept right now
+     *
+     * @return uint8_t  The free space in the waypoint buffer
+     */
+    uint8_t queueSpace();
+
+    /**
+     * @brief   Return whether either motor is moving or has moves queued
+     *
+     * @return true     Moving
+     * @return false    Stationary and nothing queued
+     */
+    bool isMoving();
+
+    /**
+     * @brief   Stop both motors now and discard any queued waypoints
+     *
+     */
+    void stop();
+
+    /**
+     * @brief   De-energize all the coils of both motors. Does nothing if they're moving. The
+     *          next move energizes them again.
+     *
+     */
+    void release();
+
+    /**
+     * @brief   Return whether any coils are (or are about to be) energized
+     *
+     * @return true     Energized, i.e., not released since the last move
+     * @return false    Released
+     */
+    bool isEnergized();
+
+    /**
+     * @brief   Get the current position of the specified axis
+     *
+     * @param axis      ME_PV or ME_LS
+     * @return int32_t  The position in steps
+     */
+    int32_t getPosition(uint8_t axis);
+
+    /**
+     * @brief   Set the position the specified axis is taken to be at. Stops all motion first.
+     *
+     * @param axis  ME_PV or ME_LS
+     * @param pos   The new position in steps
+     */
+    void setPosition(uint8_t axis, int32_t pos);
+
+    /**
+     * @brief   Turn one motor by the specified number of steps without altering its reported
+     *          position once the move is complete. Stops all motion first.
+     *
+     * @param axis  ME_PV or ME_LS
+     * @param steps The number of steps (+ or -) to turn
+     */
+    void jog(uint8_t axis, int32_t steps);
+
+private:
+    /**
+     * @brief   The DMA_IRQ_0 handler. When the DMA channel has finished sending one block of step
+     *          words to the step sequencer, starts it on the other and refills the finished one.
+     *
+     */
+    static void onDmaIrq();
+
+    /**
+     * @brief   Compute the next step along the path and the step word that takes it
+     *
+     * @param word      Where to put the step word
+     * @return true     Success
+     * @return false    There are no more steps to take
+     */
+    bool nextWord(uint32_t *word);
+
+    /**
+     * @brief   Fill the specified block with as many step words as there are, up to
+     *          ME_BLOCK_LEN
+     *
+     * @param b     The block (0 or 1)
+     */
+    void fillBlock(uint8_t b);
+
+    /**
+     * @brief   Start the DMA channel sending the specified block to the step sequencer
+     *
+     * @param b     The block (0 or 1)
+     */
+    void startBlock(uint8_t b);
+
+    /**
+     * @brief   Return the sequence number of the step word the step sequencer will take next,
+     *          i.e., the number of steps actually taken so far.
+     *
+     * @return uint32_t The sequence number
+     */
+    uint32_t takenSeq();
+
+    /**
+     * @brief   Take the next waypoint from the buffer and set up the Bresenham state to get
+     *          there. Skips waypoints we're already at.
+     *
+     * @return true     There's a segment to follow
+     * @return false    The buffer is empty
+     */
+    bool nextSegment();
+
+    /**
+     * @brief   Set the interval for the next step from the specified entry of the major axis's
+     *          ramp table, backing off as needed to leave room to stop in time and to keep to
+     *          the segment's top speed.
+     *
+     * @param next  The ramp table entry we'd like to use
+     */
+    void pace(uint16_t next);
+
+    /**
+     * @brief   Send the step sequencer a word that sets the coils for the current half-step
+     *          phases of both motors (or that turns them all off) and then holds them for the
+     *          specified time
+     *
+     * @param hold      The time to hold the coils, in microseconds
+     * @param energize  false ==> turn all the coils off instead
+     */
+    void writeCoils(uint32_t hold, bool energize = true);
+
+    /**
+     * @brief   Take the specified axis to be at the specified position. Only used while
+     *          stopped.
+     *
+     * @param axis      ME_PV or ME_LS
+     * @param newPos    The position in steps
+     */
+    void redefine(uint8_t axis, int32_t newPos);
+
+    /**
+     * @brief   Return the index of the entry in the specified axis's acceleration table that
+     *          corresponds to the fastest speed no faster than that given by the specified step
+     *          interval.
+     *
+     * @param axis      ME_PV or ME_LS
+     * @param interval  The step interval in microseconds
+     * @return uint16_t The index
+     */
+    uint16_t rampIndexFor(uint8_t axis, uint32_t interval);
+
+    /**
+     * @brief   Return the number of major-axis steps from the start of the buffered waypoint at
+     *          index from to the next point at which the motors must stop.
+     *
+     * @param from      Ring buffer index of the first waypoint to consider
+     * @return uint32_t The number of steps
+     */
+    uint32_t stepsToStop(uint8_t from);
+
+    struct logEntry_t {                     // An entry in the step log
+        int32_t pos[ME_AXES];               // The position of each axis after the step
+        uint8_t phase[ME_AXES];             // The half-step phase of each axis after the step
+    };
+
+    struct waypoint_t {                     // An entry in the waypoint ring buffer
+        int32_t tgt[ME_AXES];               // Where the axes are to go
+        uint32_t steps;                     // Major-axis steps from the previous waypoint
+        bool stopBefore;                    // true if the motors must stop before heading here
+    };
+
+    byte pins[ME_AXES][4];                  // The GPIO pins for each axis
+    uint8_t pinBase;                        // The lowest numbered of the coil pins
+    uint8_t coilBits[ME_AXES][8];           // Step sequencer pin levels for each axis at each phase
+    const MotionProfile *profile[ME_AXES];  // The motion profile of each axis
+    PIO pio;                                // The PIO block the step sequencer runs in
+    uint sm;                                // The step sequencer's state machine
+    uint offset;                            // Where the step sequencer is loaded
+    int dmaChan;                            // The DMA channel feeding it; -1 ==> not set up yet
+    static MotionEngine *engine;            // The engine the DMA_IRQ_0 handler serves
+
+    int32_t pos[ME_AXES];                   // Position of each axis as of the last step computed
+    uint8_t phase[ME_AXES];                 // Half-step phase (0..7) of each axis, likewise
+    volatile bool running;                  // true while the DMA channel has step words to send
+    bool energized;                         // false if the coils have been released
+    uint32_t block[2][ME_BLOCK_LEN];        // The two blocks of step words
+    volatile uint16_t blockLen[2];          // Number of step words in each block
+    volatile uint32_t blockSeq[2];          // Sequence number of the first step word in each
+    volatile uint8_t curBlock;              // The block the DMA channel is sending (or last sent)
+    volatile uint32_t seq;                  // Sequence number of the next step word computed
+    logEntry_t stepLog[ME_LOG_LEN];         // Where each step word computed leaves the motors
+
+    waypoint_t queue[ME_QUEUE_LEN];         // The waypoint ring buffer
+    volatile uint8_t head;                  // Where moveTo() puts the next waypoint
+    volatile uint8_t tail;                  // Where the interrupt handler takes the next waypoint
+    int32_t lastQueued[ME_AXES];            // The most recently buffered waypoint
+    int8_t lastDir[ME_AXES];                // Direction of each axis heading there; 0 ==> none
+
+    // Bresenham state for the segment being followed; only touched by the interrupt handler
+    // while running
+    bool segActive;                         // true if following a segment
+    uint8_t major;                          // The major axis
+    int8_t dir[ME_AXES];                    // Direction (+1 or -1) of each axis
+    uint32_t majorSteps;                    // Steps the major axis takes in the segment
+    uint32_t minorSteps;                    // Steps the minor axis takes in the segment
+    uint32_t stepsDone;                     // Major axis steps taken so far
+    int32_t err;                            // Bresenham error term
+    uint32_t cruise;                        // Shortest step interval (us) the segment allows
+    uint32_t interval;                      // Time (us) from the current step to the next
+    uint16_t rampPos;                       // Where in the major axis's ramp table we are
+    uint32_t toStop;                        // Major-axis steps left before we must stop
+};
@@ -0,0 +1,55 @@
+// -------------------------------------------------- //
+// This file is autogenerated by pioasm; do not edit! //
+// -------------------------------------------------- //
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+// ------------- //
+// stepsequencer //
+// ------------- //
+
+#define stepsequencer_wrap_target 0
+#define stepsequencer_wrap 3
+
+static const uint16_t stepsequencer_program_instructions[] = {
+            //     .wrap_target
+    0x80a0, //  0: pull   block                      
+    0x6008, //  1: out    pins, 8                    
+    0x6038, //  2: out    x, 24                      
+    0x0043, //  3: jmp    x--, 3                     
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program stepsequencer_program = {
+    .instructions = stepsequencer_program_instructions,
+    .length = 4,
+    .origin = -1,
+};
+
+static inline pio_sm_config stepsequencer_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + stepsequencer_wrap_target, offset + stepsequencer_wrap);
+    return c;
+}
+
+static inline void stepsequencer_program_init(PIO pio, uint sm, uint offset, uint pinBase, float div) {
+    pio_sm_config c = stepsequencer_program_get_default_config(offset);
+    sm_config_set_out_pins(&c, pinBase, 8);
+    sm_config_set_out_shift(&c, true, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, div);
+    for (uint pin = pinBase; pin < pinBase + 8; pin++) {
+        pio_gpio_init(pio, pin);
+    }
+    pio_sm_set_consecutive_pindirs(pio, sm, pinBase, 8, true);
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+#endif
+
@@ -0,0 +1,123 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the parts of the Arduino framework (as implemented by the arduino-pico
+ * core) that the firmware uses.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <WString.h>
+#include <NativeHal.h>
+
+#define HIGH                (1)
+#define LOW                 (0)
+#define INPUT               (0)
+#define OUTPUT              (1)
+#define INPUT_PULLUP        (2)
+#define LED_BUILTIN         (64)            // The Pico W's LED hangs off the CYW43, "pin" 64
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// Analog I/O
+void analogWriteFreq(uint32_t freq);
+void analogWriteRange(uint32_t range);
+void analogWrite(uint8_t pin, int value);
+void analogReadResolution(int bits);
+int analogRead(uint8_t pin);
+
+// Interrupts and the other core. There's only one thread on the host, so there's nothing to do.
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class RP2040 {
+public:
+    void idleOtherCore() {}
+    void resumeOtherCore() {}
+};
+
+extern RP2040 rp2040;
+
+// Timing (all of it virtual)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/**
+ * @brief   Host stand-in for the Serial (USB CDC) object. Output goes to stdout. Input comes
+ *          from stdin, without blocking.
+ *
+ */
+class SerialUSB {
+public:
+    void begin(unsigned long baud);
+    operator bool() const { return halSerialConnected(); }
+    int available();
+    int read();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buf, size_t len);
+    int availableForWrite();
+    size_t print(const String &s);
+    size_t print(const char *s);
+    size_t print(char c);
+    size_t print(long n);
+    size_t println(const String &s);
+    size_t println(const char *s = "");
+    size_t println(long n);
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    void flush();
+
+private:
+    int peeked = -1;                        // Character read from stdin but not yet consumed
+};
+
+extern SerialUSB Serial;
+
+// Arduino sketch entry points, supplied by the firmware. As with arduino-pico, setup1() and
+// loop1() (core 1's entry points) are optional. On the host, there's only one thread, so the
+// host driver interleaves loop1() passes with loop() passes.
+void setup();
+void loop();
+void setup1() __attribute__((weak));
+void loop1() __attribute__((weak));
+
+#endif
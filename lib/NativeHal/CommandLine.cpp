@@ -0,0 +1,104 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <CommandLine.h>
+#include <ctype.h>
+
+String CommandHandlerHelper::getWord(int16_t n) {
+    const char *p = line;
+    while (true) {
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            return String();
+        }
+        const char *start = p;
+        while (*p != '\0' && !isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (n-- == 0) {
+            return String(std::string(start, p - start));
+        }
+    }
+}
+
+String CommandHandlerHelper::getCommandLine() {
+    return String(line);
+}
+
+bool CommandLine::attachCmdHandler(const char *cmd, cmdHandler_t handler) {
+    for (uint8_t c = 0; c < nCmds; c++) {
+        if (strcmp(cmds[c], cmd) == 0) {
+            handlers[c] = handler;
+            return true;
+        }
+    }
+    if (nCmds >= CL_MAX_CMDS) {
+        return false;
+    }
+    cmds[nCmds] = cmd;
+    handlers[nCmds] = handler;
+    nCmds++;
+    return true;
+}
+
+bool CommandLine::run() {
+    bool answer = false;
+    while (Serial.available()) {
+        int c = Serial.read();
+        if (c == '\n' || c == '\r') {
+            buf[bufLen] = '\0';
+            if (bufLen != 0) {
+                answer = dispatch(buf) || answer;
+            }
+            bufLen = 0;
+        } else if (bufLen < CL_MAX_LINE) {
+            buf[bufLen++] = (char)c;
+        }
+    }
+    return answer;
+}
+
+bool CommandLine::dispatch(const char *cmdLine) {
+    strncpy(helper.line, cmdLine, CL_MAX_LINE);
+    helper.line[CL_MAX_LINE] = '\0';
+    String cmd = helper.getWord(0);
+    if (cmd.length() == 0) {
+        return false;
+    }
+    for (uint8_t c = 0; c < nCmds; c++) {
+        if (cmd == cmds[c]) {
+            Serial.print(handlers[c](&helper));
+            return true;
+        }
+    }
+    Serial.printf("Unknown command \"%s\".\n", cmd.c_str());
+    return false;
+}
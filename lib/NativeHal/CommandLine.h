@@ -0,0 +1,101 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the CommandLine library. Lines typed on stdin are split into
+ * whitespace-separated words and dispatched to the handler attached to the first word. The
+ * String the handler returns is printed to Serial.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <Arduino.h>
+
+#define CL_MAX_CMDS             (20)        // Max number of command handlers
+#define CL_MAX_LINE             (128)       // Max length of a command line
+
+class CommandHandlerHelper {
+public:
+    /**
+     * @brief   Get the nth whitespace-separated word of the command line; word 0 is the
+     *          command itself.
+     *
+     * @param n         Which word
+     * @return String   The word or "" if there aren't that many
+     */
+    String getWord(int16_t n);
+
+    /**
+     * @brief   Get the whole command line
+     *
+     * @return String
+     */
+    String getCommandLine();
+
+private:
+    friend class CommandLine;
+    char line[CL_MAX_LINE + 1];             // The command line being processed
+};
+
+typedef String (*cmdHandler_t)(CommandHandlerHelper *h);
+
+class CommandLine {
+public:
+    /**
+     * @brief   Attach a handler for a command
+     *
+     * @param cmd       The command
+     * @param handler   The function to invoke when the command is typed
+     * @return true     Success
+     * @return false    Too many commands
+     */
+    bool attachCmdHandler(const char *cmd, cmdHandler_t handler);
+
+    /**
+     * @brief   Process any available input. Call frequently.
+     *
+     * @return true     A command was dispatched
+     * @return false    No command was dispatched
+     */
+    bool run();
+
+    /**
+     * @brief   Process a complete command line as if it had been typed
+     *
+     * @param cmdLine   The command line
+     * @return true     A handler was found and invoked
+     * @return false    Unknown command
+     */
+    bool dispatch(const char *cmdLine);
+
+private:
+    const char *cmds[CL_MAX_CMDS];          // The commands
+    cmdHandler_t handlers[CL_MAX_CMDS];     // Their handlers
+    uint8_t nCmds = 0;                      // How many there are
+    char buf[CL_MAX_LINE + 1];              // Input line being accumulated
+    uint8_t bufLen = 0;                     // Its length
+    CommandHandlerHelper helper;            // Helper passed to handlers
+};
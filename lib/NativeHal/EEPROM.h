@@ -0,0 +1,73 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the arduino-pico EEPROM emulation. The "flash" starts out erased (all
+ * 0xff) and lasts as long as the process does. Each commit() is counted in halStats.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <NativeHal.h>
+
+#define EE_MAX_SIZE             (4096)      // Largest size begin() accepts, as on the Pico
+
+class EEPROMClass {
+public:
+    EEPROMClass() { memset(data, 0xff, sizeof(data)); }
+
+    void begin(size_t size) { this->size = size > EE_MAX_SIZE ? EE_MAX_SIZE : size; }
+    uint8_t read(int addr) { return addr >= 0 && (size_t)addr < size ? data[addr] : 0; }
+    void write(int addr, uint8_t val) { if (addr >= 0 && (size_t)addr < size) data[addr] = val; }
+    bool commit() {                         // On the Pico, a commit rewrites the whole sector
+        halStats.eepromCommits++;
+        halStats.flashErases++;
+        halStats.flashPrograms += EE_MAX_SIZE / 256;
+        return size != 0;
+    }
+    size_t length() { return size; }
+
+    template<typename T> T &get(int addr, T &t) {
+        if (addr >= 0 && addr + sizeof(T) <= size) {
+            memcpy(&t, data + addr, sizeof(T));
+        }
+        return t;
+    }
+    template<typename T> const T &put(int addr, const T &t) {
+        if (addr >= 0 && addr + sizeof(T) <= size) {
+            memcpy(data + addr, &t, sizeof(T));
+        }
+        return t;
+    }
+
+private:
+    uint8_t data[EE_MAX_SIZE];              // The emulated EEPROM contents
+    size_t size = 0;                        // The size established by begin()
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,91 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <NativeHal.h>
+#include <hardware/flash.h>
+#include <stdio.h>
+#include <string.h>
+
+#define HAL_STR_(x) #x
+#define HAL_STR(x) HAL_STR_(x)
+
+static_assert(HAL_FS_OFFSET + HAL_FS_SIZE == PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE, "The filesystem region must end at EEPROM's sector");
+
+uint8_t halFlash[PICO_FLASH_SIZE_BYTES];   // The emulated flash memory; erased on first use
+static bool flashErased = false;            // Whether it has been
+
+// The Pico's linker script marks the bounds of the region it sets aside for a filesystem (the 
+// board_build.filesystem_size in platformio.ini) with the symbols _FS_start and _FS_end, placing 
+// it just below EEPROM's sector at the top of flash. Define them the same way here.
+asm(".globl _FS_start\n\t.set _FS_start, halFlash + " HAL_STR(HAL_FS_OFFSET) "\n\t"
+    ".globl _FS_end\n\t.set _FS_end, halFlash + " HAL_STR(HAL_FS_OFFSET) " + " HAL_STR(HAL_FS_SIZE));
+
+uint8_t *halFlashMemory() {
+    if (!flashErased) {
+        memset(halFlash, 0xff, PICO_FLASH_SIZE_BYTES);
+        flashErased = true;
+    }
+    return halFlash;
+}
+
+/**
+ * @brief   Let the specified time pass with the interrupts held off, as it does on the Pico while 
+ *          the flash is busy
+ */
+static void flashBusy(uint64_t micros) {
+    halHoldIrqs(true);
+    halAdvance(micros);
+    halHoldIrqs(false);
+    halStats.flashBusyMicros += micros;
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE != 0 || count % FLASH_SECTOR_SIZE != 0 || 
+        flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "flash_range_erase: bad range 0x%x, %zu bytes; ignored.\n", flash_offs, count);
+        return;
+    }
+    memset(halFlashMemory() + flash_offs, 0xff, count);
+    halStats.flashErases += count / FLASH_SECTOR_SIZE;
+    flashBusy(count / FLASH_SECTOR_SIZE * HAL_FLASH_ERASE_MICROS);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE != 0 || count % FLASH_PAGE_SIZE != 0 || 
+        flash_offs + count > PICO_FLASH_SIZE_BYTES) {
+        fprintf(stderr, "flash_range_program: bad range 0x%x, %zu bytes; ignored.\n", flash_offs, count);
+        return;
+    }
+    uint8_t *p = halFlashMemory() + flash_offs;
+    for (size_t i = 0; i < count; i++) {
+        p[i] &= data[i];
+    }
+    halStats.flashPrograms += count / FLASH_PAGE_SIZE;
+    flashBusy(count / FLASH_PAGE_SIZE * HAL_FLASH_PROGRAM_MICROS);
+}
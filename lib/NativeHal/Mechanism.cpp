@@ -0,0 +1,159 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <Arduino.h>
+#include <NativeHal.h>
+
+// The half-step phase for each combination of coil levels (IN4..IN1), -1 for none. In phase order,
+// the levels are 0b0001, 0b0011, 0b0010, 0b0110, 0b0100, 0b1100, 0b1000, 0b1001.
+static const int8_t phaseOf[16] = {-1, 0, 2, 1, 4, -1, 3, -1, 6, 7, -1, -1, 5, -1, -1, -1};
+
+struct motor_t {                            // A modeled stepper motor and the part it drives
+    uint8_t pins[4];                        // The GPIO pins driving IN1..IN4
+    int32_t rotor;                          // Where the rotor has turned the part to (half steps)
+    int32_t slip;                           // How far the part has been moved without the rotor
+    int8_t rotorPhase;                      // The half-step phase the rotor is lined up with; -1 ==> not yet
+    bool flag;                              // Whether the part has a home flag
+    uint8_t flagPin;                        // The GPIO pin the flag's sensor is read on
+    int32_t flagEdge;                       // The sensor reads flagActive at and above this position
+    uint8_t flagActive;                     // What the sensor reads at and above the edge
+    uint32_t slipOdds;                      // Chance, in 2^-32 units, of losing a cycle each step
+    uint32_t slips;                         // Number of cycles lost
+};
+
+static motor_t motors[HAL_MAX_MOTORS];
+static uint8_t nMotors = 0;
+static uint32_t rng = 2463534242u;          // State of the xorshift generator deciding when cycles are lost
+
+/**
+ * @brief   Return the next number from a xorshift generator, so that runs are repeatable
+ *
+ * @return uint32_t The number
+ */
+static uint32_t nextRandom() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/**
+ * @brief   Set the level of the specified motor's home flag's sensor to match where the part is
+ *
+ * @param m     The motor
+ */
+static void updateFlag(motor_t &m) {
+    if (m.flag) {
+        bool above = m.rotor + m.slip >= m.flagEdge;
+        halSetDigitalIn(m.flagPin, above == (m.flagActive != LOW) ? HIGH : LOW);
+    }
+}
+
+/**
+ * @brief   Return the half-step phase the specified motor's coils are energized in
+ *
+ * @param m         The motor
+ * @return int8_t   The phase (0..7); -1 if the coils are off (or in no phase at all)
+ */
+static int8_t coilPhase(const motor_t &m) {
+    uint8_t bits = 0;
+    for (uint8_t c = 0; c < 4; c++) {
+        bits |= (halGetPinOut(m.pins[c]) != LOW) << c;
+    }
+    return phaseOf[bits];
+}
+
+int8_t halAddMotor(const uint8_t pins[4], int32_t pos) {
+    if (nMotors >= HAL_MAX_MOTORS) {
+        return -1;
+    }
+    motor_t &m = motors[nMotors];
+    m = {{pins[0], pins[1], pins[2], pins[3]}, pos, 0, -1, false, 0, 0, LOW, 0, 0};
+    m.rotorPhase = coilPhase(m);
+    return nMotors++;
+}
+
+void halSetMotorFlag(int8_t motor, uint8_t pin, int32_t edge, uint8_t active) {
+    if (motor >= 0 && motor < nMotors) {
+        motors[motor].flag = true;
+        motors[motor].flagPin = pin;
+        motors[motor].flagEdge = edge;
+        motors[motor].flagActive = active;
+        updateFlag(motors[motor]);
+    }
+}
+
+void halSetMotorSlip(int8_t motor, double ppm) {
+    if (motor >= 0 && motor < nMotors) {
+        motors[motor].slipOdds = (uint32_t)(ppm / 1000000.0 * 4294967296.0);
+    }
+}
+
+void halSlipMotor(int8_t motor, int32_t steps) {
+    if (motor >= 0 && motor < nMotors) {
+        motors[motor].slip += steps;
+        updateFlag(motors[motor]);
+    }
+}
+
+int32_t halGetMotorPosition(int8_t motor) {
+    return motor >= 0 && motor < nMotors ? motors[motor].rotor + motors[motor].slip : 0;
+}
+
+uint32_t halGetMotorSlips(int8_t motor) {
+    return motor >= 0 && motor < nMotors ? motors[motor].slips : 0;
+}
+
+void halPinsWritten() {
+    for (uint8_t i = 0; i < nMotors; i++) {
+        motor_t &m = motors[i];
+        int8_t p = coilPhase(m);
+        if (p < 0 || p == m.rotorPhase) {
+            continue;                       // Released, or nothing new
+        }
+        if (m.rotorPhase < 0) {
+            m.rotorPhase = p;               // First time energized: the rotor lines up
+            continue;
+        }
+        // The rotor turns toward the nearest position in the new phase. Exactly opposite, the 
+        // field has no way to pull it; it stays put until the next change.
+        int8_t d = (p - m.rotorPhase) & 7;
+        if (d == 4) {
+            continue;
+        }
+        int8_t delta = d < 4 ? d : d - 8;
+        m.rotor += delta;
+        m.rotorPhase = p;
+        if (m.slipOdds != 0 && nextRandom() < m.slipOdds) {
+            m.rotor -= delta > 0 ? 8 : -8;  // Stalled, and fell back a whole cycle
+            m.slips++;
+        }
+        updateFlag(m);
+    }
+}
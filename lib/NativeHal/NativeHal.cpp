@@ -0,0 +1,885 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <WiFi.h>
+#include <pico/time.h>
+#include <hardware/gpio.h>
+#include <hardware/pwm.h>
+#include <hardware/sync.h>
+#include <hardware/timer.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+extern "C" time_t __real_time(time_t *t);
+
+/**
+ *
+ * Global variables
+ *
+ **/
+halStats_t halStats;
+halNetwork_t halNetwork = {.wifiOk = true, .ntpOk = true, .ntpTime = 0, .wifiMillis = 3000, .wifiFailures = 0, 
+    .ntpMillis = 500, .crystalPpm = 0.0, .ntpServer = nullptr};
+SerialUSB Serial;
+RP2040 rp2040;
+EEPROMClass EEPROM;
+WiFiClass WiFi;
+NTPClass NTP;
+
+/**
+ *
+ * The state of the virtual world
+ *
+ **/
+static uint64_t nowMicros = 0;              // The virtual clock
+static uint64_t runAheadLimit = 0;          // The latest time the running event source may run ahead to
+static time_t epochAtZero = 0;              // What time() reports at nowMicros == 0
+static bool exitRequested = false;          // Set by halRequestExit()
+static bool serialOut = true;               // Whether Serial output goes to stdout
+static bool serialIn = true;                // Whether Serial input comes from stdin
+static bool serialHost = true;              // Whether a host has the serial port open
+static uint64_t ntpDueMicros = HAL_NO_EVENT; // When the time NTP.begin() asked for arrives
+static bool ntpIsSource = false;            // Whether NTP is an event source yet
+static int32_t pinOut[HAL_PIN_COUNT];       // Last value written to each pin
+static uint16_t analogIn[HAL_PIN_COUNT];    // What analogRead() returns for each pin
+static bool analogInSet[HAL_PIN_COUNT];     // Whether analogIn[] has been set for the pin
+static uint8_t digitalIn[HAL_PIN_COUNT];    // What digitalRead() returns for each pin
+static bool digitalInSet[HAL_PIN_COUNT];    // Whether digitalIn[] has been set for the pin
+static bool pulledUp[HAL_PIN_COUNT];        // Whether the pin's pull-up is on
+static struct {
+    halEventSource_t next;
+    halEventRun_t run;
+    void *ctx;
+} eventSources[HAL_MAX_EVENT_SOURCES];
+static uint8_t nEventSources = 0;
+static struct {
+    halEventRun_t run;
+    void *ctx;
+} catchUps[HAL_MAX_CATCH_UPS];
+static uint8_t nCatchUps = 0;
+static repeating_timer_t *timers[HAL_MAX_TIMERS];   // The active timers
+static uint64_t timerDue[HAL_MAX_TIMERS];           // When each is next due
+static struct {
+    bool claimed;
+    bool armed;
+    uint64_t target;
+    hardware_alarm_callback_t callback;
+} alarms[HAL_NUM_ALARMS];                           // The hardware alarms
+static bool alarmsAreSource = false;                // Whether the alarms are an event source yet
+static uint8_t nTimers = 0;
+
+/**
+ * @brief   Return the index in timers[] of the earliest due timer, or -1 if there are none
+ *
+ * @return int8_t
+ */
+static int8_t earliestTimer() {
+    int8_t answer = -1;
+    for (uint8_t t = 0; t < nTimers; t++) {
+        if (answer < 0 || timerDue[t] < timerDue[answer]) {
+            answer = t;
+        }
+    }
+    return answer;
+}
+
+/**
+ * @brief   Remove the timer at the specified index in timers[]
+ *
+ * @param t     The index
+ */
+static void removeTimer(uint8_t t) {
+    nTimers--;
+    timers[t] = timers[nTimers];
+    timerDue[t] = timerDue[nTimers];
+}
+
+// HAL functions
+
+uint64_t halMicros() {
+    return nowMicros;
+}
+
+void halAdvance(uint64_t micros) {
+    halAdvanceTo(nowMicros + micros);
+}
+
+void halAdvanceTo(uint64_t micros) {
+    runAheadLimit = 0;                      // If an event source's run called us, it's had its chance
+    while (true) {
+        // Find whatever happens first: a timer falling due or an event from a runnable source
+        int8_t t = earliestTimer();
+        uint64_t due = t < 0 ? HAL_NO_EVENT : timerDue[t];
+        int8_t src = -1;
+        uint64_t later = HAL_NO_EVENT;      // When the next thing after that is due
+        for (uint8_t s = 0; s < nEventSources; s++) {
+            if (eventSources[s].run != nullptr) {
+                uint64_t e = eventSources[s].next(eventSources[s].ctx);
+                if (e < due) {
+                    later = due;
+                    due = e;
+                    src = s;
+                } else if (e < later) {
+                    later = e;
+                }
+            }
+        }
+        if (due == HAL_NO_EVENT || due > micros) {
+            break;
+        }
+        if (due > nowMicros) {
+            nowMicros = due;
+        }
+        if (src >= 0) {
+            runAheadLimit = later - 1 < micros ? later - 1 : micros;
+            eventSources[src].run(eventSources[src].ctx);
+            runAheadLimit = 0;
+            continue;
+        }
+        repeating_timer_t *rt = timers[t];
+        bool again = rt->callback(rt);
+        // The callback may have cancelled or added timers, so find this one again
+        for (t = 0; t < nTimers && timers[t] != rt; t++) {
+        }
+        if (t == nTimers) {
+            continue;
+        }
+        if (!again) {
+            removeTimer(t);
+            continue;
+        }
+        uint64_t delay = rt->delay_us < 0 ? -rt->delay_us : rt->delay_us;
+        timerDue[t] = (rt->delay_us < 0 ? timerDue[t] : nowMicros) + (delay == 0 ? 1 : delay);
+    }
+    if (micros > nowMicros) {
+        nowMicros = micros;
+    }
+    for (uint8_t c = 0; c < nCatchUps; c++) {
+        catchUps[c].run(catchUps[c].ctx);
+    }
+}
+
+bool halAddEventSource(halEventSource_t next, halEventRun_t run, void *ctx) {
+    if (nEventSources >= HAL_MAX_EVENT_SOURCES) {
+        return false;
+    }
+    eventSources[nEventSources].next = next;
+    eventSources[nEventSources].run = run;
+    eventSources[nEventSources].ctx = ctx;
+    nEventSources++;
+    runAheadLimit = 0;
+    return true;
+}
+
+bool halRunAheadTo(uint64_t micros) {
+    if (micros > runAheadLimit) {
+        return false;
+    }
+    if (micros > nowMicros) {
+        nowMicros = micros;
+    }
+    return true;
+}
+
+bool halAddCatchUp(halEventRun_t run, void *ctx) {
+    if (nCatchUps >= HAL_MAX_CATCH_UPS) {
+        return false;
+    }
+    catchUps[nCatchUps].run = run;
+    catchUps[nCatchUps].ctx = ctx;
+    nCatchUps++;
+    return true;
+}
+
+uint64_t halNextEventMicros() {
+    int8_t t = earliestTimer();
+    uint64_t answer = t < 0 ? HAL_NO_EVENT : timerDue[t];
+    for (uint8_t s = 0; s < nEventSources; s++) {
+        uint64_t e = eventSources[s].next(eventSources[s].ctx);
+        if (e < answer) {
+            answer = e;
+        }
+    }
+    return answer;
+}
+
+/**
+ * @brief   Get the UTC time (micros) the simulated NTP server would report at the specified
+ *          virtual time
+ *
+ * @param micros    The virtual time
+ * @return int64_t  The UTC time in microseconds since the Unix epoch
+ */
+static int64_t networkUtcAt(uint64_t micros) {
+    return (int64_t)halNetwork.ntpTime * 1000000 + (int64_t)((double)micros / (1.0 + halNetwork.crystalPpm / 1e6));
+}
+
+int64_t halNetworkUtcMicros() {
+    return networkUtcAt(nowMicros);
+}
+
+void halSetTime(time_t t) {
+    epochAtZero = t - (time_t)(nowMicros / 1000000);
+}
+
+void halSetAnalogIn(uint8_t pin, uint16_t value) {
+    if (pin < HAL_PIN_COUNT) {
+        analogIn[pin] = value;
+        analogInSet[pin] = true;
+    }
+}
+
+uint16_t halGetAnalogIn(uint8_t pin) {
+    if (pin >= HAL_PIN_COUNT) {
+        return 0;
+    }
+    return analogInSet[pin] ? analogIn[pin] : HAL_DEFAULT_ANALOG_IN;
+}
+
+void halSetDigitalIn(uint8_t pin, uint8_t level) {
+    if (pin < HAL_PIN_COUNT) {
+        digitalIn[pin] = level == LOW ? LOW : HIGH;
+        digitalInSet[pin] = true;
+    }
+}
+
+int32_t halGetPinOut(uint8_t pin) {
+    return pin < HAL_PIN_COUNT ? pinOut[pin] : 0;
+}
+
+void halRequestExit() {
+    exitRequested = true;
+}
+
+bool halExitRequested() {
+    return exitRequested;
+}
+
+void halSetSerialOutput(bool on) {
+    serialOut = on;
+}
+
+void halSetSerialInput(bool on) {
+    serialIn = on;
+}
+
+void halSetSerialConnected(bool on) {
+    serialHost = on;
+}
+
+bool halSerialConnected() {
+    return serialHost;
+}
+
+/**
+ * @brief   Runs before any static initializers in the firmware. On the Pico, TZ is unset when
+ *          the firmware's static initializers call mktime(), so local time is UTC. Make it so
+ *          here too, whatever the host's time zone is.
+ *
+ */
+__attribute__((constructor(101))) static void halInitTimeZone() {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+}
+
+// The firmware's calls to time() end up here courtesy of -Wl,--wrap=time
+
+extern "C" time_t __wrap_time(time_t *t) {
+    time_t answer = epochAtZero + (time_t)(nowMicros / 1000000);
+    if (t != nullptr) {
+        *t = answer;
+    }
+    return answer;
+}
+
+// Arduino stand-ins
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < HAL_PIN_COUNT) {
+        pulledUp[pin] = mode == INPUT_PULLUP;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < HAL_PIN_COUNT) {
+        pinOut[pin] = value == LOW ? LOW : HIGH;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    if (pin < HAL_PIN_COUNT && digitalInSet[pin]) {
+        return digitalIn[pin];
+    }
+    return pin < HAL_PIN_COUNT && (pulledUp[pin] || pinOut[pin] != LOW) ? HIGH : LOW;
+}
+
+void analogWriteFreq(uint32_t freq) {
+}
+
+void analogWriteRange(uint32_t range) {
+}
+
+void analogWrite(uint8_t pin, int value) {
+    halStats.analogWrites++;
+    if (pin < HAL_PIN_COUNT) {
+        pinOut[pin] = value;
+    }
+}
+
+void analogReadResolution(int bits) {
+}
+
+int analogRead(uint8_t pin) {
+    halStats.analogReads++;
+    return halGetAnalogIn(pin);
+}
+
+unsigned long millis() {
+    return (unsigned long)(nowMicros / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)nowMicros;
+}
+
+void delay(unsigned long ms) {
+    halAdvance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    halAdvance(us);
+}
+
+// Pico SDK stand-ins
+
+uint64_t time_us_64() {
+    return nowMicros;
+}
+
+uint32_t time_us_32() {
+    return (uint32_t)nowMicros;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out) {
+    if (nTimers >= HAL_MAX_TIMERS) {
+        return false;
+    }
+    out->delay_us = delay_us;
+    out->pool = nullptr;
+    out->alarm_id = nTimers + 1;
+    out->callback = callback;
+    out->user_data = user_data;
+    uint64_t delay = delay_us < 0 ? -delay_us : delay_us;
+    timers[nTimers] = out;
+    timerDue[nTimers] = nowMicros + (delay == 0 ? 1 : delay);
+    nTimers++;
+    runAheadLimit = 0;
+    return true;
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+    for (uint8_t t = 0; t < nTimers; t++) {
+        if (timers[t] == timer) {
+            removeTimer(t);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief   Event source function for the hardware alarms: Return when the earliest armed one fires
+ *
+ * @param ctx           Unused
+ * @return uint64_t     The virtual time it fires or HAL_NO_EVENT if none are armed
+ */
+static uint64_t alarmNext(void *ctx) {
+    uint64_t answer = HAL_NO_EVENT;
+    for (uint8_t a = 0; a < HAL_NUM_ALARMS; a++) {
+        if (alarms[a].armed && alarms[a].target < answer) {
+            answer = alarms[a].target;
+        }
+    }
+    return answer;
+}
+
+/**
+ * @brief   Event source function for the hardware alarms: Fire the ones that are due
+ *
+ * @param ctx   Unused
+ */
+static void alarmRun(void *ctx) {
+    for (uint8_t a = 0; a < HAL_NUM_ALARMS; a++) {
+        if (alarms[a].armed && alarms[a].target <= nowMicros) {
+            alarms[a].armed = false;
+            if (alarms[a].callback != nullptr) {
+                alarms[a].callback(a);
+            }
+        }
+    }
+}
+
+int hardware_alarm_claim_unused(bool required) {
+    for (uint8_t a = 0; a < HAL_NUM_ALARMS; a++) {
+        if (!alarms[a].claimed) {
+            alarms[a].claimed = true;
+            if (!alarmsAreSource) {
+                alarmsAreSource = halAddEventSource(alarmNext, alarmRun, nullptr);
+            }
+            return a;
+        }
+    }
+    return -1;
+}
+
+void hardware_alarm_unclaim(uint alarm_num) {
+    if (alarm_num < HAL_NUM_ALARMS) {
+        alarms[alarm_num].claimed = false;
+        alarms[alarm_num].armed = false;
+    }
+}
+
+void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback) {
+    if (alarm_num < HAL_NUM_ALARMS) {
+        alarms[alarm_num].callback = callback;
+    }
+}
+
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t) {
+    if (alarm_num >= HAL_NUM_ALARMS || t <= nowMicros) {
+        return true;
+    }
+    alarms[alarm_num].target = t;
+    alarms[alarm_num].armed = true;
+    runAheadLimit = 0;
+    return false;
+}
+
+void hardware_alarm_cancel(uint alarm_num) {
+    if (alarm_num < HAL_NUM_ALARMS) {
+        alarms[alarm_num].armed = false;
+    }
+}
+
+void __wfe() {
+    halStats.sleeps++;
+}
+
+void __wfi() {
+    halStats.sleeps++;
+}
+
+void __sev() {
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+    if (gpio < HAL_PIN_COUNT) {
+        pinOut[gpio] = level;
+    }
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+}
+
+void gpio_init(uint gpio) {
+    if (gpio < HAL_PIN_COUNT) {
+        pinOut[gpio] = LOW;
+    }
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < HAL_PIN_COUNT) {
+        pinOut[gpio] = value ? HIGH : LOW;
+    }
+}
+
+bool gpio_get(uint gpio) {
+    return gpio < HAL_PIN_COUNT && pinOut[gpio] != LOW;
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value) {
+    while (mask != 0) {
+        uint8_t p = __builtin_ctz(mask);
+        pinOut[p] = (value >> p) & 1;
+        mask &= mask - 1;
+    }
+    halPinsWritten();
+}
+
+// WiFi and NTP stand-ins
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *pw) {
+    beginNoBlock(ssid, pw);
+    halAdvanceTo(settleMicros);
+    return status();
+}
+
+uint8_t WiFiClass::beginNoBlock(const char *ssid, const char *pw) {
+    curStatus = WL_IDLE_STATUS;
+    connecting = true;
+    settleMicros = nowMicros + (uint64_t)halNetwork.wifiMillis * 1000;
+    return curStatus;
+}
+
+wl_status_t WiFiClass::status() {
+    if (connecting && nowMicros >= settleMicros) {
+        connecting = false;
+        if (halNetwork.wifiFailures > 0) {
+            halNetwork.wifiFailures--;
+            curStatus = WL_CONNECT_FAILED;
+        } else {
+            curStatus = halNetwork.wifiOk ? WL_CONNECTED : WL_CONNECT_FAILED;
+        }
+    }
+    return curStatus;
+}
+
+/**
+ * @brief   Event source: When the time NTP.begin() asked for arrives
+ *
+ */
+static uint64_t ntpNext(void *ctx) {
+    return ntpDueMicros;
+}
+
+/**
+ * @brief   Event source: The time has arrived. Set the clock, provided there's still a network
+ *          for it to have arrived over.
+ *
+ */
+static void ntpRun(void *ctx) {
+    ntpDueMicros = HAL_NO_EVENT;
+    if (WiFi.status() == WL_CONNECTED) {
+        halSetTime((time_t)(halNetworkUtcMicros() / 1000000));
+    }
+}
+
+void NTPClass::begin(const char *server1, const char *server2) {
+    if (!ntpIsSource) {
+        ntpIsSource = halAddEventSource(ntpNext, ntpRun, nullptr);
+    }
+    if (halNetwork.ntpOk && halNetwork.ntpTime != 0) {
+        ntpDueMicros = nowMicros + (uint64_t)halNetwork.ntpMillis * 1000;
+        runAheadLimit = 0;
+    }
+}
+
+/**
+ * @brief   Put a UTC time (micros since the Unix epoch) into an NTP packet as an NTP timestamp
+ *
+ * @param at        Where in the packet
+ * @param utc       The time
+ */
+static void putNtpTime(uint8_t *at, int64_t utc) {
+    uint32_t secs = (uint32_t)(utc / 1000000 + 2208988800LL);
+    uint32_t frac = (uint32_t)(((uint64_t)(utc % 1000000) << 32) / 1000000);
+    for (uint8_t b = 0; b < 4; b++) {
+        at[b] = (uint8_t)(secs >> (24 - 8 * b));
+        at[4 + b] = (uint8_t)(frac >> (24 - 8 * b));
+    }
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    if (halNetwork.ntpServer == nullptr) {
+        return 1;
+    }
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        return 0;
+    }
+    fcntl(sock, F_SETFL, O_NONBLOCK);
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    inLen = 0;
+    replyPending = false;
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+    snprintf(this->host, sizeof(this->host), "%s", host);
+    this->port = port;
+    outLen = 0;
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t *buf, size_t len) {
+    len = len < maxLen - outLen ? len : maxLen - outLen;
+    memcpy(out + outLen, buf, len);
+    outLen += len;
+    return len;
+}
+
+int WiFiUDP::endPacket() {
+    if (WiFi.status() != WL_CONNECTED || port != 123 || outLen < maxLen) {
+        return 0;
+    }
+
+    // A real server: send the request its way
+    if (halNetwork.ntpServer != nullptr) {
+        char name[64];
+        snprintf(name, sizeof(name), "%s", halNetwork.ntpServer);
+        char *colon = strrchr(name, ':');
+        const char *service = "123";
+        if (colon != nullptr) {
+            *colon = '\0';
+            service = colon + 1;
+        }
+        struct addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        struct addrinfo *addr;
+        if (sock < 0 || getaddrinfo(name, service, &hints, &addr) != 0) {
+            return 0;
+        }
+        ssize_t sent = sendto(sock, out, outLen, 0, addr->ai_addr, addr->ai_addrlen);
+        freeaddrinfo(addr);
+        return sent == (ssize_t)outLen ? 1 : 0;
+    }
+
+    // The simulated server: it answers, if it's working, with the time as of halfway there
+    if (!halNetwork.ntpOk || halNetwork.ntpTime == 0) {
+        return 1;
+    }
+    memset(in, 0, sizeof(in));
+    in[0] = 0x24;                           // Leap indicator 0, version 4, mode 4 (server)
+    in[1] = 1;                              // Stratum 1
+    in[2] = out[2];                         // Poll interval, echoed
+    in[3] = 0xec;                           // Precision: 2^-20 s
+    memcpy(in + 12, "SIM", 3);              // Reference id
+    memcpy(in + 24, out + 40, 8);           // Originate timestamp: the request's transmit timestamp
+    int64_t serverUtc = networkUtcAt(nowMicros + halNetwork.ntpMillis * 500ULL);
+    putNtpTime(in + 16, serverUtc);         // Reference timestamp
+    putNtpTime(in + 32, serverUtc);         // Receive timestamp
+    putNtpTime(in + 40, serverUtc);         // Transmit timestamp
+    replyPending = true;
+    replyMicros = nowMicros + halNetwork.ntpMillis * 1000ULL;
+    return 1;
+}
+
+int WiFiUDP::parsePacket() {
+    inLen = 0;
+    inPos = 0;
+    if (sock >= 0) {
+        ssize_t got = recv(sock, in, sizeof(in), 0);
+        inLen = got > 0 ? got : 0;
+    } else if (replyPending && nowMicros >= replyMicros) {
+        replyPending = false;
+        inLen = WiFi.status() == WL_CONNECTED ? maxLen : 0;
+    }
+    return (int)inLen;
+}
+
+int WiFiUDP::read(uint8_t *buf, size_t len) {
+    len = len < inLen - inPos ? len : inLen - inPos;
+    memcpy(buf, in + inPos, len);
+    inPos += len;
+    return (int)len;
+}
+
+// Serial stand-in
+
+void SerialUSB::begin(unsigned long baud) {
+}
+
+int SerialUSB::available() {
+    if (peeked >= 0) {
+        return 1;
+    }
+    if (!serialIn) {
+        return 0;
+    }
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN, .revents = 0};
+    if (poll(&pfd, 1, 0) <= 0 || (pfd.revents & POLLIN) == 0) {
+        return 0;
+    }
+    unsigned char c;
+    if (::read(STDIN_FILENO, &c, 1) != 1) {
+        return 0;
+    }
+    peeked = c;
+    return 1;
+}
+
+int SerialUSB::read() {
+    if (!available()) {
+        return -1;
+    }
+    int answer = peeked;
+    peeked = -1;
+    return answer;
+}
+
+size_t SerialUSB::write(uint8_t c) {
+    if (!serialOut) {
+        return 1;
+    }
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t SerialUSB::write(const uint8_t *buf, size_t len) {
+    if (!serialOut) {
+        return len;
+    }
+    return fwrite(buf, 1, len, stdout);
+}
+
+int SerialUSB::availableForWrite() {
+    return HAL_SERIAL_TX_SPACE;
+}
+
+size_t SerialUSB::print(const String &s) {
+    return print(s.c_str());
+}
+
+size_t SerialUSB::print(const char *s) {
+    if (!serialOut) {
+        return strlen(s);
+    }
+    return fputs(s, stdout) < 0 ? 0 : strlen(s);
+}
+
+size_t SerialUSB::print(char c) {
+    return write(c);
+}
+
+size_t SerialUSB::print(long n) {
+    return printf("%ld", n);
+}
+
+size_t SerialUSB::println(const String &s) {
+    return print(s) + write('\n');
+}
+
+size_t SerialUSB::println(const char *s) {
+    return print(s) + write('\n');
+}
+
+size_t SerialUSB::println(long n) {
+    return print(n) + write('\n');
+}
+
+size_t SerialUSB::printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int answer = serialOut ? vprintf(format, args) : vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+    return answer < 0 ? 0 : answer;
+}
+
+void SerialUSB::flush() {
+    fflush(stdout);
+}
+
+#if !defined(NATIVE_SIM) && !defined(NATIVE_TOOL) && !defined(PIO_UNIT_TESTING)
+/**
+ * @brief   The host driver for the native build. Runs setup() (and setup1() if there is one)
+ *          once and then loop() (followed by loop1() if there is one) over and over, advancing
+ *          the virtual clock by HAL_LOOP_MICROS per pass.
+ *
+ *          Options:
+ *              --secs <n>      Stop after n virtual seconds (default: run until killed)
+ *              --start <t>     The UTC time_t NTP reports at boot (default: now)
+ *              --no-wifi       WiFi fails to connect
+ *              --no-ntp        NTP fails to set the clock
+ *              --ppm <n>       The virtual clock runs n ppm fast compared to the simulated NTP
+ *                              server's
+ *              --ntp-server <host:port>
+ *                              Send NTP requests to a real server (use with --realtime)
+ *              --realtime      Pace the virtual clock to match the wall clock
+ *
+ */
+int main(int argc, char *argv[]) {
+    uint64_t runMicros = 0;
+    bool realtime = false;
+    halNetwork.ntpTime = __real_time(nullptr);
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--secs") == 0 && a + 1 < argc) {
+            runMicros = strtoull(argv[++a], nullptr, 10) * 1000000;
+        } else if (strcmp(argv[a], "--start") == 0 && a + 1 < argc) {
+            halNetwork.ntpTime = (time_t)strtoll(argv[++a], nullptr, 10);
+        } else if (strcmp(argv[a], "--no-wifi") == 0) {
+            halNetwork.wifiOk = false;
+        } else if (strcmp(argv[a], "--no-ntp") == 0) {
+            halNetwork.ntpOk = false;
+        } else if (strcmp(argv[a], "--ppm") == 0 && a + 1 < argc) {
+            halNetwork.crystalPpm = strtod(argv[++a], nullptr);
+        } else if (strcmp(argv[a], "--ntp-server") == 0 && a + 1 < argc) {
+            halNetwork.ntpServer = argv[++a];
+        } else if (strcmp(argv[a], "--realtime") == 0) {
+            realtime = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--secs <n>] [--start <time_t>] [--no-wifi] [--no-ntp] [--ppm <n>]\n"
+                "          [--ntp-server <host:port>] [--realtime]\n", argv[0]);
+            return 1;
+        }
+    }
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    // In real time, the virtual clock is kept from getting ahead of the wall clock
+    struct timespec wallStart;
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    setup();
+    if (setup1) {
+        setup1();
+    }
+    while (!halExitRequested() && (runMicros == 0 || halMicros() < runMicros)) {
+        loop();
+        if (loop1) {
+            loop1();
+        }
+        halAdvance(HAL_LOOP_MICROS);
+        if (realtime) {
+            struct timespec wall;
+            clock_gettime(CLOCK_MONOTONIC, &wall);
+            int64_t wallMicros = (int64_t)(wall.tv_sec - wallStart.tv_sec) * 1000000 + (wall.tv_nsec - wallStart.tv_nsec) / 1000;
+            if ((int64_t)halMicros() > wallMicros) {
+                usleep((useconds_t)(halMicros() - wallMicros));
+            }
+        }
+    }
+    fflush(stdout);
+    return 0;
+}
+#endif
@@ -0,0 +1,408 @@
+/****
+ *
+ * This file is a part of the NativeHal library. The library is a thin hardware abstraction layer
+ * that lets the MoonDisplay firmware be built and run on a Linux host (the PlatformIO "native"
+ * environment). It does this by supplying host stand-ins for the handful of Arduino,
+ * arduino-pico, Pico SDK and third-party library interfaces the firmware uses: Arduino.h (GPIO,
+ * analogRead/analogWrite, millis(), delay(), String, Serial), EEPROM.h, WiFi.h (WiFi and NTP),
+ * CommandLine.h, pico/time.h (repeating timers), hardware/timer.h (hardware alarms),
+ * hardware/sync.h (__wfe() and friends), hardware/gpio.h, hardware/pwm.h, hardware/clocks.h,
+ * hardware/irq.h and hardware/flash.h (backed by 2 MB of emulated flash memory). The firmware
+ * sources are compiled unchanged against them. There are also hardware/pio.h, hardware/dma.h
+ * and hardware/adc.h, which are backed by emulators of the RP2040's PIO blocks, DMA channels and
+ * ADC, so that PIO programs and DMA-fed sampling run on the host too.
+ *
+ * All of the stand-ins run off a single virtual clock. Nothing happens in the virtual world
+ * unless something advances that clock, either the firmware itself (via delay()) or the host
+ * driver, the main() supplied here, or a simulator, test or host tool that replaces it (built
+ * with NATIVE_SIM, PIO_UNIT_TESTING or NATIVE_TOOL defined, respectively). Because the clock is
+ * virtual, the firmware can be run many thousands of times faster than real time. As the
+ * clock advances, the callbacks of any repeating timers that fall due are invoked in time
+ * order, just as the Pico's timer interrupts would have invoked them. The emulated peripherals
+ * are interleaved with the timers in the same way.
+ *
+ * The time() function is also part of the virtual world. The native build links with
+ * "-Wl,--wrap=time" so that the firmware's calls to time() are routed to the HAL. Until NTP has
+ * "set the clock" time() counts up from the Unix epoch, just as it does on the Pico.
+ *
+ * The simulated network takes time, as the real one does: connecting to WiFi takes
+ * halNetwork.wifiMillis whether it works or not, and the time arrives halNetwork.ntpMillis after
+ * NTP.begin(), provided WiFi is still connected then. WiFi.begin() waits for the connection,
+ * advancing the virtual clock; WiFi.beginNoBlock() and NTP.begin() don't. There's also a simulated
+ * NTP server: a request sent with WiFiUDP to port 123 of any host is answered ntpMillis later with
+ * the time halNetworkUtcMicros() says it is halfway there. The virtual clock can be made to run
+ * fast or slow compared to the server's, as a real crystal does, with halNetwork.crystalPpm. To
+ * try the firmware against a real NTP server (e.g., tools/MockNtpServer.cpp) instead, set
+ * halNetwork.ntpServer; the requests then go out over a host UDP socket. That only makes sense
+ * when the virtual clock keeps pace with the wall clock (the native driver's --realtime).
+ *
+ * There's a model of the mechanism, too, for host code that asks for it. halAddMotor() puts a
+ * 28BYJ-48 stepper on four GPIO pins; the model watches the coil levels the pins are driven to
+ * and turns the rotor the way the magnetic field pulls it, which, when all goes well, is a half
+ * step each time the coils move on a half step. It keeps track of where the part of the
+ * mechanism the motor drives is. halSetMotorFlag() gives that part a home flag whose optical
+ * sensor reads a given level on a GPIO pin at and above a given position, and the other level 
+ * below it. Things can go
+ * wrong, as they do with real motors: halSetMotorSlip() makes the motor lose a whole cycle of
+ * the coils (8 half steps) every so often, as a stalled stepper does, and halSlipMotor() moves
+ * the part without the motor turning, as a belt jumping a tooth or a hand on the mechanism does.
+ * And, as with a real motor, if the firmware energizes the coils in a phase other than the one
+ * the rotor was left at, the rotor jumps to the nearest position that matches. Digital inputs
+ * can be set directly with halSetDigitalIn(), too. Until one is, a pin reads HIGH if its pull-up 
+ * is on (pinMode() INPUT_PULLUP) and otherwise the level last written to it.
+ * 
+ * Erasing and programming the emulated flash take time, as they do on the Pico: 
+ * HAL_FLASH_ERASE_MICROS per sector and HAL_FLASH_PROGRAM_MICROS per page. On the Pico, the 
+ * firmware idles the other core and turns interrupts off for the duration, so the stand-ins 
+ * advance the virtual clock by that much with the hardware/irq.h interrupts held off 
+ * (halHoldIrqs()); the ones that come due meanwhile are taken when it's over. The PIO blocks and 
+ * DMA channels carry on regardless, as they do on the Pico. A state machine that runs out of 
+ * words to pull because the interrupt that would have kept it fed was held off counts as a 
+ * starvation in halStats.irqStarves. (The motor model doesn't lose steps over it, but a real 
+ * stepper, stopped dead at speed, does.) The linker symbols _FS_start and _FS_end bound the
+ * HAL_FS_SIZE bytes of emulated flash set aside for a filesystem, as the Pico's do.
+ *
+ * Host code (simulators and the like) uses the hal... functions declared here to drive the
+ * virtual clock, to set the state of inputs and of the simulated network and to inspect
+ * outputs.
+ *
+ * Note that on the host, unsigned long is 64 bits wide, so millis() does not wrap after 49.7
+ * days the way it does on the Pico.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+/**
+ *
+ * Compile-time constants
+ *
+ **/
+#define HAL_PIN_COUNT           (65)        // GPIO 0..29 plus the Pico W's LED pin (64)
+#define HAL_MAX_EVENT_SOURCES   (8)         // Max number of registered event sources
+#define HAL_MAX_CATCH_UPS       (4)         // Max number of registered catch-up functions
+#define HAL_LOOP_MICROS         (1000)      // Default virtual micros that pass per loop() pass
+#define HAL_NO_EVENT            (UINT64_MAX) // halNextEventMicros() value if nothing is pending
+#define HAL_DEFAULT_ANALOG_IN   (1000)      // Default analogRead() value (fairly bright ambient)
+#define HAL_SERIAL_TX_SPACE     (256)       // What Serial.availableForWrite() says (the Pico's USB TX buffer)
+#define HAL_MAX_MOTORS          (2)         // Max number of modeled stepper motors
+#define HAL_FLASH_ERASE_MICROS  (45000)     // How long erasing a flash sector takes (typical for the Pico's W25Q16JV)
+#define HAL_FLASH_PROGRAM_MICROS (400)      // How long programming a flash page takes (ditto)
+#define HAL_FS_SIZE             (16384)     // Size of the filesystem region (board_build.filesystem_size in platformio.ini)
+#define HAL_FS_OFFSET           (2097152 - 4096 - HAL_FS_SIZE) // Its flash offset: just below EEPROM's sector at the top
+
+/**
+ *
+ * Type definitions
+ *
+ **/
+struct halStats_t {                         // Counters maintained by the stand-ins
+    uint32_t eepromCommits;                 // Number of EEPROM.commit() calls
+    uint32_t analogReads;                   // Number of analogRead() calls
+    uint32_t analogWrites;                  // Number of analogWrite() calls
+    uint32_t flashErases;                   // Number of flash sectors erased
+    uint32_t flashPrograms;                 // Number of flash pages programmed
+    uint64_t flashBusyMicros;               // Time spent erasing and programming flash
+    uint32_t irqStarves;                    // Number of times a PIO state machine ran dry while interrupts were held off
+    uint32_t sleeps;                        // Number of __wfe() and __wfi() calls
+};
+
+struct halNetwork_t {                       // The state of the simulated network
+    bool wifiOk;                            // true if WiFi.begin() will succeed
+    bool ntpOk;                             // true if NTP.begin() will set the clock
+    time_t ntpTime;                         // The UTC time NTP reports at virtual micros 0
+    uint32_t wifiMillis;                    // How long connecting to WiFi takes (or takes to fail)
+    uint32_t wifiFailures;                  // How many connection attempts fail before wifiOk applies
+    uint32_t ntpMillis;                     // How long after NTP.begin() (or an NTP request) the time arrives
+    double crystalPpm;                      // How fast the virtual clock runs compared to NTP's (ppm)
+    const char *ntpServer;                  // "host:port" of a real NTP server to use instead, or nullptr
+};
+
+typedef uint64_t (*halEventSource_t)(void *ctx);    // Returns virtual micros of next event
+typedef void (*halEventRun_t)(void *ctx);           // Handles events due at or before halMicros()
+
+/**
+ *
+ * Global variables
+ *
+ **/
+extern halStats_t halStats;                 // Stand-in counters
+extern halNetwork_t halNetwork;             // Simulated network
+
+/**
+ * @brief   Get the current value of the virtual clock in microseconds since "boot"
+ *
+ * @return uint64_t The current virtual time
+ */
+uint64_t halMicros();
+
+/**
+ * @brief   Advance the virtual clock by the specified number of microseconds, running the
+ *          callbacks of any timers that fall due along the way.
+ *
+ * @param micros    The number of microseconds that are to pass
+ */
+void halAdvance(uint64_t micros);
+
+/**
+ * @brief   Advance the virtual clock to the specified virtual time, running the callbacks of any
+ *          timers that fall due along the way. If it has already passed, nothing happens.
+ *
+ * @param micros    The virtual time, in microseconds since "boot" to advance to
+ */
+void halAdvanceTo(uint64_t micros);
+
+/**
+ * @brief   Register a source of events. Stand-ins for things that happen on their own register
+ *          themselves so that a simulator can skip straight to the next thing that happens and
+ *          so that halAdvanceTo() can have them happen in time order with everything else.
+ *          (Active timers are always event sources.)
+ *
+ * @param next      Function that returns the virtual micros of the source's next event or
+ *                  HAL_NO_EVENT
+ * @param run       Function that handles the source's events that are due as of halMicros(),
+ *                  or nullptr if the source only needs to be known to halNextEventMicros()
+ * @param ctx       Passed to next and run
+ * @return true     Success
+ * @return false    Too many event sources
+ */
+bool halAddEventSource(halEventSource_t next, halEventRun_t run, void *ctx);
+
+/**
+ * @brief   For an event source's run function: move the virtual clock on to the specified time,
+ *          so the source can handle its next event without going back through halAdvanceTo(),
+ *          provided nothing else comes due first. Nothing does if no timer, other event source
+ *          or end of the halAdvanceTo() that's running the source comes at or before then, and
+ *          no timer, alarm or the like has been set since the source was run.
+ *
+ * @param micros    The virtual time of the source's next event
+ * @return true     The virtual clock is now at micros; go ahead and handle the event
+ * @return false    Something else comes first; return and let halAdvanceTo() sort it out
+ */
+bool halRunAheadTo(uint64_t micros);
+
+/**
+ * @brief   Register a catch-up function. It is called each time halAdvanceTo() has advanced the
+ *          virtual clock. It's for emulated peripherals that produce results far too often to 
+ *          be worth treating as events (e.g., a free-running ADC). Instead of scheduling every 
+ *          result, they bring themselves up to date lazily, and only as far as anyone could 
+ *          tell. Catch-up functions don't count as pending events.
+ *
+ * @param run       Function that brings the peripheral up to date as of halMicros()
+ * @param ctx       Passed to run
+ * @return true     Success
+ * @return false    Too many catch-up functions
+ */
+bool halAddCatchUp(halEventRun_t run, void *ctx);
+
+/**
+ * @brief   Get the virtual time of the earliest pending event among all active timers and
+ *          registered event sources.
+ *
+ * @return uint64_t The virtual time of the next event or HAL_NO_EVENT if nothing is pending.
+ */
+uint64_t halNextEventMicros();
+
+/**
+ * @brief   Get the UTC time, in microseconds since the Unix epoch, that the simulated NTP server
+ *          would report now. It is halNetwork.ntpTime at virtual micros 0 and runs slow by
+ *          halNetwork.crystalPpm compared to the virtual clock.
+ *
+ * @return int64_t  The simulated true time
+ */
+int64_t halNetworkUtcMicros();
+
+/**
+ * @brief   Get the emulated flash memory. On the host, it is what XIP_BASE refers to, so the
+ *          firmware reads flash via XIP_BASE + offset, just as it does on the Pico. It starts
+ *          out erased (all 0xff) and lasts as long as the process does.
+ *
+ * @return uint8_t*     The PICO_FLASH_SIZE_BYTES of emulated flash
+ */
+uint8_t *halFlashMemory();
+
+/**
+ * @brief   Set the UTC time time() reports, starting now. Called by the NTP stand-in;
+ *          simulators may call it to pretend the clock was set some other way.
+ *
+ * @param t     The time time() should return now
+ */
+void halSetTime(time_t t);
+
+/**
+ * @brief   Set the value analogRead() returns for the specified pin
+ *
+ * @param pin       The GPIO pin
+ * @param value     The value (0..4095 at 12-bit resolution)
+ */
+void halSetAnalogIn(uint8_t pin, uint16_t value);
+
+/**
+ * @brief   Get the value analogRead() (or the emulated ADC) reads on the specified pin
+ *
+ * @param pin       The GPIO pin
+ * @return uint16_t The value (0..4095 at 12-bit resolution)
+ */
+uint16_t halGetAnalogIn(uint8_t pin);
+
+/**
+ * @brief   Get the value most recently written to the specified pin using digitalWrite()
+ *          (0 or 1) or analogWrite() (the duty cycle).
+ *
+ * @param pin       The GPIO pin
+ * @return int32_t  The value last written
+ */
+int32_t halGetPinOut(uint8_t pin);
+
+/**
+ * @brief   Set the level digitalRead() reads on the specified pin from now on. Until it's set, a
+ *          pin reads HIGH if its pull-up is on and otherwise the level last written to it.
+ *
+ * @param pin       The GPIO pin
+ * @param level     HIGH or LOW
+ */
+void halSetDigitalIn(uint8_t pin, uint8_t level);
+
+/**
+ * @brief   Model a 28BYJ-48 stepper motor driven by the specified pins through a ULN2003. The
+ *          rotor lines up with the coils the first time they're energized.
+ *
+ * @param pins      The GPIO pins driving IN1, IN2, IN3 and IN4
+ * @param pos       Where the part of the mechanism the motor drives is now (half steps)
+ * @return int8_t   The motor's number or -1 if there are too many motors
+ */
+int8_t halAddMotor(const uint8_t pins[4], int32_t pos);
+
+/**
+ * @brief   Give the part the specified motor drives a home flag, whose sensor reads the
+ *          specified level on the specified pin at and above the specified position, and the 
+ *          other level below it
+ *
+ * @param motor     The motor
+ * @param pin       The GPIO pin the sensor is read on
+ * @param edge      The position of the flag's edge (half steps)
+ * @param active    What the sensor reads at and above the edge (HIGH or LOW)
+ */
+void halSetMotorFlag(int8_t motor, uint8_t pin, int32_t edge, uint8_t active);
+
+/**
+ * @brief   Set how often the specified motor loses a cycle of the coils, falling 8 half steps
+ *          short of where it's driven to
+ *
+ * @param motor     The motor
+ * @param ppm       The chance, in parts per million, for each step
+ */
+void halSetMotorSlip(int8_t motor, double ppm);
+
+/**
+ * @brief   Move the part the specified motor drives by the specified number of half steps
+ *          without the motor turning
+ *
+ * @param motor     The motor
+ * @param steps     How far (+ or -)
+ */
+void halSlipMotor(int8_t motor, int32_t steps);
+
+/**
+ * @brief   Get where the part the specified motor drives really is
+ *
+ * @param motor     The motor
+ * @return int32_t  The position (half steps)
+ */
+int32_t halGetMotorPosition(int8_t motor);
+
+/**
+ * @brief   Get how many cycles the specified motor has lost to halSetMotorSlip()
+ *
+ * @param motor     The motor
+ * @return uint32_t The number of cycles lost
+ */
+uint32_t halGetMotorSlips(int8_t motor);
+
+/**
+ * @brief   Hold off the hardware/irq.h interrupts, or stop holding them off and take the ones 
+ *          that came due meanwhile. Used by the flash stand-ins to model the firmware turning 
+ *          interrupts off while flash is busy.
+ * 
+ * @param hold  true ==> hold them off; false ==> take them again
+ */
+void halHoldIrqs(bool hold);
+
+/**
+ * @brief   Let the motor models see the coil levels. Called by the stand-ins each time they've
+ *          written a set of output pins.
+ *
+ */
+void halPinsWritten();
+
+/**
+ * @brief   Turn the firmware's Serial output to stdout on or off. Simulators that produce their
+ *          own reports typically turn it off.
+ *
+ * @param on    true ==> Serial output goes to stdout; false ==> it is discarded
+ */
+void halSetSerialOutput(bool on);
+
+/**
+ * @brief   Say whether a host has the USB serial port open. Until one does, Serial tests false,
+ *          as it does on the Pico. Output is still written (or discarded) as halSetSerialOutput()
+ *          says.
+ *
+ * @param on    true ==> a host is connected (the default); false ==> nobody's there
+ */
+void halSetSerialConnected(bool on);
+
+/**
+ * @brief   Get whether a host has the USB serial port open
+ *
+ * @return true     Connected
+ * @return false    Not
+ */
+bool halSerialConnected();
+
+/**
+ * @brief   Turn Serial input from stdin on or off. Simulators turn it off so the firmware doesn't
+ *          poll stdin on every pass through loop().
+ *
+ * @param on    true ==> Serial input comes from stdin; false ==> there's never any input
+ */
+void halSetSerialInput(bool on);
+
+/**
+ * @brief   Ask the host driver to stop running the firmware
+ *
+ */
+void halRequestExit();
+
+/**
+ * @brief   Return whether halRequestExit() has been called
+ *
+ * @return true     Exit requested
+ * @return false    Keep going
+ */
+bool halExitRequested();
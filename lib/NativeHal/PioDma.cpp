@@ -0,0 +1,1358 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <NativeHal.h>
+#include <hardware/pio.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/clocks.h>
+#include <hardware/gpio.h>
+#include <hardware/adc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ *
+ * Compile-time constants
+ *
+ **/
+#define PIO_FIFO_DEPTH          (4)         // Depth of each FIFO when not joined
+#define PIO_UNITS_PER_US        ((uint64_t)HAL_CLK_SYS_HZ / 1000000 * 256)  // 1/256ths of a sys clock cycle per us
+
+/**
+ *
+ * Type definitions
+ *
+ **/
+struct fifo_t {                             // A PIO FIFO
+    uint32_t data[2 * PIO_FIFO_DEPTH];
+    uint8_t head;                           // Index of the oldest entry
+    uint8_t count;                          // Number of entries
+    uint8_t depth;                          // Capacity (0, 4 or 8, depending on joining)
+};
+
+enum smState_t {                            // What a state machine is up to
+    SM_RUNNING,                             // Executing instructions
+    SM_STALL_TX,                            // Stalled waiting for the TX FIFO to be written
+    SM_STALL_RX,                            // Stalled waiting for the RX FIFO to be read
+    SM_STALL_POLL,                          // Stalled waiting for a pin or IRQ flag; retried every cycle
+    SM_HALTED                               // In a "jmp self" loop; nothing more will happen
+};
+
+enum execResult_t {                         // What came of executing an instruction
+    EXEC_NEXT,                              // Done; go on to the next instruction
+    EXEC_JUMPED,                            // Done; the PC has been set
+    EXEC_STALLED                            // Not done; try again later
+};
+
+struct sm_t {                               // The state of a PIO state machine
+    bool claimed;
+    bool enabled;
+    pio_sm_config cfg;
+    uint8_t pc;
+    uint32_t x, y, isr, osr;
+    uint8_t isrCount;                       // Bits shifted into the ISR
+    uint8_t osrCount;                       // Bits shifted out of the OSR (32 ==> empty)
+    bool irqWaiting;                        // Set an IRQ flag with "wait" and waiting for it to clear
+    bool execPending;                       // An OUT EXEC or MOV EXEC supplied the next instruction
+    uint16_t execInstr;                     // The instruction it supplied
+    fifo_t tx, rx;
+    smState_t state;
+    bool starved;                           // Stalled pulling while an interrupt that would have fed it was held off
+    uint64_t time;                          // When the next instruction executes (PIO_UNITS_PER_US units)
+};
+
+struct pioBlock_t {                         // The state of a PIO block
+    uint16_t instr[PIO_INSTRUCTION_COUNT];  // Instruction memory
+    uint32_t used;                          // Bit map of instruction memory that's in use
+    uint8_t irqFlags;                       // The eight IRQ flags
+    sm_t sm[NUM_PIO_STATE_MACHINES];
+};
+
+struct chan_t {                             // The state of a DMA channel
+    bool claimed;
+    bool busy;
+    dma_channel_config cfg;
+    uint32_t reload;                        // Copied to transfer_count each time it's triggered
+    bool irqRaw;                            // Completed and not yet acknowledged
+    bool irqEnabled[2];                     // Whether the channel raises DMA_IRQ_0/DMA_IRQ_1
+};
+
+/**
+ *
+ * Global variables
+ *
+ **/
+pio_hw_t halPioHw[NUM_PIOS];
+adc_hw_t halAdcHw;
+
+/**
+ *
+ * The state of the emulated peripherals
+ *
+ **/
+static pioBlock_t pios[NUM_PIOS];
+static bool pioRegistered = false;          // Whether the PIOs are registered as an event source
+static uint8_t pioEnabled = 0;              // Bit map of the enabled state machines, bit p * 4 + s
+static chan_t chans[NUM_DMA_CHANNELS];
+static dma_channel_hw_t chanHw[NUM_DMA_CHANNELS];
+static bool pumping = false;                // Whether dmaPump() is running
+static bool pumpAgain;                      // Whether dmaPump() needs to go around again
+static struct {                            // The state of the ADC
+    bool running;                           // Free-running
+    bool catchingUp;                        // Registered as a catch-up function
+    uint8_t input;                          // Selected input (0..4)
+    bool fifoEn;                            // Results go to the FIFO
+    uint32_t period;                        // Cycles of clk_adc between free-running samples
+    uint64_t next;                          // When the next free-running sample is due (clk_adc cycles)
+    uint16_t lastSample;                    // The last free-running sample
+    uint64_t sameRun;                       // How many in a row, up to it, had the same value
+    fifo_t fifo;
+} adc;
+static irq_handler_t irqHandlers[HAL_IRQ_COUNT][HAL_MAX_IRQ_HANDLERS];
+static bool irqEnabled[HAL_IRQ_COUNT];
+static bool irqsHeld = false;               // Whether halHoldIrqs() is holding interrupts off
+static bool irqPending[HAL_IRQ_COUNT];      // Interrupts that came due while they were held off
+
+static void dmaPump();
+
+// FIFO helpers
+
+static bool fifoFull(fifo_t *f) {
+    return f->count >= f->depth;
+}
+
+static void fifoPush(fifo_t *f, uint32_t v) {
+    f->data[(f->head + f->count) % (2 * PIO_FIFO_DEPTH)] = v;
+    f->count++;
+}
+
+static uint32_t fifoPop(fifo_t *f) {
+    uint32_t answer = f->data[f->head];
+    f->head = (f->head + 1) % (2 * PIO_FIFO_DEPTH);
+    f->count--;
+    return answer;
+}
+
+/**
+ * @brief   Push a word onto a state machine's TX FIFO from the system side, waking the state
+ *          machine if it's waiting for it.
+ *
+ * @return true     Success
+ * @return false    The FIFO is full; the word is lost
+ */
+static bool txPush(uint8_t p, uint8_t s, uint32_t v) {
+    sm_t *sm = &pios[p].sm[s];
+    if (fifoFull(&sm->tx)) {
+        return false;
+    }
+    fifoPush(&sm->tx, v);
+    if (sm->state == SM_STALL_TX) {
+        halStats.irqStarves += sm->starved;
+        sm->starved = false;
+        sm->state = SM_RUNNING;
+        uint64_t now = halMicros() * PIO_UNITS_PER_US;
+        sm->time = sm->time < now ? now : sm->time;
+    }
+    return true;
+}
+
+/**
+ * @brief   Pop a word from a state machine's RX FIFO from the system side, waking the state
+ *          machine if it's waiting for room. Returns 0 if the FIFO is empty.
+ */
+static uint32_t rxPop(uint8_t p, uint8_t s) {
+    sm_t *sm = &pios[p].sm[s];
+    if (sm->rx.count == 0) {
+        return 0;
+    }
+    uint32_t answer = fifoPop(&sm->rx);
+    if (sm->state == SM_STALL_RX) {
+        sm->state = SM_RUNNING;
+        uint64_t now = halMicros() * PIO_UNITS_PER_US;
+        sm->time = sm->time < now ? now : sm->time;
+    }
+    return answer;
+}
+
+/**
+ * @brief   Note that a state machine has stalled for want of a word to pull. If an interrupt 
+ *          is being held off meanwhile, it may be the one that would have fed it, which 
+ *          becomes clear if the interrupt, once taken, does.
+ */
+static void txStalled(sm_t *sm) {
+    sm->state = SM_STALL_TX;
+    for (uint8_t i = 0; i < HAL_IRQ_COUNT && irqsHeld; i++) {
+        sm->starved = sm->starved || irqPending[i];
+    }
+}
+
+// PIO emulation
+
+/**
+ * @brief   Return the length, in PIO_UNITS_PER_US units, of one cycle of a state machine's clock
+ */
+static uint64_t smPeriod(sm_t *sm) {
+    uint32_t div = sm->cfg.clkdivInt == 0 ? 65536 : sm->cfg.clkdivInt;
+    return (uint64_t)div * 256 + sm->cfg.clkdivFrac;
+}
+
+static void writePins(uint8_t base, uint8_t count, uint32_t value) {
+    // All at once, wrapping around from GPIO 31 to GPIO 0
+    uint32_t mask = count >= 32 ? 0xffffffff : (1UL << count) - 1;
+    uint8_t r = (32 - base) & 31;
+    gpio_put_masked(mask << base | mask >> r, value << base | (value & mask) >> r);
+}
+
+static uint32_t readPins(uint8_t base) {
+    uint32_t answer = 0;
+    for (uint8_t i = 0; i < 32; i++) {
+        answer |= (uint32_t)gpio_get((base + i) & 31) << i;
+    }
+    return answer;
+}
+
+static uint32_t bitReverse(uint32_t v) {
+    uint32_t answer = 0;
+    for (uint8_t i = 0; i < 32; i++) {
+        answer = (answer << 1) | ((v >> i) & 1);
+    }
+    return answer;
+}
+
+/**
+ * @brief   Execute the specified instruction on the specified state machine. Doesn't advance
+ *          the PC or the state machine's time; the caller does that.
+ */
+static execResult_t execute(uint8_t p, uint8_t s, uint16_t instr) {
+    sm_t *sm = &pios[p].sm[s];
+    pio_sm_config *cfg = &sm->cfg;
+    uint8_t op = instr >> 13;
+    uint8_t arg1 = (instr >> 5) & 7;
+    uint8_t arg2 = instr & 0x1f;
+    uint8_t bits = arg2 == 0 ? 32 : arg2;
+    uint32_t mask = bits == 32 ? 0xffffffff : (1UL << bits) - 1;
+
+    // Side-set happens whether or not the instruction stalls
+    if (cfg->sidesetBits > 0) {
+        uint8_t n = cfg->sidesetBits;
+        uint8_t v = ((instr >> 8) & 0x1f) >> (5 - n);
+        bool apply = true;
+        if (cfg->sidesetOpt) {
+            n--;
+            apply = (v >> n) & 1;
+            v &= (1 << n) - 1;
+        }
+        if (apply && !cfg->sidesetPindirs) {
+            writePins(cfg->sidesetBase, n, v);
+        }
+    }
+
+    switch (op) {
+        case 0: {   // JMP
+            bool take = false;
+            switch (arg1) {
+                case 0: take = true; break;
+                case 1: take = sm->x == 0; break;
+                case 2: take = sm->x-- != 0; break;
+                case 3: take = sm->y == 0; break;
+                case 4: take = sm->y-- != 0; break;
+                case 5: take = sm->x != sm->y; break;
+                case 6: take = gpio_get(cfg->jmpPin); break;
+                case 7: take = sm->osrCount < cfg->pullThreshold; break;
+            }
+            if (take) {
+                sm->pc = arg2;
+                return EXEC_JUMPED;
+            }
+            return EXEC_NEXT;
+        }
+        case 1: {   // WAIT
+            bool polarity = (instr >> 7) & 1;
+            uint8_t index = arg2;
+            bool level = false;
+            switch ((instr >> 5) & 3) {
+                case 0: level = gpio_get(index); break;
+                case 1: level = gpio_get((cfg->inBase + index) & 31); break;
+                case 2:
+                    index = (index & 0x10) ? (index & 4) | ((index + s) & 3) : index & 7;
+                    level = (pios[p].irqFlags >> index) & 1;
+                    if (level && polarity) {
+                        pios[p].irqFlags &= ~(1 << index);
+                    }
+                    break;
+            }
+            if (level != polarity) {
+                sm->state = SM_STALL_POLL;
+                return EXEC_STALLED;
+            }
+            return EXEC_NEXT;
+        }
+        case 2: {   // IN
+            if (cfg->autopush && sm->isrCount + bits >= cfg->pushThreshold && fifoFull(&sm->rx)) {
+                sm->state = SM_STALL_RX;
+                return EXEC_STALLED;
+            }
+            uint32_t v = 0;
+            switch (arg1) {
+                case 0: v = readPins(cfg->inBase); break;
+                case 1: v = sm->x; break;
+                case 2: v = sm->y; break;
+                case 6: v = sm->isr; break;
+                case 7: v = sm->osr; break;
+            }
+            v &= mask;
+            if (bits == 32) {
+                sm->isr = v;
+            } else if (cfg->inShiftRight) {
+                sm->isr = (sm->isr >> bits) | (v << (32 - bits));
+            } else {
+                sm->isr = (sm->isr << bits) | v;
+            }
+            sm->isrCount = sm->isrCount + bits > 32 ? 32 : sm->isrCount + bits;
+            if (cfg->autopush && sm->isrCount >= cfg->pushThreshold) {
+                fifoPush(&sm->rx, sm->isr);
+                sm->isr = 0;
+                sm->isrCount = 0;
+                dmaPump();
+            }
+            return EXEC_NEXT;
+        }
+        case 3: {   // OUT
+            if (cfg->autopull && sm->osrCount >= cfg->pullThreshold) {
+                if (sm->tx.count == 0) {
+                    txStalled(sm);
+                    return EXEC_STALLED;
+                }
+                sm->osr = fifoPop(&sm->tx);
+                sm->osrCount = 0;
+                dmaPump();
+            }
+            uint32_t v;
+            if (bits == 32) {
+                v = sm->osr;
+                sm->osr = 0;
+            } else if (cfg->outShiftRight) {
+                v = sm->osr & mask;
+                sm->osr >>= bits;
+            } else {
+                v = sm->osr >> (32 - bits);
+                sm->osr <<= bits;
+            }
+            sm->osrCount = sm->osrCount + bits > 32 ? 32 : sm->osrCount + bits;
+            switch (arg1) {
+                case 0: writePins(cfg->outBase, cfg->outCount, v); break;
+                case 1: sm->x = v; break;
+                case 2: sm->y = v; break;
+                case 5: sm->pc = v & 0x1f; return EXEC_JUMPED;
+                case 6: sm->isr = v; sm->isrCount = bits; break;
+                case 7: sm->execPending = true; sm->execInstr = v; break;
+            }
+            return EXEC_NEXT;
+        }
+        case 4: {   // PUSH or PULL
+            bool ifFlag = (instr >> 6) & 1;
+            bool block = (instr >> 5) & 1;
+            if (instr & 0x80) {
+                if (ifFlag && sm->osrCount < cfg->pullThreshold) {
+                    return EXEC_NEXT;
+                }
+                if (sm->tx.count == 0) {
+                    if (block) {
+                        txStalled(sm);
+                        return EXEC_STALLED;
+                    }
+                    sm->osr = sm->x;
+                } else {
+                    sm->osr = fifoPop(&sm->tx);
+                    dmaPump();
+                }
+                sm->osrCount = 0;
+            } else {
+                if (ifFlag && sm->isrCount < cfg->pushThreshold) {
+                    return EXEC_NEXT;
+                }
+                if (fifoFull(&sm->rx)) {
+                    if (block) {
+                        sm->state = SM_STALL_RX;
+                        return EXEC_STALLED;
+                    }
+                } else {
+                    fifoPush(&sm->rx, sm->isr);
+                    dmaPump();
+                }
+                sm->isr = 0;
+                sm->isrCount = 0;
+            }
+            return EXEC_NEXT;
+        }
+        case 5: {   // MOV
+            uint32_t v = 0;
+            switch (instr & 7) {
+                case 0: v = readPins(cfg->inBase); break;
+                case 1: v = sm->x; break;
+                case 2: v = sm->y; break;
+                case 5: v = (cfg->statusSel == STATUS_TX_LESSTHAN ? sm->tx.count : sm->rx.count) < cfg->statusN ? 0xffffffff : 0; break;
+                case 6: v = sm->isr; break;
+                case 7: v = sm->osr; break;
+            }
+            switch ((instr >> 3) & 3) {
+                case 1: v = ~v; break;
+                case 2: v = bitReverse(v); break;
+            }
+            switch (arg1) {
+                case 0: writePins(cfg->outBase, cfg->outCount, v); break;
+                case 1: sm->x = v; break;
+                case 2: sm->y = v; break;
+                case 4: sm->execPending = true; sm->execInstr = v; break;
+                case 5: sm->pc = v & 0x1f; return EXEC_JUMPED;
+                case 6: sm->isr = v; sm->isrCount = 0; break;
+                case 7: sm->osr = v; sm->osrCount = 0; break;
+            }
+            return EXEC_NEXT;
+        }
+        case 6: {   // IRQ
+            uint8_t index = (arg2 & 0x10) ? (arg2 & 4) | ((arg2 + s) & 3) : arg2 & 7;
+            if (sm->irqWaiting) {
+                if ((pios[p].irqFlags >> index) & 1) {
+                    sm->state = SM_STALL_POLL;
+                    return EXEC_STALLED;
+                }
+                sm->irqWaiting = false;
+                return EXEC_NEXT;
+            }
+            if (instr & 0x40) {
+                pios[p].irqFlags &= ~(1 << index);
+            } else {
+                pios[p].irqFlags |= 1 << index;
+                if (instr & 0x20) {
+                    sm->irqWaiting = true;
+                    sm->state = SM_STALL_POLL;
+                    return EXEC_STALLED;
+                }
+            }
+            return EXEC_NEXT;
+        }
+        default: {  // SET
+            switch (arg1) {
+                case 0: writePins(cfg->setBase, cfg->setCount, arg2); break;
+                case 1: sm->x = arg2; break;
+                case 2: sm->y = arg2; break;
+            }
+            return EXEC_NEXT;
+        }
+    }
+}
+
+/**
+ * @brief   Have the specified state machine execute its next instruction, advancing its time
+ *          accordingly. Busy-wait loops -- an instruction that jumps to itself while decrementing
+ *          X or Y -- are executed all at once.
+ */
+static void smStep(uint8_t p, uint8_t s) {
+    sm_t *sm = &pios[p].sm[s];
+    uint64_t period = smPeriod(sm);
+    uint16_t instr;
+    bool fromExec = sm->execPending;
+    if (fromExec) {
+        instr = sm->execInstr;
+        sm->execPending = false;
+    } else {
+        instr = pios[p].instr[sm->pc];
+    }
+    uint8_t delay = ((instr >> 8) & 0x1f) & ((1 << (5 - sm->cfg.sidesetBits)) - 1);
+
+    if (!fromExec && (instr >> 13) == 0 && (instr & 0x1f) == sm->pc) {
+        uint8_t cond = (instr >> 5) & 7;
+        if (cond == 0) {
+            execute(p, s, instr);
+            sm->state = SM_HALTED;
+            return;
+        }
+        if (cond == 2 || cond == 4) {
+            uint32_t *reg = cond == 2 ? &sm->x : &sm->y;
+            sm->time += ((uint64_t)*reg + 1) * (1 + delay) * period;
+            *reg = 0xffffffff;
+            sm->pc = sm->pc == sm->cfg.wrap ? sm->cfg.wrapTarget : (sm->pc + 1) & 0x1f;
+            return;
+        }
+    }
+
+    sm->state = SM_RUNNING;
+    execResult_t r = execute(p, s, instr);
+    if (r == EXEC_STALLED) {
+        if (fromExec) {
+            sm->execPending = true;
+        }
+        if (sm->state == SM_STALL_POLL) {
+            sm->time += period;
+        }
+        return;
+    }
+    if (r == EXEC_NEXT && !fromExec) {
+        sm->pc = sm->pc == sm->cfg.wrap ? sm->cfg.wrapTarget : (sm->pc + 1) & 0x1f;
+    }
+    sm->time += (1 + delay) * period;
+}
+
+/**
+ * @brief   Whether the specified instruction, next up for the specified state machine, touches
+ *          nothing but the state machine's own registers: no pins, no FIFOs, no IRQ flags and no
+ *          side-set. Nothing outside the state machine can tell when such an instruction ran.
+ */
+static bool smQuiet(sm_t *sm, uint16_t instr) {
+    pio_sm_config *cfg = &sm->cfg;
+    if (cfg->sidesetBits > 0 && (!cfg->sidesetOpt || ((instr >> 12) & 1)) && !cfg->sidesetPindirs) {
+        return false;
+    }
+    uint8_t arg1 = (instr >> 5) & 7;
+    switch (instr >> 13) {
+        case 0:     // JMP, on anything but a pin
+            return arg1 != 6;
+        case 3:     // OUT to X, Y, NULL, PC or ISR, without an autopull
+            return (arg1 == 1 || arg1 == 2 || arg1 == 3 || arg1 == 5 || arg1 == 6) &&
+                !(cfg->autopull && sm->osrCount >= cfg->pullThreshold);
+        case 5:     // MOV from and to registers
+            return (instr & 7) != 0 && (instr & 7) != 5 && (arg1 == 1 || arg1 == 2 || arg1 >= 5);
+        case 7:     // SET X or Y
+            return arg1 == 1 || arg1 == 2;
+        default:
+            return false;
+    }
+}
+
+static bool smActive(sm_t *sm) {
+    return sm->enabled && (sm->state == SM_RUNNING || sm->state == SM_STALL_POLL);
+}
+
+/**
+ * @brief   The PIO blocks' halNextEventMicros() event source: when the earliest state machine
+ *          that has something to do will next do it.
+ */
+static uint64_t pioNextEvent(void *ctx) {
+    uint64_t answer = HAL_NO_EVENT;
+    for (uint8_t m = pioEnabled; m != 0; m &= m - 1) {
+        uint8_t i = __builtin_ctz(m);
+        sm_t *sm = &pios[i / NUM_PIO_STATE_MACHINES].sm[i % NUM_PIO_STATE_MACHINES];
+        if (smActive(sm)) {
+            uint64_t t = (sm->time + PIO_UNITS_PER_US - 1) / PIO_UNITS_PER_US;
+            answer = t < answer ? t : answer;
+        }
+    }
+    return answer;
+}
+
+/**
+ * @brief   Run all the state machines, in time order, up to the current virtual time, and on
+ *          from there for as long as halRunAheadTo() says nothing else would happen first, so
+ *          that a stream of steps costs a trip through halAdvanceTo() only when something else
+ *          is due. Once a state machine has executed an instruction, any quiet ones (see
+ *          smQuiet()) that follow are executed along with it rather than each at its own time.
+ *          The state machine's time still advances by their cycles, so the next instruction that
+ *          can be seen executes exactly when it would have. Only the registers are ahead of
+ *          time, and only pio_sm_get_pc() and pio_sm_exec() can see those.
+ */
+static void pioRun(void *ctx) {
+    while (true) {
+        sm_t *first = nullptr;
+        uint8_t fp = 0, fs = 0;
+        for (uint8_t m = pioEnabled; m != 0; m &= m - 1) {
+            uint8_t i = __builtin_ctz(m);
+            sm_t *sm = &pios[i / NUM_PIO_STATE_MACHINES].sm[i % NUM_PIO_STATE_MACHINES];
+            if (smActive(sm) && (first == nullptr || sm->time < first->time)) {
+                first = sm;
+                fp = i / NUM_PIO_STATE_MACHINES;
+                fs = i % NUM_PIO_STATE_MACHINES;
+            }
+        }
+        if (first == nullptr) {
+            return;
+        }
+        if (first->time > halMicros() * PIO_UNITS_PER_US &&
+            !halRunAheadTo((first->time + PIO_UNITS_PER_US - 1) / PIO_UNITS_PER_US)) {
+            return;
+        }
+        smStep(fp, fs);
+        while (smActive(first) && !first->execPending && smQuiet(first, pios[fp].instr[first->pc])) {
+            smStep(fp, fs);
+        }
+    }
+}
+
+static uint8_t pioIndex(PIO pio) {
+    return pio == pio1 ? 1 : 0;
+}
+
+// hardware/pio.h stand-ins
+
+uint pio_get_index(PIO pio) {
+    return pioIndex(pio);
+}
+
+/**
+ * @brief   Return the offset at which the program can be loaded, or -1 if there's no room
+ */
+static int findOffset(pioBlock_t *b, const pio_program_t *program) {
+    uint32_t mask = program->length >= 32 ? 0xffffffff : (1UL << program->length) - 1;
+    if (program->origin >= 0) {
+        return program->origin + program->length <= PIO_INSTRUCTION_COUNT && (b->used & (mask << program->origin)) == 0 ? program->origin : -1;
+    }
+    for (int o = PIO_INSTRUCTION_COUNT - program->length; o >= 0; o--) {
+        if ((b->used & (mask << o)) == 0) {
+            return o;
+        }
+    }
+    return -1;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program) {
+    return findOffset(&pios[pioIndex(pio)], program) >= 0;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    pioBlock_t *b = &pios[pioIndex(pio)];
+    int offset = findOffset(b, program);
+    if (offset < 0) {
+        fprintf(stderr, "pio_add_program: no program space.\n");
+        exit(1);
+    }
+    for (uint8_t i = 0; i < program->length; i++) {
+        uint16_t instr = program->instructions[i];
+        // JMP addresses are relative to the start of the program
+        b->instr[offset + i] = (instr >> 13) == 0 ? instr + offset : instr;
+        b->used |= 1UL << (offset + i);
+    }
+    return offset;
+}
+
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset) {
+    uint32_t mask = program->length >= 32 ? 0xffffffff : (1UL << program->length) - 1;
+    pios[pioIndex(pio)].used &= ~(mask << loaded_offset);
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    pioBlock_t *b = &pios[pioIndex(pio)];
+    for (uint8_t s = 0; s < NUM_PIO_STATE_MACHINES; s++) {
+        if (!b->sm[s].claimed) {
+            b->sm[s].claimed = true;
+            return s;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "pio_claim_unused_sm: no state machines available.\n");
+        exit(1);
+    }
+    return -1;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm) {
+    pios[pioIndex(pio)].sm[sm].claimed = false;
+}
+
+void pio_gpio_init(PIO pio, uint pin) {
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return pioIndex(pio) * 8 + (is_tx ? 0 : 4) + sm;
+}
+
+pio_sm_config pio_get_default_sm_config() {
+    pio_sm_config c;
+    memset(&c, 0, sizeof(c));
+    c.clkdivInt = 1;
+    c.wrap = PIO_INSTRUCTION_COUNT - 1;
+    c.outCount = 32;
+    c.inShiftRight = c.outShiftRight = true;
+    c.pushThreshold = c.pullThreshold = 32;
+    return c;
+}
+
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count) {
+    c->outBase = out_base;
+    c->outCount = out_count;
+}
+
+void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count) {
+    c->setBase = set_base;
+    c->setCount = set_count;
+}
+
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base) {
+    c->inBase = in_base;
+}
+
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) {
+    c->sidesetBase = sideset_base;
+}
+
+void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs) {
+    c->sidesetBits = bit_count;
+    c->sidesetOpt = optional;
+    c->sidesetPindirs = pindirs;
+}
+
+void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdivInt = (uint16_t)div;
+    c->clkdivFrac = (uint8_t)((div - c->clkdivInt) * 256);
+}
+
+void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac) {
+    c->clkdivInt = div_int;
+    c->clkdivFrac = div_frac;
+}
+
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap) {
+    c->wrapTarget = wrap_target;
+    c->wrap = wrap;
+}
+
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) {
+    c->jmpPin = pin;
+}
+
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold) {
+    c->inShiftRight = shift_right;
+    c->autopush = autopush;
+    c->pushThreshold = push_threshold == 0 ? 32 : push_threshold;
+}
+
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold) {
+    c->outShiftRight = shift_right;
+    c->autopull = autopull;
+    c->pullThreshold = pull_threshold == 0 ? 32 : pull_threshold;
+}
+
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {
+    c->join = join;
+}
+
+void sm_config_set_mov_status(pio_sm_config *c, enum pio_mov_status_type status_sel, uint status_n) {
+    c->statusSel = status_sel;
+    c->statusN = status_n;
+}
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_set_config(pio, sm, config);
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    pios[pioIndex(pio)].sm[sm].pc = initial_pc;
+}
+
+void pio_sm_set_config(PIO pio, uint sm, const pio_sm_config *config) {
+    sm_t *m = &pios[pioIndex(pio)].sm[sm];
+    m->cfg = *config;
+    m->tx.depth = config->join == PIO_FIFO_JOIN_TX ? 2 * PIO_FIFO_DEPTH : config->join == PIO_FIFO_JOIN_RX ? 0 : PIO_FIFO_DEPTH;
+    m->rx.depth = config->join == PIO_FIFO_JOIN_RX ? 2 * PIO_FIFO_DEPTH : config->join == PIO_FIFO_JOIN_TX ? 0 : PIO_FIFO_DEPTH;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    sm_t *m = &pios[pioIndex(pio)].sm[sm];
+    if (enabled && !m->enabled) {
+        if (!pioRegistered) {
+            pioRegistered = halAddEventSource(pioNextEvent, pioRun, nullptr);
+        }
+        m->time = halMicros() * PIO_UNITS_PER_US;
+        if (m->state != SM_HALTED) {
+            m->state = SM_RUNNING;
+        }
+    }
+    m->enabled = enabled;
+    uint8_t bit = 1 << (pioIndex(pio) * NUM_PIO_STATE_MACHINES + sm);
+    pioEnabled = enabled ? pioEnabled | bit : pioEnabled & ~bit;
+}
+
+void pio_sm_restart(PIO pio, uint sm) {
+    sm_t *m = &pios[pioIndex(pio)].sm[sm];
+    m->isrCount = 0;
+    m->osrCount = 32;
+    m->irqWaiting = false;
+    m->execPending = false;
+    m->state = SM_RUNNING;
+    m->time = halMicros() * PIO_UNITS_PER_US;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+    sm_t *m = &pios[pioIndex(pio)].sm[sm];
+    m->tx.count = m->rx.count = 0;
+    m->tx.head = m->rx.head = 0;
+    if (m->state == SM_STALL_RX) {
+        m->state = SM_RUNNING;
+    }
+    dmaPump();
+}
+
+void pio_sm_exec(PIO pio, uint sm, uint instr) {
+    // Executed immediately, enabled or not; only a jump changes the PC
+    uint8_t p = pioIndex(pio);
+    sm_t *m = &pios[p].sm[sm];
+    if (execute(p, sm, instr) == EXEC_STALLED) {
+        m->execPending = true;
+        m->execInstr = instr;
+    } else if (m->state == SM_HALTED) {
+        m->state = SM_RUNNING;
+    }
+}
+
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) {
+}
+
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask) {
+    gpio_put_masked(pin_mask, pin_values);
+}
+
+uint pio_sm_get_pc(PIO pio, uint sm) {
+    return pios[pioIndex(pio)].sm[sm].pc;
+}
+
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm) {
+    return pios[pioIndex(pio)].sm[sm].tx.count;
+}
+
+uint pio_sm_get_rx_fifo_level(PIO pio, uint sm) {
+    return pios[pioIndex(pio)].sm[sm].rx.count;
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
+    return pios[pioIndex(pio)].sm[sm].tx.count == 0;
+}
+
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm) {
+    return fifoFull(&pios[pioIndex(pio)].sm[sm].tx);
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    return pios[pioIndex(pio)].sm[sm].rx.count == 0;
+}
+
+bool pio_sm_is_rx_fifo_full(PIO pio, uint sm) {
+    return fifoFull(&pios[pioIndex(pio)].sm[sm].rx);
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data) {
+    txPush(pioIndex(pio), sm, data);
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    // Let virtual time pass until there's room
+    while (pio_sm_is_tx_fifo_full(pio, sm) && halNextEventMicros() != HAL_NO_EVENT) {
+        halAdvanceTo(halNextEventMicros());
+    }
+    txPush(pioIndex(pio), sm, data);
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    return rxPop(pioIndex(pio), sm);
+}
+
+uint32_t pio_sm_get_blocking(PIO pio, uint sm) {
+    while (pio_sm_is_rx_fifo_empty(pio, sm) && halNextEventMicros() != HAL_NO_EVENT) {
+        halAdvanceTo(halNextEventMicros());
+    }
+    return rxPop(pioIndex(pio), sm);
+}
+
+// hardware/clocks.h stand-in
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    switch (clk_index) {
+        case clk_sys:
+        case clk_peri:
+            return HAL_CLK_SYS_HZ;
+        case clk_usb:
+        case clk_adc:
+            return 48000000;
+        case clk_rtc:
+            return 46875;
+        default:
+            return 12000000;
+    }
+}
+
+// hardware/irq.h stand-ins
+
+/**
+ * @brief   Raise the specified interrupt: call its handlers if it's enabled
+ */
+static void raiseIrq(uint num) {
+    if (num >= HAL_IRQ_COUNT || !irqEnabled[num]) {
+        return;
+    }
+    if (irqsHeld) {
+        irqPending[num] = true;
+        return;
+    }
+    for (uint8_t h = 0; h < HAL_MAX_IRQ_HANDLERS; h++) {
+        if (irqHandlers[num][h] != nullptr) {
+            irqHandlers[num][h]();
+        }
+    }
+}
+
+void halHoldIrqs(bool hold) {
+    irqsHeld = hold;
+    if (hold) {
+        return;
+    }
+    for (uint8_t i = 0; i < HAL_IRQ_COUNT; i++) {
+        if (irqPending[i]) {
+            irqPending[i] = false;
+            raiseIrq(i);
+        }
+    }
+    // A state machine the interrupts didn't feed just ran out of work
+    for (uint8_t p = 0; p < NUM_PIOS; p++) {
+        for (uint8_t s = 0; s < NUM_PIO_STATE_MACHINES; s++) {
+            pios[p].sm[s].starved = false;
+        }
+    }
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    if (num < HAL_IRQ_COUNT) {
+        memset(irqHandlers[num], 0, sizeof(irqHandlers[num]));
+        irqHandlers[num][0] = handler;
+    }
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    if (num >= HAL_IRQ_COUNT) {
+        return;
+    }
+    for (uint8_t h = 0; h < HAL_MAX_IRQ_HANDLERS; h++) {
+        if (irqHandlers[num][h] == nullptr || irqHandlers[num][h] == handler) {
+            irqHandlers[num][h] = handler;
+            return;
+        }
+    }
+    fprintf(stderr, "irq_add_shared_handler: too many handlers for IRQ %u.\n", num);
+    exit(1);
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler) {
+    if (num >= HAL_IRQ_COUNT) {
+        return;
+    }
+    for (uint8_t h = 0; h < HAL_MAX_IRQ_HANDLERS; h++) {
+        if (irqHandlers[num][h] == handler) {
+            irqHandlers[num][h] = nullptr;
+        }
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    if (num < HAL_IRQ_COUNT) {
+        irqEnabled[num] = enabled;
+    }
+}
+
+bool irq_is_enabled(uint num) {
+    return num < HAL_IRQ_COUNT && irqEnabled[num];
+}
+
+// DMA emulation
+
+/**
+ * @brief   Return whether the specified channel's DREQ allows a transfer now
+ */
+static bool dreqReady(chan_t *c) {
+    uint8_t d = c->cfg.dreq;
+    if (d == DREQ_FORCE) {
+        return true;
+    }
+    if (d == DREQ_ADC) {
+        return adc.fifo.count != 0;
+    }
+    if (d < 16) {
+        sm_t *sm = &pios[d / 8].sm[d % 4];
+        return (d % 8) < 4 ? !fifoFull(&sm->tx) : sm->rx.count != 0;
+    }
+    return false;
+}
+
+/**
+ * @brief   Return the address that follows the specified one, taking the ring setting into account
+ */
+static uintptr_t nextAddr(chan_t *c, uintptr_t addr, bool write) {
+    uintptr_t next = addr + (1 << c->cfg.size);
+    if (c->cfg.ringBits != 0 && c->cfg.ringWrite == write) {
+        uintptr_t ringMask = ((uintptr_t)1 << c->cfg.ringBits) - 1;
+        next = (addr & ~ringMask) | (next & ringMask);
+    }
+    return next;
+}
+
+/**
+ * @brief   Return which state machine's TX or RX FIFO register, numbered p * 4 + s, is at the
+ *          specified address; -1 if none is
+ */
+static int8_t pioFifoAt(uintptr_t addr, bool tx) {
+    for (uint8_t p = 0; p < NUM_PIOS; p++) {
+        uintptr_t base = (uintptr_t)(tx ? halPioHw[p].txf : halPioHw[p].rxf);
+        if (addr >= base && addr < base + sizeof(halPioHw[p].txf)) {
+            return p * NUM_PIO_STATE_MACHINES + (addr - base) / sizeof(uint32_t);
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief   Do one transfer on the specified channel
+ */
+static void dmaTransfer(uint8_t ch) {
+    chan_t *c = &chans[ch];
+    dma_channel_hw_t *hw = &chanHw[ch];
+    uint32_t v = 0;
+    bool fromFifo = hw->read_addr == (uintptr_t)&halAdcHw.fifo;
+    if (fromFifo) {
+        v = adc.fifo.count != 0 ? fifoPop(&adc.fifo) : 0;
+    }
+    int8_t i = fromFifo ? -1 : pioFifoAt(hw->read_addr, false);
+    if (i >= 0) {
+        v = rxPop(i / NUM_PIO_STATE_MACHINES, i % NUM_PIO_STATE_MACHINES);
+    } else if (!fromFifo) {
+        memcpy(&v, (const void *)hw->read_addr, 1 << c->cfg.size);
+    }
+    i = pioFifoAt(hw->write_addr, true);
+    if (i >= 0) {
+        txPush(i / NUM_PIO_STATE_MACHINES, i % NUM_PIO_STATE_MACHINES, v);
+    } else {
+        memcpy((void *)hw->write_addr, &v, 1 << c->cfg.size);
+    }
+    if (c->cfg.readIncr) {
+        hw->read_addr = nextAddr(c, hw->read_addr, false);
+    }
+    if (c->cfg.writeIncr) {
+        hw->write_addr = nextAddr(c, hw->write_addr, true);
+    }
+    hw->transfer_count--;
+}
+
+static void dmaTrigger(uint8_t ch) {
+    if (chans[ch].cfg.enable) {
+        chanHw[ch].transfer_count = chans[ch].reload;
+        chans[ch].busy = chanHw[ch].transfer_count != 0;
+        dmaPump();
+    }
+}
+
+/**
+ * @brief   Do all the transfers the channels' DREQs allow, completing channels as they finish
+ */
+static void dmaPump() {
+    if (pumping) {
+        pumpAgain = true;
+        return;
+    }
+    pumping = true;
+    do {
+        pumpAgain = false;
+        for (uint8_t ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+            chan_t *c = &chans[ch];
+            while (c->busy && dreqReady(c)) {
+                dmaTransfer(ch);
+                if (chanHw[ch].transfer_count == 0) {
+                    c->busy = false;
+                    if (c->cfg.chainTo != ch) {
+                        dmaTrigger(c->cfg.chainTo);
+                    }
+                    if (!c->cfg.irqQuiet) {
+                        c->irqRaw = true;
+                        for (uint8_t i = 0; i < 2; i++) {
+                            if (c->irqEnabled[i]) {
+                                raiseIrq(DMA_IRQ_0 + i);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } while (pumpAgain);
+    pumping = false;
+}
+
+/**
+ * @brief   Set a channel's transfer count, as writing its TRANS_COUNT register does: it sets the
+ *          reload value and, unless the channel is busy, the count itself.
+ */
+static void setTransCount(uint8_t ch, uint32_t count) {
+    chans[ch].reload = count;
+    if (!chans[ch].busy) {
+        chanHw[ch].transfer_count = count;
+    }
+}
+
+// hardware/dma.h stand-ins
+
+int dma_claim_unused_channel(bool required) {
+    for (uint8_t ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (!chans[ch].claimed) {
+            chans[ch].claimed = true;
+            return ch;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "dma_claim_unused_channel: no channels available.\n");
+        exit(1);
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    chans[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c;
+    memset(&c, 0, sizeof(c));
+    c.enable = true;
+    c.readIncr = true;
+    c.size = DMA_SIZE_32;
+    c.dreq = DREQ_FORCE;
+    c.chainTo = channel;
+    return c;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->readIncr = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->writeIncr = incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = dreq;
+}
+
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) {
+    c->chainTo = chain_to;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->size = size;
+}
+
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ringWrite = write;
+    c->ringBits = size_bits;
+}
+
+void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet) {
+    c->irqQuiet = irq_quiet;
+}
+
+void channel_config_set_enable(dma_channel_config *c, bool enable) {
+    c->enable = enable;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, uint transfer_count, bool trigger) {
+    chans[channel].cfg = *config;
+    adc.sameRun = config->dreq == DREQ_ADC ? 0 : adc.sameRun;
+    chanHw[channel].write_addr = (uintptr_t)write_addr;
+    chanHw[channel].read_addr = (uintptr_t)read_addr;
+    setTransCount(channel, transfer_count);
+    if (trigger) {
+        dmaTrigger(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    chanHw[channel].read_addr = (uintptr_t)read_addr;
+    if (trigger) {
+        dmaTrigger(channel);
+    }
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger) {
+    chanHw[channel].write_addr = (uintptr_t)write_addr;
+    if (trigger) {
+        dmaTrigger(channel);
+    }
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+    setTransCount(channel, trans_count);
+    if (trigger) {
+        dmaTrigger(channel);
+    }
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+    chanHw[channel].read_addr = (uintptr_t)read_addr;
+    setTransCount(channel, transfer_count);
+    dmaTrigger(channel);
+}
+
+void dma_channel_start(uint channel) {
+    dmaTrigger(channel);
+}
+
+void dma_channel_abort(uint channel) {
+    chans[channel].busy = false;
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return chans[channel].busy;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    chans[channel].irqEnabled[0] = enabled;
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) {
+    chans[channel].irqEnabled[1] = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel) {
+    return chans[channel].irqRaw && chans[channel].irqEnabled[0];
+}
+
+bool dma_channel_get_irq1_status(uint channel) {
+    return chans[channel].irqRaw && chans[channel].irqEnabled[1];
+}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+    chans[channel].irqRaw = false;
+}
+
+void dma_channel_acknowledge_irq1(uint channel) {
+    chans[channel].irqRaw = false;
+}
+
+dma_channel_hw_t *dma_channel_hw_addr(uint channel) {
+    return &chanHw[channel];
+}
+
+// ADC emulation
+
+/**
+ * @brief   Return the most free-running samples that could still be visible to the firmware: a
+ *          ring's worth for DMA channels that write ADC samples to a ring, otherwise a FIFO's 
+ *          worth, or HAL_ADC_MAX_CATCH_UP if a channel is moving samples somewhere without one.
+ */
+static uint64_t adcMostVisible() {
+    uint64_t answer = HAL_ADC_FIFO_DEPTH;
+    for (uint8_t ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        chan_t *c = &chans[ch];
+        if (!c->claimed || c->cfg.dreq != DREQ_ADC) {
+            continue;
+        }
+        uint64_t n = c->cfg.ringBits != 0 && c->cfg.ringWrite ? 
+            ((uint64_t)1 << c->cfg.ringBits) >> c->cfg.size : HAL_ADC_MAX_CATCH_UP;
+        answer = n + HAL_ADC_FIFO_DEPTH > answer ? n + HAL_ADC_FIFO_DEPTH : answer;
+    }
+    return answer;
+}
+
+/**
+ * @brief   Catch-up function for the ADC: Produce the free-running samples that have fallen 
+ *          due, skipping any that couldn't be visible any more, and let DMA take them. If the 
+ *          input has held steady for longer than any sample could be visible, everything the 
+ *          firmware could see already holds the value these would, so they're skipped too.
+ */
+static void adcCatchUp(void *ctx) {
+    if (!adc.running) {
+        return;
+    }
+    uint64_t now = halMicros() * HAL_ADC_CLOCK_MHZ;
+    if (adc.next > now) {
+        return;
+    }
+    uint64_t n = (now - adc.next) / adc.period + 1;
+    uint64_t most = adcMostVisible();
+    uint16_t sample = halGetAnalogIn(26 + adc.input);
+    adc.sameRun = sample == adc.lastSample ? adc.sameRun : 0;
+    adc.lastSample = sample;
+    if (adc.sameRun >= most) {
+        halAdcHw.result = sample;
+        adc.next += n * adc.period;
+        return;
+    }
+    if (n > most) {
+        adc.next += (n - most) * adc.period;
+        n = most;
+    }
+    adc.sameRun += n;
+    for (; n > 0; n--) {
+        halAdcHw.result = sample;
+        if (adc.fifoEn && !fifoFull(&adc.fifo)) {
+            fifoPush(&adc.fifo, sample);
+        }
+        dmaPump();
+        adc.next += adc.period;
+    }
+}
+
+// hardware/adc.h stand-ins
+
+void adc_init() {
+    adc.running = false;
+    adc.fifo.head = adc.fifo.count = 0;
+    adc.fifo.depth = HAL_ADC_FIFO_DEPTH;
+    adc.period = 96;
+    adc.sameRun = 0;
+    if (!adc.catchingUp) {
+        adc.catchingUp = halAddCatchUp(adcCatchUp, nullptr);
+    }
+}
+
+void adc_gpio_init(uint gpio) {
+}
+
+void adc_select_input(uint input) {
+    adc.input = input;
+}
+
+void adc_set_clkdiv(float clkdiv) {
+    adc.period = clkdiv < 96 ? 96 : (uint32_t)(clkdiv + 1);
+    halAdcHw.div = (uint32_t)(clkdiv * 256);
+}
+
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift) {
+    adc.fifoEn = en;
+}
+
+void adc_fifo_drain() {
+    adc.fifo.head = adc.fifo.count = 0;
+}
+
+void adc_run(bool run) {
+    if (run && !adc.running) {
+        adc.next = halMicros() * HAL_ADC_CLOCK_MHZ + adc.period;
+        adc.sameRun = 0;
+    }
+    adc.running = run;
+}
+
+uint16_t adc_read() {
+    halAdcHw.result = halGetAnalogIn(26 + adc.input);
+    return halAdcHw.result;
+}
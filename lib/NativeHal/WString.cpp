@@ -0,0 +1,127 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <WString.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+String::String(double value, unsigned char decimals) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    str = buf;
+}
+
+long String::toInt() const {
+    return strtol(str.c_str(), nullptr, 10);
+}
+
+double String::toDouble() const {
+    return strtod(str.c_str(), nullptr);
+}
+
+bool String::equalsIgnoreCase(const String &s) const {
+    if (str.length() != s.str.length()) {
+        return false;
+    }
+    for (size_t i = 0; i < str.length(); i++) {
+        if (tolower((unsigned char)str[i]) != tolower((unsigned char)s.str[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t pos = str.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &s, unsigned int from) const {
+    size_t pos = str.find(s.str, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const {
+    return from >= str.length() ? String() : String(str.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        unsigned int t = from; from = to; to = t;
+    }
+    if (from >= str.length()) {
+        return String();
+    }
+    return String(str.substr(from, to - from));
+}
+
+void String::toLowerCase() {
+    for (char &c : str) {
+        c = tolower((unsigned char)c);
+    }
+}
+
+void String::toUpperCase() {
+    for (char &c : str) {
+        c = toupper((unsigned char)c);
+    }
+}
+
+void String::trim() {
+    size_t first = str.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        str.clear();
+        return;
+    }
+    size_t last = str.find_last_not_of(" \t\r\n");
+    str = str.substr(first, last - first + 1);
+}
+
+std::string String::fromLong(long long value, unsigned char base) {
+    if (value < 0 && base == 10) {
+        return "-" + fromULong(-(unsigned long long)value, base);
+    }
+    return fromULong((unsigned long long)value, base);
+}
+
+std::string String::fromULong(unsigned long long value, unsigned char base) {
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    char buf[66];
+    char *p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do {
+        unsigned d = value % base;
+        *--p = d < 10 ? '0' + d : 'a' + d - 10;
+        value /= base;
+    } while (value != 0);
+    return std::string(p);
+}
@@ -0,0 +1,85 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the Arduino String class. Only the parts the firmware uses are provided.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <stdint.h>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char *s) : str(s == nullptr ? "" : s) {}
+    String(const std::string &s) : str(s) {}
+    explicit String(char c) : str(1, c) {}
+    explicit String(int value, unsigned char base = 10) : str(fromLong(value, base)) {}
+    explicit String(unsigned int value, unsigned char base = 10) : str(fromULong(value, base)) {}
+    explicit String(long value, unsigned char base = 10) : str(fromLong(value, base)) {}
+    explicit String(unsigned long value, unsigned char base = 10) : str(fromULong(value, base)) {}
+    explicit String(long long value, unsigned char base = 10) : str(fromLong(value, base)) {}
+    explicit String(unsigned long long value, unsigned char base = 10) : str(fromULong(value, base)) {}
+    explicit String(double value, unsigned char decimals = 2);
+
+    unsigned int length() const { return str.length(); }
+    const char *c_str() const { return str.c_str(); }
+    char charAt(unsigned int index) const { return index < str.length() ? str[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    long toInt() const;
+    double toDouble() const;
+    bool equals(const String &s) const { return str == s.str; }
+    bool equalsIgnoreCase(const String &s) const;
+    bool startsWith(const String &s) const { return str.compare(0, s.str.length(), s.str) == 0; }
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String &s, unsigned int from = 0) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    String &operator+=(const String &s) { str += s.str; return *this; }
+    String &operator+=(const char *s) { str += s; return *this; }
+    String &operator+=(char c) { str += c; return *this; }
+    bool operator==(const String &s) const { return str == s.str; }
+    bool operator==(const char *s) const { return str == s; }
+    bool operator!=(const String &s) const { return str != s.str; }
+    bool operator!=(const char *s) const { return str != s; }
+
+    friend String operator+(const String &a, const String &b) { return String(a.str + b.str); }
+    friend String operator+(const String &a, const char *b) { return String(a.str + b); }
+    friend String operator+(const char *a, const String &b) { return String(a + b.str); }
+    friend String operator+(const String &a, char b) { return String(a.str + b); }
+
+private:
+    static std::string fromLong(long long value, unsigned char base);
+    static std::string fromULong(unsigned long long value, unsigned char base);
+
+    std::string str;
+};
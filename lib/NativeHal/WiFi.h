@@ -0,0 +1,89 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the arduino-pico WiFi and NTP objects and for WiFiUDP, enough of it to talk
+ * to an NTP server. Whether they succeed, and how long they take about it, is controlled by
+ * halNetwork.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <NativeHal.h>
+
+enum wl_status_t {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+};
+
+class WiFiClass {
+public:
+    wl_status_t begin(const char *ssid, const char *pw);
+    uint8_t beginNoBlock(const char *ssid, const char *pw);
+    wl_status_t status();
+    void disconnect() { curStatus = WL_DISCONNECTED; connecting = false; }
+    void end() { curStatus = WL_IDLE_STATUS; connecting = false; }
+
+private:
+    wl_status_t curStatus = WL_IDLE_STATUS;
+    bool connecting = false;                // Whether a connection attempt is underway
+    uint64_t settleMicros = 0;              // When it succeeds or fails
+};
+
+class NTPClass {
+public:
+    void begin(const char *server1, const char *server2 = nullptr);
+};
+
+class WiFiUDP {
+public:
+    uint8_t begin(uint16_t port);
+    void stop();
+    int beginPacket(const char *host, uint16_t port);
+    size_t write(const uint8_t *buf, size_t len);
+    int endPacket();
+    int parsePacket();
+    int read(uint8_t *buf, size_t len);
+
+private:
+    static const size_t maxLen = 48;        // The biggest packet we deal in (an NTP packet)
+    int sock = -1;                          // The host socket if there's a real server, else -1
+    char host[64] = "";                     // Where the packet being built goes
+    uint16_t port = 0;
+    uint8_t out[maxLen];                    // The packet being built
+    size_t outLen = 0;
+    uint8_t in[maxLen];                     // The packet received
+    size_t inLen = 0;                       // Its length; 0 if there isn't one
+    size_t inPos = 0;                       // How much of it has been read()
+    bool replyPending = false;              // Whether the simulated server's reply is on its way
+    uint64_t replyMicros = 0;               // When it arrives
+};
+
+extern WiFiClass WiFi;
+extern NTPClass NTP;
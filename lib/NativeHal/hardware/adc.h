@@ -0,0 +1,64 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the parts of the Pico SDK's hardware/adc.h the firmware uses. The
+ * emulated ADC converts whatever halSetAnalogIn() last set for the selected input's pin (GPIO
+ * 26 + input). In free-running mode it takes a sample every (1 + clkdiv) cycles of its 48 MHz
+ * clock and pushes it into its 4-deep FIFO, where DREQ_ADC DMA channels can pick it up. Since
+ * that can be many thousands of samples a second, it isn't an event source. Instead, it catches
+ * up each time the virtual clock advances, producing only as many of the most recent samples
+ * as could still be visible: a ring's worth for a DMA channel writing to a ring, otherwise a
+ * FIFO's worth.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <pico/types.h>
+
+#define HAL_ADC_CLOCK_MHZ       (48)        // The ADC's clock (clk_adc) frequency in MHz
+#define HAL_ADC_FIFO_DEPTH      (4)         // Depth of the ADC's FIFO
+#define HAL_ADC_MAX_CATCH_UP    (4096)      // Most samples produced per catch-up without a DMA ring
+
+typedef struct {                            // What the firmware can see of the ADC's registers
+    volatile uint32_t cs;
+    volatile uint32_t result;               // The most recent conversion
+    volatile uint32_t fcs;
+    volatile uint32_t fifo;                 // Read (by DMA) to pop the FIFO
+    volatile uint32_t div;
+} adc_hw_t;
+
+extern adc_hw_t halAdcHw;
+#define adc_hw (&halAdcHw)
+
+void adc_init();
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+void adc_set_clkdiv(float clkdiv);
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift);
+void adc_fifo_drain();
+void adc_run(bool run);
+uint16_t adc_read();
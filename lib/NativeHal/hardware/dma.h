@@ -0,0 +1,98 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the parts of the Pico SDK's hardware/dma.h the firmware uses. The
+ * emulated DMA channels move data a word (or halfword or byte) at a time as their DREQs allow:
+ * DREQ_PIO... channels keep pace with the emulated PIO state machines' FIFOs, DREQ_ADC channels
+ * with the emulated ADC's FIFO, and DREQ_FORCE channels complete as soon as they're triggered.
+ * When a channel completes it raises DMA_IRQ_0 or DMA_IRQ_1 if so enabled, and triggers the
+ * channel it's chained to, if any. As on the RP2040, setting a channel's transfer count sets
+ * the value that's reloaded each time the channel is triggered, so two channels chained to
+ * each other can keep a transfer going indefinitely.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <pico/types.h>
+
+#define NUM_DMA_CHANNELS        (12)
+#define DREQ_PIO0_TX0           (0)
+#define DREQ_PIO0_RX0           (4)
+#define DREQ_PIO1_TX0           (8)
+#define DREQ_PIO1_RX0           (12)
+#define DREQ_ADC                (36)
+#define DREQ_FORCE              (0x3f)
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2
+};
+
+typedef struct {                            // What the firmware can see of a channel's registers
+    volatile uintptr_t read_addr;
+    volatile uintptr_t write_addr;
+    volatile uint32_t transfer_count;       // Transfers remaining
+    volatile uint32_t ctrl_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    bool enable;
+    bool readIncr;
+    bool writeIncr;
+    bool ringWrite;                         // Ring applies to the write (true) or read address
+    bool irqQuiet;
+    enum dma_channel_transfer_size size;
+    uint8_t ringBits;                       // Ring size is 1 << ringBits bytes; 0 ==> no ring
+    uint8_t dreq;
+    uint8_t chainTo;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits);
+void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet);
+void channel_config_set_enable(dma_channel_config *c, bool enable);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count);
+void dma_channel_start(uint channel);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+bool dma_channel_get_irq1_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+void dma_channel_acknowledge_irq1(uint channel);
+dma_channel_hw_t *dma_channel_hw_addr(uint channel);
@@ -0,0 +1,48 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the Pico SDK's hardware/flash.h. The flash is PICO_FLASH_SIZE_BYTES of
+ * emulated memory (see halFlashMemory()) that XIP_BASE points at. As with the real thing,
+ * erasing sets a whole sector to 0xff, and programming can only turn 1 bits into 0 bits, so a
+ * page can be programmed more than once as long as each program only writes to the parts that
+ * are still erased. Misaligned erases and programs are reported and ignored. Each sector erased
+ * and page programmed is counted in halStats.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <pico/types.h>
+#include <stddef.h>
+#include <NativeHal.h>
+
+#define FLASH_PAGE_SIZE         (1u << 8)   // Smallest unit that can be programmed
+#define FLASH_SECTOR_SIZE       (1u << 12)  // Smallest unit that can be erased
+#define PICO_FLASH_SIZE_BYTES   (2 * 1024 * 1024)   // The Pico W's flash size
+#define XIP_BASE                ((uintptr_t)halFlashMemory())   // Where flash is "mapped"
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
@@ -0,0 +1,144 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the parts of the Pico SDK's hardware/pio.h the firmware uses, backed by an
+ * instruction-level emulator of the RP2040's two PIO blocks (see PioDma.cpp). Programs are
+ * loaded and run just as they are on the Pico -- including the ones pioasm generates -- with
+ * each state machine executing one instruction per (divided) clock cycle of the virtual clock.
+ * The emulator knows how to skip over the busy-wait loops PIO programs use to kill time
+ * ("jmp x-- self" and "jmp y-- self"), so a state machine that spends most of its time in such
+ * a loop costs next to nothing to emulate. OUT, SET and side-set writes to pins are visible
+ * through halGetPinOut() and gpio_get(); WAIT GPIO and IN PINS read them back.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <pico/types.h>
+
+#define NUM_PIOS                (2)
+#define NUM_PIO_STATE_MACHINES  (4)
+#define PIO_INSTRUCTION_COUNT   (32)
+
+typedef struct {                            // What the firmware can see of a PIO block's registers
+    volatile uint32_t txf[NUM_PIO_STATE_MACHINES];  // Writing pushes to the TX FIFO (via DMA)
+    volatile uint32_t rxf[NUM_PIO_STATE_MACHINES];  // Reading pops from the RX FIFO (via DMA)
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+extern pio_hw_t halPioHw[NUM_PIOS];
+#define pio0_hw                 (&halPioHw[0])
+#define pio1_hw                 (&halPioHw[1])
+#define pio0                    pio0_hw
+#define pio1                    pio1_hw
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;                          // Required load address; -1 ==> anywhere
+} pio_program_t;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX = 1, PIO_FIFO_JOIN_RX = 2
+};
+
+enum pio_mov_status_type {
+    STATUS_TX_LESSTHAN = 0, STATUS_RX_LESSTHAN = 1
+};
+
+typedef struct {
+    uint16_t clkdivInt;                     // Clock divider, integer part
+    uint8_t clkdivFrac;                     // Clock divider, fractional part (1/256ths)
+    uint8_t wrapTarget;
+    uint8_t wrap;
+    uint8_t outBase;
+    uint8_t outCount;
+    uint8_t setBase;
+    uint8_t setCount;
+    uint8_t inBase;
+    uint8_t sidesetBase;
+    uint8_t sidesetBits;                    // Includes the enable bit if side-set is optional
+    bool sidesetOpt;
+    bool sidesetPindirs;
+    uint8_t jmpPin;
+    bool inShiftRight;
+    bool autopush;
+    uint8_t pushThreshold;
+    bool outShiftRight;
+    bool autopull;
+    uint8_t pullThreshold;
+    enum pio_fifo_join join;
+    enum pio_mov_status_type statusSel;
+    uint8_t statusN;
+} pio_sm_config;
+
+uint pio_get_index(PIO pio);
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+uint pio_add_program(PIO pio, const pio_program_t *program);
+void pio_remove_program(PIO pio, const pio_program_t *program, uint loaded_offset);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, uint sm);
+void pio_gpio_init(PIO pio, uint pin);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+
+pio_sm_config pio_get_default_sm_config();
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count);
+void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count);
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base);
+void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs);
+void sm_config_set_clkdiv(pio_sm_config *c, float div);
+void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac);
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap);
+void sm_config_set_jmp_pin(pio_sm_config *c, uint pin);
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold);
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold);
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join);
+void sm_config_set_mov_status(pio_sm_config *c, enum pio_mov_status_type status_sel, uint status_n);
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config);
+void pio_sm_set_config(PIO pio, uint sm, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_restart(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_sm_exec(PIO pio, uint sm, uint instr);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values, uint32_t pin_mask);
+uint pio_sm_get_pc(PIO pio, uint sm);
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm);
+uint pio_sm_get_rx_fifo_level(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_rx_fifo_full(PIO pio, uint sm);
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint32_t pio_sm_get(PIO pio, uint sm);
+uint32_t pio_sm_get_blocking(PIO pio, uint sm);
+
+static inline uint pio_encode_jmp(uint addr) {
+    return addr & 0x1f;
+}
@@ -0,0 +1,83 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the hardware alarm part of the Pico SDK's hardware/timer.h. There are
+ * HAL_NUM_ALARMS alarms. Each is a one-shot: once its target time is set, its callback is
+ * invoked when the virtual clock reaches that time, in time order with the repeating timers
+ * and the other emulated peripherals, and the alarm is then disarmed. The callback may set a
+ * new target. As in the SDK, setting a target that has already passed doesn't arm the alarm,
+ * and says so by returning true.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <pico/types.h>
+#include <pico/time.h>
+
+#define HAL_NUM_ALARMS          (4)         // Number of hardware alarms
+
+typedef void (*hardware_alarm_callback_t)(uint alarm_num);
+
+/**
+ * @brief   Claim a hardware alarm that isn't already claimed
+ *
+ * @param required  If true, there must be one (in the stand-in, -1 is returned regardless)
+ * @return int      The alarm number or -1 if there are none left
+ */
+int hardware_alarm_claim_unused(bool required);
+
+/**
+ * @brief   Release a claimed hardware alarm, cancelling it if it is armed
+ *
+ * @param alarm_num The alarm number
+ */
+void hardware_alarm_unclaim(uint alarm_num);
+
+/**
+ * @brief   Set the function to be called when the alarm fires
+ *
+ * @param alarm_num The alarm number
+ * @param callback  The callback
+ */
+void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback);
+
+/**
+ * @brief   Arm the alarm to fire at the specified time
+ *
+ * @param alarm_num The alarm number
+ * @param t         When it is to fire
+ * @return true     The time has already passed; the alarm is not armed
+ * @return false    The alarm is armed
+ */
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t);
+
+/**
+ * @brief   Disarm the alarm
+ *
+ * @param alarm_num The alarm number
+ */
+void hardware_alarm_cancel(uint alarm_num);
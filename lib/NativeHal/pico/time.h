@@ -0,0 +1,127 @@
+/****
+ *
+ * This file is a part of the NativeHal library. See NativeHal.h for details.
+ *
+ * A host stand-in for the repeating timer part of the Pico SDK's pico/time.h. Timers run off
+ * the virtual clock: their callbacks are invoked, in time order, as halAdvance() or
+ * halAdvanceTo() moves the clock past the times they are due. As in the SDK, a negative delay
+ * is measured from when the callback was due, a positive one from when it returned (which, in
+ * virtual time, is the same thing), and a callback may change rt->delay_us to change the time
+ * to its next invocation.
+ *
+ *****
+ *
+ * NativeHal V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <pico/types.h>
+
+#define HAL_MAX_TIMERS          (8)         // Max number of simultaneously active timers
+
+typedef int32_t alarm_id_t;
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+
+struct repeating_timer {
+    int64_t delay_us;
+    void *pool;
+    alarm_id_t alarm_id;
+    repeating_timer_callback_t callback;
+    void *user_data;
+};
+
+/**
+ * @brief   Get the number of microseconds since boot (i.e., the virtual clock)
+ *
+ * @return uint64_t
+ */
+uint64_t time_us_64();
+
+/**
+ * @brief   Get the low 32 bits of time_us_64()
+ *
+ * @return uint32_t
+ */
+uint32_t time_us_32();
+
+/**
+ * @brief   Get the current time as an absolute_time_t
+ *
+ * @return absolute_time_t
+ */
+static inline absolute_time_t get_absolute_time() {
+    return time_us_64();
+}
+
+/**
+ * @brief   Convert an absolute_time_t to microseconds since boot
+ *
+ * @param t         The time
+ * @return uint64_t
+ */
+static inline uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+/**
+ * @brief   Convert microseconds since boot to an absolute_time_t
+ *
+ * @param us                The microseconds since boot
+ * @return absolute_time_t
+ */
+static inline absolute_time_t from_us_since_boot(uint64_t us) {
+    return us;
+}
+
+/**
+ * @brief   Return the specified time plus the specified number of microseconds
+ *
+ * @param t                 The time
+ * @param us                The microseconds to add
+ * @return absolute_time_t
+ */
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return t + us;
+}
+
+/**
+ * @brief   Start a repeating timer
+ *
+ * @param delay_us  The interval; if negative, measured from when the callback was due
+ * @param callback  The function to call each time it's due
+ * @param user_data Stored in out->user_data
+ * @param out       The timer; must stay in existence while the timer is active
+ * @return true     Success
+ * @return false    Too many active timers
+ */
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out);
+
+/**
+ * @brief   Cancel a repeating timer
+ *
+ * @param timer     The timer
+ * @return true     It was active and is now cancelled
+ * @return false    It wasn't active
+ */
+bool cancel_repeating_timer(repeating_timer_t *timer);
@@ -0,0 +1,97 @@
+/****
+ *
+ * This file is a part of the OutputSink library. See OutputSink.h for details.
+ *
+ *****
+ *
+ * OutputSink V1.1.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <OutputSink.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+OutputSink::OutputSink() {
+    head = 0;
+    tail = 0;
+    dropped = 0;
+}
+
+size_t OutputSink::write(const char *s, size_t len) {
+    if (len > OUT_BUF_LEN - (head - tail)) {
+        dropped++;
+        return 0;
+    }
+    // In at most two pieces: up to the end of the ring and then from its start
+    uint32_t at = head & (OUT_BUF_LEN - 1);
+    size_t first = len < OUT_BUF_LEN - at ? len : OUT_BUF_LEN - at;
+    memcpy(ring + at, s, first);
+    memcpy(ring, s + first, len - first);
+    head += len;
+    return len;
+}
+
+size_t OutputSink::print(const char *s) {
+    return write(s, strlen(s));
+}
+
+size_t OutputSink::printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(scratch, sizeof(scratch), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    return write(scratch, (size_t)len < sizeof(scratch) ? len : sizeof(scratch) - 1);
+}
+
+bool OutputSink::drain() {
+    if (!Serial) {
+        return false;                           // Keep it; there's no one to send it to yet
+    }
+    while (head != tail) {
+        int room = Serial.availableForWrite();
+        if (room <= 0) {
+            return true;
+        }
+        uint32_t at = tail & (OUT_BUF_LEN - 1);
+        size_t n = head - tail;
+        n = n < OUT_BUF_LEN - at ? n : OUT_BUF_LEN - at;
+        n = n < (size_t)room ? n : room;
+        size_t wrote = Serial.write((const uint8_t *)ring + at, n);
+        if (wrote == 0) {
+            return true;
+        }
+        tail += wrote;
+    }
+    return false;
+}
+
+size_t OutputSink::pending() {
+    return head - tail;
+}
+
+uint32_t OutputSink::getDropped() {
+    return dropped;
+}
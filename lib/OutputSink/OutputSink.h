@@ -0,0 +1,121 @@
+/****
+ *
+ * This file is a part of the OutputSink library. The library supplies OutputSink, a place for 
+ * the firmware to print text to without using the heap and without waiting for the USB serial 
+ * port to take it.
+ *
+ * Text printed to an OutputSink -- with print(), write() or printf() -- goes into a fixed-size 
+ * ring buffer that's part of the OutputSink object. drain() moves as much of what's in the ring 
+ * to Serial as Serial.availableForWrite() says it can take without blocking; the firmware calls 
+ * it whenever it wakes up, and again a little later if there's anything left. So building a 
+ * command's response doesn't involve a single String concatenation, and a host that's slow to 
+ * read (or isn't there at all) doesn't hold things up. Until a host opens the port, drain() 
+ * leaves the ring alone, so what's printed at boot is still there to be read when one does.
+ *
+ * Each print(), write() or printf() goes into the ring whole or not at all, so lines don't get 
+ * chopped up. If there isn't room for it, it's dropped and counted. printf() formats into a 
+ * fixed scratch buffer, so what it produces is limited to OUT_MAX_PRINTF - 1 characters (longer 
+ * output is truncated). Stick to integer conversions: newlib's floating point conversions 
+ * allocate memory.
+ *
+ * An OutputSink is for use from one core only.
+ *
+ *****
+ *
+ * OutputSink V1.1.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#ifndef Arduino_h
+    #include <Arduino.h>
+#endif
+
+#define OUT_BUF_LEN             (4096)          // Size of the ring buffer (power of 2)
+#define OUT_MAX_PRINTF          (256)           // Size of printf()'s scratch buffer
+
+static_assert((OUT_BUF_LEN & (OUT_BUF_LEN - 1)) == 0, "OUT_BUF_LEN must be a power of 2");
+
+class OutputSink {
+public:
+    /**
+     * @brief   Construct a new, empty, OutputSink
+     *
+     */
+    OutputSink();
+
+    /**
+     * @brief   Put len characters into the ring
+     *
+     * @param s         The characters
+     * @param len       How many of them there are
+     * @return size_t   len if they fit, 0 if they were dropped
+     */
+    size_t write(const char *s, size_t len);
+
+    /**
+     * @brief   Put a C string into the ring
+     *
+     * @param s         The string
+     * @return size_t   Its length if it fit, 0 if it was dropped
+     */
+    size_t print(const char *s);
+
+    /**
+     * @brief   Format some text, as printf() would, and put it into the ring
+     *
+     * @param format    The format
+     * @param ...       The values to be formatted
+     * @return size_t   The number of characters if it fit, 0 if it was dropped
+     */
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    /**
+     * @brief   Write as much of what's in the ring to Serial as it can take without blocking.
+     *          If no host has the port open, leave it all for later.
+     *
+     * @return true     There's more left to write
+     * @return false    The ring is empty, or there's no host to write to
+     */
+    bool drain();
+
+    /**
+     * @brief   Get the number of characters waiting in the ring
+     *
+     * @return size_t   The number of characters
+     */
+    size_t pending();
+
+    /**
+     * @brief   Get the number of writes (and prints and printfs) dropped for want of room
+     *
+     * @return uint32_t The number dropped
+     */
+    uint32_t getDropped();
+
+private:
+    char ring[OUT_BUF_LEN];                     // The ring buffer
+    char scratch[OUT_MAX_PRINTF];               // Where printf() formats things
+    uint32_t head;                              // Where the next character goes (mod OUT_BUF_LEN)
+    uint32_t tail;                              // Where the next character to drain is (likewise)
+    uint32_t dropped;                           // Number of writes dropped
+};
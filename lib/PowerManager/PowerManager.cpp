@@ -0,0 +1,126 @@
+/****
+ *
+ * This file is a part of the PowerManager library. See PowerManager.h for details.
+ *
+ *****
+ *
+ * PowerManager V1.1.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <PowerManager.h>
+
+PowerManager::PowerManager() {
+    ssid = pw = "";
+    wifiUsers = 0;
+    connecting = false;
+    connectSince = 0;
+    sessions = 0;
+    onMillis = 0;
+    onSince = 0;
+}
+
+void PowerManager::begin(const char *ssid, const char *pw) {
+    this->ssid = ssid;
+    this->pw = pw;
+}
+
+bool PowerManager::wifiAcquire() {
+    if (wifiUsers > 0) {
+        wifiUsers++;
+        return true;
+    }
+    for (uint8_t tries = 0; tries < PM_WIFI_MAX_RETRY; tries++) {
+        if (WiFi.begin(ssid, pw) == WL_CONNECTED) {
+            wifiUsers = 1;
+            sessions++;
+            onSince = millis();
+            #ifdef PM_DEBUG
+            Serial.printf("PowerManager::wifiAcquire - Connected to '%s' after %d tries.\n", ssid, tries + 1);
+            #endif
+            return true;
+        }
+    }
+    // Leave the radio off rather than trying in the background
+    WiFi.end();
+    #ifdef PM_DEBUG
+    Serial.printf("PowerManager::wifiAcquire - Couldn't connect to '%s'.\n", ssid);
+    #endif
+    return false;
+}
+
+pmWifi_t PowerManager::wifiAcquireAsync() {
+    if (wifiUsers > 0) {
+        wifiUsers++;
+        return PM_WIFI_ON;
+    }
+    if (!connecting) {
+        WiFi.beginNoBlock(ssid, pw);
+        connecting = true;
+        connectSince = millis();
+        return PM_WIFI_CONNECTING;
+    }
+    wl_status_t status = WiFi.status();
+    if (status == WL_CONNECTED) {
+        connecting = false;
+        wifiUsers = 1;
+        sessions++;
+        onSince = millis();
+        #ifdef PM_DEBUG
+        Serial.printf("PowerManager::wifiAcquireAsync - Connected to '%s' in %lu ms.\n", ssid, millis() - connectSince);
+        #endif
+        return PM_WIFI_ON;
+    }
+    if (status != WL_CONNECT_FAILED && status != WL_NO_SSID_AVAIL && millis() - connectSince < PM_CONNECT_TIMEOUT_MILLIS) {
+        return PM_WIFI_CONNECTING;
+    }
+    connecting = false;
+    WiFi.end();
+    #ifdef PM_DEBUG
+    Serial.printf("PowerManager::wifiAcquireAsync - Couldn't connect to '%s'.\n", ssid);
+    #endif
+    return PM_WIFI_OFF;
+}
+
+void PowerManager::wifiRelease() {
+    if (wifiUsers == 0 || --wifiUsers > 0) {
+        return;
+    }
+    WiFi.disconnect();
+    WiFi.end();
+    onMillis += millis() - onSince;
+    #ifdef PM_DEBUG
+    Serial.printf("PowerManager::wifiRelease - Radio off after %lu ms.\n", millis() - onSince);
+    #endif
+}
+
+bool PowerManager::wifiIsOn() {
+    return wifiUsers > 0;
+}
+
+uint32_t PowerManager::getWifiSessions() {
+    return sessions;
+}
+
+unsigned long PowerManager::getWifiOnMillis() {
+    return onMillis + (wifiUsers > 0 ? millis() - onSince : 0);
+}
@@ -0,0 +1,141 @@
+/****
+ *
+ * This file is a part of the PowerManager library. The library looks after the Pico W's WiFi
+ * radio, which, when it's connected, draws more current than the rest of the controller put
+ * together. The display only needs the network now and again -- to get the time from NTP, for
+ * example -- so rather than bringing WiFi up at boot and leaving it up, code that needs the
+ * network asks for it with wifiAcquire() and says it's done with wifiRelease(). The first
+ * acquire connects (retrying up to PM_WIFI_MAX_RETRY times); the last release disconnects and
+ * powers the radio down. Acquires and releases nest, so independent users don't have to know
+ * about one another. The manager also keeps track of how many times, and for how long, the
+ * radio has been on.
+ *
+ * Connecting takes seconds, so there's also wifiAcquireAsync(), which starts connecting and
+ * returns right away. The caller calls it again every so often until it says how things turned
+ * out, and gets on with other things in between. It makes one attempt, giving up after
+ * PM_CONNECT_TIMEOUT_MILLIS; whether and when to try again is up to the caller.
+ *
+ * The rest of the power saving happens elsewhere: the cores sleep between deadlines (see the
+ * Scheduler library) and the stepper coils are released while the display is stationary (see
+ * the MoonDisplay library).
+ *
+ * A PowerManager is meant to be used from core 0 only.
+ *
+ *****
+ *
+ * PowerManager V1.1.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#ifndef Arduino_h
+    #include <Arduino.h>
+#endif
+#include <WiFi.h>
+
+#define PM_WIFI_MAX_RETRY       (3)             // How many times to try WiFi.begin() before giving up
+#define PM_CONNECT_TIMEOUT_MILLIS (15000)       // How long wifiAcquireAsync() waits for a connection
+
+//#define PM_DEBUG                                // Uncomment to enable debug printing
+
+enum pmWifi_t : uint8_t {                      // How a wifiAcquireAsync() is going
+    PM_WIFI_OFF,                                // Couldn't connect; the radio is off again
+    PM_WIFI_CONNECTING,                         // Still trying; call again in a bit
+    PM_WIFI_ON                                  // Connected
+};
+
+class PowerManager {
+public:
+    /**
+     * @brief   Construct a new PowerManager object
+     *
+     */
+    PowerManager();
+
+    /**
+     * @brief   Tell the manager the WiFi credentials to use. They're used by reference, so
+     *          changes to them take effect the next time the radio comes on.
+     *
+     * @param ssid  The WiFi SSID
+     * @param pw    The WiFi password
+     */
+    void begin(const char *ssid, const char *pw);
+
+    /**
+     * @brief   Get WiFi for use, connecting if it isn't already on. Each successful call must be
+     *          balanced by a call to wifiRelease().
+     *
+     * @return true     WiFi is connected
+     * @return false    Couldn't connect; don't call wifiRelease()
+     */
+    bool wifiAcquire();
+
+    /**
+     * @brief   Get WiFi for use without waiting for it to connect. If it's already on, that's
+     *          that. Otherwise the first call starts connecting and later calls see how it's
+     *          going. PM_WIFI_ON is a successful acquire, which must be balanced by a call to
+     *          wifiRelease(). Don't mix with wifiAcquire() while a connection is underway.
+     *
+     * @return pmWifi_t     PM_WIFI_ON, PM_WIFI_CONNECTING or PM_WIFI_OFF
+     */
+    pmWifi_t wifiAcquireAsync();
+
+    /**
+     * @brief   Say we're done with WiFi. When nobody needs it any more, disconnect and power the
+     *          radio down.
+     *
+     */
+    void wifiRelease();
+
+    /**
+     * @brief   Return whether the radio is on
+     *
+     * @return true     On and connected
+     * @return false    Off
+     */
+    bool wifiIsOn();
+
+    /**
+     * @brief   Get the number of times the radio has been turned on
+     *
+     * @return uint32_t The count
+     */
+    uint32_t getWifiSessions();
+
+    /**
+     * @brief   Get the total time the radio has been on, including any time it's been on so far
+     *          this session
+     *
+     * @return unsigned long    The time in millis()
+     */
+    unsigned long getWifiOnMillis();
+
+private:
+    const char *ssid;                           // The WiFi SSID
+    const char *pw;                             // The WiFi password
+    uint8_t wifiUsers;                          // Number of unreleased wifiAcquire() calls
+    bool connecting;                            // Whether wifiAcquireAsync() has a connection underway
+    unsigned long connectSince;                 // millis() when it started
+    uint32_t sessions;                          // Number of times the radio has come on
+    unsigned long onMillis;                     // Time the radio was on in sessions that are over
+    unsigned long onSince;                      // millis() when the current session started
+};
@@ -0,0 +1,218 @@
+/****
+ *
+ * This file is a part of the Scheduler library. See Scheduler.h for details.
+ *
+ *****
+ *
+ * Scheduler V1.2.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <Scheduler.h>
+
+Scheduler::Scheduler() {
+    nTasks = 0;
+    heapLen = 0;
+    alarm = -1;
+    stats = {};
+}
+
+void Scheduler::begin() {
+    nTasks = 0;
+    heapLen = 0;
+    stats = {};
+    if (alarm < 0) {
+        alarm = hardware_alarm_claim_unused(false);
+        if (alarm >= 0) {
+            hardware_alarm_set_callback(alarm, onAlarm);
+        }
+    }
+    #ifdef SCH_DEBUG
+    Serial.printf("Scheduler::begin - Using hardware alarm %d.\n", alarm);
+    #endif
+}
+
+int8_t Scheduler::addTask(schTaskFn_t fn, void *ctx, bool everyWake) {
+    if (nTasks >= SCH_MAX_TASKS) {
+        #ifdef SCH_DEBUG
+        Serial.println("Scheduler::addTask - Too many tasks.");
+        #endif
+        return -1;
+    }
+    schTask_t &t = task[nTasks];
+    t.fn = fn;
+    t.ctx = ctx;
+    t.everyWake = everyWake;
+    t.heapPos = -1;
+    t.due = 0;
+    t.notified.store(false);
+    return nTasks++;
+}
+
+void Scheduler::at(int8_t id, uint64_t micros) {
+    if (id < 0 || id >= nTasks) {
+        return;
+    }
+    schTask_t &t = task[id];
+    t.due = micros;
+    if (t.heapPos < 0) {
+        t.heapPos = heapLen;
+        heap[heapLen++] = id;
+    }
+    sift(t.heapPos);
+}
+
+void Scheduler::after(int8_t id, uint32_t ms) {
+    at(id, time_us_64() + ms * 1000ULL);
+}
+
+void Scheduler::cancel(int8_t id) {
+    if (id >= 0 && id < nTasks && task[id].heapPos >= 0) {
+        removeAt(task[id].heapPos);
+    }
+}
+
+void Scheduler::notify(int8_t id) {
+    if (id >= 0 && id < nTasks) {
+        task[id].notified.store(true, std::memory_order_release);
+        __sev();
+    }
+}
+
+bool Scheduler::deadline(int8_t id, uint64_t &micros) {
+    if (id < 0 || id >= nTasks || task[id].heapPos < 0) {
+        return false;
+    }
+    micros = task[id].due;
+    return true;
+}
+
+void Scheduler::run() {
+    uint64_t start = time_us_64();
+
+    // The ones that run on every wake and the ones that have been notified
+    for (uint8_t id = 0; id < nTasks; id++) {
+        schTask_t &t = task[id];
+        if (t.notified.load(std::memory_order_acquire)) {
+            t.notified.store(false, std::memory_order_relaxed);
+            t.fn(t.ctx);
+        } else if (t.everyWake) {
+            t.fn(t.ctx);
+        }
+    }
+
+    // The ones whose deadlines have come. They're all taken off the heap before any of them 
+    // runs, so a task that sets itself a deadline that has already come waits for the next pass 
+    // rather than keeping the others from running.
+    uint64_t now = time_us_64();
+    uint8_t due[SCH_MAX_TASKS];
+    uint8_t nDue = 0;
+    while (heapLen > 0 && task[heap[0]].due <= now) {
+        due[nDue++] = heap[0];
+        removeAt(0);
+    }
+    for (uint8_t d = 0; d < nDue; d++) {
+        task[due[d]].fn(task[due[d]].ctx);
+    }
+
+    // Keep track of how long that took
+    now = time_us_64();
+    uint32_t took = (uint32_t)(now - start);
+    stats.passes++;
+    stats.busyMicros += took;
+    stats.maxPassMicros = took > stats.maxPassMicros ? took : stats.maxPassMicros;
+
+    // Sleep until the next deadline (or as long as we dare if there isn't one)
+    uint64_t wake = now + SCH_MAX_SLEEP_MICROS;
+    if (heapLen > 0 && task[heap[0]].due < wake) {
+        wake = task[heap[0]].due;
+    }
+    sleepUntil(wake);
+}
+
+void Scheduler::sleepUntil(uint64_t micros) {
+    if (micros <= time_us_64()) {
+        return;
+    }
+    if (alarm >= 0 && hardware_alarm_set_target(alarm, from_us_since_boot(micros))) {
+        return;                                 // Already there
+    }
+    __wfe();
+    if (alarm >= 0) {
+        hardware_alarm_cancel(alarm);
+    }
+}
+
+schStats_t Scheduler::getStats() {
+    return stats;
+}
+
+// Private member functions
+
+void Scheduler::onAlarm(uint alarmNum) {
+}
+
+bool Scheduler::earlier(uint8_t a, uint8_t b) {
+    return task[heap[a]].due < task[heap[b]].due;
+}
+
+void Scheduler::swap(uint8_t a, uint8_t b) {
+    uint8_t t = heap[a];
+    heap[a] = heap[b];
+    heap[b] = t;
+    task[heap[a]].heapPos = a;
+    task[heap[b]].heapPos = b;
+}
+
+void Scheduler::sift(uint8_t pos) {
+    while (pos > 0 && earlier(pos, (pos - 1) / 2)) {
+        swap(pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+    while (true) {
+        uint8_t least = pos;
+        uint8_t l = 2 * pos + 1;
+        uint8_t r = l + 1;
+        if (l < heapLen && earlier(l, least)) {
+            least = l;
+        }
+        if (r < heapLen && earlier(r, least)) {
+            least = r;
+        }
+        if (least == pos) {
+            return;
+        }
+        swap(pos, least);
+        pos = least;
+    }
+}
+
+void Scheduler::removeAt(uint8_t pos) {
+    task[heap[pos]].heapPos = -1;
+    heapLen--;
+    if (pos == heapLen) {
+        return;
+    }
+    heap[pos] = heap[heapLen];
+    task[heap[pos]].heapPos = pos;
+    sift(pos);
+}
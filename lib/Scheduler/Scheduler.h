@@ -0,0 +1,227 @@
+/****
+ *
+ * This file is a part of the Scheduler library. The library supplies a small cooperative
+ * scheduler that lets a core spend its idle time asleep instead of polling.
+ *
+ * Subsystems register tasks -- a function and a context pointer -- with the scheduler. A task
+ * runs when one of three things happens:
+ *
+ *      Its deadline arrives. A task can be given a deadline with at() or after(). Deadlines are
+ *      one-shot; a periodic task sets its next deadline each time it runs. The pending deadlines
+ *      are kept in a binary min-heap, so finding the next one is immediate and scheduling one
+ *      takes O(log n).
+ *
+ *      It is notified. notify() may be called from an interrupt handler or from the other core.
+ *      The task runs at the next opportunity.
+ *
+ *      The core wakes. A task added with everyWake set runs each time the core wakes for any
+ *      reason. That's for things with no deadline that are cheap to check and that something
+ *      outside the scheduler's knowledge makes ready: characters arriving over USB (whose
+ *      interrupt wakes the core) or a status change published by the other core (which
+ *      signals an event with __sev() to wake this one).
+ *
+ * run() runs whatever is ready and then puts the core to sleep until the next deadline. To wake
+ * at the deadline, it arms a hardware alarm, claimed by begin() on the core that will call
+ * run() so that the alarm's interrupt goes to that core, and then waits with __wfe(). Any
+ * interrupt or __sev() wakes it early. (__wfe() rather than __wfi() because the other core's
+ * __sev() doesn't raise an interrupt. An interrupt taken after the scheduler has decided to
+ * sleep sets the event register on its way out, so it is never missed.)
+ *
+ * sleepUntil() is the sleeping half of run() on its own, for a loop that knows when it next
+ * needs to run without having any tasks to speak of.
+ *
+ * run() also keeps count of how many times it has run tasks and how long that took, so that how
+ * busy the core is can be watched from outside (getStats()).
+ *
+ * Deadlines are in the Pico SDK's 64-bit microsecond timebase, time_us_64(), which counts up
+ * from boot and won't wrap for half a million years. (millis() is 32 bits on the Pico and wraps
+ * every 49.7 days, so deadlines in millis() need wrap-aware comparisons, and the comparisons go
+ * wrong for deadlines more than 24.8 days off.)
+ *
+ *****
+ *
+ * Scheduler V1.2.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#ifndef Arduino_h
+    #include <Arduino.h>
+#endif
+#include <atomic>
+#include <hardware/sync.h>
+#include <hardware/timer.h>
+
+#define SCH_MAX_TASKS           (8)             // Max number of tasks
+#define SCH_MAX_SLEEP_MICROS    (3600000000ULL) // Longest sleep (microseconds) without a look around
+
+//#define SCH_DEBUG                               // Uncomment to enable debug printing
+
+typedef void (*schTaskFn_t)(void *ctx);         // A task's function
+
+struct schStats_t {                             // How the scheduler's core has spent its time
+    uint32_t passes;                            // Number of passes run() has made (wraps)
+    uint32_t busyMicros;                        // Total time (micros) spent running tasks (wraps)
+    uint32_t maxPassMicros;                     // Time (micros) the longest pass took
+};
+
+class Scheduler {
+public:
+    /**
+     * @brief   Construct a new Scheduler object
+     *
+     */
+    Scheduler();
+
+    /**
+     * @brief   Get the scheduler ready for use, forgetting any tasks it had. Must be called on the
+     *          core that will call run() or sleepUntil().
+     *
+     */
+    void begin();
+
+    /**
+     * @brief   Add a task. It has no deadline until it is given one.
+     *
+     * @param fn            The task's function
+     * @param ctx           Passed to fn when it's called
+     * @param everyWake     true ==> also run fn each time the core wakes
+     * @return int8_t       The task's id or -1 if there are too many tasks
+     */
+    int8_t addTask(schTaskFn_t fn, void *ctx = nullptr, bool everyWake = false);
+
+    /**
+     * @brief   Set the task's deadline to the specified time_us_64(), replacing any it had
+     *
+     * @param task      The task's id
+     * @param micros    When it should run
+     */
+    void at(int8_t task, uint64_t micros);
+
+    /**
+     * @brief   Set the task's deadline to the specified number of millis from now
+     *
+     * @param task      The task's id
+     * @param ms        How long from now, in milliseconds, it should run
+     */
+    void after(int8_t task, uint32_t ms);
+
+    /**
+     * @brief   Remove the task's deadline, if it has one
+     *
+     * @param task      The task's id
+     */
+    void cancel(int8_t task);
+
+    /**
+     * @brief   Have the task run at the next opportunity. Safe to call from an interrupt handler
+     *          or from the other core.
+     *
+     * @param task      The task's id
+     */
+    void notify(int8_t task);
+
+    /**
+     * @brief   Return whether the task has a deadline and, if it does, what it is
+     *
+     * @param task      The task's id
+     * @param micros    Set to the deadline (a time_us_64()) if there is one
+     * @return true     The task has a deadline
+     * @return false    It doesn't
+     */
+    bool deadline(int8_t task, uint64_t &micros);
+
+    /**
+     * @brief   Run the tasks that are ready, then sleep until the next deadline, an interrupt or
+     *          an event, whichever comes first.
+     *
+     */
+    void run();
+
+    /**
+     * @brief   Sleep until the specified time_us_64(), an interrupt or an event, whichever comes
+     *          first. Returns immediately if the time has already come.
+     *
+     * @param micros    When to wake up
+     */
+    void sleepUntil(uint64_t micros);
+
+    /**
+     * @brief   Get the counts of run()'s passes and the time they took, from the start
+     *
+     * @return schStats_t   The counts
+     */
+    schStats_t getStats();
+
+private:
+    /**
+     * @brief   The hardware alarm's interrupt handler. There's nothing for it to do: taking the
+     *          interrupt is what wakes the core.
+     *
+     * @param alarmNum  The number of the alarm
+     */
+    static void onAlarm(uint alarmNum);
+
+    /**
+     * @brief   Return whether the deadline of the task at heap position a is before that of the
+     *          one at heap position b
+     *
+     */
+    bool earlier(uint8_t a, uint8_t b);
+
+    /**
+     * @brief   Swap the tasks at heap positions a and b
+     *
+     */
+    void swap(uint8_t a, uint8_t b);
+
+    /**
+     * @brief   Restore the heap property by moving the task at heap position pos toward the top
+     *          or toward the bottom, as need be
+     *
+     * @param pos   The heap position
+     */
+    void sift(uint8_t pos);
+
+    /**
+     * @brief   Remove the task at heap position pos from the heap
+     *
+     * @param pos   The heap position
+     */
+    void removeAt(uint8_t pos);
+
+    struct schTask_t {
+        schTaskFn_t fn;                         // The task's function
+        void *ctx;                              // Its context
+        bool everyWake;                         // Whether it runs each time the core wakes
+        int8_t heapPos;                         // Its position in heap[] or -1 if no deadline
+        uint64_t due;                           // Its deadline (time_us_64()), if it has one
+        std::atomic<bool> notified;             // Whether notify() has been called for it
+    };
+
+    schTask_t task[SCH_MAX_TASKS];              // The tasks
+    uint8_t nTasks;                             // The number of tasks
+    uint8_t heap[SCH_MAX_TASKS];                // Ids of the tasks with deadlines, as a min-heap
+    uint8_t heapLen;                            // The number of tasks in the heap
+    int alarm;                                  // The hardware alarm used to wake up; -1 until claimed
+    schStats_t stats;                           // How the time has been spent
+};
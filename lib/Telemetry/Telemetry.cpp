@@ -0,0 +1,81 @@
+/****
+ *
+ * This file is a part of the Telemetry library. See Telemetry.h for details.
+ *
+ *****
+ *
+ * Telemetry V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <Telemetry.h>
+
+Telemetry::Telemetry() {
+    buf = {};
+    periodMillis = 0;
+    seq = 0;
+    sent = 0;
+    dropped = 0;
+}
+
+void Telemetry::setPeriod(uint32_t millis) {
+    periodMillis = millis == 0 || millis >= TLM_MIN_PERIOD_MILLIS ? millis : TLM_MIN_PERIOD_MILLIS;
+}
+
+uint32_t Telemetry::getPeriod() {
+    return periodMillis;
+}
+
+tlmFrame_t &Telemetry::frame() {
+    return buf;
+}
+
+bool Telemetry::send() {
+    // A dropped frame uses up its sequence number, so the decoder sees the gap
+    uint32_t frameSeq = seq++;
+    if (Serial.availableForWrite() < (int)sizeof(buf)) {
+        dropped++;
+        #ifdef TLM_DEBUG
+        Serial.printf("Telemetry::send - No room for frame %u; dropped.\n", frameSeq);
+        #endif
+        return false;
+    }
+    buf.sync[0] = TLM_SYNC0;
+    buf.sync[1] = TLM_SYNC1;
+    buf.version = TLM_VERSION;
+    buf.len = sizeof(buf);
+    buf.seq = frameSeq;
+    buf.dropped = (uint16_t)dropped;
+    buf.reserved = 0;
+    buf.crc = tlmCrc16((const uint8_t *)&buf, offsetof(tlmFrame_t, crc));
+    Serial.write((const uint8_t *)&buf, sizeof(buf));
+    sent++;
+    return true;
+}
+
+uint32_t Telemetry::getSent() {
+    return sent;
+}
+
+uint32_t Telemetry::getDropped() {
+    return dropped;
+}
@@ -0,0 +1,115 @@
+/****
+ *
+ * This file is a part of the Telemetry library. The library sends a stream of compact, binary 
+ * status frames out the USB serial port, so that the display's behaviour can be logged for 
+ * weeks at a time at next to no cost, rather than asked about now and then with the 'status' 
+ * command.
+ *
+ * Each frame is a fixed-size tlmFrame_t (see TelemetryFrame.h for the format), built in a 
+ * buffer that's part of the Telemetry object, so sending one allocates nothing. The firmware 
+ * fills in the frame's contents via frame() and then calls send(), which fills in the header, 
+ * the sequence number and the CRC and writes the frame. If the serial port doesn't have room 
+ * for the whole frame just then (say, because nothing on the host is reading), the frame is 
+ * dropped and counted rather than waited for. The next frame carries the count.
+ *
+ * How often frames are sent is up to the firmware; the library just keeps the period, which is 
+ * 0 (no frames) to start with.
+ *
+ * On the host, tools/TelemetryDecoder.cpp picks the frames out of whatever else comes over the 
+ * serial port and turns them into CSV.
+ *
+ *****
+ *
+ * Telemetry V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#ifndef Arduino_h
+    #include <Arduino.h>
+#endif
+#include <TelemetryFrame.h>
+
+#define TLM_MIN_PERIOD_MILLIS   (100)           // Shortest time (millis) between frames
+
+//#define TLM_DEBUG                               // Uncomment to enable debug printing
+
+class Telemetry {
+public:
+    /**
+     * @brief   Construct a new Telemetry object. It starts out with a period of 0: no frames.
+     *
+     */
+    Telemetry();
+
+    /**
+     * @brief   Set the time between frames
+     *
+     * @param millis    The period in millis(); 0 ==> don't send frames. Periods shorter than 
+     *                  TLM_MIN_PERIOD_MILLIS are taken to be TLM_MIN_PERIOD_MILLIS.
+     */
+    void setPeriod(uint32_t millis);
+
+    /**
+     * @brief   Get the time between frames
+     *
+     * @return uint32_t The period in millis(); 0 ==> frames aren't being sent
+     */
+    uint32_t getPeriod();
+
+    /**
+     * @brief   Get the frame to fill in before calling send(). The header, the sequence number, 
+     *          the dropped count and the CRC are send()'s job.
+     *
+     * @return tlmFrame_t&  The frame
+     */
+    tlmFrame_t &frame();
+
+    /**
+     * @brief   Finish off the frame and write it to Serial, unless there isn't room for it
+     *
+     * @return true     Sent
+     * @return false    Dropped
+     */
+    bool send();
+
+    /**
+     * @brief   Get the number of frames sent
+     *
+     * @return uint32_t The number sent
+     */
+    uint32_t getSent();
+
+    /**
+     * @brief   Get the number of frames dropped because Serial didn't have room for them
+     *
+     * @return uint32_t The number dropped
+     */
+    uint32_t getDropped();
+
+private:
+    tlmFrame_t buf;                             // The frame being built
+    uint32_t periodMillis;                      // The time between frames; 0 ==> none
+    uint32_t seq;                               // Sequence number of the next frame
+    uint32_t sent;                              // Number of frames sent
+    uint32_t dropped;                           // Number of frames dropped
+};
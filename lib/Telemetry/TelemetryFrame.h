@@ -0,0 +1,105 @@
+/****
+ *
+ * This file is a part of the Telemetry library. It defines the telemetry frame, the one thing 
+ * the firmware and the host-side decoder (tools/TelemetryDecoder.cpp) have to agree on, so it 
+ * includes nothing but the standard headers. See Telemetry.h for details.
+ *
+ * A frame is a fixed-size, little-endian tlmFrame_t, laid out so that it has no padding on 
+ * either the RP2040 or a 64-bit host. It begins with TLM_SYNC0 and TLM_SYNC1, then the format 
+ * version and the frame's length, and ends with a CRC-16 (CCITT, the same one the FlashJournal 
+ * uses) of everything before it. Frames share the USB serial port with the command line's text, 
+ * so a decoder finds them by looking for the sync bytes and believes what it finds only if the 
+ * version, the length and the CRC all check out. Counters in a frame are cumulative and wrap; 
+ * a decoder works with the differences between successive frames.
+ *
+ * If the frame changes, bump TLM_VERSION. Only add fields by using up reserved ones, so that 
+ * the length stays the same.
+ *
+ *****
+ *
+ * Telemetry V1.0.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define TLM_SYNC0               (0xa5)          // First byte of every frame
+#define TLM_SYNC1               (0x5a)          // Second byte of every frame
+#define TLM_VERSION             (1)             // Version of the frame format
+
+// tlmFrame_t.flags bits
+#define TLM_F_BUSY              (0x0001)        // Display is moving or has a move still to make
+#define TLM_F_RESETTING         (0x0002)        // A reset sweep is underway
+#define TLM_F_UNDERWAY          (0x0004)        // Moving to the next phase
+#define TLM_F_TRACKING          (0x0008)        // Display is in track mode
+#define TLM_F_ENERGIZED         (0x0010)        // Stepper coils are energized
+#define TLM_F_WIFI              (0x0020)        // WiFi is on
+#define TLM_F_CLOCK_SET         (0x0040)        // The system clock has been set
+#define TLM_F_TESTING           (0x0080)        // In test mode
+
+struct tlmFrame_t {                             // A telemetry frame
+    uint8_t sync[2];                            // TLM_SYNC0, TLM_SYNC1
+    uint8_t version;                            // TLM_VERSION
+    uint8_t len;                                // sizeof(tlmFrame_t)
+    uint32_t seq;                               // Frame sequence number (wraps)
+    uint64_t micros;                            // time_us_64() when the frame was made
+    uint32_t utc;                               // time() when the frame was made
+    int32_t pv;                                 // Pivot position (steps)
+    int32_t ls;                                 // Leadscrew position (steps)
+    int16_t phase;                              // The phase showing (or being reset to)
+    int16_t tgtPhase;                           // The phase being worked toward
+    uint16_t flags;                             // TLM_F_... bits
+    int16_t ambient;                            // Ambient light level (0..100)
+    int16_t duty[2];                            // Waxing and waning COB duty cycles
+    uint32_t c0Passes;                          // Core 0 scheduler passes (wraps)
+    uint32_t c0BusyMicros;                      // Core 0 time spent running tasks (wraps)
+    uint32_t c0MaxMicros;                       // Core 0 longest pass
+    uint32_t c1Passes;                          // Core 1 runMotion() passes (wraps)
+    uint32_t c1BusyMicros;                      // Core 1 time spent in runMotion() (wraps)
+    uint32_t c1MaxMicros;                       // Core 1 longest runMotion() pass
+    uint16_t arrivals;                          // Display moves completed (wraps)
+    uint16_t dropped;                           // Frames not sent for want of room to (wraps)
+    uint16_t reserved;                          // 0
+    uint16_t crc;                               // tlmCrc16() of everything before it
+};
+static_assert(sizeof(tlmFrame_t) == 72, "tlmFrame_t has padding in it");
+static_assert(offsetof(tlmFrame_t, crc) == sizeof(tlmFrame_t) - 2, "tlmFrame_t's CRC isn't last");
+
+/**
+ * @brief   Return the CRC-16 (CCITT: polynomial 0x1021, initial value 0xffff) of some data
+ *
+ * @param data      The data
+ * @param len       Its length in bytes
+ * @return uint16_t The CRC
+ */
+inline uint16_t tlmCrc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xffff;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
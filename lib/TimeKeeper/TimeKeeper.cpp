@@ -0,0 +1,389 @@
+/****
+ *
+ * This file is a part of the TimeKeeper library. See TimeKeeper.h for details.
+ *
+ *****
+ *
+ * TimeKeeper V1.2.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#include <TimeKeeper.h>
+
+#define NTP_UNIX_OFFSET         (2208988800LL)  // Seconds from the NTP epoch (1900) to the Unix one (1970)
+
+/**
+ * @brief   Put a UTC time into an NTP timestamp
+ *
+ * @param at        Where the timestamp goes (8 bytes, big-endian seconds and fraction)
+ * @param utc       The UTC time (micros since the Unix epoch)
+ */
+static void putTimestamp(uint8_t *at, int64_t utc) {
+    uint32_t secs = (uint32_t)(utc / 1000000 + NTP_UNIX_OFFSET);
+    uint32_t frac = (uint32_t)(((uint64_t)(utc % 1000000) << 32) / 1000000);
+    for (uint8_t b = 0; b < 4; b++) {
+        at[b] = (uint8_t)(secs >> (24 - 8 * b));
+        at[4 + b] = (uint8_t)(frac >> (24 - 8 * b));
+    }
+}
+
+/**
+ * @brief   Get the UTC time in an NTP timestamp. (Good until the NTP era rolls over in 2036.)
+ *
+ * @param at        The timestamp
+ * @return int64_t  The UTC time (micros since the Unix epoch)
+ */
+static int64_t getTimestamp(const uint8_t *at) {
+    uint32_t secs = 0;
+    uint32_t frac = 0;
+    for (uint8_t b = 0; b < 4; b++) {
+        secs = (secs << 8) | at[b];
+        frac = (frac << 8) | at[4 + b];
+    }
+    return ((int64_t)secs - NTP_UNIX_OFFSET) * 1000000 + (int64_t)(((uint64_t)frac * 1000000) >> 32);
+}
+
+TimeKeeper::TimeKeeper() {
+    power = nullptr;
+    state = TK_OFF;
+    set = false;
+    synced = false;
+}
+
+void TimeKeeper::begin(PowerManager *power) {
+    udp.stop();
+    this->power = power;
+    state = TK_OFF;
+    set = false;
+    synced = false;
+    since = 0;
+    sentMillis = 0;
+    backoffMillis = TK_BACKOFF_MIN_MILLIS;
+    retryWait = 0;
+    tries = 0;
+    connectOk = false;
+    setMillis = 0;
+    t1Micros = 0;
+    samples = 0;
+    bestOffset = 0;
+    bestDelay = 0;
+    anchorLocal = 0;
+    anchorUtc = 0;
+    freqPpb = 0;
+    slewMicros = 0;
+    drifts = 0;
+    stats = {};
+    stats.resyncMillis = TK_RESYNC_MIN_MILLIS;
+}
+
+void TimeKeeper::start() {
+    if (state != TK_OFF) {
+        return;
+    }
+    state = TK_CONNECTING;
+    since = millis();
+    tries = 1;
+}
+
+bool TimeKeeper::syncNow() {
+    if (state == TK_OFF) {
+        return false;
+    }
+    if (state == TK_BACKOFF || state == TK_SYNCED) {
+        state = TK_CONNECTING;
+        since = millis();
+        tries = 1;
+    }
+    return true;
+}
+
+uint32_t TimeKeeper::run() {
+    unsigned long now = millis();
+    switch (state) {
+        case TK_OFF:
+            return 0;
+
+        case TK_BACKOFF:
+        case TK_SYNCED:
+            if (now - since < retryWait) {
+                return retryWait - (now - since);
+            }
+            tries = state == TK_SYNCED ? 1 : tries + 1;
+            state = TK_CONNECTING;
+            since = now;
+            #ifdef TK_DEBUG
+            Serial.printf("TimeKeeper::run - Try %lu at getting the time.\n", (unsigned long)tries);
+            #endif
+            [[fallthrough]];                    // Get the connection started
+
+        case TK_CONNECTING:
+            switch (power->wifiAcquireAsync()) {
+                case PM_WIFI_CONNECTING:
+                    return TK_POLL_MILLIS;
+                case PM_WIFI_OFF:
+                    connectOk = false;
+                    return backOff();
+                case PM_WIFI_ON:
+                    break;
+            }
+            connectOk = true;
+            udp.begin(TK_LOCAL_PORT);
+            samples = 0;
+            state = TK_SYNCING;
+            since = now;
+            sendRequest();
+            return TK_REPLY_POLL_MILLIS;
+
+        case TK_SYNCING:
+            readAnswers();
+            if (samples >= (synced ? TK_NTP_SAMPLES : 1) || (samples > 0 && now - since >= TK_NTP_TIMEOUT_MILLIS)) {
+                udp.stop();
+                power->wifiRelease();
+                applySync();
+                state = TK_SYNCED;
+                since = now;
+                retryWait = stats.resyncMillis;
+                backoffMillis = TK_BACKOFF_MIN_MILLIS;
+                return retryWait;
+            }
+            if (now - since >= TK_NTP_TIMEOUT_MILLIS) {
+                udp.stop();
+                power->wifiRelease();
+                return backOff();
+            }
+            if (now - sentMillis >= TK_REQUEST_TIMEOUT_MILLIS) {
+                sendRequest();
+            }
+            return TK_REPLY_POLL_MILLIS;
+    }
+    return 0;
+}
+
+tkState_t TimeKeeper::getState() {
+    return state;
+}
+
+bool TimeKeeper::clockIsSet() {
+    return set;
+}
+
+bool TimeKeeper::clockIsSynced() {
+    return synced;
+}
+
+bool TimeKeeper::seed(const tkCache_t &cache) {
+    if (set || cache.utcMicros <= 0 || cache.freqPpb > TK_MAX_PPB || cache.freqPpb < -TK_MAX_PPB) {
+        return false;
+    }
+
+    // At least the time since the anchor has passed if time_us_64() has kept counting since the 
+    // cache was saved, and at least the time since boot if it has started over
+    uint64_t local = time_us_64();
+    uint64_t passed = local >= cache.localMicros ? local - cache.localMicros : local;
+    freqPpb = cache.freqPpb;
+    drifts = freqPpb == 0 ? 0 : 1;
+    anchorLocal = local;
+    anchorUtc = cache.utcMicros + (int64_t)passed - (int64_t)((double)passed * freqPpb / 1e9);
+    slewMicros = 0;
+    set = true;
+    setMillis = millis();
+    #ifdef TK_DEBUG
+    Serial.printf("TimeKeeper::seed - Clock set to %lld us, rate error %ld ppb.\n", (long long)anchorUtc, (long)freqPpb);
+    #endif
+    return true;
+}
+
+bool TimeKeeper::getCache(tkCache_t &cache) {
+    if (!set) {
+        return false;
+    }
+    cache = {};
+    cache.localMicros = time_us_64();
+    cache.utcMicros = utcAt(cache.localMicros);
+    cache.freqPpb = freqPpb;
+    return true;
+}
+
+int64_t TimeKeeper::utcMicros() {
+    return utcAt(time_us_64());
+}
+
+time_t TimeKeeper::now() {
+    return (time_t)(utcMicros() / 1000000);
+}
+
+uint64_t TimeKeeper::localMicrosAt(int64_t utc) {
+    // While slewing, the clock runs at rate +/- the slew rate; after that, at rate, with the 
+    // whole of the slew done
+    double d = (double)(utc - anchorUtc);
+    double rate = 1.0 - freqPpb / 1e9;
+    double slewRate = TK_SLEW_PPM / 1e6;
+    double e = (d - slewMicros) / rate;
+    if (slewMicros != 0 && d < (double)(slewMicros < 0 ? -slewMicros : slewMicros) / slewRate * rate + slewMicros) {
+        e = d / (rate + (slewMicros < 0 ? -slewRate : slewRate));
+    }
+    double local = (double)anchorLocal + e;
+    return local <= 0.0 ? 0 : (uint64_t)local;
+}
+
+tkStats_t TimeKeeper::getStats() {
+    tkStats_t answer = stats;
+    int64_t left = slewMicros - slewedBy(time_us_64());
+    answer.slewMicros = (int32_t)left;
+    answer.freqPpb = freqPpb;
+    return answer;
+}
+
+uint32_t TimeKeeper::getTries() {
+    return tries;
+}
+
+bool TimeKeeper::lastConnectOk() {
+    return connectOk;
+}
+
+unsigned long TimeKeeper::getSetMillis() {
+    return setMillis;
+}
+
+unsigned long TimeKeeper::getRetryMillis() {
+    return since + retryWait;
+}
+
+// Private member functions
+
+int64_t TimeKeeper::utcAt(uint64_t local) {
+    int64_t e = (int64_t)(local - anchorLocal);
+    return anchorUtc + e - (int64_t)((double)e * freqPpb / 1e9) + slewedBy(local);
+}
+
+int64_t TimeKeeper::slewedBy(uint64_t local) {
+    if (slewMicros == 0 || local <= anchorLocal) {
+        return 0;
+    }
+    int64_t most = (int64_t)(local - anchorLocal) * TK_SLEW_PPM / 1000000;
+    return slewMicros > 0 ? (slewMicros < most ? slewMicros : most) : (-slewMicros < most ? slewMicros : -most);
+}
+
+void TimeKeeper::sendRequest() {
+    uint8_t packet[TK_NTP_LEN] = {};
+    packet[0] = 0x23;                           // Leap indicator 0, version 4, mode 3 (client)
+    t1Micros = utcMicros();
+    putTimestamp(t1, t1Micros);
+    memcpy(packet + 40, t1, sizeof(t1));        // Transmit timestamp; the server echoes it back
+    udp.beginPacket(tries % 2 == 1 ? TK_NTP_SERVER1 : TK_NTP_SERVER2, TK_NTP_PORT);
+    udp.write(packet, sizeof(packet));
+    udp.endPacket();
+    sentMillis = millis();
+}
+
+void TimeKeeper::readAnswers() {
+    uint8_t packet[TK_NTP_LEN];
+    while (udp.parsePacket() > 0) {
+        int64_t t4 = utcMicros();
+        if (udp.read(packet, sizeof(packet)) != TK_NTP_LEN) {
+            continue;
+        }
+        // It has to be a server's answer to our latest request from a server that knows the time
+        uint8_t leap = packet[0] >> 6;
+        uint8_t mode = packet[0] & 0x07;
+        uint8_t stratum = packet[1];
+        if (mode != 4 || leap == 3 || stratum == 0 || stratum > 15 || memcmp(packet + 24, t1, sizeof(t1)) != 0) {
+            #ifdef TK_DEBUG
+            Serial.printf("TimeKeeper::readAnswers - Ignoring answer: mode %d, leap %d, stratum %d.\n", mode, leap, stratum);
+            #endif
+            continue;
+        }
+        int64_t t2 = getTimestamp(packet + 32);
+        int64_t t3 = getTimestamp(packet + 40);
+        int64_t offset = ((t2 - t1Micros) + (t3 - t4)) / 2;
+        int64_t delay = (t4 - t1Micros) - (t3 - t2);
+        delay = delay < 0 ? 0 : delay;
+        if (samples == 0 || delay < bestDelay) {
+            bestOffset = offset;
+            bestDelay = (uint32_t)delay;
+        }
+        samples++;
+        #ifdef TK_DEBUG
+        Serial.printf("TimeKeeper::readAnswers - Offset %lld us, delay %lld us.\n", (long long)offset, (long long)delay);
+        #endif
+        if (samples < (synced ? TK_NTP_SAMPLES : 1)) {
+            sendRequest();
+        }
+    }
+}
+
+void TimeKeeper::applySync() {
+    uint64_t local = time_us_64();
+    int64_t utc = utcAt(local);
+    if (synced) {
+        // The part of the last offset still to be slewed away was already known. The rest built up 
+        // since the last sync, which, if it's been long enough to tell, says how far off the 
+        // rate error estimate is.
+        int64_t newOffset = bestOffset - (slewMicros - slewedBy(local));
+        uint64_t interval = local - anchorLocal;
+        if (interval >= TK_MIN_DRIFT_MILLIS * 1000ULL) {
+            int64_t correction = (int64_t)((double)newOffset * 1e9 / (double)interval);
+            freqPpb -= (int32_t)(drifts == 0 ? correction : correction * TK_FREQ_GAIN_PCT / 100);
+            freqPpb = freqPpb > TK_MAX_PPB ? TK_MAX_PPB : freqPpb < -TK_MAX_PPB ? -TK_MAX_PPB : freqPpb;
+            drifts = drifts == UINT8_MAX ? drifts : drifts + 1;
+            bool settled = newOffset > -TK_SETTLED_MICROS && newOffset < TK_SETTLED_MICROS;
+            stats.resyncMillis = !settled ? TK_RESYNC_MIN_MILLIS :
+                stats.resyncMillis >= TK_RESYNC_MAX_MILLIS / 2 ? TK_RESYNC_MAX_MILLIS : stats.resyncMillis * 2;
+        }
+    }
+
+    // Start again from here, stepping or slewing the offset away
+    anchorLocal = local;
+    anchorUtc = utc;
+    if (!synced || bestOffset >= TK_STEP_MICROS || bestOffset <= -TK_STEP_MICROS) {
+        anchorUtc += bestOffset;
+        slewMicros = 0;
+        stats.steps++;
+    } else {
+        slewMicros = bestOffset;
+    }
+    if (!set) {
+        set = true;
+        setMillis = millis();
+    }
+    synced = true;
+    stats.syncs++;
+    stats.lastOffsetMicros = (int32_t)(bestOffset > INT32_MAX ? INT32_MAX : bestOffset < -INT32_MAX ? -INT32_MAX : bestOffset);
+    stats.lastDelayMicros = bestDelay;
+    stats.lastSyncMillis = millis();
+    #ifdef TK_DEBUG
+    Serial.printf("TimeKeeper::applySync - Offset %lld us, delay %lu us, rate error %ld ppb, next sync in %lu ms.\n", 
+        (long long)bestOffset, (unsigned long)bestDelay, (long)freqPpb, (unsigned long)stats.resyncMillis);
+    #endif
+}
+
+uint32_t TimeKeeper::backOff() {
+    state = TK_BACKOFF;
+    since = millis();
+    retryWait = backoffMillis;
+    backoffMillis = backoffMillis >= TK_BACKOFF_MAX_MILLIS / 2 ? TK_BACKOFF_MAX_MILLIS : backoffMillis * 2;
+    #ifdef TK_DEBUG
+    Serial.printf("TimeKeeper::backOff - Try %lu failed; trying again in %lu ms.\n", (unsigned long)tries, (unsigned long)retryWait);
+    #endif
+    return retryWait;
+}
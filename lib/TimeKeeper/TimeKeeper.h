@@ -0,0 +1,359 @@
+/****
+ *
+ * This file is a part of the TimeKeeper library. The library keeps track of the time of day,
+ * getting it from the network without holding anything else up while it does, and keeping it
+ * right afterwards.
+ *
+ * Getting the time means connecting to WiFi, which takes a few seconds, and then waiting for
+ * an NTP server to answer, which can take a few more. Done one after the other in setup(), that
+ * keeps the display and the command line waiting, and if the network is down, the clock never
+ * gets set at all. Instead, a TimeKeeper is a state machine that the firmware runs from a
+ * scheduler task. Each call to run() does whatever is needed to move things along, never waits,
+ * and says how long it is until it needs to run again:
+ *
+ *      TK_OFF          Nothing to do: start() hasn't been called (there's no WiFi configuration)
+ *      TK_CONNECTING   Waiting for PowerManager::wifiAcquireAsync() to connect
+ *      TK_SYNCING      Connected; asking an NTP server for the time
+ *      TK_BACKOFF      The last try failed; waiting to try again
+ *      TK_SYNCED       Got the time; waiting until it's time to sync again
+ *
+ * While connecting, run() wants to run every TK_POLL_MILLIS, and while waiting for NTP, every
+ * TK_REPLY_POLL_MILLIS. If a try fails -- WiFi won't connect or NTP doesn't answer within
+ * TK_NTP_TIMEOUT_MILLIS -- the radio goes off and the TimeKeeper waits before trying again,
+ * starting with TK_BACKOFF_MIN_MILLIS and doubling the wait after each failure, up to
+ * TK_BACKOFF_MAX_MILLIS. So a unit that boots while the network is down gets the time soon after
+ * the network comes back, without keeping the radio on in the meantime.
+ *
+ * The TimeKeeper talks to the NTP server itself, over UDP, rather than leaving it to the SDK's
+ * SNTP client, so that it can see how far off its own clock was instead of just having it set.
+ * Each request carries our time of sending (T1); the answer has the server's times of receiving
+ * it (T2) and of answering (T3); and we note when the answer arrived (T4). Our clock's offset
+ * from the server's is ((T2 - T1) + (T3 - T4)) / 2, give or take half the round trip delay,
+ * (T4 - T1) - (T3 - T2). A sync asks up to TK_NTP_SAMPLES times and believes the answer with
+ * the shortest round trip. (The first sync, at boot, takes the first answer; anything is better
+ * than nothing.)
+ *
+ * The time of day the TimeKeeper keeps -- utcMicros() -- is worked out from time_us_64(), which
+ * counts the crystal's ticks. The crystal runs a little fast or slow, by a few tens of ppm,
+ * which adds up to seconds a day. So:
+ *
+ *      Each sync is an anchor: the time_us_64() and UTC then. utcMicros() is the anchor's UTC
+ *      plus the time_us_64() since, corrected for the crystal's estimated rate error.
+ *
+ *      The rate error is estimated from the offsets the syncs find. Whatever offset has built up
+ *      since the last sync (at least TK_MIN_DRIFT_MILLIS ago) is put down to an error in the
+ *      estimate, which is corrected by TK_FREQ_GAIN_PCT of what that implies.
+ *
+ *      Offsets are slewed, not stepped: the clock runs up to TK_SLEW_PPM fast or slow until
+ *      it has made the offset up, so it never jumps and never goes backward. (Only the first
+ *      sync, and ones that find the clock off by more than TK_STEP_MICROS, step it.)
+ *
+ *      The time between syncs starts at TK_RESYNC_MIN_MILLIS and doubles after each sync that
+ *      finds the clock within TK_SETTLED_MICROS of right, up to TK_RESYNC_MAX_MILLIS. A sync
+ *      that finds it further off than that starts over at TK_RESYNC_MIN_MILLIS.
+ *
+ * A TimeKeeper can also be warm started, for when the network is down at boot. Now and then,
+ * the firmware gets a tkCache_t from it -- the time, the time_us_64() it was read at (the uptime
+ * anchor) and the rate error estimate -- and saves it in flash. At the next boot, before the
+ * network has been heard from, it hands the saved one to seed(), which sets the clock to the
+ * saved time plus however much time is known to have passed since: the time_us_64() since the
+ * anchor if time_us_64() has kept counting (a simulator), or since boot if it has started over
+ * (a Pico). That's behind by however long the power was off, but it keeps the phase changes
+ * coming, and from then on the clock drifts no more than the rate error estimate allows. The
+ * first sync after that steps the clock to the right time, and clockIsSynced() says which it is.
+ *
+ * The system clock (time()) is left alone. Ask the TimeKeeper what time it is instead, and use
+ * localMicrosAt() to turn a UTC time into a time_us_64() to schedule something for. Deadlines
+ * worked out that way before a sync should be worked out again after it, since the mapping from
+ * one to the other will have changed (a little).
+ *
+ * A TimeKeeper is meant to be used from core 0 only, like the PowerManager it uses.
+ *
+ *****
+ *
+ * TimeKeeper V1.2.0, October 2026
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****/
+
+#pragma once
+#ifndef Arduino_h
+    #include <Arduino.h>
+#endif
+#include <hardware/timer.h>
+#include <WiFi.h>
+#include <PowerManager.h>
+
+#define TK_POLL_MILLIS          (100)           // How often to look in on a connection
+#define TK_REPLY_POLL_MILLIS    (2)             // How often to look for an NTP answer (limits the precision of T4)
+#define TK_REQUEST_TIMEOUT_MILLIS (2000)        // How long to wait for an answer before asking again
+#define TK_NTP_TIMEOUT_MILLIS   (10000)         // How long a sync may take
+#define TK_NTP_SAMPLES          (4)             // How many answers a sync collects (at most)
+#define TK_BACKOFF_MIN_MILLIS   (5000)          // Wait after the first failure before trying again
+#define TK_BACKOFF_MAX_MILLIS   (3600000)       // Longest wait between tries
+#define TK_RESYNC_MIN_MILLIS    (3600000)       // Shortest time between syncs
+#define TK_RESYNC_MAX_MILLIS    (86400000)      // Longest time between syncs
+#define TK_SETTLED_MICROS       (20000)         // A sync finding the clock within this of right lengthens the interval
+#define TK_MIN_DRIFT_MILLIS     (900000)        // Shortest time between syncs that's used to estimate the rate error
+#define TK_FREQ_GAIN_PCT        (50)            // How much of a rate error estimate is believed (after the first)
+#define TK_MAX_PPB              (500000)        // Largest rate error believed (ppb)
+#define TK_SLEW_PPM             (500)           // How fast offsets are slewed away (ppm)
+#define TK_STEP_MICROS          (10000000LL)    // Bigger offsets are stepped
+#define TK_NTP_PORT             (123)           // The NTP servers' UDP port
+#define TK_LOCAL_PORT           (2390)          // Our UDP port
+#define TK_NTP_LEN              (48)            // Length of an NTP packet
+#define TK_NTP_SERVER1          "pool.ntp.org"  // The NTP servers; tries alternate between them
+#define TK_NTP_SERVER2          "time.nist.gov"
+
+//#define TK_DEBUG                                // Uncomment to enable debug printing
+
+enum tkState_t : uint8_t {                      // What a TimeKeeper is up to
+    TK_OFF,                                     // Nothing
+    TK_CONNECTING,                              // Connecting to WiFi
+    TK_SYNCING,                                 // Asking NTP
+    TK_BACKOFF,                                 // Waiting to try again
+    TK_SYNCED                                   // Waiting to sync again
+};
+
+struct tkStats_t {                              // How the time keeping is going
+    uint32_t syncs;                             // Number of successful syncs
+    int32_t lastOffsetMicros;                   // The offset the last sync found (+ ==> we were behind), clamped
+    uint32_t lastDelayMicros;                   // The round trip delay of the answer it was based on
+    int32_t freqPpb;                            // Estimated rate error (ppb; + ==> the crystal runs fast)
+    int32_t slewMicros;                         // The part of the last offset not yet slewed away
+    unsigned long lastSyncMillis;               // millis() at the last sync
+    uint32_t resyncMillis;                      // Time between syncs just now
+    uint32_t steps;                             // Number of syncs that stepped the clock rather than slewing it
+};
+
+struct tkCache_t {                              // What's saved so the clock can be warm started
+    int64_t utcMicros;                          // The UTC time (micros since the Unix epoch) when saved
+    uint64_t localMicros;                       // The time_us_64() it was read at (the uptime anchor)
+    int32_t freqPpb;                            // The rate error estimate then (ppb)
+};
+
+class TimeKeeper {
+public:
+    /**
+     * @brief   Construct a new TimeKeeper object
+     *
+     */
+    TimeKeeper();
+
+    /**
+     * @brief   Get ready to get the time, but don't start yet. Forgets the time, if it had it.
+     *
+     * @param power     The PowerManager to get WiFi from
+     */
+    void begin(PowerManager *power);
+
+    /**
+     * @brief   Start trying to get the clock set. The first call to run() gets WiFi connecting.
+     *
+     */
+    void start();
+
+    /**
+     * @brief   Sync with NTP now rather than waiting until it's time. Call run() right after.
+     *
+     * @return true     A sync is underway
+     * @return false    start() hasn't been called
+     */
+    bool syncNow();
+
+    /**
+     * @brief   Move things along. Never waits.
+     *
+     * @return uint32_t     How long (millis) until run() should be called again; 0 if it needn't be
+     */
+    uint32_t run();
+
+    /**
+     * @brief   Get what the TimeKeeper is up to
+     *
+     * @return tkState_t    The state
+     */
+    tkState_t getState();
+
+    /**
+     * @brief   Return whether the clock has been set
+     *
+     * @return true     It has
+     * @return false    Not yet
+     */
+    bool clockIsSet();
+
+    /**
+     * @brief   Return whether the clock has been set from the network since boot, as opposed to 
+     *          from a saved tkCache_t only
+     *
+     * @return true     It has
+     * @return false    Not yet
+     */
+    bool clockIsSynced();
+
+    /**
+     * @brief   Set the clock from a tkCache_t saved before the last reboot, if it hasn't already 
+     *          been set. It stays set that way, behind by however long the power was off, until 
+     *          the first sync.
+     *
+     * @param cache     The saved cache
+     * @return true     The clock has been set from it
+     * @return false    The clock was already set or the cache makes no sense
+     */
+    bool seed(const tkCache_t &cache);
+
+    /**
+     * @brief   Get what needs saving to warm start the clock after the next reboot
+     *
+     * @param cache     Set to what needs saving
+     * @return true     Done
+     * @return false    The clock isn't set; there's nothing worth saving
+     */
+    bool getCache(tkCache_t &cache);
+
+    /**
+     * @brief   Get the time of day. Until the clock is set, it counts up from the Unix epoch at 
+     *          boot, as time() does.
+     *
+     * @return int64_t  The UTC time in microseconds since the Unix epoch
+     */
+    int64_t utcMicros();
+
+    /**
+     * @brief   Get the time of day to the second
+     *
+     * @return time_t   The UTC time
+     */
+    time_t now();
+
+    /**
+     * @brief   Get the time_us_64() at which it will be the specified UTC time, as things stand
+     *
+     * @param utc       The UTC time in microseconds since the Unix epoch
+     * @return uint64_t The time_us_64() (0 if that was before boot)
+     */
+    uint64_t localMicrosAt(int64_t utc);
+
+    /**
+     * @brief   Get how the time keeping is going
+     *
+     * @return tkStats_t    The statistics
+     */
+    tkStats_t getStats();
+
+    /**
+     * @brief   Get the number of tries at connecting to WiFi for the current (or last) sync
+     *
+     * @return uint32_t The count
+     */
+    uint32_t getTries();
+
+    /**
+     * @brief   Return whether the most recent try at connecting to WiFi that's over succeeded
+     *
+     * @return true     It did
+     * @return false    It failed, or there hasn't been one yet
+     */
+    bool lastConnectOk();
+
+    /**
+     * @brief   Get the millis() at which the clock was first set
+     *
+     * @return unsigned long    The millis(); 0 if it hasn't been
+     */
+    unsigned long getSetMillis();
+
+    /**
+     * @brief   Get the millis() at which the TimeKeeper will next try, if it's in TK_BACKOFF, or
+     *          sync, if it's in TK_SYNCED
+     *
+     * @return unsigned long    The millis()
+     */
+    unsigned long getRetryMillis();
+
+private:
+    /**
+     * @brief   Get the UTC time at the specified time_us_64()
+     *
+     * @param local     The time_us_64()
+     * @return int64_t  The UTC time (micros since the Unix epoch)
+     */
+    int64_t utcAt(uint64_t local);
+
+    /**
+     * @brief   Get how much of the slew there is to do has been done by the specified 
+     *          time_us_64()
+     *
+     * @param local     The time_us_64()
+     * @return int64_t  The micros slewed so far
+     */
+    int64_t slewedBy(uint64_t local);
+
+    /**
+     * @brief   Send an NTP request
+     *
+     */
+    void sendRequest();
+
+    /**
+     * @brief   Look at the answers that have arrived, keeping the best
+     *
+     */
+    void readAnswers();
+
+    /**
+     * @brief   Correct the clock and the rate error estimate from the best answer a sync got
+     *
+     */
+    void applySync();
+
+    /**
+     * @brief   The current try has failed. Wait a while, longer each time, before trying again.
+     *
+     * @return uint32_t     How long to wait (millis)
+     */
+    uint32_t backOff();
+
+    PowerManager *power;                        // Where WiFi comes from
+    WiFiUDP udp;                                // How we talk to NTP
+    tkState_t state;                            // What we're up to
+    bool set;                                   // Whether the clock has been set
+    bool synced;                                // Whether it has been set from the network since boot
+    unsigned long since;                        // millis() when the current state began
+    unsigned long sentMillis;                   // millis() when the last request went out
+    uint32_t backoffMillis;                     // How long to wait after the next failure
+    uint32_t retryWait;                         // How long to wait, in TK_BACKOFF or TK_SYNCED, before trying again
+    uint32_t tries;                             // Number of tries at connecting for this sync
+    bool connectOk;                             // Whether the last connection attempt succeeded
+    unsigned long setMillis;                    // millis() when the clock got set
+    uint8_t t1[8];                              // The transmit timestamp of the last request, as sent
+    int64_t t1Micros;                           // The same as a UTC time
+    uint8_t samples;                            // Number of good answers this sync
+    int64_t bestOffset;                         // The offset from the best of them
+    uint32_t bestDelay;                         // Its round trip delay
+    uint64_t anchorLocal;                       // time_us_64() at the last sync
+    int64_t anchorUtc;                          // UTC time (micros) then
+    int32_t freqPpb;                            // Estimated rate error of the crystal (ppb)
+    int64_t slewMicros;                         // The offset being slewed away, starting from the anchor
+    uint8_t drifts;                             // Number of rate error estimates made (saturates)
+    tkStats_t stats;                            // How it's going
+};
@@ -0,0 +1,508 @@
+/****
+ * @file LunationSim.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * An accelerated-time lunation simulator for the moon phase display firmware. It is built by
+ * the PlatformIO "native_sim" environment and replaces the NativeHal's main(). It runs the
+ * unmodified firmware (setup(), loop(), setup1() and loop1() in Main.cpp) against the NativeHal
+ * stand-ins. Core 1's loop1() gets a pass after each loop() pass and again as soon as the
+ * virtual clock has been advanced, so the display's status snapshot is always fresh when the
+ * simulator looks at it. While the motors are moving, loop() runs every SIM_MOVING_MICROS of
+ * virtual time, the motor timer firing as often as it needs to in between. Otherwise the simulator skips the virtual clock
+ * straight ahead to the next scheduled phase change or the next sample time, whichever comes
+ * first. A year of operation, including all of the 29 -> 30 and 59 -> 0 reset sweeps, takes
+ * about eight seconds, most of it emulating the 45 million or so steps the motors take, one
+ * PIO instruction and DMA transfer at a time.
+ *
+ * The simulated unit is provisioned and rebooted, just as a real one would be: The first boot
+ * finds no saved configuration, so the simulator sets the WiFi credentials, turns test mode
+ * off, tells the display it's showing the current phase and saves. The second boot connects
+ * to the (simulated) network, sets the clock and runs from there.
+ *
+ * For each true lunation (new moon to new moon) the simulator reports the number of steps each
+ * motor took, the time the motors spent moving, the number of flash pages programmed and
+ * sectors erased saving state, the number of reset sweeps, and how far the displayed phase was
+ * from the true phase of the moon. The phase error is measured in display phases (1/60
+ * lunation); it is zero while the display shows the phase whose span contains the true phase.
+ * The mean is time-weighted. The true new moons come from Meeus' series,
+ * MoonPhase::computeNewMoon(), not from NewMoonTable.h, which is what the firmware uses, so a
+ * mistake in the table or in how it's read shows up as phase error.
+ *
+ * It also estimates the charge the unit draws, in mA·h, using a simple energy model: the
+ * controller draws SIM_MA_AWAKE while the motors move (core 1 is kept busy feeding them) and
+ * SIM_MA_ASLEEP otherwise, plus SIM_MA_WIFI while WiFi is connected, SIM_MA_COIL for each
+ * energized stepper coil and SIM_MA_COB in proportion to each COB's PWM duty cycle. The loads
+ * are sampled at the start of each step of the virtual clock, which is fine-grained enough while
+ * anything is changing. The figures are typical values, not measurements; they're for comparing
+ * one version of the firmware with another.
+ *
+ * With --track, the unit is provisioned in track mode, so the terminator follows the moon a step
+ * or two at a time instead of moving a whole phase at each phase change.
+ *
+ * The simulator also reports how long the second boot takes to get going: how long setup()
+ * took, how long until the clock was set and how long until the display showed the true phase of
+ * the moon. The simulated network takes --wifi-ms to connect and --ntp-ms for NTP to answer, and
+ * the first --wifi-fails connection attempts fail. With --offline, the unit sits unpowered for
+ * that many hours between the two boots, so the phase it saved is out of date when it comes back.
+ * No host has the USB serial port open unless --verbose is given.
+ *
+ * The Pico's crystal can be made to run --ppm parts per million fast (or, if negative, slow).
+ * The phase error is then measured against the true time rather than the Pico's, and the
+ * simulator reports how far off the firmware's clock was at the end and how well it estimated
+ * the drift.
+ *
+ * With --outage, the network is down for the first that many days after the second boot, so the
+ * unit has to make do with the time it saved before it was powered off. For that to be worth
+ * anything, the unit runs SIM_BURN_IN_DAYS with the network up between being provisioned and
+ * being powered off, long enough to have estimated the drift. For example,
+ * "--outage 30 --ppm 40 --offline 0.5" shows how far off the display gets in a month with no
+ * network after a half-hour power cut.
+ *
+ * The motors drive NativeHal's model of the mechanism, which starts out where the display is 
+ * told it is when the unit is provisioned and has home flags where MoonDisplay.h says they are. 
+ * At the end, the simulator reports how far the display's idea of where its motors are was from 
+ * where the mechanism really was, then and at worst. With --slip, the motors lose a cycle of 
+ * the coils with that chance, in parts per million, at each step; with --knock, the pivot is 
+ * knocked that many steps out of place while the unit is off between the two boots. With 
+ * --home-days, the display is homed every that many days, starting a day after the second 
+ * boot, to put things right. For example, "--knock 150 --slip 20 --home-days 30" shows how 
+ * well homing keeps the display registered.
+ *
+ * Erasing and programming flash hold up both cores, as they do on the Pico. The simulator 
+ * reports how long the flash was busy and how many times, meanwhile, the steppers' step stream 
+ * ran dry because the interrupt that keeps it fed was held off. On the Pico, that's a stepper 
+ * stopping dead at speed and losing steps, so it ought to be zero.
+ *
+ * Usage: program [--days <n>] [--start <time_t>] [--track] [--verbose] [--wifi-ms <n>]
+ *                [--ntp-ms <n>] [--wifi-fails <n>] [--offline <hours>] [--ppm <n>]
+ *                [--outage <days>] [--slip <ppm>] [--knock <steps>] [--home-days <days>]
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <CommandLine.h>
+#include <MoonDisplay.h>
+#include <MoonPhase.h>
+#include <Scheduler.h>
+#include <TimeKeeper.h>
+#include <WiFi.h>
+#include <stdio.h>
+#include <chrono>
+
+#define SIM_DEFAULT_DAYS    (365)                       // Default length of simulation in days
+#define SIM_DEFAULT_START   (1735689600)                // Default start time: 2025-01-01 00:00 UTC
+#define SIM_SAMPLE_MICROS   (60000000ULL)               // Longest virtual time between loop() passes when idle
+#define SIM_MOVING_MICROS   (10000ULL)                  // Virtual time between loop() passes while motors move
+#define SIM_MIN_MICROS      (1000ULL)                   // Shortest virtual time between loop() passes
+#define SIM_BURN_IN_DAYS    (2)                         // Days the unit runs before being powered off, with --outage
+#define SIM_COIL_PIN_FIRST  (2)                         // First of the eight coil pins (as wired in Main.cpp)
+#define SIM_COB_PIN_FIRST   (10)                        // First of the two COB pins (likewise)
+#define SIM_PV_HOME_PIN     (12)                        // The pivot home sensor's pin (likewise)
+#define SIM_LS_HOME_PIN     (13)                        // The leadscrew home sensor's pin (likewise)
+#define SIM_MA_AWAKE        (25.0)                      // mA drawn by the Pico W with a core running flat out
+#define SIM_MA_ASLEEP       (8.0)                       // mA drawn with both cores asleep in __wfe()
+#define SIM_MA_WIFI         (45.0)                      // Extra mA drawn while WiFi is connected
+#define SIM_MA_COIL         (70.0)                      // mA drawn by an energized 28BYJ-48 coil
+#define SIM_MA_COB          (250.0)                     // mA drawn by a COB at 100% duty
+
+/****
+ * The parts of the firmware (Main.cpp) the simulator reaches into
+ ****/
+extern MoonDisplay display;
+extern CommandLine ui;
+extern Scheduler sched;
+extern TimeKeeper timeKeeper;
+extern int8_t phaseTask;
+extern int8_t timeTask;
+extern bool clockIsSet;
+int16_t moonPhaseAt(time_t t);
+
+/****
+ * Type definitions
+ ****/
+struct lunationStats_t {                                // Statistics gathered for one lunation
+    int32_t k;                                          // Meeus' lunation number
+    time_t start;                                       // True new moon that starts it
+    time_t end;                                         // True new moon that ends it
+    uint64_t pvSteps;                                   // Steps taken by the pivot motor
+    uint64_t lsSteps;                                   // Steps taken by the leadscrew motor
+    uint64_t movingMicros;                              // Virtual time during which a motor moved
+    uint32_t programs;                                  // Flash pages programmed
+    uint32_t erases;                                    // Flash sectors erased
+    uint32_t resets;                                    // Reset sweeps begun
+    double errMicros;                                   // Integral of |phase error| over time
+    double maxErr;                                      // Largest |phase error| seen
+    double mcuMAh;                                      // Charge drawn by the controller (mA·h)
+    double wifiMAh;                                     // Charge drawn by WiFi
+    double coilMAh;                                     // Charge drawn by the stepper coils
+    double cobMAh;                                      // Charge drawn by the COBs
+};
+
+/**
+ * @brief   Add what the unit draws over the specified span of virtual time, given its state at
+ *          the start of it, to the specified statistics
+ *
+ * @param s         The statistics
+ * @param moving    Whether the motors are moving
+ * @param micros    The span of virtual time
+ */
+static void accountEnergy(lunationStats_t &s, bool moving, uint64_t micros) {
+    double hours = micros / 3600000000.0;
+    uint8_t coils = 0;
+    for (uint8_t p = SIM_COIL_PIN_FIRST; p < SIM_COIL_PIN_FIRST + 8; p++) {
+        coils += halGetPinOut(p) != LOW;
+    }
+    double duty = (double)(halGetPinOut(SIM_COB_PIN_FIRST) + halGetPinOut(SIM_COB_PIN_FIRST + 1)) / IL_ANALOG_RANGE;
+    s.mcuMAh += (moving ? SIM_MA_AWAKE : SIM_MA_ASLEEP) * hours;
+    s.wifiMAh += (WiFi.status() == WL_CONNECTED ? SIM_MA_WIFI : 0.0) * hours;
+    s.coilMAh += coils * SIM_MA_COIL * hours;
+    s.cobMAh += duty * SIM_MA_COB * hours;
+}
+
+/**
+ * @brief   Work out when the next interesting thing happens: the next deadline of the phase or 
+ *          time task, or the next sample, whichever comes first, but not past the end
+ *
+ * @param now       The virtual time now
+ * @param end       The virtual time the run ends
+ * @return uint64_t The virtual time to advance to
+ */
+static uint64_t nextStep(uint64_t now, uint64_t end) {
+    uint64_t next = now + (display.isMoving() ? SIM_MOVING_MICROS : SIM_SAMPLE_MICROS);
+    for (int8_t task : {phaseTask, timeTask}) {
+        uint64_t due;
+        if (sched.deadline(task, due)) {
+            next = due > now && due < next ? due : next;
+        }
+    }
+    next = next < now + SIM_MIN_MICROS ? now + SIM_MIN_MICROS : next;
+    return next > end ? end : next;
+}
+
+/**
+ * @brief   Return the number of the true lunation, per Meeus' series, that the specified time is in
+ *
+ * @param t         The time
+ * @return int32_t  The lunation number
+ */
+static int32_t seriesLunationAt(time_t t) {
+    int32_t k = MoonPhase::lunationAt(t);
+    while (MoonPhase::computeNewMoon(k) > t) {
+        k--;
+    }
+    while (MoonPhase::computeNewMoon(k + 1) <= t) {
+        k++;
+    }
+    return k;
+}
+
+/**
+ * @brief   Print the statistics for one lunation
+ *
+ * @param s     The statistics
+ */
+static void printLunation(const lunationStats_t &s) {
+    char startStr[24];
+    strftime(startStr, sizeof(startStr), "%Y-%m-%d %H:%M", gmtime(&s.start));
+    double span = (double)(s.end - s.start) * 1000000.0;
+    printf("%6d  %s  %9llu  %9llu  %8.0f  %8u  %6u  %6u  %8.5f  %7.5f  %7.0f\n",
+        s.k, startStr, (unsigned long long)s.pvSteps, (unsigned long long)s.lsSteps,
+        s.movingMicros / 1000000.0, s.programs, s.erases, s.resets, s.errMicros / span, s.maxErr,
+        s.mcuMAh + s.wifiMAh + s.coilMAh + s.cobMAh);
+}
+
+int main(int argc, char *argv[]) {
+    double days = SIM_DEFAULT_DAYS;
+    time_t start = SIM_DEFAULT_START;
+    bool verbose = false;
+    bool track = false;
+    double offlineHours = 0;
+    double outageDays = 0;
+    double slipPpm = 0;
+    int32_t knock = 0;
+    double homeDays = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--days") == 0 && a + 1 < argc) {
+            days = strtod(argv[++a], nullptr);
+        } else if (strcmp(argv[a], "--start") == 0 && a + 1 < argc) {
+            start = (time_t)strtoll(argv[++a], nullptr, 10);
+        } else if (strcmp(argv[a], "--track") == 0) {
+            track = true;
+        } else if (strcmp(argv[a], "--verbose") == 0) {
+            verbose = true;
+        } else if (strcmp(argv[a], "--wifi-ms") == 0 && a + 1 < argc) {
+            halNetwork.wifiMillis = (uint32_t)strtoul(argv[++a], nullptr, 10);
+        } else if (strcmp(argv[a], "--ntp-ms") == 0 && a + 1 < argc) {
+            halNetwork.ntpMillis = (uint32_t)strtoul(argv[++a], nullptr, 10);
+        } else if (strcmp(argv[a], "--wifi-fails") == 0 && a + 1 < argc) {
+            halNetwork.wifiFailures = (uint32_t)strtoul(argv[++a], nullptr, 10);
+        } else if (strcmp(argv[a], "--offline") == 0 && a + 1 < argc) {
+            offlineHours = strtod(argv[++a], nullptr);
+        } else if (strcmp(argv[a], "--ppm") == 0 && a + 1 < argc) {
+            halNetwork.crystalPpm = strtod(argv[++a], nullptr);
+        } else if (strcmp(argv[a], "--outage") == 0 && a + 1 < argc) {
+            outageDays = strtod(argv[++a], nullptr);
+        } else if (strcmp(argv[a], "--slip") == 0 && a + 1 < argc) {
+            slipPpm = strtod(argv[++a], nullptr);
+        } else if (strcmp(argv[a], "--knock") == 0 && a + 1 < argc) {
+            knock = (int32_t)strtol(argv[++a], nullptr, 10);
+        } else if (strcmp(argv[a], "--home-days") == 0 && a + 1 < argc) {
+            homeDays = strtod(argv[++a], nullptr);
+        } else {
+            fprintf(stderr, "Usage: %s [--days <n>] [--start <time_t>] [--track] [--verbose] [--wifi-ms <n>]\n"
+                "          [--ntp-ms <n>] [--wifi-fails <n>] [--offline <hours>] [--ppm <n>] [--outage <days>]\n"
+                "          [--slip <ppm>] [--knock <steps>] [--home-days <days>]\n", argv[0]);
+            return 1;
+        }
+    }
+    auto wallStart = std::chrono::steady_clock::now();
+    halSetSerialOutput(verbose);
+    halSetSerialInput(false);
+    halSetSerialConnected(verbose);
+
+    // First boot: provision the unit, offlineHours before the real thing. No network, so nothing 
+    // moves.
+    uint32_t wifiFailures = halNetwork.wifiFailures;
+    halNetwork.wifiOk = false;
+    halNetwork.ntpOk = false;
+    halNetwork.wifiFailures = 0;
+    setup();
+    setup1();
+    char cmd[32];
+    time_t provisioned = start - (time_t)(offlineHours * 3600.0) - (outageDays > 0 ? SIM_BURN_IN_DAYS * 86400 : 0);
+    snprintf(cmd, sizeof(cmd), "assume %d", moonPhaseAt(provisioned));
+    ui.dispatch("wifi ssid simulated");
+    ui.dispatch("wifi pw simulated");
+    ui.dispatch("test off");
+    ui.dispatch(cmd);
+    ui.dispatch(track ? "track on" : "track off");
+    ui.dispatch("save");
+    loop1();
+
+    // The mechanism is where the display has just been told it is
+    const uint8_t pvPins[4] = {SIM_COIL_PIN_FIRST, SIM_COIL_PIN_FIRST + 1, SIM_COIL_PIN_FIRST + 2, SIM_COIL_PIN_FIRST + 3};
+    const uint8_t lsPins[4] = {SIM_COIL_PIN_FIRST + 4, SIM_COIL_PIN_FIRST + 5, SIM_COIL_PIN_FIRST + 6, SIM_COIL_PIN_FIRST + 7};
+    int8_t pvMotor = halAddMotor(pvPins, display.getPv());
+    int8_t lsMotor = halAddMotor(lsPins, display.getLs());
+    halSetMotorFlag(pvMotor, SIM_PV_HOME_PIN, MD_HOME_PV, MD_HOME_ACTIVE);
+    halSetMotorFlag(lsMotor, SIM_LS_HOME_PIN, MD_HOME_LS, MD_HOME_ACTIVE);
+    halSetMotorSlip(pvMotor, slipPpm);
+    halSetMotorSlip(lsMotor, slipPpm);
+
+    // With an outage to come, a boot in between, with the network up, to get the clock set, the 
+    // drift estimated and the time saved
+    if (outageDays > 0) {
+        halNetwork.wifiOk = true;
+        halNetwork.ntpOk = true;
+        halNetwork.ntpTime = provisioned - (time_t)(halMicros() / 1000000.0 / (1.0 + halNetwork.crystalPpm / 1000000.0));
+        setup();
+        setup1();
+        loop1();
+        uint64_t endMicros = halMicros() + SIM_BURN_IN_DAYS * 86400000000ULL;
+        while (halMicros() < endMicros) {
+            loop();
+            loop1();
+            halAdvanceTo(nextStep(halMicros(), endMicros));
+            loop1();
+        }
+        halNetwork.wifiOk = false;
+    }
+
+    // Second boot: the real thing. The network works, after a fashion, and NTP says it's "start"
+    // at boot. Time runs from there whether or not anybody knows what time it is. The true time 
+    // is what the simulated NTP server says it is. With an outage, the network only comes up 
+    // later.
+    halNetwork.wifiOk = outageDays == 0;
+    halNetwork.ntpOk = true;
+    halNetwork.wifiFailures = wifiFailures;
+    halNetwork.ntpTime = start - (time_t)(halMicros() / 1000000.0 / (1.0 + halNetwork.crystalPpm / 1000000.0));
+    halSlipMotor(pvMotor, knock);
+    halStats = {};
+    uint64_t bootMicros = halMicros();
+    time_t bootTime = start;
+    setup();
+    setup1();
+    loop1();
+    uint64_t setupMicros = halMicros() - bootMicros;
+    uint64_t clockSetMicros = 0;
+    uint64_t caughtUpMicros = 0;
+    uint64_t endMicros = halMicros() + (uint64_t)(days * 86400.0 * 1000000.0);
+    uint64_t outageEndMicros = bootMicros + (uint64_t)(outageDays * 86400.0 * 1000000.0);
+    lunationStats_t cur = {};
+    lunationStats_t total = {};
+    cur.k = seriesLunationAt(bootTime);
+    cur.start = MoonPhase::computeNewMoon(cur.k);
+    cur.end = MoonPhase::computeNewMoon(cur.k + 1);
+    int32_t lastPv = display.getPv();
+    int32_t lastLs = display.getLs();
+    bool wasResetting = display.getStatus().resetting;
+    uint32_t lastPrograms = halStats.flashPrograms;
+    uint32_t lastErases = halStats.flashErases;
+    uint32_t nLunations = 0;
+    total.maxErr = 0;
+    uint64_t nextHomeMicros = homeDays > 0 ? bootMicros + 86400000000ULL : UINT64_MAX;
+    uint32_t homings = 0;
+    uint32_t homeFailures = 0;
+    bool homing = false;
+    int32_t maxPvOff = 0;
+    int32_t maxLsOff = 0;
+
+    printf("Simulating %.1f days%s starting %s", days, track ? " in track mode" : "", asctime(gmtime(&bootTime)));
+    printf("     k  new moon (UTC)     pv steps   ls steps  moving s  programs  erases  resets  mean err  max err      mAh\n");
+    while (halMicros() < endMicros) {
+        loop();
+        loop1();
+        uint64_t now = halMicros();
+        time_t t = (time_t)(halNetworkUtcMicros() / 1000000);
+        halNetwork.wifiOk = halNetwork.wifiOk || now >= outageEndMicros;
+
+        // Roll over to the next lunation if need be
+        if (t >= cur.end) {
+            printLunation(cur);
+            nLunations++;
+            total.pvSteps += cur.pvSteps;
+            total.lsSteps += cur.lsSteps;
+            total.movingMicros += cur.movingMicros;
+            total.programs += cur.programs;
+            total.erases += cur.erases;
+            total.resets += cur.resets;
+            total.errMicros += cur.errMicros;
+            total.maxErr = cur.maxErr > total.maxErr ? cur.maxErr : total.maxErr;
+            total.mcuMAh += cur.mcuMAh;
+            total.wifiMAh += cur.wifiMAh;
+            total.coilMAh += cur.coilMAh;
+            total.cobMAh += cur.cobMAh;
+            cur = {};
+            cur.k = seriesLunationAt(t);
+            cur.start = MoonPhase::computeNewMoon(cur.k);
+            cur.end = MoonPhase::computeNewMoon(cur.k + 1);
+        }
+
+        // Home the display now and then, if asked to, and keep track of how well registered it is
+        mdStatus_t ds = display.getStatus();
+        if (homing && !ds.homing) {
+            homeFailures += ds.homeResult != MD_HOME_OK;
+        }
+        homing = ds.homing;
+        if (now >= nextHomeMicros && !ds.busy) {
+            ui.dispatch("home");
+            homings++;
+            nextHomeMicros = now + (uint64_t)(homeDays * 86400.0 * 1000000.0);
+        }
+        if (!ds.busy) {
+            int32_t pvOff = abs(ds.pv - halGetMotorPosition(pvMotor));
+            int32_t lsOff = abs(ds.ls - halGetMotorPosition(lsMotor));
+            maxPvOff = pvOff > maxPvOff ? pvOff : maxPvOff;
+            maxLsOff = lsOff > maxLsOff ? lsOff : maxLsOff;
+        }
+
+        // Work out when the next interesting thing happens and go there
+        bool moving = display.isMoving();
+        uint64_t next = nextStep(now, endMicros);
+        next = now < outageEndMicros && next > outageEndMicros ? outageEndMicros : next;
+
+        // Account for what the display shows between now and then
+        double truePhase = 60.0 * (double)(t - cur.start) / (double)(cur.end - cur.start);
+        double d = truePhase - display.getPhase();
+        d = d >= 30.0 ? d - 60.0 : d < -30.0 ? d + 60.0 : d;
+        double err = d < 0.0 ? -d : d > 1.0 ? d - 1.0 : 0.0;
+        if (clockSetMicros == 0 && clockIsSet) {
+            clockSetMicros = now - bootMicros;
+        }
+        if (caughtUpMicros == 0 && err == 0.0 && !moving) {
+            caughtUpMicros = now - bootMicros;
+        }
+        cur.errMicros += err * (double)(next - now);
+        cur.maxErr = err > cur.maxErr ? err : cur.maxErr;
+        accountEnergy(cur, moving, next - now);
+
+        halAdvanceTo(next);
+        loop1();
+
+        // Account for what the motors did
+        int32_t pv = display.getPv();
+        int32_t ls = display.getLs();
+        if (pv != lastPv || ls != lastLs) {
+            cur.pvSteps += pv > lastPv ? pv - lastPv : lastPv - pv;
+            cur.lsSteps += ls > lastLs ? ls - lastLs : lastLs - ls;
+            cur.movingMicros += next - now;
+            lastPv = pv;
+            lastLs = ls;
+        }
+        bool resetting = display.getStatus().resetting;
+        if (resetting && !wasResetting) {
+            cur.resets++;
+        }
+        wasResetting = resetting;
+        cur.programs += halStats.flashPrograms - lastPrograms;
+        lastPrograms = halStats.flashPrograms;
+        cur.erases += halStats.flashErases - lastErases;
+        lastErases = halStats.flashErases;
+    }
+    total.pvSteps += cur.pvSteps;
+    total.lsSteps += cur.lsSteps;
+    total.movingMicros += cur.movingMicros;
+    total.programs += cur.programs;
+    total.erases += cur.erases;
+    total.resets += cur.resets;
+    total.errMicros += cur.errMicros;
+    total.maxErr = cur.maxErr > total.maxErr ? cur.maxErr : total.maxErr;
+    total.mcuMAh += cur.mcuMAh;
+    total.wifiMAh += cur.wifiMAh;
+    total.coilMAh += cur.coilMAh;
+    total.cobMAh += cur.cobMAh;
+
+    double wallSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    printf("Totals: %u complete lunations, pv steps %llu, ls steps %llu, moving %.0f s, programs %u, "
+        "erases %u, resets %u, mean err %.5f, max err %.5f\n",
+        nLunations, (unsigned long long)total.pvSteps, (unsigned long long)total.lsSteps,
+        total.movingMicros / 1000000.0, total.programs, total.erases, total.resets,
+        total.errMicros / (days * 86400.0 * 1000000.0), total.maxErr);
+    printf("Boot: setup() took %.3f s, ", setupMicros / 1000000.0);
+    if (clockSetMicros == 0) {
+        printf("the clock was never set, ");
+    } else {
+        printf("clock set after %.3f s, ", clockSetMicros / 1000000.0);
+    }
+    if (caughtUpMicros == 0) {
+        printf("the display never showed the true phase\n");
+    } else {
+        printf("display showed the true phase after %.3f s\n", caughtUpMicros / 1000000.0);
+    }
+    tkStats_t ts = timeKeeper.getStats();
+    printf("Clock: %u syncs, off by %.3f ms at the end, drift estimated %+.3f ppm (actual %+.3f ppm)\n", 
+        (unsigned)ts.syncs, (timeKeeper.utcMicros() - halNetworkUtcMicros()) / 1000.0, ts.freqPpb / 1000.0, 
+        halNetwork.crystalPpm);
+    printf("Flash: busy for %.3f s with interrupts held off; the steppers' step stream ran dry %u times meanwhile\n", 
+        halStats.flashBusyMicros / 1000000.0, (unsigned)halStats.irqStarves);
+    printf("Mechanism: pv off by %d steps and ls by %d at the end (at worst %d and %d); %u and %u cycles lost; "
+        "%u homings, %u failed\n", (int)(display.getPv() - halGetMotorPosition(pvMotor)), 
+        (int)(display.getLs() - halGetMotorPosition(lsMotor)), (int)maxPvOff, (int)maxLsOff, 
+        (unsigned)halGetMotorSlips(pvMotor), (unsigned)halGetMotorSlips(lsMotor), (unsigned)homings, (unsigned)homeFailures);
+    printf("Energy: %.0f mA·h (%.0f mA mean): controller %.0f, WiFi %.0f, coils %.0f, COBs %.0f\n",
+        total.mcuMAh + total.wifiMAh + total.coilMAh + total.cobMAh,
+        (total.mcuMAh + total.wifiMAh + total.coilMAh + total.cobMAh) / (days * 24.0),
+        total.mcuMAh, total.wifiMAh, total.coilMAh, total.cobMAh);
+    printf("Simulated %.1f days in %.2f s of wall time.\n", days, wallSecs);
+    return 0;
+}
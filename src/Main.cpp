@@ -67,6 +67,11 @@
  * lit during the moon's waning phases. During the new-moon transition from phase 59 to phase 0, 
  * while the terminator is reset, neither light source is lit.
  * 
+ * In track mode ('track on'), rather than waiting for each phase change and moving the 
+ * terminator a whole phase at once, the display is told the phase in 1/256 phase units each time 
+ * that changes (every three minutes or so) and moves the terminator a step or two at a time to 
+ * keep up with the real moon.
+ * 
  *****
  * 
  * Copyright (C) 2024 D.L. Ehnebuske
@@ -88,10 +93,17 @@
  * 
  ****/
 #include <Arduino.h>                                    // Basic Arduino framework stuff
-#include <EEPROM.h>                                     // EEPROM emulation for the Pico
+#include <EEPROM.h>                                     // EEPROM emulation for the Pico (old saved configurations)
+#include <FlashJournal.h>                               // Wear-leveled persistent record store
 #include <WiFi.h>                                       // Pico WiFi support
 #include <CommandLine.h>                                // Terminal command line support
 #include <MoonDisplay.h>                                // The moon display mechanism
+#include <MoonPhase.h>                                  // The phase of the real moon
+#include <Scheduler.h>                                  // Sleep until there's something to do
+#include <PowerManager.h>                               // WiFi only when it's needed
+#include <Telemetry.h>                                  // Binary status frames over USB serial
+#include <OutputSink.h>                                 // Console output without the heap or the wait
+#include <TimeKeeper.h>                                 // Gets the time from the network in the background
 
 //#define DEBUG                                           // Uncomment to enable debug printing
 
@@ -99,13 +111,18 @@
 #define PAUSE_MILLIS        (500)                       // millis() to pause between various initialization retries
 #define BLINK_ON_MILLIS     (50)                        // millis() LED blinks on to show we're actually running
 #define BLINK_OFF_MILLIS    (10000)                     // millis() LED blinks off to show we're actually running
-#define SERIAL_WAIT_MS      (20000)                     // millis() to wait for Serial to begin before charging ahead
-#define WIFI_CONN_MAX_RETRY (3)                         // How many times to retry WiFi.begin() before giving up
-#define NTP_MAX_RETRY       (20)                        // How many times to retry getting the system clock set by NTP
-#define CONFIG_ADDR         (0)                         // Address of config structure in persistent memory
+#define CONSOLE_RETRY_MILLIS (10)                       // millis() to wait before trying again to drain the console
+#define TIME_SAVE_MILLIS    (3600000)                   // millis() between saves of the time, for warm starts
+#define TIME_RETRY_MILLIS   (60000)                     // millis() to put off saving the time while the display moves
+#define CONFIG_ADDR         (0)                         // Address of config structure in EEPROM (before the journal)
+#define JOURNAL_OFFSET      ((uint32_t)((uintptr_t)&_FS_start - XIP_BASE))  // The journal takes the filesystem region...
+#define JOURNAL_SECTORS     ((uint8_t)((&_FS_end - &_FS_start) / FLASH_SECTOR_SIZE))  // ...all of it (see platformio.ini)
+#define TAG_STATE           (0)                         // Journal tag for the whole of the nvState_t
+#define TAG_PHASE           (1)                         // Journal tag for just the displayed phase
+#define TAG_TRACK           (2)                         // Journal tag for whether we're in track mode
+#define TAG_TIME            (3)                         // Journal tag for the TimeKeeper's tkCache_t
+#define TAG_MOTION          (4)                         // Journal tag for the display's mdCheckpoint_t
 #define BANNER              "MoonDisplay V1.1.0"        // Hello World message
-#define LUNAR_MONTH         (29.53059)                  // The (average) length of the lunar cycle in days
-#define PHASE_MILLIS        (42524050)                  // The interval in ms between display phase changes (29.53059/60 days)
 
 #define TIMEZONE            "PST8PDT,M3.2.0,M11.1.0"    // Default time zone definition in POSIX format
 
@@ -126,46 +143,26 @@
 #define IL_IN2              (10)                        // Waning COB pin
 #define IL_IN3              (26)                        // Phototransistor pin
 
+// Home sensor pin definitions
+#define PV_HOME             (12)                        // Pivot home flag's optical sensor (active low)
+#define LS_HOME             (13)                        // Leadscrew home flag's optical sensor (active low)
+
 /****
  *  Type definitions
  ****/
-struct nvState_t {  // Type definition for configuration data stored in "EEPROM" (actually flash memory in the rp2040)
-    int16_t fingerprint;                // Value to tell whether EEPROM contents is ours
+struct nvState_t {  // Type definition for configuration data stored in the journal (in the rp2040's flash memory)
+    int16_t fingerprint;                // Value to tell whether stored contents is ours
     char ssid[33];                      // The WiFi SSID
     char pw[33];                        // The WiFi password
     char timezone[49];                  // The timezone in POSIX format
     int16_t curPhase;                   // The currently displayed phase
     boolean testing;                    // True if in testing mode false if running normally
 };
+static_assert(sizeof(nvState_t) <= FJ_MAX_LEN, "nvState_t is too big for a journal record");
 
 /****
  * Constants
  ****/
-// A tm structure defining a time that's earlier than now: Jan 1, 2024
-// Make it this way because C time_t values are, technically, opaque
-struct tm tmDawnOfHistory {
-    .tm_sec = 0,            // tm_sec is 0-based
-    .tm_min = 0,            // tm_min is 0-based
-    .tm_hour = 0,           // tm_hour is 0-based
-    .tm_mday = 1,           // tm_mday is 1-based
-    .tm_mon = 1 - 1,        // tm_mon is 0-based
-    .tm_year = 2024 - 1900, // tm_year is 1900-based
-    .tm_isdst = 0
-};
-const time_t dawnOfHistory = mktime(&tmDawnOfHistory);
-
-// There was a new moon at 22:57UTC on JUly 5, 2024. That's what we'll use as the first new moon
-struct tm tmFirstNewMoon {
-    .tm_sec = 0,            // tm_sec is 0-based
-    .tm_min = 57,           // tm_min is 0-based
-    .tm_hour = 22,          // tm_hour is 0-based
-    .tm_mday = 5,           // tm_mday is 1-based
-    .tm_mon = 7 - 1,        // tm_mon is 0-based
-    .tm_year = 2024 - 1900, // tm_year is 1900-based
-    .tm_isdst = 0
-};
-const time_t firstNewMoon = mktime(&tmFirstNewMoon);
-
 const nvState_t defaultState = {
     .fingerprint = FINGERPRINT,     // How we recognize the content as ours
     .ssid = "Set the SSID",         // Place holder for SSID
@@ -175,147 +172,432 @@ const nvState_t defaultState = {
     .testing = true                 // Default for whether we're in testing mode or not
 };
 
-// GPIO pins for pivot motor, leadscrew motor, and the Illuminator's two LED COBs and its phototransistor
+// GPIO pins for pivot motor, leadscrew motor, the Illuminator's two LED COBs and its phototransistor, 
+// and the home sensors
 const byte p[4] = {PV_IN1, PV_IN2, PV_IN3, PV_IN4};
 const byte l[4] = {LS_IN1, LS_IN2, LS_IN3, LS_IN4};
 const byte i[3] = {IL_IN1, IL_IN2, IL_IN3};
+const byte h[2] = {PV_HOME, LS_HOME};
+
+// Bounds of the flash region the linker script sets aside for a filesystem (whose size is 
+// board_build.filesystem_size in platformio.ini). The journal uses it instead.
+extern uint8_t _FS_start;
+extern uint8_t _FS_end;
 
 /****
  * Global variables
  ****/
-MoonDisplay display(p, l, i);                           // The moon phase display
+MoonDisplay display(p, l, i, h);                           // The moon phase display
 CommandLine ui;                                         // Command line interpreter object
-nvState_t state;                                        // Non-volatile (EEPROM) state
-unsigned long nextPhaseChangeMillis;                    // millis() at next phase change
+nvState_t state;                                        // Non-volatile (journaled) state
+nvState_t savedState;                                   // The state as last saved to the journal
+FlashJournal journal(JOURNAL_OFFSET, JOURNAL_SECTORS);  // Where the non-volatile state is kept
+Scheduler sched;                                        // Core 0's task scheduler
+Scheduler core1Sched;                                   // Core 1's scheduler (just for sleeping)
+PowerManager power;                                     // Turns WiFi on and off as needed
+MoonPhase moonPhase(MD_PHASES);                         // Works out the phase of the real moon
+MoonPhase moonPhaseFrac(MD_PHASES * MD_PHASE_FRAC);     // Works it out in track mode's finer units
+Telemetry telemetry;                                    // Sends status frames when asked to
+OutputSink console;                                     // Where command responses and the like are printed
+TimeKeeper timeKeeper;                                  // Keeps the system clock set and on time
+int8_t blinkTask;                                       // Scheduler task that blinks the watchdog LED
+int8_t phaseTask;                                       // Scheduler task that changes the displayed phase (or tracks it)
+int8_t telemetryTask;                                   // Scheduler task that sends telemetry frames
+int8_t consoleTask;                                     // Scheduler task that drains the console to Serial
+int8_t timeTask;                                        // Scheduler task that runs the TimeKeeper
+uint64_t nextBlinkMicros;                               // time_us_64() at next watchdog LED blink transition
+int64_t nextPhaseChangeUtc;                             // UTC (micros since the epoch) of the next phase change
+int64_t phaseTaskUtc;                                   // UTC (micros since the epoch) at which the phase task is to run
+uint32_t timeSyncs;                                     // The number of syncs the TimeKeeper had made at last look
+uint32_t timeSteps;                                     // The number of those that stepped the clock
+uint64_t nextTimeSaveMicros;                            // time_us_64() at which the time is next to be saved
+uint64_t nextTelemetryMicros;                           // time_us_64() at which the next telemetry frame is due
 boolean eStop;                                          // True if emergency stop needed, false otherwise
 bool haveSavedState;                                    // True if we have a saved state
-bool wifiIsUp;                                          // True if we got connected to Wifi
 bool clockIsSet;                                        // True if we managed to get the system clock set via WiFi, Internet and NTP
+boolean tracking;                                       // True if in track mode (journaled separately from state)
+boolean savedTracking;                                  // Whether we were in track mode as last saved
+mdCheckpoint_t checkpoint;                               // The display's latest checkpoint
+bool checkpointPending;                                 // True if it has yet to be saved
 
 /**
- * @brief   Returns true if a comes "before" b in modulo arithmetic. Basically, if it's shorter to
- *          go "forward" from a to b than it is to go "backward" from a to b.
+ * @brief   Save the whole of the non-volatile state. The phase goes first so that, if the power 
+ *          fails in between, what's restored at the next boot still has the right phase. Whether 
+ *          we're in track mode has a record of its own so that nvState_t, and with it the 
+ *          records earlier firmware saved, stays the same.
  * 
- * @param a
- * @param b 
- * @return  true    a comes before b
- * @return  false   a does not come before b
+ * @return true     Saved
+ * @return false    Unable to save
  */
-inline bool isBefore(unsigned long a, unsigned long b) {
-    return (a - b) > (b - a);
+bool saveState() {
+    if (!(journal.write(TAG_PHASE, &state.curPhase, sizeof(state.curPhase)) && 
+          journal.write(TAG_STATE, &state, sizeof(state)) &&
+          journal.write(TAG_TRACK, &tracking, sizeof(tracking)))) {
+        return false;
+    }
+    savedState = state;
+    savedTracking = tracking;
+    return true;
 }
 
 /**
- * @brief   Return the "moon age" in seconds at the specified time, t. I.e., the number of seconds 
- *          that have passed since the new moon previous to t
+ * @brief   Say whether the configuration has changed since it was last saved. The phase, which 
+ *          is saved on its own every time the display moves, doesn't count.
  * 
- * @param t         The time_t for which the moon age is required
- * @return int32_t  The age of the moon in seconds at t
+ * @return true     It has changed
+ * @return false    It hasn't
  */
-int32_t moonAgeSecsAt(time_t t) {
-    uint32_t secSinceFirstNewMoon = static_cast<uint32_t>(difftime(t, firstNewMoon));
-    // The number of seconds since the last new moon is mod(secSinceFirstNewMoon, <lunar month length in secs>)
-    return static_cast<int32_t>(secSinceFirstNewMoon % static_cast<int32_t>(LUNAR_MONTH * 86400));
+bool configChanged() {
+    return state.fingerprint != savedState.fingerprint || state.testing != savedState.testing ||
+           tracking != savedTracking || strcmp(state.ssid, savedState.ssid) != 0 ||
+           strcmp(state.pw, savedState.pw) != 0 || strcmp(state.timezone, savedState.timezone) != 0;
 }
 
 /**
- * @brief Get the phase (0-59) of the moon at the specifed time.
- * 
- * NB:  The specified time must be on or after firstNewMoon (22:57UTC on July 5, 2024).
+ * @brief Get the phase (0-59) of the moon at the specifed time. Each true lunation, new moon to 
+ *        new moon, is divided into 60 equal phases.
  * 
  * @param t         time_t time for which the phase is required
  * @return int16_t  The phase (0-59) at the specified time
  */
 int16_t moonPhaseAt(time_t t) {
-    // The required phase is 60 * <moon age in sec> / <length of the lunar month in sec> ('cause we're using 60 phases/lunation)
-    return static_cast<int16_t>(moonAgeSecsAt(t) / static_cast<int32_t>(LUNAR_MONTH * 1440.0));
+    return moonPhase.phaseAt(t);
 }
 
-unsigned long getNextPhaseChangeMillis() {
-    time_t now = time(nullptr);
-    int32_t millisSincePhaseChange = (moonAgeSecsAt(now) * 1000) - (moonPhaseAt(now) * PHASE_MILLIS);
-    int32_t nextPhaseChangeMillisFromNow = PHASE_MILLIS - millisSincePhaseChange;
-    return millis() + nextPhaseChangeMillisFromNow;
+/**
+ * @brief   Get the UTC time at which the moon's phase next changes. Phase changes are worked out 
+ *          in UTC and only turned into time_us_64() deadlines when they're scheduled, so that, 
+ *          as the TimeKeeper learns how the crystal drifts, they can be moved to match.
+ * 
+ * @return int64_t      The UTC (micros since the epoch) of the next phase change
+ */
+int64_t getNextPhaseChangeUtc() {
+    int64_t next;
+    moonPhase.phaseAtMicros(timeKeeper.utcMicros(), &next);
+    return next;
+}
+
+/**
+ * @brief   Get the UTC time at which the moon's phase, in track mode's 1/MD_PHASE_FRAC phase 
+ *          units, next changes.
+ * 
+ * @return int64_t      The UTC (micros since the epoch) of the next change
+ */
+int64_t getNextPhaseFracChangeUtc() {
+    int64_t next;
+    moonPhaseFrac.phaseAtMicros(timeKeeper.utcMicros(), &next);
+    return next;
 }
 
 /**
- * @brief Connect to the WiFi network using state.ssid for the SSID and state.pw for the password
+ * @brief   Set the time of the next phase change and, if the clock is set, schedule it. In track 
+ *          mode, the phase task runs each time the fractional phase changes, which is sooner.
  * 
- * @return true     Success
- * @return false    Failure
+ * @param at    The UTC (micros since the epoch) of the next phase change
  */
-bool connectToWifi() {
-    int8_t retryCount = 0;
-    while (WiFi.status() != WL_CONNECTED && retryCount < WIFI_CONN_MAX_RETRY) {
-        WiFi.begin(state.ssid, state.pw);
-        if (WiFi.status() != WL_CONNECTED) {
-            if (++retryCount >= WIFI_CONN_MAX_RETRY) {
-                return false;   // Give up on connecting to WiFi
-            }
+void schedulePhaseChange(int64_t at) {
+    nextPhaseChangeUtc = at;
+    if (clockIsSet) {
+        int64_t fracAt = tracking ? getNextPhaseFracChangeUtc() : at;
+        phaseTaskUtc = fracAt < at ? fracAt : at;
+        sched.at(phaseTask, timeKeeper.localMicrosAt(phaseTaskUtc));
+    }
+}
+
+/**
+ * @brief   Get the phase changes going from where the display is now: right away if it isn't 
+ *          showing the moon's phase (and isn't already on its way somewhere), otherwise when 
+ *          the phase next changes. For when the clock has been set or has jumped.
+ * 
+ */
+void catchUpWithMoon() {
+    if (state.testing || display.isMoving() || state.curPhase == moonPhaseAt(timeKeeper.now())) {
+        schedulePhaseChange(getNextPhaseChangeUtc());
+    } else {
+        schedulePhaseChange(timeKeeper.utcMicros());
+    }
+}
+
+/**
+ * @brief   Save the time, so that, if there's no network after the next reboot, the clock can be 
+ *          warm started from it. Writing to flash holds up core 1, so, if the display is moving, 
+ *          put it off for a bit instead.
+ * 
+ */
+void saveTime() {
+    if (display.isMoving()) {
+        nextTimeSaveMicros = time_us_64() + TIME_RETRY_MILLIS * 1000ULL;
+        return;
+    }
+    tkCache_t cache;
+    if (timeKeeper.getCache(cache) && !journal.write(TAG_TIME, &cache, sizeof(cache))) {
+        console.print("Unable to save the time.\n");
+    }
+    nextTimeSaveMicros = time_us_64() + TIME_SAVE_MILLIS * 1000ULL;
+}
+
+/**
+ * @brief   Scheduler task: Blink the watchdog LED to show we're actually running
+ * 
+ * @param ctx   Unused
+ */
+void onBlinkDue(void *ctx) {
+    if (!state.testing) {
+        if(digitalRead(LED) == HIGH) {
+            digitalWrite(LED, LOW);
+            nextBlinkMicros += BLINK_OFF_MILLIS * 1000ULL;
+        } else {
+            digitalWrite(LED, HIGH);
+            nextBlinkMicros += BLINK_ON_MILLIS * 1000ULL;
         }
+    } else {
+        nextBlinkMicros += BLINK_OFF_MILLIS * 1000ULL;
     }
-    return true;
+    sched.at(blinkTask, nextBlinkMicros);
 }
 
 /**
- * @brief   Get the time from an NTP server and set the Pico's system clock from that
+ * @brief   Scheduler task: The time for a new phase (or, in track mode, a new fractional phase) 
+ *          has arrived, deal with it
  * 
- * @return true     All went well
- * @return false    Couldn't get the time from an NTP server
+ * @param ctx   Unused
  */
-bool setSysTimeFromNTP() {
-    time_t now;
-    setenv("TZ", state.timezone, 1);               // Do POSIX ritual to make local time be our time zone
-    tzset();
-    NTP.begin("pool.ntp.org", "time.nist.gov");     // Set system clock with current epoch using NTP
-    int8_t retryCount = 0;
-    while ((now = time(nullptr)) < dawnOfHistory && ++retryCount < NTP_MAX_RETRY) {
-        delay(PAUSE_MILLIS);
+void onPhaseChangeDue(void *ctx) {
+    // if we're not testing, actually move the display
+    if (!state.testing && tracking) {
+        if (!display.trackPhase(moonPhaseFrac.phaseAtMicros(timeKeeper.utcMicros()))) {
+            console.print("Time to move the terminator along, but the display's command queue is full.\n");
+        }
+    } else if (!state.testing) {
+        int16_t phase = moonPhase.phaseAtMicros(timeKeeper.utcMicros());
+        // If something's already underway, we went off the rails somehow. Stop the world, it's time to get off!
+        if (!display.showPhase(phase)) {
+            console.print("Time for phase change, but things aren't all quiet. Stopping.\n");
+            display.stop();
+        }
     }
-    if (retryCount >= NTP_MAX_RETRY) {
-        return false;
+    schedulePhaseChange(getNextPhaseChangeUtc());
+}
+
+/**
+ * @brief   Scheduler task: Time for a telemetry frame; fill it in and send it
+ * 
+ * @param ctx   Unused
+ */
+void onTelemetryDue(void *ctx) {
+    if (telemetry.getPeriod() == 0) {
+        return;
     }
-    return true;
+    mdStatus_t s = display.getStatus();
+    schStats_t c0 = sched.getStats();
+    tlmFrame_t &f = telemetry.frame();
+    f.micros = time_us_64();
+    f.utc = (uint32_t)timeKeeper.now();
+    f.pv = s.pv;
+    f.ls = s.ls;
+    f.phase = s.phase;
+    f.tgtPhase = s.tgtPhase;
+    f.flags = (s.busy ? TLM_F_BUSY : 0) | (s.resetting ? TLM_F_RESETTING : 0) | (s.underway ? TLM_F_UNDERWAY : 0) |
+        (s.tracking ? TLM_F_TRACKING : 0) | (s.energized ? TLM_F_ENERGIZED : 0) | (power.wifiIsOn() ? TLM_F_WIFI : 0) |
+        (clockIsSet ? TLM_F_CLOCK_SET : 0) | (state.testing ? TLM_F_TESTING : 0);
+    f.ambient = s.ambient;
+    f.duty[0] = s.duty[0];
+    f.duty[1] = s.duty[1];
+    f.c0Passes = c0.passes;
+    f.c0BusyMicros = c0.busyMicros;
+    f.c0MaxMicros = c0.maxPassMicros;
+    f.c1Passes = s.runs;
+    f.c1BusyMicros = s.runMicros;
+    f.c1MaxMicros = s.maxRunMicros;
+    f.arrivals = (uint16_t)s.arrivals;
+    telemetry.send();
+    nextTelemetryMicros += telemetry.getPeriod() * 1000ULL;
+    sched.at(telemetryTask, nextTelemetryMicros);
 }
 
 /**
- * @brief Get the status of the device as a String
+ * @brief   Scheduler task, run on every wake: Let the ui do its thing. Characters arriving over 
+ *          USB come with an interrupt, which wakes us.
  * 
- * @return String   The device status
+ * @param ctx   Unused
  */
-String getStatus() {
-    String answer = 
-        String("WiFi is ") + (wifiIsUp ? "" : "not" ) + "connected, system clock is " + (clockIsSet ? "" : "not ") + 
-        "set, test is " + (state.testing ? "on.\n" : "off.\n");
+void onUiWake(void *ctx) {
+    ui.run();
+}
+
+/**
+ * @brief   Scheduler task, run on every wake: Move what's been printed to the console along to 
+ *          Serial. If Serial can't take all of it yet, try again in a bit.
+ * 
+ * @param ctx   Unused
+ */
+void onConsoleWake(void *ctx) {
+    if (console.drain()) {
+        sched.after(consoleTask, CONSOLE_RETRY_MILLIS);
+    }
+}
+
+/**
+ * @brief   Scheduler task, run on every wake: If the display has arrived at a new phase, save 
+ *          it, along with the rest of the configuration if that has changed since it was last 
+ *          saved. If it has asked for a checkpoint of where its motors are, save that too. Core 1 
+ *          signals an event when it arrives or asks, which wakes us.
+ * 
+ *          An erase holds core 1 up for far longer than the step words the motion engine has 
+ *          queued last, so, while the display is moving, a checkpoint is saved only if it can be 
+ *          without erasing anything. Otherwise it waits, superseded by any later one, until the 
+ *          display stops. And, while the display is stationary, the journal erases the sector 
+ *          it moves on to next ahead of time, so that it can.
+ * 
+ * @param ctx   Unused
+ */
+void onDisplayWake(void *ctx) {
+    int16_t newPhase = display.run();
+    if (newPhase != -1) {
+        state.curPhase = newPhase;
+        bool saved = configChanged() ? saveState() : journal.write(TAG_PHASE, &state.curPhase, sizeof(state.curPhase));
+        if (!saved) {
+            console.print("Moved to new phase, but unable to save!\n");
+        }
+    }
+    bool moving = display.isMoving();
+    if (display.checkpoint(checkpoint)) {
+        checkpointPending = true;
+    }
+    if (checkpointPending && (!moving || journal.fits(sizeof(checkpoint)))) {
+        checkpointPending = false;
+        if (!journal.write(TAG_MOTION, &checkpoint, sizeof(checkpoint))) {
+            console.print("Unable to save where the display's motors are!\n");
+        }
+    }
+    if (!moving) {
+        journal.prepare();
+    }
+}
+
+/**
+ * @brief   Scheduler task: Let the TimeKeeper move along getting the system clock set and 
+ *          keeping it on time. When it first has been set, start the phase changes and the 
+ *          watchdog blink. Until then, the display stays at the phase it had when it was last 
+ *          saved. After each later sync, move the pending phase task to where the corrected 
+ *          clock says it belongs, or, if the clock jumped, catch up with the moon. Once the 
+ *          clock is set, save the time after each sync and every TIME_SAVE_MILLIS.
+ * 
+ * @param ctx   Unused
+ */
+void onTimeDue(void *ctx) {
+    uint32_t wait = timeKeeper.run();
+    tkStats_t ts = timeKeeper.getStats();
+    if (!clockIsSet && timeKeeper.clockIsSet()) {
+        clockIsSet = true;
+        if (timeKeeper.clockIsSynced()) {
+            console.printf("System clock set %u ms after boot.\n", (unsigned)timeKeeper.getSetMillis());
+        } else {
+            console.print("System clock set from the time saved before the reboot. It's behind by however long the "
+                "power was off until the network can be reached.\n");
+        }
+        catchUpWithMoon();
+        nextBlinkMicros = time_us_64() + PAUSE_MILLIS * 1000ULL;
+        sched.at(blinkTask, nextBlinkMicros);
+        nextTimeSaveMicros = time_us_64();
+    } else if (clockIsSet && ts.syncs != timeSyncs) {
+        uint64_t due;
+        if (ts.steps != timeSteps) {
+            console.printf("System clock stepped by %d s.\n", (int)(ts.lastOffsetMicros / 1000000));
+            catchUpWithMoon();
+        } else if (sched.deadline(phaseTask, due)) {
+            sched.at(phaseTask, timeKeeper.localMicrosAt(phaseTaskUtc));
+        }
+        nextTimeSaveMicros = time_us_64();
+    }
+    if (clockIsSet && time_us_64() >= nextTimeSaveMicros) {
+        saveTime();
+    }
+    timeSyncs = ts.syncs;
+    timeSteps = ts.steps;
     if (clockIsSet) {
-        time_t now = time(nullptr);
+        uint32_t untilSave = (uint32_t)((nextTimeSaveMicros - time_us_64()) / 1000 + 1);
+        wait = wait == 0 || wait > untilSave ? untilSave : wait;
+    }
+    if (wait > 0) {
+        sched.after(timeTask, wait);
+    }
+}
+
+/**
+ * @brief   Print the status of the device to the console
+ * 
+ */
+void printStatus() {
+    console.printf("WiFi is %s (last connection attempt %s), system clock is %s, test is %s, track is %s.\n", 
+        power.wifiIsOn() ? "on" : "off", timeKeeper.lastConnectOk() ? "succeeded" : "failed", 
+        !clockIsSet ? "not set" : timeKeeper.clockIsSynced() ? "set" : "set from the saved time", 
+        state.testing ? "on" : "off", tracking ? "on" : "off");
+    switch (timeKeeper.getState()) {
+        case TK_OFF:
+            console.print("Not getting the time: there's no WiFi configuration.\n");
+            break;
+        case TK_CONNECTING:
+            console.printf("Getting the time: connecting to WiFi (try %u).\n", (unsigned)timeKeeper.getTries());
+            break;
+        case TK_SYNCING:
+            console.printf("Getting the time: asking NTP (try %u).\n", (unsigned)timeKeeper.getTries());
+            break;
+        case TK_BACKOFF:
+            console.printf("Getting the time: %u tries failed; trying again in %u s.\n", (unsigned)timeKeeper.getTries(), 
+                (unsigned)((timeKeeper.getRetryMillis() - millis()) / 1000));
+            break;
+        case TK_SYNCED:
+            console.printf("Got the time %u ms after boot; next sync in %u s.\n", (unsigned)timeKeeper.getSetMillis(), 
+                (unsigned)((timeKeeper.getRetryMillis() - millis()) / 1000));
+            break;
+    }
+    if (timeKeeper.clockIsSynced()) {
+        tkStats_t ts = timeKeeper.getStats();
+        int32_t ppb = ts.freqPpb < 0 ? -ts.freqPpb : ts.freqPpb;
+        console.printf("Clock synced %u times, last %u s ago: off by %d ms (round trip %u ms). Crystal drift %s%d.%03d ppm, "
+            "%d ms left to slew, syncing every %u s.\n", (unsigned)ts.syncs, (unsigned)((millis() - ts.lastSyncMillis) / 1000), 
+            (int)(ts.lastOffsetMicros / 1000), (unsigned)(ts.lastDelayMicros / 1000), ts.freqPpb < 0 ? "-" : "+", 
+            (int)(ppb / 1000), (int)(ppb % 1000), (int)(ts.slewMicros / 1000), (unsigned)(ts.resyncMillis / 1000));
+    }
+    console.printf("WiFi has been on %u times for a total of %u s.\n", 
+        (unsigned)power.getWifiSessions(), (unsigned)(power.getWifiOnMillis() / 1000));
+    if (clockIsSet) {
+        time_t now = timeKeeper.now();
         tm *nowTm = gmtime(&now);
-        int32_t secToPC = (nextPhaseChangeMillis - millis()) / 1000;
-        String hourPC = String(secToPC / 3600);
-        String minPC = String((secToPC % 3600) / 60);
-        String secPC = String(secToPC % 60);
-        answer += 
-            "At " + String(nowTm->tm_hour) + ":" + (nowTm->tm_min < 10 ? "0" : "") + 
-            String(nowTm->tm_min) + ":" + (nowTm->tm_sec < 10 ? "0" : "") + String(nowTm->tm_sec) + " UTC displayed moon phase is " + 
-            String(display.getPhase()) + "/60, actual moon phase is " + String(moonPhaseAt(now)) + "/60, next phase change is in " + 
-            hourPC + ":" + (minPC.length() < 2 ? "0" : "") + minPC + ":" + (secPC.length() < 2 ? "0" : "") + secPC + ".\n";
+        int32_t secToPC = (int32_t)((nextPhaseChangeUtc - timeKeeper.utcMicros()) / 1000000);
+        console.printf("At %d:%02d:%02d UTC displayed moon phase is %d/60, actual moon phase is %d/60 (%d%% lit, "
+            "elongation %d degrees), next phase change is in %d:%02d:%02d.\n", 
+            nowTm->tm_hour, nowTm->tm_min, nowTm->tm_sec, display.getPhase(), moonPhaseAt(now), 
+            (int)(moonPhase.illuminatedFractionAt(now) * 100.0 + 0.5), (int)(moonPhase.elongationAt(now) + 0.5), 
+            (int)(secToPC / 3600), (int)((secToPC % 3600) / 60), (int)(secToPC % 60));
     } else {
-        answer += "Displayed moon phase is " + String(display.getPhase()) + ".\n";
+        console.printf("Displayed moon phase is %d.\n", display.getPhase());
+    }
+    mdStatus_t ds = display.getStatus();
+    if (ds.homing) {
+        console.print("The display is homing.\n");
+    } else if (ds.homeResult == MD_HOME_OK) {
+        console.printf("When last homed, the pivot was off by %d steps and the leadscrew by %d.\n",
+            (int)ds.homePvOff, (int)ds.homeLsOff);
+    } else if (ds.homeResult != MD_HOME_NEVER) {
+        console.printf("The last homing failed: %s.\n", ds.homeResult == MD_HOME_NO_PV_FLAG ? "no pivot flag found" :
+            ds.homeResult == MD_HOME_NO_LS_FLAG ? "no leadscrew flag found" : "it was stopped");
     }
-    return answer;
 }
 
 /**
  * @brief help command handler: Display command summary
  * 
  * @param h         Pointer to CommandHandlerHelper object
- * @return String   The String to dsiplay
+ * @return String   Nothing; the response goes to the console
  */
 String onHelp(CommandHandlerHelper *h) {
-    return
+    console.print(
         "help                   Display this text to the user\n"
         "h                      Same as \"help\"\n"
         "assume <phase>         Assume display is showing phase <phase>\n"
+        "home                   Find the motors' home flags and re-register the display\n"
         "ls [<steps>]           Drive leadscrew by <steps>. + ==> out, - ==> in\n"
         "pv [<steps>]           Drive pivot by <steps>. + ==> CC, - ==> CW viewed from front\n"
         "save                   Save the current configuration data in persistent memory.\n"
@@ -325,13 +607,19 @@ String onHelp(CommandHandlerHelper *h) {
         "status                 Report on the system's status.\n"
         "stop                   Stop all motion immediately\n"
         "s                      Same as \"stop\"\n"
+        "sync                   Get the time from the network now\n"
         "test [on|off]          Set or print whether we're in test mode\n"
+        "tlm [<millis>|off]     Send binary telemetry frames every <millis> ms, stop\n"
+        "                       sending them, or print how it's going\n"
+        "track [on|off]         Set or print whether the terminator tracks the moon\n"
+        "                       continuously. Save to make persistent.\n"
         "tz [<POSIX tz>]        Set or display the POSIX-format timeszone to use.\n"
         "                       Save to make persistent.\n"
         "wifi pw <password>     Set the WiFi password to <password>.\n"
         "                       Save to make persistent.\n"
         "wifi ssid <ssid>       Set the WiFi SSID we should use to <ssid>\n"
-        "                       Save to make persistent.\n";
+        "                       Save to make persistent.\n");
+    return String();
 }
 
 /**
@@ -339,17 +627,18 @@ String onHelp(CommandHandlerHelper *h) {
  *          where we are and want to be.
  * 
  * @param h         CommandLineHelper to talk to command processor
- * @return String   What command processor should show to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onAssume(CommandHandlerHelper *h) {
     int16_t phase = h->getWord(1).toInt();
     if (phase < 0 || phase >= 60) {
-        return "Phase must be 0 .. 59\n";
+        console.print("Phase must be 0 .. 59\n");
+        return String();
     }
     state.curPhase = phase;
     display.assume(phase);
-    EEPROM.put(CONFIG_ADDR, state);
-    return String("Assumed display shows phase ") + String(phase) + String(EEPROM.commit() ? " and saved\n" : " but unable to save.\n");
+    console.printf("Assumed display shows phase %d%s", phase, saveState() ? " and saved\n" : " but unable to save.\n");
+    return String();
 }
 
 /**
@@ -357,15 +646,17 @@ String onAssume(CommandHandlerHelper *h) {
  *          but don't change thes location the motor thinks it's at
  * 
  * @param h         CommandLineHelper to talk to command processor
- * @return String   What command processor should show to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onLs(CommandHandlerHelper *h) {
     int32_t steps = h->getWord(1).toInt();
     if (steps == 0) {
-        return "Leadscrew position: " + String(display.getLs()) + " steps.\n";
+        console.printf("Leadscrew position: %d steps.\n", (int)display.getLs());
+        return String();
     }
     display.turnLs(steps);
-    return String("Driving leadscrew by ") + String(steps) + ".\n";
+    console.printf("Driving leadscrew by %d.\n", (int)steps);
+    return String();
 }
 
 /**
@@ -373,260 +664,387 @@ String onLs(CommandHandlerHelper *h) {
  *          but don't change the location the motor thinks it's at.
  * 
  * @param h         CommandLineHelper to talk to command processor
- * @return String   What command processor should show to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onPv(CommandHandlerHelper *h) {
     int32_t steps = h->getWord(1).toInt();
     if (steps == 0) {
-        return "Pivot position: " + String(display.getPv()) + " steps.\n";
+        console.printf("Pivot position: %d steps.\n", (int)display.getPv());
+        return String();
     }
     display.turnPv(steps);
-    return String("Driving pivot by ") + String(steps) + ".\n";
+    console.printf("Driving pivot by %d.\n", (int)steps);
+    return String();
 }
 
 /**
  * @brief   'save' command handler: Save the configuration data to persistent memory
  * 
  * @param h         The command handler helper we use to access what the user typed
- * @return String   The result to be displayed to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onSave(CommandHandlerHelper* h) {
-    EEPROM.put(CONFIG_ADDR, state);
-    return (EEPROM.commit() ? "Configuration saved\n" : "Configuration save failed.\n");
+    console.print(saveState() ? "Configuration saved\n" : "Configuration save failed.\n");
+    return String();
 }
 
 /**
  * @brief show <phase> command handler: Change display to show phase <phase>
  * 
  * @param h         CommandLineHelper to talk to command processor
- * @return String   What command processor should show to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onShow(CommandHandlerHelper *h) {
     int16_t phase = h->getWord(1).toInt();
     if (phase < 0 || phase >= 60) {
-        return "Phase to show must be 0 .. 59.\n";
+        console.print("Phase to show must be 0 .. 59.\n");
+        return String();
     }
     display.showPhase(phase);
-    return String("Changing to show phase ") + String(phase) + ".\n";
+    console.printf("Changing to show phase %d.\n", phase);
+    return String();
+}
+
+/**
+ * @brief   home command handler: Find the home flags' edges, take them to be where the motors 
+ *          are and go back to showing the current phase. The status command says how it went.
+ * 
+ * @param h         CommandLineHelper to talk to command processor
+ * @return String   Nothing; the response goes to the console
+ */
+String onHome(CommandHandlerHelper *h) {
+    if (!display.home()) {
+        console.print("The display is busy. Try again once it has stopped.\n");
+        return String();
+    }
+    console.print("Homing the display.\n");
+    return String();
 }
 
 /**
  * @brief status command handler: Report on the system's status
  * 
  * @param h         CommandLineHelper to talk to command processor
- * @return String   What command processor should show to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onStatus(CommandHandlerHelper *h) {
-    return getStatus();
+    printStatus();
+    return String();
 }
 
 /**
  * @brief stop and s command handler: Put us in an emergency stop state
  * 
  * @param h         CommandLineHelper to talk to command processor
- * @return String   What command processor should show to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onStop(CommandHandlerHelper *h) {
     display.stop();
-    return "Stopping.\n";
+    console.print("Stopping.\n");
+    return String();
+}
+
+/**
+ * @brief   sync command handler: Get the time from the network now rather than waiting for the 
+ *          next scheduled sync
+ * 
+ * @param h         CommandLineHelper to talk to command processor
+ * @return String   Nothing; the response goes to the console
+ */
+String onSync(CommandHandlerHelper *h) {
+    if (!timeKeeper.syncNow()) {
+        console.print("Can't get the time: there's no WiFi configuration.\n");
+        return String();
+    }
+    sched.at(timeTask, time_us_64());
+    console.print("Getting the time from the network.\n");
+    return String();
 }
 
 /**
  * @brief test on|off command handler: Turn test mode on or off
  * 
  * @param h         CommandLineHelper to talk to command processor
- * @return String   What command processor should show to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onTest(CommandHandlerHelper *h) {
     if(h->getWord(1).equalsIgnoreCase("on")) {
         state.testing = true;
-        return "Test mode on\n";
         digitalWrite(LED, LOW); // The watchdog doesn't blink in test mode, so, in case it's on...
+        console.print("Test mode on\n");
     } else if (h->getWord(1).equalsIgnoreCase("off")) {
         state.testing = false;
-        nextPhaseChangeMillis = millis();
-        return "Test mode off\n";
+        schedulePhaseChange(timeKeeper.utcMicros());
+        console.print("Test mode off\n");
     } else {
-        return String("Test mode is currently ") + (state.testing ? "on\n" : "off\n");
+        console.printf("Test mode is currently %s\n", state.testing ? "on" : "off");
     }
+    return String();
+}
+
+/**
+ * @brief   'tlm [<millis>|off]' command handler: Start or stop sending telemetry frames, or 
+ *          report on them
+ * 
+ * @param h         CommandLineHelper to talk to command processor
+ * @return String   Nothing; the response goes to the console
+ */
+String onTlm(CommandHandlerHelper *h) {
+    String arg = h->getWord(1);
+    if (arg.length() == 0) {
+        if (telemetry.getPeriod() == 0) {
+            console.print("Telemetry is off");
+        } else {
+            console.printf("Telemetry is every %u ms", (unsigned)telemetry.getPeriod());
+        }
+        console.printf("; %u frames sent, %u dropped.\n", (unsigned)telemetry.getSent(), (unsigned)telemetry.getDropped());
+        return String();
+    }
+    if (arg.equalsIgnoreCase("off")) {
+        telemetry.setPeriod(0);
+        sched.cancel(telemetryTask);
+        console.print("Telemetry off\n");
+        return String();
+    }
+    long period = arg.toInt();
+    if (period <= 0) {
+        console.print("Telemetry period must be a positive number of millis or 'off'.\n");
+        return String();
+    }
+    telemetry.setPeriod(period);
+    nextTelemetryMicros = time_us_64();
+    sched.at(telemetryTask, nextTelemetryMicros);
+    console.printf("Sending telemetry every %u ms\n", (unsigned)telemetry.getPeriod());
+    return String();
+}
+
+/**
+ * @brief track on|off command handler: Turn track mode on or off
+ * 
+ * @param h         CommandLineHelper to talk to command processor
+ * @return String   Nothing; the response goes to the console
+ */
+String onTrack(CommandHandlerHelper *h) {
+    if(h->getWord(1).equalsIgnoreCase("on")) {
+        tracking = true;
+        schedulePhaseChange(timeKeeper.utcMicros());
+        console.print("Track mode on\n");
+    } else if (h->getWord(1).equalsIgnoreCase("off")) {
+        tracking = false;
+        schedulePhaseChange(timeKeeper.utcMicros());
+        console.print("Track mode off\n");
+    } else {
+        console.printf("Track mode is currently %s\n", tracking ? "on" : "off");
+    }
+    return String();
 }
 
 /**
  * @brief   'tz [<POSIX tz>]' command handler: Set or display the POSIX-format timeszone to use
  * 
  * @param h         The command handler helper we use to access what the user typed
- * @return String   The result to be displayed to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onTz(CommandHandlerHelper* h) {
     String target = h->getWord(1);
     if (target.length() == 0) {
-        return String("Timezone is: '") + String(state.timezone) + "'.\n";
+        console.printf("Timezone is: '%s'.\n", state.timezone);
+        return String();
     }
     if (target.length() > sizeof(state.timezone) - 1) {
-        return String("timezone string must be less than ") + String(sizeof(state.timezone)) + String(" characters.\n");
+        console.printf("timezone string must be less than %u characters.\n", (unsigned)sizeof(state.timezone));
+        return String();
     }
     strcpy(state.timezone, target.c_str());
-    return String("Timezone set to '") + target + "'.\n";
+    console.printf("Timezone set to '%s'.\n", state.timezone);
+    return String();
 }
 
 /**
  * @brief   'wifi pw <password>' and 'wifi ssid <ssid>' commend handler: Set the WiFi password 
- *          or SSID to use to connect to the internet.
+ *          or SSID to use to connect to the internet. The password or SSID is the whole of the 
+ *          rest of the line, less leading and trailing whitespace, so it may contain spaces.
  * 
  * @param h         The command handler helper we use to access what the user typed
- * @return String   The result to be displayed to the user
+ * @return String   Nothing; the response goes to the console
  */
 String onWifi(CommandHandlerHelper* h) {
     String subCmd = h->getWord(1);
-    subCmd.toLowerCase();
     if (subCmd.length() == 0) {
-        return String("Wifi ssid: '") + String(state.ssid) + String("'\nWifi pw:   '") + String(state.pw) + "'\n";
+        console.printf("Wifi ssid: '%s'\nWifi pw:   '%s'\n", state.ssid, state.pw);
+        return String();
     }
-    if (!(subCmd.equals("pw") || subCmd.equals("ssid"))) {
-        return String("wifi command only knows about 'pw' and 'ssid'.\n");
+    bool isPw = subCmd.equalsIgnoreCase("pw");
+    if (!(isPw || subCmd.equalsIgnoreCase("ssid"))) {
+        console.print("wifi command only knows about 'pw' and 'ssid'.\n");
+        return String();
     }
-    String target = h->getCommandLine().substring(subCmd.length());
-    target = target.substring(target.indexOf(subCmd) + subCmd.length());
-    target.trim();
-    if (target.length() <= 0) {
-        return String("Can't set the WiFi ") + subCmd +  String(" to nothing at all.\n");
-    }
-    if (subCmd.equals("pw")) {
-        if (sizeof(state.pw) < target.length() + 1) {
-            return String("Maximum length of a password is ") + String(sizeof(state.pw) - 1) + String(" characters\n");
+
+    // Skip over the first two words and the whitespace around them, and trim what's left
+    String line = h->getCommandLine();
+    const char *target = line.c_str();
+    for (uint8_t w = 0; w < 2; w++) {
+        while (isspace((unsigned char)*target)) {
+            target++;
         }
-        strcpy(state.pw, target.c_str());
-    } else {
-        if (sizeof(state.ssid) < target.length() + 1) {
-            return String("Maximum length of an ssid is ") + String(sizeof(state.pw) - 1) + String(" characters\n");
+        while (*target != '\0' && !isspace((unsigned char)*target)) {
+            target++;
         }
-        strcpy(state.ssid, target.c_str());
     }
-    return String("Changed ") + subCmd + " to '" + target + "'.\n";
+    while (isspace((unsigned char)*target)) {
+        target++;
+    }
+    size_t len = strlen(target);
+    while (len > 0 && isspace((unsigned char)target[len - 1])) {
+        len--;
+    }
+    if (len == 0) {
+        console.printf("Can't set the WiFi %s to nothing at all.\n", isPw ? "pw" : "ssid");
+        return String();
+    }
+    char *dest = isPw ? state.pw : state.ssid;
+    if (len + 1 > (isPw ? sizeof(state.pw) : sizeof(state.ssid))) {
+        console.printf("Maximum length of %s is %u characters\n", isPw ? "a password" : "an ssid", 
+            (unsigned)((isPw ? sizeof(state.pw) : sizeof(state.ssid)) - 1));
+        return String();
+    }
+    memcpy(dest, target, len);
+    dest[len] = '\0';
+    console.printf("Changed %s to '%s'.\n", isPw ? "pw" : "ssid", dest);
+    return String();
 }
 
-
 void setup() {
     haveSavedState = true;          // Assume we'll succeed in retrieveing the state
-    wifiIsUp = false;               // Assume we'll fail in getting the WiFi up
-    clockIsSet = false;             // Assume we'll succeed in setting the system clock from NTP
+    clockIsSet = false;             // Until the TimeKeeper gets it set
+    timeSyncs = 0;
+    timeSteps = 0;
+    tracking = false;               // Unless the journal says otherwise
 
     // Init builtin LED
     pinMode(LED, OUTPUT);
-    digitalWrite(LED, HIGH);
+    digitalWrite(LED, LOW);
 
-    // Get Serial up and running
+    // Get Serial up and running. There's no waiting for a host to open the port: what's printed 
+    // to the console is kept until one does.
     Serial.begin(9600);
-    long msStart = millis();
-    while (!Serial && millis() - msStart < SERIAL_WAIT_MS) {
-        delay(PAUSE_MILLIS);
-        digitalWrite(LED, digitalRead(LED) == HIGH ? LOW : HIGH);
-    }
-    Serial.println(BANNER);
-    digitalWrite(LED, LOW);
+    console.print(BANNER "\n");
 
-    // Try to retrieve the configuration
-    EEPROM.begin(4096);
-    state = EEPROM.get(CONFIG_ADDR, state);
+    // Set up the scheduler and its tasks
+    sched.begin();
+    blinkTask = sched.addTask(onBlinkDue);
+    phaseTask = sched.addTask(onPhaseChangeDue);
+    telemetryTask = sched.addTask(onTelemetryDue);
+    sched.addTask(onUiWake, nullptr, true);
+    sched.addTask(onDisplayWake, nullptr, true);
+    consoleTask = sched.addTask(onConsoleWake, nullptr, true);
+    timeTask = sched.addTask(onTimeDue);
+
+    // Try to retrieve the configuration from the journal. The phase is journaled separately 
+    // each time the display moves, so it's likely newer than the one in the state record. If 
+    // there's no journal yet, fall back to what earlier firmware may have left in EEPROM.
+    bool journaled = journal.begin() && journal.read(TAG_STATE, &state, sizeof(state));
+    if (journaled) {
+        journal.read(TAG_PHASE, &state.curPhase, sizeof(state.curPhase));
+        journal.read(TAG_TRACK, &tracking, sizeof(tracking));
+        savedState = state;
+        savedTracking = tracking;
+    } else {
+        EEPROM.begin(4096);
+        state = EEPROM.get(CONFIG_ADDR, state);
+    }
     if (state.fingerprint != FINGERPRINT) {
         state = defaultState;
-        Serial.println("There's no stored configuration data; we won't be able to connect to WiFi.");
+        console.print("There's no stored configuration data; we won't be able to connect to WiFi.\n");
         haveSavedState = false;
+    } else if (!journaled && !saveState()) {
+        console.print("Unable to move the saved configuration from EEPROM to the journal.\n");
     }
 
     // Initialize the command interpreter
     if (!(
         ui.attachCmdHandler("help", onHelp) && ui.attachCmdHandler("h", onHelp) &&
         ui.attachCmdHandler("assume", onAssume) &&
+        ui.attachCmdHandler("home", onHome) &&
         ui.attachCmdHandler("ls", onLs) && 
         ui.attachCmdHandler("pv", onPv) &&
         ui.attachCmdHandler("save", onSave) &&
         ui.attachCmdHandler("show", onShow) &&
         ui.attachCmdHandler("status", onStatus) &&
         ui.attachCmdHandler("stop", onStop) && ui.attachCmdHandler("s", onStop) &&
+        ui.attachCmdHandler("sync", onSync) &&
         ui.attachCmdHandler("test", onTest) &&
+        ui.attachCmdHandler("tlm", onTlm) &&
+        ui.attachCmdHandler("track", onTrack) &&
         ui.attachCmdHandler("tz", onTz) &&
         ui.attachCmdHandler("wifi", onWifi)
     )) {
-        Serial.print("Too many command handlers.\n");
-    }
-
-    // Connect to WiFi if we have a saved config
-    if (haveSavedState) {
-        Serial.printf(String("Attempting to connect to WiFi with ssid '%s'.\n").c_str(), state.ssid);
-        wifiIsUp = connectToWifi();
+        console.print("Too many command handlers.\n");
     }
 
-    // Initialize time of day if WiFi is up
-    if (wifiIsUp) {
-        Serial.println("Successfully connected to WiFi. Getting time from NTP server.");
-        clockIsSet = setSysTimeFromNTP();
+    // Start the display right away, from where its motors were when they were last saved, or, 
+    // failing that, at the phase it was showing. If it was in the middle of a move, it picks up 
+    // where it left off.
+    console.print("Initializing the display.\n");
+    mdCheckpoint_t cp;
+    if (journaled && journal.read(TAG_MOTION, &cp, sizeof(cp)) && display.resume(cp)) {
+        state.curPhase = cp.curPhase;
+        if (cp.underway || cp.resetting || cp.curPhase != cp.tgtPhase) {
+            console.printf("Resuming the interrupted move from phase %d to phase %d.\n", 
+                cp.curPhase, cp.resetting ? cp.resetTgt : cp.tgtPhase);
+        }
     } else {
-        Serial.println("Unable to connect to WiFi.");
+        display.begin(state.curPhase);
     }
 
-    if (clockIsSet) {
-        Serial.println("System clock set successfully.");
-    } else {
-        Serial.println("Couldn't initialize the system clock from the internet, hopefully for obvious reasons.");
+    // Get the time from the network in the background, if we have a saved config. Once the 
+    // clock is set, onTimeDue() catches the display up with the moon.
+    setenv("TZ", state.timezone, 1);                // Do POSIX ritual to make local time be our time zone
+    tzset();
+    power.begin(state.ssid, state.pw);
+    timeKeeper.begin(&power);
+    // Meanwhile, if the time was saved before the reboot, start from that.
+    tkCache_t cache;
+    bool seeded = journaled && journal.read(TAG_TIME, &cache, sizeof(cache)) && timeKeeper.seed(cache);
+    if (haveSavedState) {
+        console.printf("Getting the time in the background using WiFi ssid '%s'.\n", state.ssid);
+        timeKeeper.start();
     }
-
-    // Initialize the display
-    Serial.println("Initializing the display.");
-    display.begin(state.curPhase);
-    if (clockIsSet) {
-        time_t now = time(nullptr);
-        if (state.testing || state.curPhase == moonPhaseAt(now)) {
-            nextPhaseChangeMillis = getNextPhaseChangeMillis();
-        } else {
-            nextPhaseChangeMillis = millis();
-        }
+    if (haveSavedState || seeded) {
+        sched.at(timeTask, time_us_64());
     }
 
     // Show we're ready to go
-    Serial.print(getStatus());
-    Serial.print("Type 'h' or 'help' for a command summary.\n");
+    printStatus();
+    console.print("Type 'h' or 'help' for a command summary.\n");
 }
 
+/**
+ * @brief   Core 0 loop: Run whatever tasks are ready, then sleep until the next one is due or 
+ *          something wakes us.
+ * 
+ */
 void loop() {
-    static unsigned long nextBlinkMillis = millis() + PAUSE_MILLIS;
-    // If we're actually running, deal with blinking the watchdog LED
-    if (clockIsSet && isBefore(nextBlinkMillis, millis())) {
-        if (!state.testing) {
-            if(digitalRead(LED) == HIGH) {
-                digitalWrite(LED, LOW);
-                nextBlinkMillis += BLINK_OFF_MILLIS;
-            } else {
-                digitalWrite(LED, HIGH);
-                nextBlinkMillis += BLINK_ON_MILLIS;
-            }
-        } else {
-            nextBlinkMillis += BLINK_OFF_MILLIS;
-        }
-    }
-     // Let the ui and the display do their thing
-    ui.run();
-    int16_t newPhase = display.run();
-    if (newPhase != -1) {
-        state.curPhase = newPhase;
-        EEPROM.put(CONFIG_ADDR, state);
-        if(!EEPROM.commit()) {
-            Serial.println("Moved to new phase, but unable to save!");
-        }
-    }
+    sched.run();
+}
 
-    // If the time for a new phase has arrived, deal with it
-    if (clockIsSet && isBefore(nextPhaseChangeMillis, millis())) {
-        // if we're not testing, actually move the display
-        if (!state.testing ) {
-            time_t now = time(nullptr);
-            int16_t phase = moonPhaseAt(now);
-            // If something's already underway, we went off the rails somehow. Stop the world, it's time to get off!
-            if (!display.showPhase(phase)) {
-                Serial.println("Time for phase change, but things aren't all quiet. Stopping.");
-                display.stop();
-            }
-        }
-        nextPhaseChangeMillis = getNextPhaseChangeMillis();
-    }
+/**
+ * @brief   Core 1 setup. Core 1 is dedicated to the display's motion. The only thing to set up 
+ *          here is its scheduler, so that its wake-up alarm interrupts core 1. The display 
+ *          initializes its hardware on core 1 when it carries out the begin command setup() 
+ *          posts.
+ * 
+ */
+void setup1() {
+    core1Sched.begin();
+}
+
+/**
+ * @brief   Core 1 loop: Let the display carry out its commands and run the mechanism, then 
+ *          sleep until it next needs to, a command arrives or an interrupt happens.
+ * 
+ */
+void loop1() {
+    display.runMotion();
+    core1Sched.sleepUntil(display.getWakeMicros());
 }
@@ -0,0 +1,122 @@
+/****
+ * @file test_main.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * Host tests for the MoonDisplay library's integer calibration curve, pvToLs(), and its
+ * compile-time table of the motor positions for each phase. They check both against the
+ * floating point functions they replaced, which are reproduced here as they were:
+ *
+ *      pio test -e native -f test_calibration
+ *
+ * The only disagreements allowed are where the exact value of the curve is a whole number of
+ * steps and floating point rounding left the old function just short of it, so that truncation
+ * took it down a step. That happens at |pv| = 1400 and 1600, and nowhere else. Beyond the
+ * calibrated range, where the old function went on along the parabola and the integer one
+ * would eventually overflow, pvToLs() holds steady at the value at the end of the range.
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+
+#include <unity.h>
+#include <MoonDisplay.h>
+
+static const float phasePva[MD_PHASES] = {   // Pivot angle (degrees) for each phase, as it was
+    -78, -78, -75.5, -73.5, -71, -67, -63,  -58,  -53, -47,
+    -40, -33, -25,   -18,   -10,  10,  18,   25,   33,  40,
+     47,  53,  58,    63,    67,  71,  73.5, 75.5, 78,  78,
+    -78, -78, -75.5, -73.5, -71, -67, -63,  -58,  -53, -47,
+    -40, -33, -25,   -18,   -10,  10,  18,   25,   33,  40,
+     47,  53,  58,    63,    67,  71,  73.5, 75.5, 78,  78
+};
+
+static int32_t oldPvToLs(int32_t pv) {
+    return pv >= 0 ? (int32_t)(497671.0 + 30.5 * pv - 0.201 * pv * pv) : (int32_t)(497671.0 - 30.5 * pv - 0.201 * pv * pv);
+}
+
+static int32_t oldDegToPv(float angle) {
+    return (int32_t)(20.48 * angle);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief   pvToLs() agrees with the floating point curve at every pivot position in the
+ *          calibrated range, except, by a step, at the four where it's exact
+ */
+void testPvToLsAgrees() {
+    uint32_t exceptions = 0;
+    for (int32_t pv = -MD_CAL_MAX_PV; pv <= MD_CAL_MAX_PV; pv++) {
+        int32_t diff = MoonDisplay::pvToLs(pv) - oldPvToLs(pv);
+        if (diff != 0) {
+            int32_t a = pv >= 0 ? pv : -pv;
+            TEST_ASSERT_TRUE_MESSAGE(a == 1400 || a == 1600, "Disagrees away from |pv| = 1400 and 1600");
+            TEST_ASSERT_EQUAL_INT32(1, diff);
+            exceptions++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, exceptions);
+}
+
+/**
+ * @brief   Past the calibrated range, however far, pvToLs() stays at the value at its end
+ */
+void testPvToLsBeyondRange() {
+    int32_t lsAtEnd = MoonDisplay::pvToLs(MD_CAL_MAX_PV);
+    for (int32_t pv = MD_CAL_MAX_PV + 1; pv <= 4 * MD_CAL_MAX_PV; pv++) {
+        TEST_ASSERT_EQUAL_INT32(lsAtEnd, MoonDisplay::pvToLs(pv));
+        TEST_ASSERT_EQUAL_INT32(lsAtEnd, MoonDisplay::pvToLs(-pv));
+    }
+    TEST_ASSERT_EQUAL_INT32(lsAtEnd, MoonDisplay::pvToLs(INT32_MAX));
+    TEST_ASSERT_EQUAL_INT32(lsAtEnd, MoonDisplay::pvToLs(INT32_MIN));
+}
+
+/**
+ * @brief   The phase targets are bit for bit what degToPv() and pvToLs() used to compute at run
+ *          time. begin() publishes the target for the phase it's given, so that's where to
+ *          look.
+ */
+void testPhaseTargetsAgree() {
+    const byte p[4] = {2, 3, 4, 5};
+    const byte l[4] = {6, 7, 8, 9};
+    const byte i[3] = {11, 10, 26};
+    const byte h[2] = {12, 13};
+    MoonDisplay display(p, l, i, h);
+    for (int16_t phase = 0; phase < MD_PHASES; phase++) {
+        int32_t pv = oldDegToPv(phasePva[phase]);
+        TEST_ASSERT_EQUAL_INT32(pv, MoonDisplay::degToPv(phasePva[phase]));
+        display.begin(phase);
+        TEST_ASSERT_EQUAL_INT32(pv, display.getPv());
+        TEST_ASSERT_EQUAL_INT32(oldPvToLs(pv), display.getLs());
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(testPvToLsAgrees);
+    RUN_TEST(testPvToLsBeyondRange);
+    RUN_TEST(testPhaseTargetsAgree);
+    return UNITY_END();
+}
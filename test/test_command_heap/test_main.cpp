@@ -0,0 +1,197 @@
+/****
+ * @file test_main.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * Host tests that the command handlers in Main.cpp don't use the heap. malloc(), calloc(),
+ * realloc() and operator new are wrapped so that every allocation made while they're counting
+ * is counted. The firmware is started up as on the Pico, and then each command is dispatched,
+ * the way the CommandLine library does it when a line is typed, followed by a pass through
+ * loop() to drain the response to Serial. Each command with short arguments, response and
+ * all, must make no allocations at all:
+ *
+ *      pio test -e native -f test_command_heap
+ *
+ * That only holds for short arguments. The handlers get their arguments from the CommandLine
+ * library as Strings, and a String longer than it can hold without a trip to the heap (11
+ * characters on the Pico, 15 on the host) is allocated. So a long time zone costs an
+ * allocation, and so does setting the WiFi SSID or password, which are read from the whole
+ * command line. The last test documents that.
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+
+#include <unity.h>
+#include <Arduino.h>
+#include <NativeHal.h>
+#include <CommandLine.h>
+#include <new>
+
+// glibc's own allocator, which the wrappers pass the calls on to
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void __libc_free(void *p);
+
+static bool counting = false;                   // Whether allocations are being counted
+static uint32_t allocs;                         // How many there have been while they were
+
+extern "C" void *malloc(size_t size) {
+    allocs += counting;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+    allocs += counting;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *p, size_t size) {
+    allocs += counting;
+    return __libc_realloc(p, size);
+}
+
+void *operator new(size_t size) {
+    allocs += counting;
+    void *answer = __libc_malloc(size == 0 ? 1 : size);
+    if (answer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return answer;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    __libc_free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    __libc_free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept {
+    __libc_free(p);
+}
+
+void operator delete[](void *p, size_t size) noexcept {
+    __libc_free(p);
+}
+
+/****
+ * The parts of the firmware (Main.cpp) the test reaches into
+ ****/
+extern CommandLine ui;
+
+/**
+ * @brief   Dispatch the specified command line, run loop(), and return the number of allocations
+ *          that made
+ *
+ * @param cmdLine       The command line
+ * @return uint32_t     The number of allocations
+ */
+static uint32_t allocsFor(const char *cmdLine) {
+    allocs = 0;
+    counting = true;
+    bool known = ui.dispatch(cmdLine);
+    loop();
+    counting = false;
+    TEST_ASSERT_TRUE_MESSAGE(known, cmdLine);
+    return allocs;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief   The wrappers count what they're supposed to
+ */
+void testCounting() {
+    allocs = 0;
+    counting = true;
+    char *p = new char[100];
+    void *q = malloc(100);
+    counting = false;
+    delete[] p;
+    free(q);
+    TEST_ASSERT_EQUAL_UINT32(2, allocs);
+}
+
+/**
+ * @brief   Commands that report make no allocations
+ */
+void testReports() {
+    const char *cmds[] = {"help", "h", "status", "show 5", "test", "tlm", "track", "tz", "wifi"};
+    for (const char *cmd : cmds) {
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, allocsFor(cmd), cmd);
+    }
+}
+
+/**
+ * @brief   Commands that change things make no allocations
+ */
+void testChanges() {
+    const char *cmds[] = {
+        "test on", "assume 12", "ls 100", "stop", "pv -100", "s", "home", "stop", "track on",
+        "track off", "tlm 1000", "tlm off", "tz EST5EDT", "save", "sync", "test off", "wifi bogus",
+        "wifi pw x"
+    };
+    for (const char *cmd : cmds) {
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, allocsFor(cmd), cmd);
+    }
+}
+
+/**
+ * @brief   Commands with arguments too long for a String to hold without the heap do allocate.
+ *          This documents the limit rather than asking for it: if one of these stops allocating,
+ *          the README's note on it can go.
+ */
+void testLongArguments() {
+    const char *cmds[] = {
+        "tz America/Los_Angeles", "wifi ssid The Network With A Long Name", "wifi pw a long password"
+    };
+    for (const char *cmd : cmds) {
+        TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(0, allocsFor(cmd), cmd);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, allocsFor("tz EST5EDT"));
+}
+
+int main(int argc, char **argv) {
+    halSetSerialOutput(false);
+    halSetSerialInput(false);
+    halNetwork.wifiOk = false;
+    halNetwork.ntpOk = false;
+    setup();
+    setup1();
+    loop();
+
+    UNITY_BEGIN();
+    RUN_TEST(testCounting);
+    RUN_TEST(testReports);
+    RUN_TEST(testChanges);
+    RUN_TEST(testLongArguments);
+    return UNITY_END();
+}
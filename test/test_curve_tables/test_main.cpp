@@ -0,0 +1,108 @@
+/****
+ * @file test_main.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * Host tests for the Illuminator library's integer math: its compile-time Q15 tables -- the
+ * ambient light factor and the gamma curve -- and the integer averaging readAmbient() does over
+ * the sample ring. They check each against the floating point expression it stands in for,
+ * reproduced here as the firmware had it before (the gamma curve is pow(x, IL_GAMMA)), evaluated
+ * in single precision as it was on the Pico:
+ *
+ *      pio test -e native -f test_curve_tables
+ *
+ * Every table entry is within half a unit in the last place (2^-15) of the float curve, which
+ * is to say it's the float curve rounded to Q15. Every possible sum of a ring's worth of
+ * samples averages to exactly the level the float expression gave.
+ *
+ * The tables' run-time cost against the float expressions' is measured by the benchmark in
+ * tools/Benchmark.cpp.
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+
+#include <unity.h>
+#include <Illuminator.h>
+#include <math.h>
+
+static float oldAmbientFactor(int16_t ambPct) {
+    float answer = (ambPct - IL_AMB_LOWEST) * 100.0 / (IL_AMB_HIGHEST - IL_AMB_LOWEST);
+    answer = answer > 100.0 ? 100.0 : answer < 0.0 ? 0.0 : answer;
+    answer = log10(1 + IL_AMB_COEFF * answer) / log10(1 + IL_AMB_COEFF * 100.0);
+    return answer;
+}
+
+static float oldGamma(uint16_t i) {
+    return powf((float)i / (1 << IL_GAMMA_BITS), (float)IL_GAMMA);
+}
+
+static int16_t oldAmbientForSum(uint32_t sum) {
+    float sensorReading = sum;
+    return static_cast<int16_t>(100 - ((sensorReading * 100) / (IL_ADC_RING_LEN * IL_ANALOG_FULLSCALE)));
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief   Every entry of the ambient factor table is the float factor in Q15
+ */
+void testAmbientFactor() {
+    for (int16_t amb = 0; amb <= 100; amb++) {
+        float q15 = oldAmbientFactor(amb) * IL_FACTOR_ONE;
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, q15, (float)Illuminator::ambientFactorFor(amb));
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, Illuminator::ambientFactorFor(-1));
+    TEST_ASSERT_EQUAL_UINT16(IL_FACTOR_ONE, Illuminator::ambientFactorFor(101));
+}
+
+/**
+ * @brief   Every entry of the gamma table is the float gamma curve in Q15
+ */
+void testGammaCurve() {
+    for (uint16_t i = 0; i <= 1 << IL_GAMMA_BITS; i++) {
+        float q15 = oldGamma(i) * IL_FACTOR_ONE;
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, q15, (float)Illuminator::gammaFor(i));
+    }
+}
+
+/**
+ * @brief   Every sum of a ring's worth of samples averages to the float expression's level
+ */
+void testAmbientAveraging() {
+    const uint32_t fullSum = (uint32_t)IL_ADC_RING_LEN * IL_ANALOG_FULLSCALE;
+    for (uint32_t sum = 0; sum <= fullSum; sum++) {
+        TEST_ASSERT_EQUAL_INT16(oldAmbientForSum(sum), Illuminator::ambientForSum(sum));
+    }
+    TEST_ASSERT_EQUAL_INT16(100, Illuminator::ambientForSum(0));
+    TEST_ASSERT_EQUAL_INT16(0, Illuminator::ambientForSum(fullSum));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(testAmbientFactor);
+    RUN_TEST(testGammaCurve);
+    RUN_TEST(testAmbientAveraging);
+    return UNITY_END();
+}
@@ -0,0 +1,234 @@
+/****
+ * @file test_main.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * Host tests for the Illuminator library's fades. The fade alarm is one of NativeHal's
+ * hardware alarms, which fire at exactly their target as the virtual clock is advanced, so the
+ * tests can look at the COBs' PWM levels at every step of a fade:
+ *
+ *      pio test -e native -f test_fades
+ *
+ * A fade takes IL_FADE_MILLIS in steps of IL_FADE_TICK_MICROS, each of which is checked against
+ * the fade worked out in floating point: the perceived brightness moves linearly from where it
+ * was to where it's going, and the duty cycle is that brightness to the power IL_GAMMA. It
+ * lands on the new duty cycle exactly, on time, and then the alarm is left disarmed. A fade
+ * cancelled midway turns back from wherever it had got to, without a jump, and one cancelled
+ * with fades turned off jumps straight to the new duty cycle.
+ *
+ * On the Pico, setDuty() and the alarm's interrupt handler race: setDuty() may run just before
+ * or just after a step, or just as the last step finds nothing left to do and leaves the alarm
+ * disarmed. The host has no interrupts, but setDuty() can be called a microsecond before a
+ * step and at the instant just after it, which are the two orders the race can come out in.
+ * Either way, the fade must carry on from where it was and run to the end.
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+
+#include <unity.h>
+#include <Arduino.h>
+#include <NativeHal.h>
+#include <Illuminator.h>
+#include <math.h>
+
+#define FT_WAXING_PIN   (11)                    // The waxing COB's pin (as in Main.cpp)
+#define FT_WANING_PIN   (10)                    // The waning COB's pin
+#define FT_SENSOR_PIN   (26)                    // The phototransistor's pin
+#define FT_LIT_PHASE    (10)                    // A phase at which only the waxing COB is lit
+#define FT_DARK_PHASE   (0)                     // A phase at which neither is
+#define FT_TICK         ((uint64_t)IL_FADE_TICK_MICROS)
+#define FT_TICKS        (IL_FADE_MILLIS * 1000 / IL_FADE_TICK_MICROS)  // Steps in a fade
+#define FT_TOLERANCE    (1)                     // How far a step's duty cycle may be from the float fade's
+
+static_assert(IL_FADE_MILLIS * 1000 % IL_FADE_TICK_MICROS == 0, "The tests assume a fade is a whole number of steps");
+
+static Illuminator il(FT_WAXING_PIN, FT_WANING_PIN, FT_SENSOR_PIN);
+
+/**
+ * @brief   The duty cycle the waxing COB is lit at: its max duty cycle, scaled by the ambient
+ *          light and the brightness
+ */
+static int16_t litDuty() {
+    uint32_t factor = Illuminator::ambientFactorFor(il.getAmbientLevel());
+    return (int16_t)(factor * il.getBright() * il.getMaxDuty(true) / (IL_FACTOR_ONE * 100u));
+}
+
+/**
+ * @brief   The duty cycle a fade from one duty cycle to another should be at after the specified
+ *          time, worked out in floating point
+ */
+static int16_t fadeDuty(int16_t from, int16_t to, uint64_t elapsed) {
+    double fromLevel = pow((double)from / IL_ANALOG_RANGE, 1.0 / IL_GAMMA);
+    double toLevel = pow((double)to / IL_ANALOG_RANGE, 1.0 / IL_GAMMA);
+    double frac = elapsed >= IL_FADE_MILLIS * 1000ULL ? 1.0 : (double)elapsed / (IL_FADE_MILLIS * 1000.0);
+    return (int16_t)lround(IL_ANALOG_RANGE * pow(fromLevel + (toLevel - fromLevel) * frac, IL_GAMMA));
+}
+
+/**
+ * @brief   Follow a fade of the waxing COB, step by step, from the specified duty cycle at the
+ *          specified time to the specified duty cycle, checking each step against the float
+ *          fade and that it lands on time. The first step is the first one after start; steps
+ *          are at a whole number of ticks from tickBase.
+ */
+static void followFade(int16_t from, int16_t to, uint64_t start, uint64_t tickBase) {
+    uint64_t end = start + IL_FADE_MILLIS * 1000ULL;
+    int16_t prev = halGetPinOut(FT_WAXING_PIN);
+    for (uint64_t t = tickBase + ((start - tickBase) / FT_TICK + 1) * FT_TICK; ; t += FT_TICK) {
+        halAdvanceTo(t);
+        int16_t duty = halGetPinOut(FT_WAXING_PIN);
+        TEST_ASSERT_EQUAL_INT16(duty, il.getDuty(true));
+        TEST_ASSERT_EQUAL_INT16(0, halGetPinOut(FT_WANING_PIN));
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(FT_TOLERANCE, fadeDuty(from, to, t - start), duty, "Step off the perceptual ramp");
+        TEST_ASSERT_TRUE_MESSAGE(to >= from ? duty >= prev : duty <= prev, "Fade went the wrong way");
+        prev = duty;
+        if (t >= end) {
+            TEST_ASSERT_EQUAL_INT16(to, duty);
+            TEST_ASSERT_TRUE_MESSAGE(halNextEventMicros() > t + FT_TICK, "Alarm still armed after the fade");
+            return;
+        }
+    }
+}
+
+void setUp() {
+    il.begin();
+    il.setFadeMillis(IL_FADE_MILLIS);
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief   A fade up and a fade down each take IL_FADE_MILLIS, follow the perceptual ramp and
+ *          land exactly on the new duty cycle
+ */
+void testFadeTiming() {
+    int16_t lit = litDuty();
+    TEST_ASSERT_GREATER_THAN(0, lit);
+    uint64_t t0 = time_us_64();
+    il.atPhase(FT_LIT_PHASE);
+    TEST_ASSERT_EQUAL_INT16(0, halGetPinOut(FT_WAXING_PIN));
+    TEST_ASSERT_EQUAL_UINT64(t0 + FT_TICK, halNextEventMicros());
+    followFade(0, lit, t0, t0);
+
+    // Halfway up, it's well under half the duty cycle: the fade is even in brightness, not duty
+    TEST_ASSERT_LESS_THAN(lit / 4, fadeDuty(0, lit, IL_FADE_MILLIS * 500ULL));
+
+    halAdvance(12345);
+    uint64_t t1 = time_us_64();
+    il.atPhase(FT_DARK_PHASE);
+    followFade(lit, 0, t1, t1);
+}
+
+/**
+ * @brief   A fade cancelled midway turns back from where it had got to; with fades turned off,
+ *          cancelling it is immediate
+ */
+void testCancelMidway() {
+    int16_t lit = litDuty();
+    uint64_t t0 = time_us_64();
+    il.atPhase(FT_LIT_PHASE);
+    halAdvanceTo(t0 + FT_TICKS / 3 * FT_TICK);
+    int16_t midway = halGetPinOut(FT_WAXING_PIN);
+    TEST_ASSERT_TRUE(midway > 0 && midway < lit);
+
+    // Asking for the duty cycle it's already fading to doesn't restart it
+    il.atPhase(FT_LIT_PHASE);
+    halAdvanceTo(t0 + FT_TICKS * FT_TICK);
+    TEST_ASSERT_EQUAL_INT16(lit, halGetPinOut(FT_WAXING_PIN));
+
+    // Cancel a fade down a third of the way along; it goes back up from where it had got to
+    halAdvance(FT_TICK / 2);
+    t0 = time_us_64();
+    il.atPhase(FT_DARK_PHASE);
+    halAdvanceTo(t0 + FT_TICKS / 3 * FT_TICK);
+    uint64_t t1 = time_us_64();
+    int16_t from = halGetPinOut(FT_WAXING_PIN);
+    TEST_ASSERT_TRUE(from > 0 && from < lit);
+    il.atPhase(FT_LIT_PHASE);
+    TEST_ASSERT_EQUAL_INT16(from, halGetPinOut(FT_WAXING_PIN));
+    followFade(from, lit, t1, t0);
+
+    // With fades turned off, cancelling one midway goes straight to the new duty cycle, and the
+    // alarm's next step finds nothing to do and isn't rearmed
+    t0 = time_us_64();
+    il.atPhase(FT_DARK_PHASE);
+    halAdvanceTo(t0 + FT_TICKS / 2 * FT_TICK);
+    il.setFadeMillis(0);
+    il.atPhase(FT_LIT_PHASE);
+    TEST_ASSERT_EQUAL_INT16(lit, halGetPinOut(FT_WAXING_PIN));
+    TEST_ASSERT_EQUAL_INT16(lit, il.getDuty(true));
+    halAdvance(FT_TICK);
+    TEST_ASSERT_EQUAL_INT16(lit, halGetPinOut(FT_WAXING_PIN));
+    TEST_ASSERT_TRUE(halNextEventMicros() > time_us_64() + FT_TICK);
+}
+
+/**
+ * @brief   setDuty() just before and just after a step, including the last one, picks the fade
+ *          up from where it was and runs it to the end
+ */
+void testSetDutyRacingAlarm() {
+    int16_t lit = litDuty();
+
+    // A microsecond before a step: that step already belongs to the new fade
+    uint64_t t0 = time_us_64();
+    il.atPhase(FT_LIT_PHASE);
+    halAdvanceTo(t0 + FT_TICKS / 2 * FT_TICK - 1);
+    int16_t from = halGetPinOut(FT_WAXING_PIN);
+    uint64_t t1 = time_us_64();
+    il.atPhase(FT_DARK_PHASE);
+    followFade(from, 0, t1, t0);
+
+    // At the instant of a step, just after it
+    t0 = time_us_64();
+    il.atPhase(FT_LIT_PHASE);
+    halAdvanceTo(t0 + FT_TICKS / 2 * FT_TICK);
+    from = halGetPinOut(FT_WAXING_PIN);
+    il.atPhase(FT_DARK_PHASE);
+    followFade(from, 0, t0 + FT_TICKS / 2 * FT_TICK, t0);
+
+    // A microsecond before the last step, which would have left the alarm disarmed
+    t0 = time_us_64();
+    il.atPhase(FT_LIT_PHASE);
+    halAdvanceTo(t0 + FT_TICKS * FT_TICK - 1);
+    from = halGetPinOut(FT_WAXING_PIN);
+    TEST_ASSERT_TRUE(from < lit);
+    t1 = time_us_64();
+    il.atPhase(FT_DARK_PHASE);
+    followFade(from, 0, t1, t0);
+
+    // At the instant of the last step, just after it left the alarm disarmed
+    t0 = time_us_64();
+    il.atPhase(FT_LIT_PHASE);
+    halAdvanceTo(t0 + FT_TICKS * FT_TICK);
+    TEST_ASSERT_EQUAL_INT16(lit, halGetPinOut(FT_WAXING_PIN));
+    t1 = time_us_64();
+    il.atPhase(FT_DARK_PHASE);
+    TEST_ASSERT_EQUAL_UINT64(t1 + FT_TICK, halNextEventMicros());
+    followFade(lit, 0, t1, t1);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(testFadeTiming);
+    RUN_TEST(testCancelMidway);
+    RUN_TEST(testSetDutyRacingAlarm);
+    return UNITY_END();
+}
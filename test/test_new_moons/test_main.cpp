@@ -0,0 +1,164 @@
+/****
+ * @file test_main.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * Host tests for the MoonPhase library's new moons. They check MoonPhase::trueNewMoon(), which
+ * reads NewMoonTable.h inside 2024 through 2100, and MoonPhase::computeNewMoon(), which it falls
+ * back on outside that span, against published new moon instants:
+ *
+ *      pio test -e native -f test_new_moons
+ *
+ * The published instants are UTC to the minute, as the almanacs give them, so each can be off
+ * by up to half a minute. Meeus' series is good to well under a minute, so a new moon is
+ * allowed to be NM_TOLERANCE seconds, a minute, from the published one. (They're all, in fact,
+ * within half a minute.) Meeus' own worked example (49.a, the new moon of 1977 February) is
+ * given to the second on Terrestrial Time, so computeNewMoon() is held to a second or two of
+ * that. Inside the table's span, every entry is also checked to give back the new moon the
+ * series gives, to within the half a unit the table is rounded to.
+ *
+ * The table's run-time cost against the series' is measured by the benchmark in
+ * tools/Benchmark.cpp.
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+
+#include <unity.h>
+#include <MoonPhase.h>
+#include <NewMoonTable.h>
+
+#define NM_TOLERANCE        (60)                // Seconds a new moon may be from a published one
+#define NM_MEEUS_TOLERANCE  (2)                 // Seconds it may be from Meeus' worked example
+
+struct newMoon_t {                              // A published new moon, UTC
+    int16_t year;
+    int8_t month;
+    int8_t day;
+    int8_t hour;
+    int8_t minute;
+};
+
+static const newMoon_t inTable[] = {            // New moons in NewMoonTable.h's span
+    {2024,  1, 11, 11, 57},
+    {2024,  4,  8, 18, 21},                     // Total solar eclipse
+    {2024, 10,  2, 18, 49},                     // Annular solar eclipse
+    {2025,  3, 29, 10, 58},                     // Partial solar eclipse
+    {2025,  9, 21, 19, 54},
+    {2026,  2, 17, 12,  1},                     // Annular solar eclipse
+    {2026,  8, 12, 17, 37},                     // Total solar eclipse
+    {2027,  8,  2, 10,  5},                     // Total solar eclipse
+    {2030,  6,  1,  6, 21}                      // Annular solar eclipse
+};
+
+static const newMoon_t beforeTable[] = {        // New moons before it
+    {1999,  8, 11, 11,  8},                     // Total solar eclipse
+    {2000,  1,  6, 18, 14},                     // Lunation 0
+    {2017,  8, 21, 18, 30},                     // Total solar eclipse
+    {2023,  4, 20,  4, 12}                      // Hybrid solar eclipse
+};
+
+/**
+ * @brief   Convert a UTC calendar date and time to a time_t without depending on the host's
+ *          time zone
+ */
+static time_t utcOf(int16_t year, int8_t month, int8_t day, int8_t hour, int8_t minute, int8_t second) {
+    // Days from 1970-01-01 to the date (Howard Hinnant's days_from_civil)
+    int32_t y = year - (month <= 2);
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    int32_t yoe = y - era * 400;
+    int32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+    return (time_t)(days * 86400 + hour * 3600 + minute * 60 + second);
+}
+
+static time_t utcOf(const newMoon_t &nm) {
+    return utcOf(nm.year, nm.month, nm.day, nm.hour, nm.minute, 0);
+}
+
+/**
+ * @brief   Check that each of the specified published new moons is within NM_TOLERANCE of the
+ *          one the specified function gives for its lunation, and that the lunations are in the
+ *          expected place relative to the table
+ */
+static void checkNewMoons(const newMoon_t *nms, size_t count, time_t (*newMoon)(int32_t), bool expectInTable) {
+    for (size_t i = 0; i < count; i++) {
+        time_t published = utcOf(nms[i]);
+        // The new moon on or before half a day later is the one the published instant is of
+        int32_t k = MoonPhase::lunationAt(published + 43200);
+        bool inTable = k >= MP_TABLE_FIRST_K && k < MP_TABLE_FIRST_K + MP_TABLE_LEN;
+        TEST_ASSERT_EQUAL_MESSAGE(expectInTable, inTable, "Lunation in the wrong part of the span");
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(NM_TOLERANCE, 0, (int32_t)(newMoon(k) - published), "New moon too far from the published one");
+    }
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief   trueNewMoon() agrees with published new moons inside the table's span
+ */
+void testTableNewMoons() {
+    checkNewMoons(inTable, sizeof(inTable) / sizeof(inTable[0]), MoonPhase::trueNewMoon, true);
+}
+
+/**
+ * @brief   computeNewMoon(), and trueNewMoon() falling back on it, agree with published new
+ *          moons outside the table's span
+ */
+void testSeriesNewMoons() {
+    checkNewMoons(beforeTable, sizeof(beforeTable) / sizeof(beforeTable[0]), MoonPhase::computeNewMoon, false);
+    checkNewMoons(beforeTable, sizeof(beforeTable) / sizeof(beforeTable[0]), MoonPhase::trueNewMoon, false);
+}
+
+/**
+ * @brief   computeNewMoon() gives Meeus' example 49.a, the new moon of 1977 February 18 at
+ *          3:37:42 TD (lunation -283), to within a second or two
+ */
+void testMeeusExample() {
+    time_t td = utcOf(1977, 2, 18, 3, 37, 42);
+    TEST_ASSERT_INT32_WITHIN(NM_MEEUS_TOLERANCE, 0, (int32_t)(MoonPhase::computeNewMoon(-283) + MP_DELTA_T - td));
+}
+
+/**
+ * @brief   Every entry in the table gives back the series' new moon to within half a unit, and
+ *          trueNewMoon() and computeNewMoon() meet at each end of the table
+ */
+void testTableMatchesSeries() {
+    for (int32_t k = MP_TABLE_FIRST_K; k < MP_TABLE_FIRST_K + MP_TABLE_LEN; k++) {
+        int32_t diff = (int32_t)(MoonPhase::trueNewMoon(k) - MoonPhase::computeNewMoon(k));
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(MP_TABLE_UNIT, 0, 2 * diff, "Table entry off by more than half a unit");
+    }
+    TEST_ASSERT_EQUAL_INT64(MoonPhase::computeNewMoon(MP_TABLE_FIRST_K - 1), MoonPhase::trueNewMoon(MP_TABLE_FIRST_K - 1));
+    TEST_ASSERT_EQUAL_INT64(MoonPhase::computeNewMoon(MP_TABLE_FIRST_K + MP_TABLE_LEN), MoonPhase::trueNewMoon(MP_TABLE_FIRST_K + MP_TABLE_LEN));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(testTableNewMoons);
+    RUN_TEST(testSeriesNewMoons);
+    RUN_TEST(testMeeusExample);
+    RUN_TEST(testTableMatchesSeries);
+    return UNITY_END();
+}
@@ -0,0 +1,191 @@
+/****
+ * @file test_main.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * Host tests for the 64-bit timebase the phase schedule runs on. The first two sweep every
+ * second of several lunations through MoonPhase::phaseAtMicros(), the way the firmware asks
+ * for the phase and for when it next changes, and check that the answers hang together: the
+ * change is always after now and never more than a phase away, the phase holds right up to
+ * the microsecond before it and at that microsecond steps to the next phase, and every phase
+ * of every lunation turns up exactly once. The late waning phases, where moon ages of more
+ * than 24.8 days used to overflow an int32_t of milliseconds, get the same checks as the rest.
+ * One sweep is inside NewMoonTable.h's span, the other past it, where the new moons come from
+ * Meeus' series.
+ *
+ * The last test runs the Scheduler across the point where the Pico's 32-bit millis() wraps,
+ * 2^32 ms (49.7 days) after boot. On the host, millis() is 64 bits and doesn't wrap, but the
+ * scheduler works in time_us_64() and doesn't look at millis() at all, so the test can check
+ * that deadlines on either side of the wrap, right at it and more than 24.8 days past it come
+ * due in order and on time, with the Pico's millis() shown to have wrapped along the way:
+ *
+ *      pio test -e native -f test_phase_timing
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+
+#include <unity.h>
+#include <Arduino.h>
+#include <NativeHal.h>
+#include <MoonDisplay.h>
+#include <MoonPhase.h>
+#include <NewMoonTable.h>
+#include <Scheduler.h>
+
+#define TT_LUNATIONS        (4)                         // Lunations in the sweep inside the table
+#define TT_FIRST_K          (329)                       // Where it starts: the new moon of 2026-08-12
+#define TT_MAX_PHASE_MICROS (12 * 3600 * 1000000LL)     // Longer than any phase (1/60 of the longest lunation)
+#define TT_WRAP_MICROS      (4294967296000ULL)          // time_us_64() at which the Pico's millis() wraps
+#define TT_TASKS            (5)                         // Tasks in the millis() wrap test
+
+/**
+ * @brief   Sweep every second from the true new moon of lunation k0 to the one n lunations
+ *          later, checking what phaseAtMicros() says at each
+ *
+ * @param k0    The lunation to start with
+ * @param n     The number of lunations
+ */
+static void sweepLunations(int32_t k0, int32_t n) {
+    MoonPhase moonPhase(MD_PHASES);
+    MoonPhase check(MD_PHASES);
+    time_t start = MoonPhase::trueNewMoon(k0);
+    time_t end = MoonPhase::trueNewMoon(k0 + n);
+    int16_t prevPhase = -1;
+    int64_t prevNext = 0;
+    int32_t changes = 0;
+    for (time_t t = start; t < end; t++) {
+        int64_t now = (int64_t)t * 1000000;
+        int64_t next;
+        int16_t phase = moonPhase.phaseAtMicros(now, &next);
+        TEST_ASSERT_TRUE_MESSAGE(phase >= 0 && phase < MD_PHASES, "Phase out of range");
+        TEST_ASSERT_TRUE_MESSAGE(next > now && next - now <= TT_MAX_PHASE_MICROS, "Next change not within a phase");
+        if (prevPhase < 0) {
+            TEST_ASSERT_EQUAL_INT16(0, phase);
+        } else if (phase == prevPhase) {
+            TEST_ASSERT_EQUAL_INT64(prevNext, next);
+        } else {
+            // The change came when it was said it would: in the last second, to the microsecond
+            TEST_ASSERT_EQUAL_INT16((prevPhase + 1) % MD_PHASES, phase);
+            TEST_ASSERT_TRUE_MESSAGE(prevNext > now - 1000000 && prevNext <= now, "Phase changed at the wrong time");
+            TEST_ASSERT_EQUAL_INT16(prevPhase, check.phaseAtMicros(prevNext - 1));
+            TEST_ASSERT_EQUAL_INT16(phase, check.phaseAtMicros(prevNext));
+            changes++;
+        }
+        prevPhase = phase;
+        prevNext = next;
+    }
+    TEST_ASSERT_EQUAL_INT16(MD_PHASES - 1, prevPhase);
+    TEST_ASSERT_EQUAL_INT32(n * MD_PHASES - 1, changes);
+}
+
+static uint64_t ranAt[TT_TASKS];                        // time_us_64() at which each task ran
+static uint8_t ranOrder[TT_TASKS];                      // The tasks in the order they ran
+static uint8_t nRan;                                    // How many have run
+
+static void recordRun(void *ctx) {
+    uint8_t id = (uint8_t)(uintptr_t)ctx;
+    ranAt[id] = time_us_64();
+    ranOrder[nRan++] = id;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief   Every second of several lunations in the table's span
+ */
+void testSweepTable() {
+    sweepLunations(TT_FIRST_K, TT_LUNATIONS);
+}
+
+/**
+ * @brief   Every second of a lunation past the table's span
+ */
+void testSweepSeries() {
+    sweepLunations(MP_TABLE_FIRST_K + MP_TABLE_LEN, 1);
+}
+
+/**
+ * @brief   Deadlines across the Pico's millis() wrap come due in order and on time
+ */
+void testMillisWrap() {
+    halAdvanceTo(TT_WRAP_MICROS - 10000000);
+    uint32_t picoMillis = (uint32_t)millis();
+    Scheduler sched;
+    sched.begin();
+    int8_t id[TT_TASKS];
+    for (uint8_t i = 0; i < TT_TASKS; i++) {
+        id[i] = sched.addTask(recordRun, (void *)(uintptr_t)i);
+        TEST_ASSERT_EQUAL_INT(i, id[i]);
+    }
+    const uint64_t due[TT_TASKS] = {
+        TT_WRAP_MICROS - 1000000,                       // Just before the wrap
+        TT_WRAP_MICROS,                                 // Right at it
+        TT_WRAP_MICROS + 1000,                          // The first millisecond after it
+        TT_WRAP_MICROS + 5000000,                       // Set with after(), from before it
+        TT_WRAP_MICROS - 10000000 + 30 * 86400000000ULL // More than 24.8 days off
+    };
+    // Given in an order that doesn't match when they're due
+    sched.after(id[4], 30 * 86400000UL);
+    sched.at(id[2], due[2]);
+    sched.after(id[3], 15000);
+    sched.at(id[0], due[0]);
+    sched.at(id[1], due[1]);
+
+    // On the host, sleeping doesn't pass the time, so, as the simulator does, step the virtual
+    // clock to the earliest deadline the scheduler has after each pass
+    nRan = 0;
+    bool wrapped = false;
+    while (true) {
+        sched.run();
+        if (nRan == TT_TASKS) {
+            break;
+        }
+        uint64_t next = UINT64_MAX;
+        for (uint8_t i = 0; i < TT_TASKS; i++) {
+            uint64_t d;
+            if (sched.deadline(id[i], d)) {
+                TEST_ASSERT_TRUE_MESSAGE(d > time_us_64(), "A task that was due didn't run");
+                next = d < next ? d : next;
+            }
+        }
+        TEST_ASSERT_TRUE_MESSAGE(next != UINT64_MAX, "A task lost its deadline");
+        halAdvanceTo(next);
+        wrapped = wrapped || (uint32_t)millis() < picoMillis;
+        picoMillis = (uint32_t)millis();
+    }
+    TEST_ASSERT_TRUE(wrapped);
+    for (uint8_t i = 0; i < TT_TASKS; i++) {
+        TEST_ASSERT_EQUAL_UINT8(i, ranOrder[i]);
+        TEST_ASSERT_EQUAL_UINT64(due[i], ranAt[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(testSweepTable);
+    RUN_TEST(testSweepSeries);
+    RUN_TEST(testMillisWrap);
+    return UNITY_END();
+}
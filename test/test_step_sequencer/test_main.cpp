@@ -0,0 +1,286 @@
+/****
+ * @file test_main.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * Host tests for the MotionEngine library's step sequencer: the PIO program in StepSequencer.pio
+ * fed by DMA from the blocks of step words the engine computes. They run against NativeHal's
+ * PIO and DMA emulation, which executes the step sequencer's instructions, and its model of the
+ * 28BYJ-48s, which turns each rotor the way the coil levels pull it:
+ *
+ *      pio test -e native -f test_step_sequencer
+ *
+ * The coil pins are watched as the virtual clock goes from one event to the next, so each step
+ * is seen at the very microsecond the state machine took it. The tests check that the coils go
+ * through the half-step sequence in order, one half step at a time, paced by the motion
+ * profile's ramp; that an axis that reverses comes to a stop first; that both axes of a
+ * diagonal move finish together; and that release() turns every coil off without losing the
+ * motors' places.
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+
+#include <unity.h>
+#include <MotionEngine.h>
+
+#define MAX_STEPS       (2000)      // Most coil changes a test records
+
+static const byte pins[ME_AXES][4] = {{2, 3, 4, 5}, {6, 7, 8, 9}};
+static const uint8_t halfSteps[8] = {0b0001, 0b0011, 0b0010, 0b0110, 0b0100, 0b1100, 0b1000, 0b1001};
+static constexpr MotionProfile profile {300, 500, 1500, 0};
+
+struct change_t {                   // A change of the coil levels
+    uint64_t at;                    // When it happened (virtual micros)
+    uint8_t coils[ME_AXES];         // The levels of each motor's coils afterwards; bit 0 is IN1
+};
+
+static MotionEngine engine(pins[ME_PV], pins[ME_LS]);
+static int8_t motor[ME_AXES];       // The model of each motor
+static change_t change[MAX_STEPS];  // The coil changes a move made
+static uint16_t nChanges;           // How many it made
+
+/**
+ * @brief   Get the levels the specified motor's coils are driven to
+ */
+static uint8_t coils(uint8_t axis) {
+    uint8_t answer = 0;
+    for (uint8_t c = 0; c < 4; c++) {
+        answer |= (halGetPinOut(pins[axis][c]) != LOW) << c;
+    }
+    return answer;
+}
+
+/**
+ * @brief   Get the half-step phase the specified coil levels energize, or -1 if none does
+ */
+static int8_t phaseOf(uint8_t levels) {
+    for (int8_t s = 0; s < 8; s++) {
+        if (halfSteps[s] == levels) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief   Let virtual time pass, one event at a time, until the engine has stopped and the
+ *          coils have been held long enough to come to a standstill, noting each change to the
+ *          coil levels in change[]. Since the engine may take the first step as soon as it's
+ *          given a waypoint, the changes are from the specified coil levels, the ones before it
+ *          was. (The engine has stopped once the step sequencer has pulled the last step word,
+ *          which is a cycle before it sets the coils.)
+ */
+static void runToStop(const uint8_t from[ME_AXES]) {
+    uint8_t last[ME_AXES] = {from[ME_PV], from[ME_LS]};
+    uint64_t until = HAL_NO_EVENT;
+    nChanges = 0;
+    while (halMicros() < until) {
+        if (engine.isMoving()) {
+            until = HAL_NO_EVENT;
+        } else if (until == HAL_NO_EVENT) {
+            until = halMicros() + 2 * profile[0];
+        }
+        uint64_t next = halNextEventMicros();
+        halAdvanceTo(next < until ? next : until);
+        uint8_t now[ME_AXES] = {coils(ME_PV), coils(ME_LS)};
+        if (now[ME_PV] != last[ME_PV] || now[ME_LS] != last[ME_LS]) {
+            TEST_ASSERT_LESS_THAN_UINT16(MAX_STEPS, nChanges);
+            change[nChanges++] = {halMicros(), {now[ME_PV], now[ME_LS]}};
+            last[ME_PV] = now[ME_PV];
+            last[ME_LS] = now[ME_LS];
+        }
+    }
+}
+
+/**
+ * @brief   Check that, from the specified coil levels, the specified axis's coils go through
+ *          the half-step sequence a half step at a time, ending up the specified number of
+ *          steps away. Returns the index of the change at which the axis reversed, or -1.
+ */
+static int16_t checkSequence(uint8_t axis, uint8_t from, int32_t steps) {
+    int8_t phase = phaseOf(from);
+    TEST_ASSERT_TRUE(phase >= 0);
+    int32_t pos = 0;
+    int8_t lastDir = 0;
+    int16_t reversedAt = -1;
+    for (uint16_t i = 0; i < nChanges; i++) {
+        int8_t next = phaseOf(change[i].coils[axis]);
+        TEST_ASSERT_TRUE_MESSAGE(next >= 0, "Coils energized in a pattern that isn't a half step");
+        int8_t d = (next - phase) & 7;
+        TEST_ASSERT_TRUE_MESSAGE(d == 0 || d == 1 || d == 7, "Coils moved more than a half step at once");
+        if (d != 0) {
+            int8_t dir = d == 1 ? 1 : -1;
+            if (lastDir != 0 && dir != lastDir) {
+                reversedAt = i;
+            }
+            lastDir = dir;
+            pos += dir;
+        }
+        phase = next;
+    }
+    TEST_ASSERT_EQUAL_INT32(steps, pos);
+    return reversedAt;
+}
+
+/**
+ * @brief   Check that the changes from first to last - 1, which are the steps of a move from one
+ *          standstill to the next, are paced by the profile's ramp: step k of the move comes
+ *          ramp[k] after the one before on the way up, then at top speed, then back down the
+ *          ramp, the last coming ramp[0] after the one before. The move starts ramp[0] or more
+ *          after any step before it.
+ */
+static void checkPacing(uint16_t first, uint16_t last) {
+    uint16_t n = last - first;
+    TEST_ASSERT_TRUE_MESSAGE(2 * profile.size() < n, "Too short a move to reach top speed");
+    if (first > 0) {
+        TEST_ASSERT_GREATER_OR_EQUAL(profile[0], change[first].at - change[first - 1].at);
+    }
+    for (uint16_t k = 1; k < n; k++) {
+        uint16_t r = k < profile.size() - 1 ? k : profile.size() - 1;
+        r = n - 1 - k < r ? n - 1 - k : r;
+        TEST_ASSERT_EQUAL_UINT32(profile[r], change[first + k].at - change[first + k - 1].at);
+    }
+}
+
+void setUp() {
+    engine.setProfile(ME_PV, profile);
+    engine.setProfile(ME_LS, profile);
+    engine.begin(0, 0);
+    while (engine.isMoving()) {
+        halAdvance(1000);
+    }
+    halAdvance(profile[0]);
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief   A move of one axis takes the coils through the half-step sequence, one step per
+ *          change, with the step intervals the profile's ramp says, up and back down again
+ */
+void testStepSequence() {
+    uint8_t from[ME_AXES] = {coils(ME_PV), coils(ME_LS)};
+    int32_t modelFrom = halGetMotorPosition(motor[ME_PV]);
+    TEST_ASSERT_TRUE(engine.moveTo(200, 0));
+    runToStop(from);
+    TEST_ASSERT_EQUAL_UINT16(200, nChanges);
+    checkSequence(ME_PV, from[ME_PV], 200);
+    for (uint16_t i = 0; i < nChanges; i++) {
+        TEST_ASSERT_EQUAL_UINT8(from[ME_LS], change[i].coils[ME_LS]);
+    }
+
+    checkPacing(0, nChanges);
+    TEST_ASSERT_EQUAL_INT32(200, engine.getPosition(ME_PV));
+    TEST_ASSERT_EQUAL_INT32(0, engine.getPosition(ME_LS));
+    TEST_ASSERT_EQUAL_INT32(200, halGetMotorPosition(motor[ME_PV]) - modelFrom);
+}
+
+/**
+ * @brief   An axis that reverses slows to a stop, turns around and speeds up again
+ */
+void testReversal() {
+    uint8_t from[ME_AXES] = {coils(ME_PV), coils(ME_LS)};
+    int32_t modelFrom = halGetMotorPosition(motor[ME_PV]);
+    TEST_ASSERT_TRUE(engine.moveTo(150, 0));
+    TEST_ASSERT_TRUE(engine.moveTo(-50, 0));
+    runToStop(from);
+    TEST_ASSERT_EQUAL_UINT16(350, nChanges);
+    int16_t at = checkSequence(ME_PV, from[ME_PV], -50);
+    TEST_ASSERT_EQUAL_INT16(150, at);
+
+    // Each way is a move of its own, from a standstill to a standstill
+    checkPacing(0, at);
+    checkPacing(at, nChanges);
+    TEST_ASSERT_EQUAL_INT32(-50, engine.getPosition(ME_PV));
+    TEST_ASSERT_EQUAL_INT32(-50, halGetMotorPosition(motor[ME_PV]) - modelFrom);
+}
+
+/**
+ * @brief   Both axes of a diagonal move start and finish together, the minor one stepping evenly
+ *          among the major one's steps
+ */
+void testDiagonal() {
+    uint8_t from[ME_AXES] = {coils(ME_PV), coils(ME_LS)};
+    TEST_ASSERT_TRUE(engine.moveTo(-120, 40));
+    runToStop(from);
+    TEST_ASSERT_EQUAL_UINT16(120, nChanges);
+    checkSequence(ME_PV, from[ME_PV], -120);
+    checkSequence(ME_LS, from[ME_LS], 40);
+    uint16_t lsSteps = 0;
+    for (uint16_t i = 0; i < nChanges; i++) {
+        uint8_t prev = i == 0 ? from[ME_LS] : change[i - 1].coils[ME_LS];
+        lsSteps += change[i].coils[ME_LS] != prev;
+        // Within a step of the straight line from start to finish
+        int32_t ideal = (int32_t)(i + 1) * 40 / 120;
+        TEST_ASSERT_INT_WITHIN(1, ideal, lsSteps);
+    }
+    TEST_ASSERT_EQUAL_UINT16(40, lsSteps);
+    TEST_ASSERT_EQUAL_INT32(-120, engine.getPosition(ME_PV));
+    TEST_ASSERT_EQUAL_INT32(40, engine.getPosition(ME_LS));
+}
+
+/**
+ * @brief   release() turns all the coils off, but not while moving, and the next move picks up
+ *          where the motors were left
+ */
+void testRelease() {
+    TEST_ASSERT_TRUE(engine.moveTo(100, 100));
+    halAdvance(20000);
+    TEST_ASSERT_TRUE(engine.isMoving());
+    engine.release();                           // Too soon; does nothing
+    TEST_ASSERT_TRUE(engine.isEnergized());
+    uint8_t from[ME_AXES] = {coils(ME_PV), coils(ME_LS)};
+    runToStop(from);
+    TEST_ASSERT_NOT_EQUAL(0, coils(ME_PV));
+
+    uint8_t held[ME_AXES] = {coils(ME_PV), coils(ME_LS)};
+    int32_t modelAt[ME_AXES] = {halGetMotorPosition(motor[ME_PV]), halGetMotorPosition(motor[ME_LS])};
+    engine.release();
+    halAdvance(1000);
+    TEST_ASSERT_FALSE(engine.isEnergized());
+    TEST_ASSERT_EQUAL_UINT8(0, coils(ME_PV));
+    TEST_ASSERT_EQUAL_UINT8(0, coils(ME_LS));
+    TEST_ASSERT_EQUAL_INT32(100, engine.getPosition(ME_PV));
+    TEST_ASSERT_EQUAL_INT32(100, engine.getPosition(ME_LS));
+
+    // The first step after is a half step on from where the coils were held
+    uint8_t off[ME_AXES] = {0, 0};
+    TEST_ASSERT_TRUE(engine.moveTo(110, 95));
+    runToStop(off);
+    TEST_ASSERT_TRUE(engine.isEnergized());
+    TEST_ASSERT_EQUAL_UINT16(10, nChanges);
+    checkSequence(ME_PV, held[ME_PV], 10);
+    checkSequence(ME_LS, held[ME_LS], -5);
+    TEST_ASSERT_EQUAL_INT32(10, halGetMotorPosition(motor[ME_PV]) - modelAt[ME_PV]);
+    TEST_ASSERT_EQUAL_INT32(-5, halGetMotorPosition(motor[ME_LS]) - modelAt[ME_LS]);
+}
+
+int main(int argc, char **argv) {
+    motor[ME_PV] = halAddMotor(pins[ME_PV], 0);
+    motor[ME_LS] = halAddMotor(pins[ME_LS], 0);
+    UNITY_BEGIN();
+    RUN_TEST(testStepSequence);
+    RUN_TEST(testReversal);
+    RUN_TEST(testDiagonal);
+    RUN_TEST(testRelease);
+    return UNITY_END();
+}
@@ -0,0 +1,140 @@
+/****
+ * @file Benchmark.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * A host tool that times the firmware's lookup tables against the floating point expressions
+ * they replaced. It is built by the PlatformIO "benchmark" environment, against the same
+ * NativeHal stand-ins as the native build, and writes its results to stdout:
+ *
+ *      pio run -e benchmark && .pio/build/benchmark/program [<calls>]
+ *
+ * Each benchmark calls a function over and over, running through the function's whole domain,
+ * and reports the mean time per call, first for the table (the code the firmware runs now) and
+ * then for the float expression it stands in for (reproduced here as it was or, for the new
+ * moons, MoonPhase::computeNewMoon(), the series NewMoonTable.h is made from). The host has a
+ * floating point unit and the Pico's M0+ cores don't, so on the Pico, where float math is done
+ * in software (and integer division in the SIO's hardware divider), the gap is far wider than
+ * it is here. For the simplest of them, a single float multiply and divide, the host's FPU can
+ * even come out ahead. Whether the tables agree with the float expressions is for the host
+ * tests in test/ to say.
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+#include <Illuminator.h>
+#include <MoonPhase.h>
+#include <NewMoonTable.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BM_DEFAULT_CALLS    (10000000)                  // Default number of calls per benchmark
+
+typedef int32_t (*bmFunc_t)(uint32_t i);                // A function to time; i runs through 0 .. calls - 1
+
+struct benchmark_t {                                    // A table and the float expression it replaced
+    const char *name;                                   // What's being timed
+    bmFunc_t table;                                     // The table lookup
+    bmFunc_t expr;                                      // The float expression
+};
+
+static volatile int32_t sink;                           // Where results go, so they aren't optimized away
+
+// The ambient light factor for levels 0..100 (Illuminator)
+static int32_t ambientTable(uint32_t i) {
+    return Illuminator::ambientFactorFor(i % 101);
+}
+
+static int32_t ambientExpr(uint32_t i) {
+    int16_t ambPct = i % 101;
+    float answer = (ambPct - IL_AMB_LOWEST) * 100.0 / (IL_AMB_HIGHEST - IL_AMB_LOWEST);
+    answer = answer > 100.0 ? 100.0 : answer < 0.0 ? 0.0 : answer;
+    answer = log10(1 + IL_AMB_COEFF * answer) / log10(1 + IL_AMB_COEFF * 100.0);
+    return (int32_t)(answer * IL_FACTOR_ONE);
+}
+
+// The gamma curve (Illuminator)
+static int32_t gammaTable(uint32_t i) {
+    return Illuminator::gammaFor(i % ((1 << IL_GAMMA_BITS) + 1));
+}
+
+static int32_t gammaExpr(uint32_t i) {
+    return (int32_t)(powf((float)(i % ((1 << IL_GAMMA_BITS) + 1)) / (1 << IL_GAMMA_BITS), (float)IL_GAMMA) * IL_FACTOR_ONE);
+}
+
+// The ambient light level from a sample ring's sum (Illuminator)
+static int32_t averageInt(uint32_t i) {
+    return Illuminator::ambientForSum(i % (IL_ADC_RING_LEN * IL_ANALOG_FULLSCALE + 1));
+}
+
+static int32_t averageExpr(uint32_t i) {
+    float sensorReading = i % (IL_ADC_RING_LEN * IL_ANALOG_FULLSCALE + 1);
+    return static_cast<int16_t>(100 - ((sensorReading * 100) / (IL_ADC_RING_LEN * IL_ANALOG_FULLSCALE)));
+}
+
+// The true new moon of a lunation in NewMoonTable.h's span (MoonPhase)
+static int32_t newMoonTable(uint32_t i) {
+    return (int32_t)MoonPhase::trueNewMoon(MP_TABLE_FIRST_K + i % MP_TABLE_LEN);
+}
+
+static int32_t newMoonSeries(uint32_t i) {
+    return (int32_t)MoonPhase::computeNewMoon(MP_TABLE_FIRST_K + i % MP_TABLE_LEN);
+}
+
+static const benchmark_t benchmarks[] = {
+    {"ambient light factor", ambientTable, ambientExpr},
+    {"gamma curve", gammaTable, gammaExpr},
+    {"ambient level from samples", averageInt, averageExpr},
+    {"true new moon", newMoonTable, newMoonSeries}
+};
+
+/**
+ * @brief   Return the mean time, in nanoseconds, the specified function takes per call
+ *
+ * @param f         The function
+ * @param calls     The number of times to call it
+ * @return double   The mean time per call
+ */
+static double nsPerCall(bmFunc_t f, uint32_t calls) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < calls; i++) {
+        sink = f(i);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / calls;
+}
+
+int main(int argc, char **argv) {
+    uint32_t calls = argc > 1 ? strtoul(argv[1], nullptr, 10) : BM_DEFAULT_CALLS;
+    if (argc > 2 || calls == 0) {
+        fprintf(stderr, "Usage: %s [<calls>]\n", argv[0]);
+        return 1;
+    }
+    printf("%-28s %12s %12s %8s\n", "", "table ns", "float ns", "ratio");
+    for (const benchmark_t &b : benchmarks) {
+        double table = nsPerCall(b.table, calls);
+        double expr = nsPerCall(b.expr, calls);
+        printf("%-28s %12.2f %12.2f %8.1f\n", b.name, table, expr, expr / table);
+    }
+    return 0;
+}
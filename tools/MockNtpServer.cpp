@@ -0,0 +1,184 @@
+/****
+ * @file MockNtpServer.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * A host tool that pretends to be an NTP server, so that the firmware's TimeKeeper can be tried
+ * against a real one, over a real network stack, without waiting weeks to see how it copes with
+ * a drifting clock. It is built by the PlatformIO "mockntp" environment. Its clock is the host's,
+ * plus --offset seconds, running --ppm parts per million fast (or, if negative, slow) from when
+ * it starts. Each answer is held back --delay-ms, split evenly between the way in and the way
+ * out, as a distant server's would be. For example:
+ *
+ *      .pio/build/mockntp/program --port 12300 --offset 2.5 --ppm 200 &
+ *      .pio/build/native/program --realtime --ntp-server 127.0.0.1:12300
+ *
+ * and then ask the firmware for its 'status' every so often. With --ppm, the firmware's clock
+ * seems to drift compared to the server's, which is what the TimeKeeper measures and corrects.
+ * Each request is logged to stderr along with the time given in answer.
+ *
+ * Usage: program [--port <n>] [--offset <seconds>] [--ppm <n>] [--delay-ms <n>] [--stratum <n>]
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MN_DEFAULT_PORT     (123)                       // The NTP port (needs privileges on most hosts)
+#define MN_PACKET_LEN       (48)                        // Length of an NTP packet without extensions
+#define MN_UNIX_OFFSET      (2208988800LL)              // Seconds from the NTP epoch (1900) to the Unix one (1970)
+
+/**
+ * @brief   The server's settings
+ *
+ */
+struct mnConfig_t {
+    double offsetSecs;                                  // How far ahead of the host's clock ours is
+    double ppm;                                         // How fast ours runs compared to the host's
+    uint32_t delayMillis;                               // Round trip delay to add to each answer
+    uint8_t stratum;                                    // The stratum we claim
+};
+
+/**
+ * @brief   Get the host's clock in microseconds since the Unix epoch
+ *
+ * @return int64_t  The host's time
+ */
+static int64_t hostMicros() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief   Get our clock at the specified host time
+ *
+ * @param cfg       The settings
+ * @param start     The host time when we started
+ * @param host      The host time
+ * @return int64_t  Our time, in microseconds since the Unix epoch
+ */
+static int64_t serverMicros(const mnConfig_t &cfg, int64_t start, int64_t host) {
+    return host + (int64_t)(cfg.offsetSecs * 1000000.0) + (int64_t)((double)(host - start) * cfg.ppm / 1000000.0);
+}
+
+/**
+ * @brief   Put a time into an NTP timestamp
+ *
+ * @param at        Where the timestamp goes (8 bytes, big-endian seconds and fraction)
+ * @param utc       The time (micros since the Unix epoch)
+ */
+static void putTimestamp(uint8_t *at, int64_t utc) {
+    uint32_t secs = (uint32_t)(utc / 1000000 + MN_UNIX_OFFSET);
+    uint32_t frac = (uint32_t)(((uint64_t)(utc % 1000000) << 32) / 1000000);
+    for (int b = 0; b < 4; b++) {
+        at[b] = (uint8_t)(secs >> (24 - 8 * b));
+        at[4 + b] = (uint8_t)(frac >> (24 - 8 * b));
+    }
+}
+
+/**
+ * @brief   Sleep for the specified number of microseconds
+ *
+ */
+static void sleepMicros(int64_t micros) {
+    if (micros > 0) {
+        timespec ts = {(time_t)(micros / 1000000), (long)(micros % 1000000) * 1000};
+        nanosleep(&ts, nullptr);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    mnConfig_t cfg = {0.0, 0.0, 0, 1};
+    unsigned port = MN_DEFAULT_PORT;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--port") == 0 && a + 1 < argc) {
+            port = (unsigned)strtoul(argv[++a], nullptr, 10);
+        } else if (strcmp(argv[a], "--offset") == 0 && a + 1 < argc) {
+            cfg.offsetSecs = strtod(argv[++a], nullptr);
+        } else if (strcmp(argv[a], "--ppm") == 0 && a + 1 < argc) {
+            cfg.ppm = strtod(argv[++a], nullptr);
+        } else if (strcmp(argv[a], "--delay-ms") == 0 && a + 1 < argc) {
+            cfg.delayMillis = (uint32_t)strtoul(argv[++a], nullptr, 10);
+        } else if (strcmp(argv[a], "--stratum") == 0 && a + 1 < argc) {
+            cfg.stratum = (uint8_t)strtoul(argv[++a], nullptr, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--port <n>] [--offset <seconds>] [--ppm <n>] [--delay-ms <n>] [--stratum <n>]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (sock < 0 || bind(sock, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("Can't listen for NTP requests");
+        return 1;
+    }
+    int64_t start = hostMicros();
+    fprintf(stderr, "Answering NTP requests on port %u: offset %.3f s, drift %+.3f ppm, delay %u ms, stratum %u.\n",
+        port, cfg.offsetSecs, cfg.ppm, (unsigned)cfg.delayMillis, (unsigned)cfg.stratum);
+
+    // Answer requests, one at a time, until killed
+    uint64_t requests = 0;
+    while (true) {
+        uint8_t packet[MN_PACKET_LEN];
+        sockaddr_in from = {};
+        socklen_t fromLen = sizeof(from);
+        ssize_t len = recvfrom(sock, packet, sizeof(packet), 0, (sockaddr *)&from, &fromLen);
+        if (len < MN_PACKET_LEN || (packet[0] & 0x07) != 3) {
+            continue;                                   // Not a client request
+        }
+        requests++;
+        sleepMicros(cfg.delayMillis * 500LL);
+        int64_t received = serverMicros(cfg, start, hostMicros());
+
+        uint8_t answer[MN_PACKET_LEN] = {};
+        answer[0] = (uint8_t)((packet[0] & 0x38) | 4); // Leap indicator 0, the client's version, mode 4 (server)
+        answer[1] = cfg.stratum;
+        answer[2] = packet[2];                          // Poll interval
+        answer[3] = 0xec;                               // Precision: about a microsecond
+        memcpy(answer + 12, "MOCK", 4);                 // Reference id
+        putTimestamp(answer + 16, received);            // Reference timestamp
+        memcpy(answer + 24, packet + 40, 8);            // Originate timestamp: the client's transmit timestamp
+        putTimestamp(answer + 32, received);            // Receive timestamp
+        int64_t sent = serverMicros(cfg, start, hostMicros());
+        putTimestamp(answer + 40, sent);                // Transmit timestamp
+        sleepMicros(cfg.delayMillis * 500LL);
+        sendto(sock, answer, sizeof(answer), 0, (sockaddr *)&from, fromLen);
+
+        time_t secs = (time_t)(sent / 1000000);
+        char when[32];
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", gmtime(&secs));
+        fprintf(stderr, "Request %llu from %s:%u answered with %s.%06u UTC\n", (unsigned long long)requests,
+            inet_ntoa(from.sin_addr), (unsigned)ntohs(from.sin_port), when, (unsigned)(sent % 1000000));
+    }
+}
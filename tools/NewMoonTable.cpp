@@ -0,0 +1,119 @@
+/****
+ * @file NewMoonTable.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * A host tool that generates lib/MoonPhase/NewMoonTable.h, the table of true new moons the
+ * MoonPhase library looks up instead of evaluating Meeus' series at run time. It is built by
+ * the PlatformIO "newmoons" environment and writes the table to stdout:
+ *
+ *      pio run -e newmoons && .pio/build/newmoons/program > lib/MoonPhase/NewMoonTable.h
+ *
+ * The table covers every lunation that has any part of it in the span of years given (by
+ * default, 2024 through 2100). Each entry is the difference between the true new moon, per
+ * MoonPhase::computeNewMoon(), and the mean one, per MoonPhase::meanNewMoon(), in units of
+ * MP_TABLE_UNIT seconds, rounded to nearest. The tool checks that every entry fits in an
+ * int16_t and that every new moon comes back out of the table to within half a unit, and
+ * fails if not.
+ *
+ * Usage: program [<first year> <last year>]
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+#include <MoonPhase.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NMT_DEFAULT_FIRST   (2024)                      // Default first year covered
+#define NMT_DEFAULT_LAST    (2100)                      // Default last year covered
+#define NMT_PER_LINE        (12)                        // Table entries per line of output
+
+/**
+ * @brief   Return the time_t of 00:00 UTC on January 1 of the specified year
+ *
+ * @param year      The year
+ * @return time_t   The time
+ */
+static time_t newYear(int32_t year) {
+    // Days since 1970-01-01, counting leap days the Gregorian way
+    int64_t y = year - 1;
+    int64_t days = 365 * (int64_t)(year - 1970) + (y / 4 - y / 100 + y / 400) - (1969 / 4 - 1969 / 100 + 1969 / 400);
+    return (time_t)(days * 86400);
+}
+
+int main(int argc, char *argv[]) {
+    int32_t firstYear = NMT_DEFAULT_FIRST;
+    int32_t lastYear = NMT_DEFAULT_LAST;
+    if (argc == 3) {
+        firstYear = atoi(argv[1]);
+        lastYear = atoi(argv[2]);
+    }
+    if ((argc != 1 && argc != 3) || lastYear < firstYear) {
+        fprintf(stderr, "Usage: %s [<first year> <last year>]\n", argv[0]);
+        return 1;
+    }
+
+    // The lunations with any part of them in the span. (lunationAt() may use the existing
+    // table, but only to find the lunation numbers; the entries come from the series.)
+    int32_t firstK = MoonPhase::lunationAt(newYear(firstYear));
+    int32_t lastK = MoonPhase::lunationAt(newYear(lastYear + 1)) + 1;
+    int32_t len = lastK - firstK + 1;
+    int16_t *entry = new int16_t[len];
+    int64_t maxAbs = 0;
+    for (int32_t i = 0; i < len; i++) {
+        int64_t d = (int64_t)(MoonPhase::computeNewMoon(firstK + i) - MoonPhase::meanNewMoon(firstK + i));
+        int64_t e = (d >= 0 ? d + MP_TABLE_UNIT / 2 : d - MP_TABLE_UNIT / 2) / MP_TABLE_UNIT;
+        if (e < INT16_MIN || e > INT16_MAX) {
+            fprintf(stderr, "Lunation %d is %lld s from the mean; too far for an int16_t entry.\n", firstK + i, (long long)d);
+            return 1;
+        }
+        if (llabs(e * MP_TABLE_UNIT - d) > MP_TABLE_UNIT / 2) {
+            fprintf(stderr, "Lunation %d doesn't round-trip.\n", firstK + i);
+            return 1;
+        }
+        entry[i] = (int16_t)e;
+        maxAbs = llabs(d) > maxAbs ? llabs(d) : maxAbs;
+    }
+
+    printf("/****\n");
+    printf(" *\n");
+    printf(" * This file is a part of the MoonPhase library. It was generated by tools/NewMoonTable.cpp\n");
+    printf(" * -- don't edit it by hand. See MoonPhase.h for details.\n");
+    printf(" *\n");
+    printf(" * The true new moons of lunations %d through %d (%d through %d), as differences from\n", firstK, lastK, firstYear, lastYear);
+    printf(" * MoonPhase::meanNewMoon() in units of MP_TABLE_UNIT seconds. The largest is %lld s.\n", (long long)maxAbs);
+    printf(" *\n");
+    printf(" ****/\n");
+    printf("\n");
+    printf("#pragma once\n");
+    printf("#include <stdint.h>\n");
+    printf("\n");
+    printf("#define MP_TABLE_FIRST_K    (%d)%*s// Lunation number of the first entry\n", firstK, (int)(16 - snprintf(nullptr, 0, "%d", firstK)), "");
+    printf("#define MP_TABLE_LEN        (%d)%*s// Number of entries\n", len, (int)(16 - snprintf(nullptr, 0, "%d", len)), "");
+    printf("\n");
+    printf("static const int16_t mpNewMoonTable[MP_TABLE_LEN] = {\n");
+    for (int32_t i = 0; i < len; i++) {
+        printf("%s%6d%s", i % NMT_PER_LINE == 0 ? "   " : "", entry[i], i == len - 1 ? "\n" : i % NMT_PER_LINE == NMT_PER_LINE - 1 ? ",\n" : ",");
+    }
+    printf("};\n");
+    delete[] entry;
+    return 0;
+}
@@ -0,0 +1,163 @@
+/****
+ * @file TelemetryDecoder.cpp
+ * @version 1.0.0
+ * @date October, 2026
+ *
+ * A host tool that decodes the binary telemetry frames the firmware sends over USB serial when
+ * told to ('tlm <millis>'). It is built by the PlatformIO "tlmdecode" environment. It reads the
+ * serial stream, either live or as recorded, from the file given or from stdin, picks out the
+ * frames and writes one line of CSV per frame to stdout. For example, on Linux:
+ *
+ *      stty -F /dev/ttyACM0 raw && cat /dev/ttyACM0 > moon.tlm         (record, for weeks)
+ *      .pio/build/tlmdecode/program moon.tlm > moon.csv                (decode)
+ *
+ * Whatever isn't part of a frame -- the command line's text, mostly -- is skipped, or, with
+ * --text, copied to stderr. A frame is believed only if its sync bytes, version, length and CRC
+ * all check out (see TelemetryFrame.h), so a frame that's been damaged in transit, or text that
+ * happens to look like the start of one, costs at most that frame. Gaps in the sequence numbers
+ * show frames that were dropped or damaged.
+ *
+ * The cumulative counters are turned into something more useful along the way: each core's
+ * busy time is reported as a percentage of the time since the previous frame. When it's done,
+ * the tool writes a summary to stderr.
+ *
+ * Usage: program [--text] [<file>]
+ *
+ *****
+ *
+ * Copyright (C) 2026 D.L. Ehnebuske
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+ * and associated documentation files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+ * BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ****/
+#include <TelemetryFrame.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TD_BUF_LEN          (65536)                     // Size of the input buffer
+
+/**
+ * @brief   The decoder's state and counts
+ *
+ */
+struct tdState_t {
+    bool havePrev;                                      // true once a frame has been decoded
+    tlmFrame_t prev;                                    // The previous frame decoded
+    uint64_t frames;                                    // Number of frames decoded
+    uint64_t badFrames;                                 // Number of would-be frames whose CRC was wrong
+    uint64_t missing;                                   // Number of frames missing per the sequence numbers
+    uint64_t textBytes;                                 // Number of bytes that weren't part of a frame
+};
+
+/**
+ * @brief   Return the percentage of the time between two frames a core spent busy
+ *
+ * @param busy      The core's busy micros in the later frame
+ * @param prevBusy  The core's busy micros in the earlier one
+ * @param span      The micros between the two
+ * @return double   The percentage
+ */
+static double busyPct(uint32_t busy, uint32_t prevBusy, uint64_t span) {
+    return span == 0 ? 0.0 : 100.0 * (uint32_t)(busy - prevBusy) / (double)span;
+}
+
+/**
+ * @brief   Write a frame as a line of CSV and update the state
+ *
+ * @param f     The frame
+ * @param st    The state
+ */
+static void emit(const tlmFrame_t &f, tdState_t &st) {
+    if (st.havePrev && f.seq != st.prev.seq + 1) {
+        st.missing += (uint32_t)(f.seq - st.prev.seq - 1);
+    }
+    printf("%u,%llu,%u,%d,%d,%d,%d,0x%04x,%d,%d,%d,", f.seq, (unsigned long long)f.micros, f.utc,
+        f.pv, f.ls, f.phase, f.tgtPhase, f.flags, f.ambient, f.duty[0], f.duty[1]);
+    if (st.havePrev && f.micros > st.prev.micros) {
+        uint64_t span = f.micros - st.prev.micros;
+        printf("%.3f,%u,%.3f,%u,", busyPct(f.c0BusyMicros, st.prev.c0BusyMicros, span), f.c0MaxMicros,
+            busyPct(f.c1BusyMicros, st.prev.c1BusyMicros, span), f.c1MaxMicros);
+    } else {
+        printf(",%u,,%u,", f.c0MaxMicros, f.c1MaxMicros);
+    }
+    printf("%u,%u\n", f.arrivals, f.dropped);
+    st.prev = f;
+    st.havePrev = true;
+    st.frames++;
+}
+
+int main(int argc, char *argv[]) {
+    bool text = false;
+    const char *path = nullptr;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--text") == 0) {
+            text = true;
+        } else if (path == nullptr && argv[a][0] != '-') {
+            path = argv[a];
+        } else {
+            fprintf(stderr, "Usage: %s [--text] [<file>]\n", argv[0]);
+            return 1;
+        }
+    }
+    FILE *in = path == nullptr ? stdin : fopen(path, "rb");
+    if (in == nullptr) {
+        perror(path);
+        return 1;
+    }
+
+    static uint8_t buf[TD_BUF_LEN];
+    size_t have = 0;
+    bool eof = false;
+    tdState_t st = {};
+    printf("seq,micros,utc,pv,ls,phase,tgtPhase,flags,ambient,dutyWaxing,dutyWaning,"
+        "c0BusyPct,c0MaxMicros,c1BusyPct,c1MaxMicros,arrivals,dropped\n");
+    while (!eof) {
+        // read() rather than fread() so that, reading a live stream, we deal with what has come 
+        // so far rather than waiting for a bufferful.
+        ssize_t n = read(fileno(in), buf + have, TD_BUF_LEN - have);
+        eof = n <= 0;
+        have += n > 0 ? n : 0;
+
+        // Go through what we have, leaving any partial frame at the end for next time
+        size_t i = 0;
+        while (i < have && (eof || have - i >= sizeof(tlmFrame_t))) {
+            if (have - i >= sizeof(tlmFrame_t) && buf[i] == TLM_SYNC0 && buf[i + 1] == TLM_SYNC1 && 
+                buf[i + 2] == TLM_VERSION && buf[i + 3] == sizeof(tlmFrame_t)) {
+                tlmFrame_t f;
+                memcpy(&f, buf + i, sizeof(f));
+                if (tlmCrc16(buf + i, offsetof(tlmFrame_t, crc)) == f.crc) {
+                    emit(f, st);
+                    i += sizeof(f);
+                    continue;
+                }
+                st.badFrames++;
+            }
+            if (text) {
+                fputc(buf[i], stderr);
+            }
+            st.textBytes++;
+            i++;
+        }
+        memmove(buf, buf + i, have - i);
+        have -= i;
+        fflush(stdout);
+    }
+    fprintf(stderr, "%llu frames decoded, %llu with bad CRCs, %llu missing, %llu bytes of other stuff.\n",
+        (unsigned long long)st.frames, (unsigned long long)st.badFrames, (unsigned long long)st.missing,
+        (unsigned long long)st.textBytes);
+    return 0;
+}